@@ -9,9 +9,13 @@
 
 #import "OpenGLRenderer.h"
 #import "matrixUtil.h"
+#import "affineUtil.h"
 #import "imageUtil.h"
 #import "modelUtil.h"
+#import "meshUtil.h"
+#import "vertexUtil.h"
 #import "sourceUtil.h"
+#import "programUtil.h"
 
 // Toggle this to disable vertex buffer objects
 // (i.e. use client-side vertex array objects)
@@ -23,6 +27,16 @@
 // the reflection.
 #define RENDER_REFLECTION 1
 
+// Toggle this to reorder the character model's triangles and vertices
+// for the vertex cache when it is loaded.  Shipping models should be
+// optimized offline with the optimizemodel tool instead.
+#define OPTIMIZE_MODELS_ON_LOAD 0
+
+// Toggle this to draw the character from a single interleaved vertex
+// stream with half float positions, octahedral normals and 16-bit
+// texcoords instead of a separate float array per attribute
+#define USE_INTERLEAVED_VERTICES 1
+
 // Indicies to which we will set vertex array attibutes
 // See buildVAO and buildProgram
 enum {
@@ -37,6 +51,18 @@ enum {
 
 #define BUFFER_OFFSET(i) ((char *)NULL + (i))
 
+// Models too large for UNSIGNED_SHORT elements are split into
+// submeshes (see mdlSplitModel) which are each drawn with their own VAO
+typedef struct characterSubmeshRec
+{
+    GLuint vaoName;
+    GLuint numElements;
+    
+    // Client-side arrays only kept when not using VBOs
+    GLubyte* elements;
+    demoVertexStream* vertexStream;
+} characterSubmesh;
+
 @interface OpenGLRenderer ()
 {
     GLuint _defaultFBOName;
@@ -59,12 +85,12 @@ enum {
 
     GLuint _characterPrgName;
     GLint _characterMvpUniformIdx;
-    GLuint _characterVAOName;
+    characterSubmesh* _characterSubmeshes;
+    GLuint _characterNumSubmeshes;
     GLuint _characterTexName;
     demoModel* _characterModel;
     GLenum _characterPrimType;
     GLenum _characterElementType;
-    GLuint _characterNumElements;
     GLfloat _characterAngle;
     
     GLuint _viewWidth;
@@ -88,7 +114,7 @@ enum {
 - (void) render
 {
     // Set up the modelview and projection matricies
-    GLfloat modelView[16];
+    demoAffine modelView;
     GLfloat projection[16];
     GLfloat mvp[16];
     
@@ -103,17 +129,17 @@ enum {
     
     mtxLoadPerspective(projection, 90, (float)_reflectWidth / (float)_reflectHeight,5.0,10000);
 
-    mtxLoadIdentity(modelView);
+    affLoadIdentity(&modelView);
     
     // Invert Y so that everything is rendered up-side-down
     // as it should with a reflection
     
-    mtxScaleApply(modelView, 1, -1, 1);
-    mtxTranslateApply(modelView, 0, 300, -800);
-    mtxRotateXApply(modelView, -90.0f);    
-    mtxRotateApply(modelView, _characterAngle, 0.7, 0.3, 1);    
+    affScaleApply(&modelView, 1, -1, 1);
+    affTranslateApply(&modelView, 0, 300, -800);
+    affRotateXApply(&modelView, -90.0f);    
+    affRotateApply(&modelView, _characterAngle, 0.7, 0.3, 1);    
     
-    mtxMultiply(mvp, projection, modelView);
+    mtxMultiply(mvp, projection, modelView.mtx);
     
     // Use the program that we previously created
     glUseProgram(_characterPrgName);
@@ -122,9 +148,6 @@ enum {
     // in our vertex shader
     glUniformMatrix4fv(_characterMvpUniformIdx, 1, GL_FALSE, mvp);
     
-    // Bind our vertex array object
-    glBindVertexArray(_characterVAOName);
-    
     // Bind the texture to be used
     glBindTexture(GL_TEXTURE_2D, _characterTexName);
     
@@ -133,14 +156,7 @@ enum {
     glCullFace(GL_FRONT);
     
     // Draw our object
-    if(_useVBOs)
-    {
-        glDrawElements(GL_TRIANGLES, _characterNumElements, _characterElementType, 0);
-    }
-    else 
-    {
-        glDrawElements(GL_TRIANGLES, _characterNumElements, _characterElementType, _characterModel->elements);
-    }
+    [self drawCharacter];
     
     // Bind our default FBO to render to the screen
     glBindFramebuffer(GL_FRAMEBUFFER, _defaultFBOName);
@@ -159,12 +175,12 @@ enum {
     
     // Calculate the modelview matrix to render our character 
     //  at the proper position and rotation
-    mtxLoadTranslate(modelView, 0, 150, -450);
-    mtxRotateXApply(modelView, -90.0f);    
-    mtxRotateApply(modelView, _characterAngle, 0.7, 0.3, 1);
+    affLoadTranslate(&modelView, 0, 150, -450);
+    affRotateXApply(&modelView, -90.0f);    
+    affRotateApply(&modelView, _characterAngle, 0.7, 0.3, 1);
     
     // Multiply the modelview and projection matrix and set it in the shader
-    mtxMultiply(mvp, projection, modelView);
+    mtxMultiply(mvp, projection, modelView.mtx);
     
     // Have our shader use the modelview projection matrix 
     // that we calculated above
@@ -173,36 +189,26 @@ enum {
     // Bind the texture to be used
     glBindTexture(GL_TEXTURE_2D, _characterTexName);
     
-    // Bind our vertex array object
-    glBindVertexArray(_characterVAOName);
-    
     // Cull back faces now that we no longer render 
     // with an inverted matrix
     glCullFace(GL_BACK);
     
     // Draw our character
-    if(_useVBOs)
-    {
-        glDrawElements(GL_TRIANGLES, _characterNumElements, _characterElementType, 0);
-    }
-    else 
-    {
-        glDrawElements(GL_TRIANGLES, _characterNumElements, _characterElementType, _characterModel->elements);
-    }
+    [self drawCharacter];
     
 #if RENDER_REFLECTION
     
     // Use our shader for reflections
     glUseProgram(_reflectPrgName);
     
-    mtxLoadTranslate(modelView, 0, -50, -250);
+    affLoadTranslate(&modelView, 0, -50, -250);
     
     // Multiply the modelview and projection matrix and set it in the shader
-    mtxMultiply(mvp, projection, modelView);
+    mtxMultiply(mvp, projection, modelView.mtx);
     
     // Set the modelview matrix that we calculated above
     // in our vertex shader
-    glUniformMatrix4fv(_reflectModelViewUniformIdx, 1, GL_FALSE, modelView);
+    glUniformMatrix4fv(_reflectModelViewUniformIdx, 1, GL_FALSE, modelView.mtx);
     
     // Set the projection matrix that we calculated above
     // in our vertex shader
@@ -215,10 +221,9 @@ enum {
     
     // The normal matrix needs to be the inverse transpose of the 
     //   top left 3x3 portion of the modelview matrix
-    // We don't need to calculate the inverse transpose matrix
-    //   here because this will always be an orthonormal matrix
-    //   thus the the inverse tranpose is the same thing
-    mtx3x3FromTopLeftOf4x4(normalMatrix, modelView);
+    // The modelview matrix knows whether it is rigid, in which case
+    //   the inverse transpose is the same thing and nothing is inverted
+    affNormalMatrix(normalMatrix, &modelView);
     
     // Set the normal matrix for our shader to use
     glUniformMatrix3fv(_reflectNormalMatrixUniformIdx, 1, GL_FALSE, normalMatrix);
@@ -251,6 +256,28 @@ enum {
     _characterAngle++;
 }
 
+- (void) drawCharacter
+{
+    GLuint submeshNum;
+    
+    for(submeshNum = 0; submeshNum < _characterNumSubmeshes; submeshNum++)
+    {
+        characterSubmesh* submesh = &_characterSubmeshes[submeshNum];
+        
+        // Bind the submesh's vertex array object
+        glBindVertexArray(submesh->vaoName);
+        
+        if(_useVBOs)
+        {
+            glDrawElements(GL_TRIANGLES, submesh->numElements, _characterElementType, 0);
+        }
+        else
+        {
+            glDrawElements(GL_TRIANGLES, submesh->numElements, _characterElementType, submesh->elements);
+        }
+    }
+}
+
 static GLsizei GetGLTypeSize(GLenum type)
 {
     switch (type) {
@@ -438,6 +465,68 @@ static GLsizei GetGLTypeSize(GLenum type)
     return vaoName;
 }
 
+- (void) setVertexAttrib:(GLuint)index fromStream:(demoVertexStream*)stream attrib:(demoVertexAttrib*)attrib
+{
+    if(!attrib->size)
+    {
+        return;
+    }
+    
+    // Enable the attribute for this VAO
+    glEnableVertexAttribArray(index);
+    
+    // All attributes share the stream's stride and are found at their offset within
+    //  each vertex, either in the currently bound VBO or in the stream's memory
+    glVertexAttribPointer(index,                // What attibute index will this array feed in the vertex shader (see buildProgram)
+                          attrib->size,         // How many elements are there per vertex?
+                          attrib->type,         // What is the type of this data?
+                          attrib->normalized,   // Do we want to normalize this data (0-1 or -1-1 range for fixed-point types)
+                          stream->stride,       // What is the stride (i.e. bytes between vertices)?
+                          _useVBOs ? BUFFER_OFFSET(attrib->offset) : (stream->vertices + attrib->offset));
+}
+
+- (GLuint) buildVAO:(demoModel*)model withVertexStream:(demoVertexStream*)stream
+{
+    GLuint vaoName;
+    
+    // Create a vertex array object (VAO) to cache model parameters
+    glGenVertexArrays(1, &vaoName);
+    glBindVertexArray(vaoName);
+    
+    if(_useVBOs)
+    {
+        GLuint vertexBufferName;
+        
+        // Create a single vertex buffer object (VBO) to store every attribute
+        glGenBuffers(1, &vertexBufferName);
+        glBindBuffer(GL_ARRAY_BUFFER, vertexBufferName);
+        
+        // Allocate and load the interleaved vertex data into the VBO
+        glBufferData(GL_ARRAY_BUFFER, stream->vertexArraySize, stream->vertices, GL_STATIC_DRAW);
+    }
+    
+    [self setVertexAttrib:POS_ATTRIB_IDX fromStream:stream attrib:&stream->position];
+    [self setVertexAttrib:NORMAL_ATTRIB_IDX fromStream:stream attrib:&stream->normal];
+    [self setVertexAttrib:TEXCOORD_ATTRIB_IDX fromStream:stream attrib:&stream->texcoord];
+    
+    if(_useVBOs)
+    {
+        GLuint elementBufferName;
+        
+        // Create a VBO to vertex array elements
+        // This also attaches the element array buffer to the VAO
+        glGenBuffers(1, &elementBufferName);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, elementBufferName);
+        
+        // Allocate and load vertex array element data into VBO
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, model->elementArraySize, model->elements, GL_STATIC_DRAW);
+    }
+    
+    GetGLError();
+    
+    return vaoName;
+}
+
 -(void)destroyVAO:(GLuint) vaoName
 {
     GLuint index;
@@ -629,58 +718,36 @@ static GLsizei GetGLTypeSize(GLenum type)
     return fboName;
 }
 
--(GLuint) buildProgramWithVertexSource:(demoSource*)vertexSource
-                    withFragmentSource:(demoSource*)fragmentSource
-                            withNormal:(BOOL)hasNormal
-                          withTexcoord:(BOOL)hasTexcoord
++ (NSString*) programCacheDirectory
 {
-    GLuint prgName;
+    NSString* cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) firstObject];
+    NSString* directory = [cachesDirectory stringByAppendingPathComponent:@"Shaders"];
+    
+    if(![[NSFileManager defaultManager] createDirectoryAtPath:directory
+                                  withIntermediateDirectories:YES
+                                                   attributes:nil
+                                                        error:NULL])
+    {
+        return nil;
+    }
     
+    return directory;
+}
+
+-(BOOL) compileProgram:(GLuint)prgName
+      withVertexSource:(demoSource*)vertexSource
+    withFragmentSource:(demoSource*)fragmentSource
+           withVersion:(GLuint)version
+{
     GLint logLength, status;
     
     // String to pass to glShaderSource
     GLchar* sourceString = NULL;  
     
-    // Determine if GLSL version 140 is supported by this context.
-    //  We'll use this info to generate a GLSL shader source string  
-    //  with the proper version preprocessor string prepended
-    float  glLanguageVersion;
-    
-#if TARGET_IOS
-    sscanf((char *)glGetString(GL_SHADING_LANGUAGE_VERSION), "OpenGL ES GLSL ES %f", &glLanguageVersion);
-#else
-    sscanf((char *)glGetString(GL_SHADING_LANGUAGE_VERSION), "%f", &glLanguageVersion);    
-#endif
-    
-    // GL_SHADING_LANGUAGE_VERSION returns the version standard version form 
-    //  with decimals, but the GLSL version preprocessor directive simply
-    //  uses integers (thus 1.10 should 110 and 1.40 should be 140, etc.)
-    //  We multiply the floating point number by 100 to get a proper
-    //  number for the GLSL preprocessor directive
-    GLuint version = 100 * glLanguageVersion;
-    
     // Get the size of the version preprocessor string info so we know 
     //  how much memory to allocate for our sourceString
     const GLsizei versionStringSize = sizeof("#version 123\n");
     
-    // Create a program object
-    prgName = glCreateProgram();
-    
-    // Indicate the attribute indicies on which vertex arrays will be
-    //  set with glVertexAttribPointer
-    //  See buildVAO to see where vertex arrays are actually set
-    glBindAttribLocation(prgName, POS_ATTRIB_IDX, "inPosition");
-    
-    if(hasNormal)
-    {
-        glBindAttribLocation(prgName, NORMAL_ATTRIB_IDX, "inNormal");
-    }
-    
-    if(hasTexcoord)
-    {
-        glBindAttribLocation(prgName, TEXCOORD_ATTRIB_IDX, "inTexcoord");
-    }
-    
     //////////////////////////////////////
     // Specify and compile VertexShader //
     //////////////////////////////////////
@@ -709,7 +776,8 @@ static GLsizei GetGLTypeSize(GLenum type)
     if (status == 0)
     {
         NSLog(@"Failed to compile vtx shader:\n%s\n", sourceString);
-        return 0;
+        free(sourceString);
+        return NO;
     }
     
     free(sourceString);
@@ -749,7 +817,8 @@ static GLsizei GetGLTypeSize(GLenum type)
     if (status == 0)
     {
         NSLog(@"Failed to compile frag shader:\n%s\n", sourceString);
-        return 0;
+        free(sourceString);
+        return NO;
     }
     
     free(sourceString);
@@ -766,6 +835,9 @@ static GLsizei GetGLTypeSize(GLenum type)
     // Link the program //
     //////////////////////
     
+    // Ask the driver to keep the linked binary so that it can be cached
+    prgSetBinaryRetrievable(prgName);
+    
     glLinkProgram(prgName);
     glGetProgramiv(prgName, GL_INFO_LOG_LENGTH, &logLength);
     if (logLength > 0)
@@ -780,7 +852,7 @@ static GLsizei GetGLTypeSize(GLenum type)
     if (status == 0)
     {
         NSLog(@"Failed to link program");
-        return 0;
+        return NO;
     }
     
     glValidateProgram(prgName);
@@ -807,6 +879,85 @@ static GLsizei GetGLTypeSize(GLenum type)
         free(log);
     }
 
+    return YES;
+}
+
+-(GLuint) buildProgramWithVertexSource:(demoSource*)vertexSource
+                    withFragmentSource:(demoSource*)fragmentSource
+                            withNormal:(BOOL)hasNormal
+                          withTexcoord:(BOOL)hasTexcoord
+{
+    GLuint prgName;
+    
+    if(NULL == vertexSource || NULL == fragmentSource)
+    {
+        NSLog(@"Missing shader source");
+        return 0;
+    }
+    
+    // Determine if GLSL version 140 is supported by this context.
+    //  We'll use this info to generate a GLSL shader source string  
+    //  with the proper version preprocessor string prepended
+    float  glLanguageVersion;
+    
+#if TARGET_IOS
+    sscanf((char *)glGetString(GL_SHADING_LANGUAGE_VERSION), "OpenGL ES GLSL ES %f", &glLanguageVersion);
+#else
+    sscanf((char *)glGetString(GL_SHADING_LANGUAGE_VERSION), "%f", &glLanguageVersion);    
+#endif
+    
+    // GL_SHADING_LANGUAGE_VERSION returns the version standard version form 
+    //  with decimals, but the GLSL version preprocessor directive simply
+    //  uses integers (thus 1.10 should 110 and 1.40 should be 140, etc.)
+    //  We multiply the floating point number by 100 to get a proper
+    //  number for the GLSL preprocessor directive
+    GLuint version = 100 * glLanguageVersion;
+    
+    // Create a program object
+    prgName = glCreateProgram();
+    
+    // Indicate the attribute indicies on which vertex arrays will be
+    //  set with glVertexAttribPointer
+    //  See buildVAO to see where vertex arrays are actually set
+    glBindAttribLocation(prgName, POS_ATTRIB_IDX, "inPosition");
+    
+    if(hasNormal)
+    {
+        glBindAttribLocation(prgName, NORMAL_ATTRIB_IDX, "inNormal");
+    }
+    
+    if(hasTexcoord)
+    {
+        glBindAttribLocation(prgName, TEXCOORD_ATTRIB_IDX, "inTexcoord");
+    }
+    
+    // A binary cached by an earlier run skips compiling and linking
+    //  entirely.  The hash covers the sources, GLSL version, attribute
+    //  bindings and driver so a stale binary is never loaded.
+    const GLchar* attribNames[] =
+    {
+        "inPosition",
+        hasNormal ? "inNormal" : NULL,
+        hasTexcoord ? "inTexcoord" : NULL
+    };
+    
+    const char* cacheDirectory = [[OpenGLRenderer programCacheDirectory] fileSystemRepresentation];
+    uint64_t programHash = prgHashProgram(vertexSource, fragmentSource, version, attribNames, 3);
+    
+    if(!cacheDirectory || !prgLoadBinary(prgName, cacheDirectory, programHash))
+    {
+        if(![self compileProgram:prgName withVertexSource:vertexSource withFragmentSource:fragmentSource withVersion:version])
+        {
+            glDeleteProgram(prgName);
+            return 0;
+        }
+        
+        if(cacheDirectory && prgBinariesSupported())
+        {
+            prgSaveBinary(prgName, cacheDirectory, programHash);
+        }
+    }
+    
     glUseProgram(prgName);
     
     ///////////////////////////////////////
@@ -853,13 +1004,70 @@ static GLsizei GetGLTypeSize(GLenum type)
         //////////////////////////////
         
         filePathName = [[NSBundle mainBundle] pathForResource:@"demon" ofType:@"model"];
-        _characterModel = mdlLoadModel([filePathName cStringUsingEncoding:NSASCIIStringEncoding]);
         
-        // Build Vertex Buffer Objects (VBOs) and Vertex Array Object (VAOs) with our model data
-        _characterVAOName = [self buildVAO:_characterModel];
+        // Map the model file so the arrays are uploaded to GL straight from
+        //  the file's pages without first being copied into heap buffers
+        _characterModel = mdlMapModel([filePathName cStringUsingEncoding:NSASCIIStringEncoding]);
         
-        // Cache the number of element and primType to use later in our glDrawElements calls
-        _characterNumElements = _characterModel->numElements;
+#if OPTIMIZE_MODELS_ON_LOAD
+        demoMeshStats statsBefore, statsAfter;
+        
+        if(mshOptimizeModel(_characterModel, MESH_DEFAULT_OVERDRAW_THRESHOLD, &statsBefore, &statsAfter))
+        {
+            NSLog(@"Character model ACMR %.3f -> %.3f, ATVR %.3f -> %.3f",
+                  statsBefore.acmr, statsAfter.acmr, statsBefore.atvr, statsAfter.atvr);
+        }
+#endif
+        
+#if TARGET_IOS
+        // OpenGL ES 2.0 cannot draw with UNSIGNED_INT elements so convert them
+        //  to UNSIGNED_SHORT, splitting the model if it has too many vertices.
+        //  Desktop OpenGL can use the mapped elements directly.
+        if(!mdlSplitModel(_characterModel))
+        {
+            NSLog(@"Could not convert character model to UNSIGNED_SHORT elements");
+        }
+#endif
+        
+        _characterNumSubmeshes = MAX(_characterModel->numSubmeshes, 1);
+        _characterSubmeshes = (characterSubmesh*) calloc(_characterNumSubmeshes, sizeof(characterSubmesh));
+        
+        GLuint submeshNum;
+        
+        for(submeshNum = 0; submeshNum < _characterNumSubmeshes; submeshNum++)
+        {
+            characterSubmesh* submesh = &_characterSubmeshes[submeshNum];
+            demoModel submeshModel;
+            
+            mdlSubmeshModel(_characterModel, submeshNum, &submeshModel);
+            
+#if USE_INTERLEAVED_VERTICES
+            submesh->vertexStream = vtxInterleaveModel(&submeshModel, VERTEX_POSITION_HALF,
+                                                       VERTEX_NORMAL_OCT16, VERTEX_TEXCOORD_UNORM16);
+#endif
+            
+            // Build Vertex Buffer Objects (VBOs) and Vertex Array Object (VAOs) with our model data
+            if(submesh->vertexStream)
+            {
+                submesh->vaoName = [self buildVAO:&submeshModel withVertexStream:submesh->vertexStream];
+            }
+            else
+            {
+                submesh->vaoName = [self buildVAO:&submeshModel];
+            }
+            
+            // Cache the number of elements to use later in our glDrawElements calls
+            submesh->numElements = submeshModel.numElements;
+            submesh->elements = submeshModel.elements;
+            
+            if(_useVBOs)
+            {
+                vtxDestroyStream(submesh->vertexStream);
+                submesh->vertexStream = NULL;
+            }
+        }
+        
+        // Cache the primType and element type to use later in our glDrawElements calls
         _characterPrimType = _characterModel->primType;
         _characterElementType = _characterModel->elementType;
 
@@ -1035,7 +1243,16 @@ static GLsizei GetGLTypeSize(GLenum type)
     // Cleanup all OpenGL objects and
     glDeleteTextures(1, &_characterTexName);
         
-    [self destroyVAO:_characterVAOName];
+    GLuint submeshNum;
+    
+    for(submeshNum = 0; submeshNum < _characterNumSubmeshes; submeshNum++)
+    {
+        [self destroyVAO:_characterSubmeshes[submeshNum].vaoName];
+        
+        vtxDestroyStream(_characterSubmeshes[submeshNum].vertexStream);
+    }
+    
+    free(_characterSubmeshes);
 
     glDeleteProgram(_characterPrgName);
 
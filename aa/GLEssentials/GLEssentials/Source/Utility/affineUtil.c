@@ -0,0 +1,296 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for building affine transforms that remember whether they are
+  rigid, uniformly scaled or general, so that their inverse and normal
+  matrix can be computed with the cheapest formula that is exact.
+ */
+
+#include "affineUtil.h"
+#include "matrixUtil.h"
+
+#include <math.h>
+#include <string.h>
+
+// Relative tolerance used by affLoadMatrix when deciding whether the columns
+// of a matrix are orthogonal and of equal length
+#define AFFINE_CLASSIFY_TOLERANCE 1e-5f
+
+static void affSetKind(demoAffine* aff, unsigned int kind, float scaleSquared)
+{
+	if(AFFINE_GENERAL == kind)
+	{
+		scaleSquared = 0.0f;
+	}
+	else if(1.0f == scaleSquared)
+	{
+		kind = AFFINE_RIGID;
+	}
+	else
+	{
+		kind = AFFINE_UNIFORM_SCALE;
+	}
+	
+	aff->kind = kind;
+	aff->scaleSquared = scaleSquared;
+}
+
+// Combines the kind of AFF with that of a transform it is multiplied by
+static void affCombineKind(demoAffine* aff, unsigned int kind, float scaleSquared)
+{
+	affSetKind(aff, (aff->kind > kind) ? aff->kind : kind, aff->scaleSquared * scaleSquared);
+}
+
+static void affClassifyScale(float xScale, float yScale, float zScale,
+							 unsigned int* kind, float* scaleSquared)
+{
+	// Scales that differ only in sign are a uniform scale times a reflection
+	if(fabsf(xScale) == fabsf(yScale) && fabsf(xScale) == fabsf(zScale))
+	{
+		*kind = AFFINE_UNIFORM_SCALE;
+		*scaleSquared = xScale * xScale;
+	}
+	else
+	{
+		*kind = AFFINE_GENERAL;
+		*scaleSquared = 0.0f;
+	}
+}
+
+void affLoadIdentity(demoAffine* aff)
+{
+	mtxLoadIdentity(aff->mtx);
+	affSetKind(aff, AFFINE_RIGID, 1.0f);
+}
+
+void affLoadTranslate(demoAffine* aff, float xTrans, float yTrans, float zTrans)
+{
+	mtxLoadTranslate(aff->mtx, xTrans, yTrans, zTrans);
+	affSetKind(aff, AFFINE_RIGID, 1.0f);
+}
+
+void affLoadScale(demoAffine* aff, float xScale, float yScale, float zScale)
+{
+	unsigned int kind;
+	float scaleSquared;
+	
+	mtxLoadScale(aff->mtx, xScale, yScale, zScale);
+	affClassifyScale(xScale, yScale, zScale, &kind, &scaleSquared);
+	affSetKind(aff, kind, scaleSquared);
+}
+
+void affLoadRotate(demoAffine* aff, float deg, float xAxis, float yAxis, float zAxis)
+{
+	mtxLoadRotate(aff->mtx, deg, xAxis, yAxis, zAxis);
+	affSetKind(aff, AFFINE_RIGID, 1.0f);
+}
+
+void affLoadMatrix(demoAffine* aff, const float* mtx)
+{
+	const float* x = &mtx[0];
+	const float* y = &mtx[4];
+	const float* z = &mtx[8];
+	
+	float xx = x[0]*x[0] + x[1]*x[1] + x[2]*x[2];
+	float yy = y[0]*y[0] + y[1]*y[1] + y[2]*y[2];
+	float zz = z[0]*z[0] + z[1]*z[1] + z[2]*z[2];
+	float xy = x[0]*y[0] + x[1]*y[1] + x[2]*y[2];
+	float yz = y[0]*z[0] + y[1]*z[1] + y[2]*z[2];
+	float zx = z[0]*x[0] + z[1]*x[1] + z[2]*x[2];
+	
+	float tolerance = AFFINE_CLASSIFY_TOLERANCE * xx;
+	
+	memcpy(aff->mtx, mtx, 16 * sizeof(float));
+	
+	// The columns of a rigid or uniformly scaled transform are orthogonal
+	// and all the same length
+	if(xx > 0.0f &&
+	   fabsf(xy) <= tolerance && fabsf(yz) <= tolerance && fabsf(zx) <= tolerance &&
+	   fabsf(yy - xx) <= tolerance && fabsf(zz - xx) <= tolerance)
+	{
+		float scaleSquared = (xx + yy + zz) * (1.0f / 3.0f);
+		
+		if(fabsf(scaleSquared - 1.0f) <= AFFINE_CLASSIFY_TOLERANCE)
+		{
+			scaleSquared = 1.0f;
+		}
+		
+		affSetKind(aff, AFFINE_UNIFORM_SCALE, scaleSquared);
+	}
+	else
+	{
+		affSetKind(aff, AFFINE_GENERAL, 0.0f);
+	}
+}
+
+void affTranslateApply(demoAffine* aff, float xTrans, float yTrans, float zTrans)
+{
+	// Translation never changes the kind
+	mtxTranslateApply(aff->mtx, xTrans, yTrans, zTrans);
+}
+
+void affScaleApply(demoAffine* aff, float xScale, float yScale, float zScale)
+{
+	unsigned int kind;
+	float scaleSquared;
+	
+	mtxScaleApply(aff->mtx, xScale, yScale, zScale);
+	affClassifyScale(xScale, yScale, zScale, &kind, &scaleSquared);
+	affCombineKind(aff, kind, scaleSquared);
+}
+
+void affRotateApply(demoAffine* aff, float deg, float xAxis, float yAxis, float zAxis)
+{
+	// Rotation never changes the kind
+	mtxRotateApply(aff->mtx, deg, xAxis, yAxis, zAxis);
+}
+
+void affRotateXApply(demoAffine* aff, float deg)
+{
+	mtxRotateXApply(aff->mtx, deg);
+}
+
+void affRotateYApply(demoAffine* aff, float deg)
+{
+	mtxRotateYApply(aff->mtx, deg);
+}
+
+void affRotateZApply(demoAffine* aff, float deg)
+{
+	mtxRotateZApply(aff->mtx, deg);
+}
+
+void affMultiply(demoAffine* aff, const demoAffine* lhs, const demoAffine* rhs)
+{
+	unsigned int kind = (lhs->kind > rhs->kind) ? lhs->kind : rhs->kind;
+	float scaleSquared = lhs->scaleSquared * rhs->scaleSquared;
+	
+	// mtxMultiply cannot write over its inputs
+	if(aff == lhs || aff == rhs)
+	{
+		float mtx[16];
+		
+		mtxMultiply(mtx, lhs->mtx, rhs->mtx);
+		memcpy(aff->mtx, mtx, 16 * sizeof(float));
+	}
+	else
+	{
+		mtxMultiply(aff->mtx, lhs->mtx, rhs->mtx);
+	}
+	
+	affSetKind(aff, kind, scaleSquared);
+}
+
+void affInvert(demoAffine* aff, const demoAffine* src)
+{
+	// [ 0 4  8 12 ]
+	// [ 1 5  9 13 ]
+	// [ 2 6 10 14 ]
+	// [ 3 7 11 15 ]
+	
+	// Read everything before writing so that AFF may be SRC
+	float m0 = src->mtx[0], m1 = src->mtx[1], m2  = src->mtx[ 2];
+	float m4 = src->mtx[4], m5 = src->mtx[5], m6  = src->mtx[ 6];
+	float m8 = src->mtx[8], m9 = src->mtx[9], m10 = src->mtx[10];
+	float tx = src->mtx[12], ty = src->mtx[13], tz = src->mtx[14];
+	unsigned int kind = src->kind;
+	float scaleSquared = src->scaleSquared;
+	float* inv = aff->mtx;
+	
+	if(AFFINE_GENERAL != kind)
+	{
+		// (sR)^-1 = R^T / s = (sR)^T / s^2
+		float r = (AFFINE_RIGID == kind) ? 1.0f : 1.0f / scaleSquared;
+		
+		inv[ 0] = m0 * r; inv[ 4] = m1 * r; inv[ 8] = m2  * r;
+		inv[ 1] = m4 * r; inv[ 5] = m5 * r; inv[ 9] = m6  * r;
+		inv[ 2] = m8 * r; inv[ 6] = m9 * r; inv[10] = m10 * r;
+		
+		scaleSquared = r;
+	}
+	else
+	{
+		// The rows of the inverse are the cross products of pairs of columns
+		// (the adjugate) divided by the determinant
+		float cx0 = m5*m10 - m6*m9, cx1 = m6*m8 - m4*m10, cx2 = m4*m9 - m5*m8;
+		float det = m0*cx0 + m1*cx1 + m2*cx2;
+		
+		if(0.0f == det)
+		{
+			affLoadIdentity(aff);
+			return;
+		}
+		
+		float r = 1.0f / det;
+		
+		inv[ 0] = cx0 * r;
+		inv[ 4] = cx1 * r;
+		inv[ 8] = cx2 * r;
+		
+		inv[ 1] = (m9*m2 - m10*m1) * r;
+		inv[ 5] = (m10*m0 - m8*m2) * r;
+		inv[ 9] = (m8*m1 - m9*m0) * r;
+		
+		inv[ 2] = (m1*m6 - m2*m5) * r;
+		inv[ 6] = (m2*m4 - m0*m6) * r;
+		inv[10] = (m0*m5 - m1*m4) * r;
+	}
+	
+	// -(A^-1 t)
+	inv[12] = -(inv[0]*tx + inv[4]*ty + inv[ 8]*tz);
+	inv[13] = -(inv[1]*tx + inv[5]*ty + inv[ 9]*tz);
+	inv[14] = -(inv[2]*tx + inv[6]*ty + inv[10]*tz);
+	
+	inv[3] = inv[7] = inv[11] = 0.0f;
+	inv[15] = 1.0f;
+	
+	affSetKind(aff, kind, scaleSquared);
+}
+
+void affNormalMatrix(float* mtx, const demoAffine* src)
+{
+	const float* m = src->mtx;
+	
+	if(AFFINE_RIGID == src->kind)
+	{
+		// R^-T = R
+		mtx3x3FromTopLeftOf4x4(mtx, m);
+	}
+	else if(AFFINE_UNIFORM_SCALE == src->kind)
+	{
+		// (sR)^-T = R / s = sR / s^2
+		float r = 1.0f / src->scaleSquared;
+		
+		mtx[0] = m[0] * r; mtx[1] = m[1] * r; mtx[2]  = m[ 2] * r;
+		mtx[3] = m[4] * r; mtx[4] = m[5] * r; mtx[5]  = m[ 6] * r;
+		mtx[6] = m[8] * r; mtx[7] = m[9] * r; mtx[8]  = m[10] * r;
+	}
+	else
+	{
+		// A^-T is the cofactor matrix divided by the determinant, whose
+		// columns are the cross products of pairs of columns of A
+		float cx[3] = { m[5]*m[10] - m[6]*m[9], m[6]*m[8] - m[4]*m[10], m[4]*m[9] - m[5]*m[8] };
+		float det = m[0]*cx[0] + m[1]*cx[1] + m[2]*cx[2];
+		
+		if(0.0f == det)
+		{
+			mtx3x3LoadIdentity(mtx);
+			return;
+		}
+		
+		float r = 1.0f / det;
+		
+		mtx[0] = cx[0] * r;
+		mtx[1] = cx[1] * r;
+		mtx[2] = cx[2] * r;
+		
+		mtx[3] = (m[9]*m[2] - m[10]*m[1]) * r;
+		mtx[4] = (m[10]*m[0] - m[8]*m[2]) * r;
+		mtx[5] = (m[8]*m[1] - m[9]*m[0]) * r;
+		
+		mtx[6] = (m[1]*m[6] - m[2]*m[5]) * r;
+		mtx[7] = (m[2]*m[4] - m[0]*m[6]) * r;
+		mtx[8] = (m[0]*m[5] - m[1]*m[4]) * r;
+	}
+}
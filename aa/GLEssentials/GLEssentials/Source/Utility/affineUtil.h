@@ -0,0 +1,77 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for building affine transforms that remember whether they are
+  rigid, uniformly scaled or general, so that their inverse and normal
+  matrix can be computed with the cheapest formula that is exact.
+ */
+
+#ifndef __AFFINE_UTIL_H__
+#define __AFFINE_UTIL_H__
+
+// Kinds are ordered so that the kind of a product is the larger of its factors'
+enum
+{
+	AFFINE_RIGID,          // Rotations, reflections and translations: inverse is the transpose
+	AFFINE_UNIFORM_SCALE,  // Rigid times a scale s: inverse is the transpose divided by s^2
+	AFFINE_GENERAL         // Any other affine transform: inverse from the 3x3 adjugate
+};
+
+typedef struct demoAffineRec
+{
+	// Column major 4x4 matrix, as in matrixUtil, whose bottom row is always
+	// 0 0 0 1.  Pass it to the mtx functions and glUniformMatrix4fv as is.
+	float mtx[16];
+	
+	// Square of the uniform scale for AFFINE_RIGID (always 1) and AFFINE_UNIFORM_SCALE
+	float scaleSquared;
+	
+	unsigned int kind;
+	
+} demoAffine;
+
+// AFF = IdentityMatrix
+void affLoadIdentity(demoAffine* aff);
+
+// AFF = TranslationMatrix
+void affLoadTranslate(demoAffine* aff, float xTrans, float yTrans, float zTrans);
+
+// AFF = ScaleMatrix
+void affLoadScale(demoAffine* aff, float xScale, float yScale, float zScale);
+
+// AFF = RotateXYZMatrix
+void affLoadRotate(demoAffine* aff, float deg, float xAxis, float yAxis, float zAxis);
+
+// AFF = MTX, classifying MTX by measuring its upper 3x3 (MTX must be affine)
+void affLoadMatrix(demoAffine* aff, const float* mtx);
+
+// AFF = AFF * TranslationMatrix
+void affTranslateApply(demoAffine* aff, float xTrans, float yTrans, float zTrans);
+
+// AFF = AFF * ScaleMatrix
+void affScaleApply(demoAffine* aff, float xScale, float yScale, float zScale);
+
+// AFF = AFF * RotateXYZMatrix
+void affRotateApply(demoAffine* aff, float deg, float xAxis, float yAxis, float zAxis);
+
+// AFF = AFF * RotateXMatrix
+void affRotateXApply(demoAffine* aff, float deg);
+
+// AFF = AFF * RotateYMatrix
+void affRotateYApply(demoAffine* aff, float deg);
+
+// AFF = AFF * RotateZMatrix
+void affRotateZApply(demoAffine* aff, float deg);
+
+// AFF = LHS * RHS
+void affMultiply(demoAffine* aff, const demoAffine* lhs, const demoAffine* rhs);
+
+// AFF = SRC^-1.  A singular general transform gives the identity, as mtx3x3Invert does.
+void affInvert(demoAffine* aff, const demoAffine* src);
+
+// 3x3 MTX = Transpose(Inverse(TopLeft of SRC)), for transforming normals.
+// Rigid transforms need only a copy and uniform scales a multiply.
+void affNormalMatrix(float* mtx, const demoAffine* src);
+
+#endif // __AFFINE_UTIL_H__
@@ -11,6 +11,7 @@
 #define __IMAGE_UTIL_H__
 
 #include "glUtil.h"
+#include <stddef.h>
 
 typedef struct demoImageRec
 {
@@ -29,6 +30,10 @@ typedef struct demoImageRec
 
 demoImage* imgLoadImage(const char* filepathname, int flipVertical);
 
+// Decodes an image file (PNG, JPEG, etc.) that is already in memory.
+// The data is not retained after the function returns.
+demoImage* imgLoadImageData(const void* data, size_t size, int flipVertical);
+
 void imgDestroyImage(demoImage* image);
 
 #endif //__IMAGE_UTIL_H__
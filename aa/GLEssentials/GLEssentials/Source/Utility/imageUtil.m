@@ -14,20 +14,8 @@
 #import <Cocoa/Cocoa.h>
 #endif
 
-demoImage* imgLoadImage(const char* filepathname, int flipVertical)
+static demoImage* imgImageWithCGImage(CGImageRef cgImage, int flipVertical)
 {
-    NSString *filepathString = @(filepathname);
-    
-#if TARGET_IOS
-    UIImage* imageClass = [[UIImage alloc] initWithContentsOfFile:filepathString];
-#else   
-    NSImage *nsimage = [[NSImage alloc] initWithContentsOfFile: filepathString];
-    
-    NSBitmapImageRep *imageClass = [[NSBitmapImageRep alloc] initWithData:nsimage.TIFFRepresentation];
-    nsimage = nil;
-#endif
-    
-    CGImageRef cgImage = imageClass.CGImage;
     if (!cgImage)
     {
         return NULL;
@@ -60,6 +48,42 @@ demoImage* imgLoadImage(const char* filepathname, int flipVertical)
     return image;
 }
 
+demoImage* imgLoadImage(const char* filepathname, int flipVertical)
+{
+    NSString *filepathString = @(filepathname);
+    
+#if TARGET_IOS
+    UIImage* imageClass = [[UIImage alloc] initWithContentsOfFile:filepathString];
+#else   
+    NSImage *nsimage = [[NSImage alloc] initWithContentsOfFile: filepathString];
+    
+    NSBitmapImageRep *imageClass = [[NSBitmapImageRep alloc] initWithData:nsimage.TIFFRepresentation];
+    nsimage = nil;
+#endif
+    
+    return imgImageWithCGImage(imageClass.CGImage, flipVertical);
+}
+
+demoImage* imgLoadImageData(const void* data, size_t size, int flipVertical)
+{
+    // This may be called on worker threads (see pakLoadAssets) which
+    //  have no autorelease pool of their own
+    @autoreleasepool
+    {
+        // Wrap the bytes without copying them.  They only need to live
+        //  until the image has been drawn into our own buffer below.
+        NSData *imageData = [NSData dataWithBytesNoCopy:(void*)data length:size freeWhenDone:NO];
+        
+#if TARGET_IOS
+        UIImage* imageClass = [[UIImage alloc] initWithData:imageData];
+#else
+        NSBitmapImageRep *imageClass = [[NSBitmapImageRep alloc] initWithData:imageData];
+#endif
+        
+        return imgImageWithCGImage(imageClass.CGImage, flipVertical);
+    }
+}
+
 void imgDestroyImage(demoImage* image)
 {
     free(image->data);
@@ -11,6 +11,10 @@
 #include <math.h>
 #include <memory.h>
 
+// Keep multiplies and adds separate so results do not depend on whether the
+// compiler fuses them, and match the batched kernels in matrixUtilBatch.c
+#pragma STDC FP_CONTRACT OFF
+
 void mtxMultiply(float* ret, const float* lhs, const float* rhs)
 {
 	// [ 0 4  8 12 ]   [ 0 4  8 12 ]
@@ -164,7 +168,9 @@ void mtxInvert(float* mtx, const float* src)
 	float val, val2, val_inv;
 	int i, j, i4, i8, i12, ind;
 	
-	mtxTranspose(tmp, src);
+	// Gauss-Jordan elimination on a copy of src, applying the same row
+	// operations to the identity to turn it into the inverse
+	memcpy(tmp, src, 16 * sizeof(float));
 	
 	mtxLoadIdentity(mtx);
 	
@@ -427,75 +433,9 @@ void mtxLoadRotateZ(float* mtx, float rad)
 
 void mtxLoadRotate(float* mtx, float deg, float xAxis, float yAxis, float zAxis)
 {
-	float rad = deg * M_PI/180.0f;
-	
-	float sin_a = sinf(rad);
-	float cos_a = cosf(rad);
-	
-	// Calculate coeffs.  No need to check for zero magnitude because we wouldn't be here.
-	float magnitude = sqrtf(xAxis * xAxis + yAxis * yAxis + zAxis * zAxis);
-	
-	float p = 1.0f / magnitude;
-	float cos_am = 1.0f - cos_a;
-	
-	float xp = xAxis * p;
-	float yp = yAxis * p;
-	float zp = zAxis * p;
-	
-	float xx = xp * xp;
-	float yy = yp * yp;
-	float zz = zp * zp;
-	
-	float xy = xp * yp * cos_am;
-	float yz = yp * zp * cos_am;
-	float zx = zp * xp * cos_am;
-	
-	xp *= sin_a;
-	yp *= sin_a;
-	zp *= sin_a;
-	
-	// Load coefs
-	float m0  = xx + cos_a * (1.0f - xx);
-	float m1  = xy + zp;
-	float m2  = zx - yp;
-	float m4  = xy - zp;
-	float m5  = yy + cos_a * (1.0f - yy);
-	float m6  = yz + xp;
-	float m8  = zx + yp;
-	float m9  = yz - xp;
-	float m10 = zz + cos_a * (1.0f - zz);
-	
-	// Apply rotation 
-	float c1 = mtx[0];
-	float c2 = mtx[4];
-	float c3 = mtx[8];
-	mtx[0]  = c1 * m0 + c2 * m1 + c3 * m2;
-	mtx[4]  = c1 * m4 + c2 * m5 + c3 * m6;
-	mtx[8]  = c1 * m8 + c2 * m9 + c3 * m10;
-	
-	c1 = mtx[1];
-	c2 = mtx[5];
-	c3 = mtx[9];
-	mtx[1]  = c1 * m0 + c2 * m1 + c3 * m2;
-	mtx[5]  = c1 * m4 + c2 * m5 + c3 * m6;
-	mtx[9]  = c1 * m8 + c2 * m9 + c3 * m10;
-	
-	c1 = mtx[2];
-	c2 = mtx[6];
-	c3 = mtx[10];
-	mtx[2]  = c1 * m0 + c2 * m1 + c3 * m2;
-	mtx[6]  = c1 * m4 + c2 * m5 + c3 * m6;
-	mtx[10] = c1 * m8 + c2 * m9 + c3 * m10;
-	
-	c1 = mtx[3];
-	c2 = mtx[7];
-	c3 = mtx[11];
-	mtx[3]  = c1 * m0 + c2 * m1 + c3 * m2;
-	mtx[7]  = c1 * m4 + c2 * m5 + c3 * m6;
-	mtx[11] = c1 * m8 + c2 * m9 + c3 * m10;
-	
-	mtx[12] = mtx[13] = mtx[14] = 0.0;
-	mtx[15] = 1.0f;
+	// Rotating the identity loads the rotation itself
+	mtxLoadIdentity(mtx);
+	mtxRotateApply(mtx, deg, xAxis, yAxis, zAxis);
 }
 
 
@@ -533,7 +473,7 @@ void mtxScaleApply(float* mtx, float xScale, float yScale, float zScale)
 	
 	mtx[ 3] *= xScale;
 	mtx[ 7] *= yScale;
-	mtx[11] *= xScale;
+	mtx[11] *= zScale;
 }
 
 
@@ -852,10 +792,13 @@ void mtxRotateZMatrix(float* mtx, float rad)
 void mtxRotateMatrix(float* mtx, float rad, float xAxis, float yAxis, float zAxis)
 {
 	float rotMtx[16];
+	float src[16];
 	
-	mtxLoadRotate(rotMtx, rad, xAxis, yAxis, zAxis);
+	// mtxLoadRotate takes degrees, and mtxMultiply cannot write over its inputs
+	mtxLoadRotate(rotMtx, rad * (180.0f/M_PI), xAxis, yAxis, zAxis);
 	
-	mtxMultiply(mtx, rotMtx, mtx);
+	memcpy(src, mtx, 16 * sizeof(float));
+	mtxMultiply(mtx, rotMtx, src);
 }
 
 
@@ -919,17 +862,17 @@ void mtx3x3Invert(float* mtx, const float* src)
 	
 	memcpy(cpy, src, 9 * sizeof(float));
 	
-	mtx[0] =   cpy[4]*cpy[8] - cpy[5]*cpy[7]  / det;
+	mtx[0] =  (cpy[4]*cpy[8] - cpy[5]*cpy[7]) / det;
 	mtx[1] = -(cpy[1]*cpy[8] - cpy[7]*cpy[2]) / det;
-	mtx[2] =   cpy[1]*cpy[5] - cpy[4]*cpy[2]  / det;
+	mtx[2] =  (cpy[1]*cpy[5] - cpy[4]*cpy[2]) / det;
 	
 	mtx[3] = -(cpy[3]*cpy[8] - cpy[5]*cpy[6]) / det;
-	mtx[4] =   cpy[0]*cpy[8] - cpy[6]*cpy[2]  / det;
+	mtx[4] =  (cpy[0]*cpy[8] - cpy[6]*cpy[2]) / det;
 	mtx[5] = -(cpy[0]*cpy[5] - cpy[3]*cpy[2]) / det;
 	
-	mtx[6] =   cpy[3]*cpy[7] - cpy[6]*cpy[4]  / det;
+	mtx[6] =  (cpy[3]*cpy[7] - cpy[6]*cpy[4]) / det;
 	mtx[7] = -(cpy[0]*cpy[7] - cpy[6]*cpy[1]) / det;
-	mtx[8] =   cpy[0]*cpy[4] - cpy[1]*cpy[3]  / det;
+	mtx[8] =  (cpy[0]*cpy[4] - cpy[1]*cpy[3]) / det;
 }
 
 void mtx3x3Multiply(float* mtx, const float* lhs, const float* rhs)
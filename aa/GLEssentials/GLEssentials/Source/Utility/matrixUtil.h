@@ -112,5 +112,20 @@ void mtx3x3Transpose(float* mtx, const float* src);
 // 3x3 MTX = 3x3 SRC^-1
 void mtx3x3Invert(float* mtx, const float* src);
 
+// Batched variants operate on contiguous arrays of 'count' 4x4 matrices
+// (16 floats each, same layout as above).  The kernel (SSE, AVX or NEON)
+// is picked at runtime and produces results bit-identical to calling the
+// single matrix function on each element.  Output arrays must not overlap
+// the input arrays.
+
+// RET[i] = LHS[i] * RHS[i]
+void mtxMultiplyBatch(float* ret, const float* lhs, const float* rhs, unsigned int count);
+
+// MTX[i] = Transpose(SRC[i])
+void mtxTransposeBatch(float* mtx, const float* src, unsigned int count);
+
+// MTX[i] = SRC[i]^-1
+void mtxInvertBatch(float* mtx, const float* src, unsigned int count);
+
 #endif //__MATRIX_UTIL_H__
 
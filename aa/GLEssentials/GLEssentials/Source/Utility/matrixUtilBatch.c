@@ -0,0 +1,509 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Batched matrix functions operating on contiguous arrays of 4x4 matrices.
+  SSE, AVX or NEON kernels are selected at runtime, with a scalar fallback
+  that simply calls the single matrix functions in matrixUtil.c.
+ */
+
+#include "matrixUtil.h"
+
+// Keep multiplies and adds separate so every kernel rounds exactly like
+// the scalar functions (see the matching pragma in matrixUtil.c)
+#pragma STDC FP_CONTRACT OFF
+
+#if defined(__x86_64__) || defined(__i386__)
+#define MTX_BATCH_SSE 1
+#define MTX_BATCH_AVX 1
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define MTX_BATCH_NEON 1
+#include <arm_neon.h>
+#endif
+
+typedef struct mtxBatchKernelsRec
+{
+	void (*multiply)(float* ret, const float* lhs, const float* rhs, unsigned int count);
+	void (*transpose)(float* mtx, const float* src, unsigned int count);
+	void (*invert)(float* mtx, const float* src, unsigned int count);
+} mtxBatchKernels;
+
+//////////////////////
+// Scalar fallbacks //
+//////////////////////
+
+static void mtxMultiplyBatchScalar(float* ret, const float* lhs, const float* rhs, unsigned int count)
+{
+	for(; count; count--, ret += 16, lhs += 16, rhs += 16)
+	{
+		mtxMultiply(ret, lhs, rhs);
+	}
+}
+
+static void mtxTransposeBatchScalar(float* mtx, const float* src, unsigned int count)
+{
+	for(; count; count--, mtx += 16, src += 16)
+	{
+		mtxTranspose(mtx, src);
+	}
+}
+
+static void mtxInvertBatchScalar(float* mtx, const float* src, unsigned int count)
+{
+	for(; count; count--, mtx += 16, src += 16)
+	{
+		mtxInvert(mtx, src);
+	}
+}
+
+static const mtxBatchKernels mtxBatchScalar =
+{
+	mtxMultiplyBatchScalar,
+	mtxTransposeBatchScalar,
+	mtxInvertBatchScalar
+};
+
+#if MTX_BATCH_SSE
+
+/////////////////
+// SSE kernels //
+/////////////////
+
+static void mtxMultiplyBatchSSE(float* ret, const float* lhs, const float* rhs, unsigned int count)
+{
+	unsigned int col;
+
+	for(; count; count--, ret += 16, lhs += 16, rhs += 16)
+	{
+		__m128 c0 = _mm_loadu_ps(lhs);
+		__m128 c1 = _mm_loadu_ps(lhs + 4);
+		__m128 c2 = _mm_loadu_ps(lhs + 8);
+		__m128 c3 = _mm_loadu_ps(lhs + 12);
+
+		// Each column of RET is the LHS columns weighted by one column of RHS,
+		//  summed in the same order as mtxMultiply
+		for(col = 0; col < 16; col += 4)
+		{
+			__m128 r = _mm_mul_ps(c0, _mm_set1_ps(rhs[col]));
+			r = _mm_add_ps(r, _mm_mul_ps(c1, _mm_set1_ps(rhs[col + 1])));
+			r = _mm_add_ps(r, _mm_mul_ps(c2, _mm_set1_ps(rhs[col + 2])));
+			r = _mm_add_ps(r, _mm_mul_ps(c3, _mm_set1_ps(rhs[col + 3])));
+			_mm_storeu_ps(ret + col, r);
+		}
+	}
+}
+
+static void mtxTransposeBatchSSE(float* mtx, const float* src, unsigned int count)
+{
+	for(; count; count--, mtx += 16, src += 16)
+	{
+		__m128 c0 = _mm_loadu_ps(src);
+		__m128 c1 = _mm_loadu_ps(src + 4);
+		__m128 c2 = _mm_loadu_ps(src + 8);
+		__m128 c3 = _mm_loadu_ps(src + 12);
+
+		_MM_TRANSPOSE4_PS(c0, c1, c2, c3);
+
+		_mm_storeu_ps(mtx, c0);
+		_mm_storeu_ps(mtx + 4, c1);
+		_mm_storeu_ps(mtx + 8, c2);
+		_mm_storeu_ps(mtx + 12, c3);
+	}
+}
+
+// Converts 4 consecutive matrices to structure-of-arrays form
+static void mtxLoadSoASSE(__m128* soa, const float* src)
+{
+	int q;
+
+	for(q = 0; q < 16; q += 4)
+	{
+		__m128 a = _mm_loadu_ps(src + q);
+		__m128 b = _mm_loadu_ps(src + q + 16);
+		__m128 c = _mm_loadu_ps(src + q + 32);
+		__m128 d = _mm_loadu_ps(src + q + 48);
+
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+
+		soa[q]     = a;
+		soa[q + 1] = b;
+		soa[q + 2] = c;
+		soa[q + 3] = d;
+	}
+}
+
+static void mtxStoreSoASSE(float* mtx, const __m128* soa)
+{
+	int q;
+
+	for(q = 0; q < 16; q += 4)
+	{
+		__m128 a = soa[q];
+		__m128 b = soa[q + 1];
+		__m128 c = soa[q + 2];
+		__m128 d = soa[q + 3];
+
+		_MM_TRANSPOSE4_PS(a, b, c, d);
+
+		_mm_storeu_ps(mtx + q, a);
+		_mm_storeu_ps(mtx + q + 16, b);
+		_mm_storeu_ps(mtx + q + 32, c);
+		_mm_storeu_ps(mtx + q + 48, d);
+	}
+}
+
+#define MTX_KERNEL(name)  mtx##name##SSE
+#define MTX_VEC           __m128
+#define MTX_MASK          __m128
+#define MTX_SUB           _mm_sub_ps
+#define MTX_MUL           _mm_mul_ps
+#define MTX_DIV           _mm_div_ps
+#define MTX_ABS(a)        _mm_andnot_ps(_mm_set1_ps(-0.0f), (a))
+#define MTX_GT            _mm_cmpgt_ps
+#define MTX_EQ            _mm_cmpeq_ps
+#define MTX_OR            _mm_or_ps
+#define MTX_SEL(a, b, m)  _mm_or_ps(_mm_andnot_ps((m), (a)), _mm_and_ps((m), (b)))
+#define MTX_SPLAT         _mm_set1_ps
+#include "matrixUtilKernel.h"
+#undef MTX_KERNEL
+#undef MTX_VEC
+#undef MTX_MASK
+#undef MTX_SUB
+#undef MTX_MUL
+#undef MTX_DIV
+#undef MTX_ABS
+#undef MTX_GT
+#undef MTX_EQ
+#undef MTX_OR
+#undef MTX_SEL
+#undef MTX_SPLAT
+
+static void mtxInvertBatchSSE(float* mtx, const float* src, unsigned int count)
+{
+	__m128 soa[16];
+	__m128 inv[16];
+
+	for(; count >= 4; count -= 4, mtx += 64, src += 64)
+	{
+		mtxLoadSoASSE(soa, src);
+		mtxInvertSoASSE(inv, soa);
+		mtxStoreSoASSE(mtx, inv);
+	}
+
+	mtxInvertBatchScalar(mtx, src, count);
+}
+
+static const mtxBatchKernels mtxBatchSSE =
+{
+	mtxMultiplyBatchSSE,
+	mtxTransposeBatchSSE,
+	mtxInvertBatchSSE
+};
+
+#endif // MTX_BATCH_SSE
+
+#if MTX_BATCH_AVX
+
+/////////////////
+// AVX kernels //
+/////////////////
+
+#define MTX_AVX __attribute__((target("avx")))
+
+MTX_AVX static void mtxMultiplyBatchAVX(float* ret, const float* lhs, const float* rhs, unsigned int count)
+{
+	int col;
+
+	for(; count; count--, ret += 16, lhs += 16, rhs += 16)
+	{
+		// Both 128-bit halves hold the same LHS column so two RET
+		//  columns are produced per iteration
+		__m256 c0 = _mm256_broadcast_ps((const __m128*)lhs);
+		__m256 c1 = _mm256_broadcast_ps((const __m128*)(lhs + 4));
+		__m256 c2 = _mm256_broadcast_ps((const __m128*)(lhs + 8));
+		__m256 c3 = _mm256_broadcast_ps((const __m128*)(lhs + 12));
+
+		for(col = 0; col < 16; col += 8)
+		{
+			__m256 b = _mm256_loadu_ps(rhs + col);
+			__m256 r = _mm256_mul_ps(c0, _mm256_shuffle_ps(b, b, 0x00));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c1, _mm256_shuffle_ps(b, b, 0x55)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c2, _mm256_shuffle_ps(b, b, 0xAA)));
+			r = _mm256_add_ps(r, _mm256_mul_ps(c3, _mm256_shuffle_ps(b, b, 0xFF)));
+			_mm256_storeu_ps(ret + col, r);
+		}
+	}
+}
+
+// Converts 8 consecutive matrices to structure-of-arrays form
+MTX_AVX static void mtxLoadSoAAVX(__m256* soa, const float* src)
+{
+	__m128 lo[16];
+	__m128 hi[16];
+	int k;
+
+	mtxLoadSoASSE(lo, src);
+	mtxLoadSoASSE(hi, src + 64);
+
+	for(k = 0; k < 16; k++)
+	{
+		soa[k] = _mm256_insertf128_ps(_mm256_castps128_ps256(lo[k]), hi[k], 1);
+	}
+}
+
+MTX_AVX static void mtxStoreSoAAVX(float* mtx, const __m256* soa)
+{
+	__m128 lo[16];
+	__m128 hi[16];
+	int k;
+
+	for(k = 0; k < 16; k++)
+	{
+		lo[k] = _mm256_castps256_ps128(soa[k]);
+		hi[k] = _mm256_extractf128_ps(soa[k], 1);
+	}
+
+	mtxStoreSoASSE(mtx, lo);
+	mtxStoreSoASSE(mtx + 64, hi);
+}
+
+#define MTX_KERNEL(name)  MTX_AVX mtx##name##AVX
+#define MTX_VEC           __m256
+#define MTX_MASK          __m256
+#define MTX_SUB           _mm256_sub_ps
+#define MTX_MUL           _mm256_mul_ps
+#define MTX_DIV           _mm256_div_ps
+#define MTX_ABS(a)        _mm256_andnot_ps(_mm256_set1_ps(-0.0f), (a))
+#define MTX_GT(a, b)      _mm256_cmp_ps((a), (b), _CMP_GT_OQ)
+#define MTX_EQ(a, b)      _mm256_cmp_ps((a), (b), _CMP_EQ_OQ)
+#define MTX_OR            _mm256_or_ps
+#define MTX_SEL(a, b, m)  _mm256_blendv_ps((a), (b), (m))
+#define MTX_SPLAT         _mm256_set1_ps
+#include "matrixUtilKernel.h"
+#undef MTX_KERNEL
+#undef MTX_VEC
+#undef MTX_MASK
+#undef MTX_SUB
+#undef MTX_MUL
+#undef MTX_DIV
+#undef MTX_ABS
+#undef MTX_GT
+#undef MTX_EQ
+#undef MTX_OR
+#undef MTX_SEL
+#undef MTX_SPLAT
+
+MTX_AVX static void mtxInvertBatchAVX(float* mtx, const float* src, unsigned int count)
+{
+	__m256 soa[16];
+	__m256 inv[16];
+
+	for(; count >= 8; count -= 8, mtx += 128, src += 128)
+	{
+		mtxLoadSoAAVX(soa, src);
+		mtxInvertSoAAVX(inv, soa);
+		mtxStoreSoAAVX(mtx, inv);
+	}
+
+	mtxInvertBatchSSE(mtx, src, count);
+}
+
+static const mtxBatchKernels mtxBatchAVX =
+{
+	mtxMultiplyBatchAVX,
+	mtxTransposeBatchSSE,
+	mtxInvertBatchAVX
+};
+
+#endif // MTX_BATCH_AVX
+
+#if MTX_BATCH_NEON
+
+//////////////////
+// NEON kernels //
+//////////////////
+
+static void mtxMultiplyBatchNEON(float* ret, const float* lhs, const float* rhs, unsigned int count)
+{
+	unsigned int col;
+
+	for(; count; count--, ret += 16, lhs += 16, rhs += 16)
+	{
+		float32x4_t c0 = vld1q_f32(lhs);
+		float32x4_t c1 = vld1q_f32(lhs + 4);
+		float32x4_t c2 = vld1q_f32(lhs + 8);
+		float32x4_t c3 = vld1q_f32(lhs + 12);
+
+		for(col = 0; col < 16; col += 4)
+		{
+			float32x4_t b = vld1q_f32(rhs + col);
+			float32x4_t r = vmulq_laneq_f32(c0, b, 0);
+			r = vaddq_f32(r, vmulq_laneq_f32(c1, b, 1));
+			r = vaddq_f32(r, vmulq_laneq_f32(c2, b, 2));
+			r = vaddq_f32(r, vmulq_laneq_f32(c3, b, 3));
+			vst1q_f32(ret + col, r);
+		}
+	}
+}
+
+static void mtxTransposeBatchNEON(float* mtx, const float* src, unsigned int count)
+{
+	for(; count; count--, mtx += 16, src += 16)
+	{
+		// De-interleaving load yields the rows of SRC, which are the columns of MTX
+		float32x4x4_t rows = vld4q_f32(src);
+
+		vst1q_f32(mtx, rows.val[0]);
+		vst1q_f32(mtx + 4, rows.val[1]);
+		vst1q_f32(mtx + 8, rows.val[2]);
+		vst1q_f32(mtx + 12, rows.val[3]);
+	}
+}
+
+static inline void mtxTranspose4NEON(float32x4_t* v)
+{
+	float32x4_t t0 = vtrn1q_f32(v[0], v[1]);
+	float32x4_t t1 = vtrn2q_f32(v[0], v[1]);
+	float32x4_t t2 = vtrn1q_f32(v[2], v[3]);
+	float32x4_t t3 = vtrn2q_f32(v[2], v[3]);
+
+	v[0] = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2)));
+	v[1] = vreinterpretq_f32_f64(vtrn1q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3)));
+	v[2] = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t0), vreinterpretq_f64_f32(t2)));
+	v[3] = vreinterpretq_f32_f64(vtrn2q_f64(vreinterpretq_f64_f32(t1), vreinterpretq_f64_f32(t3)));
+}
+
+// Converts 4 consecutive matrices to structure-of-arrays form
+static void mtxLoadSoANEON(float32x4_t* soa, const float* src)
+{
+	int q;
+
+	for(q = 0; q < 16; q += 4)
+	{
+		soa[q]     = vld1q_f32(src + q);
+		soa[q + 1] = vld1q_f32(src + q + 16);
+		soa[q + 2] = vld1q_f32(src + q + 32);
+		soa[q + 3] = vld1q_f32(src + q + 48);
+
+		mtxTranspose4NEON(soa + q);
+	}
+}
+
+static void mtxStoreSoANEON(float* mtx, const float32x4_t* soa)
+{
+	float32x4_t v[4];
+	int q;
+
+	for(q = 0; q < 16; q += 4)
+	{
+		v[0] = soa[q];
+		v[1] = soa[q + 1];
+		v[2] = soa[q + 2];
+		v[3] = soa[q + 3];
+
+		mtxTranspose4NEON(v);
+
+		vst1q_f32(mtx + q, v[0]);
+		vst1q_f32(mtx + q + 16, v[1]);
+		vst1q_f32(mtx + q + 32, v[2]);
+		vst1q_f32(mtx + q + 48, v[3]);
+	}
+}
+
+#define MTX_KERNEL(name)  mtx##name##NEON
+#define MTX_VEC           float32x4_t
+#define MTX_MASK          uint32x4_t
+#define MTX_SUB           vsubq_f32
+#define MTX_MUL           vmulq_f32
+#define MTX_DIV           vdivq_f32
+#define MTX_ABS           vabsq_f32
+#define MTX_GT            vcgtq_f32
+#define MTX_EQ            vceqq_f32
+#define MTX_OR            vorrq_u32
+#define MTX_SEL(a, b, m)  vbslq_f32((m), (b), (a))
+#define MTX_SPLAT         vdupq_n_f32
+#include "matrixUtilKernel.h"
+#undef MTX_KERNEL
+#undef MTX_VEC
+#undef MTX_MASK
+#undef MTX_SUB
+#undef MTX_MUL
+#undef MTX_DIV
+#undef MTX_ABS
+#undef MTX_GT
+#undef MTX_EQ
+#undef MTX_OR
+#undef MTX_SEL
+#undef MTX_SPLAT
+
+static void mtxInvertBatchNEON(float* mtx, const float* src, unsigned int count)
+{
+	float32x4_t soa[16];
+	float32x4_t inv[16];
+
+	for(; count >= 4; count -= 4, mtx += 64, src += 64)
+	{
+		mtxLoadSoANEON(soa, src);
+		mtxInvertSoANEON(inv, soa);
+		mtxStoreSoANEON(mtx, inv);
+	}
+
+	mtxInvertBatchScalar(mtx, src, count);
+}
+
+static const mtxBatchKernels mtxBatchNEON =
+{
+	mtxMultiplyBatchNEON,
+	mtxTransposeBatchNEON,
+	mtxInvertBatchNEON
+};
+
+#endif // MTX_BATCH_NEON
+
+///////////////////////
+// Runtime selection //
+///////////////////////
+
+static const mtxBatchKernels* mtxBatchSelect(void)
+{
+	// Selection is idempotent so a racing first call simply stores the same pointer twice
+	static const mtxBatchKernels* kernels = NULL;
+
+	if(NULL == kernels)
+	{
+		const mtxBatchKernels* selected = &mtxBatchScalar;
+
+#if MTX_BATCH_SSE
+		selected = &mtxBatchSSE;
+#endif
+#if MTX_BATCH_AVX
+		if(__builtin_cpu_supports("avx"))
+		{
+			selected = &mtxBatchAVX;
+		}
+#endif
+#if MTX_BATCH_NEON
+		selected = &mtxBatchNEON;
+#endif
+
+		kernels = selected;
+	}
+
+	return kernels;
+}
+
+void mtxMultiplyBatch(float* ret, const float* lhs, const float* rhs, unsigned int count)
+{
+	mtxBatchSelect()->multiply(ret, lhs, rhs, count);
+}
+
+void mtxTransposeBatch(float* mtx, const float* src, unsigned int count)
+{
+	mtxBatchSelect()->transpose(mtx, src, count);
+}
+
+void mtxInvertBatch(float* mtx, const float* src, unsigned int count)
+{
+	mtxBatchSelect()->invert(mtx, src, count);
+}
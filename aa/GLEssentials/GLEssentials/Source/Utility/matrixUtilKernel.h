@@ -0,0 +1,106 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Vector kernel body shared by the SSE, AVX and NEON batch matrix functions.
+  This file is included once per instruction set by matrixUtilBatch.c after
+  defining the MTX_* macros below; it is not a public header.
+ */
+
+// Required macros:
+//   MTX_KERNEL(name)     Decorates a kernel function name (and adds any target attributes)
+//   MTX_VEC / MTX_MASK   Vector and comparison mask types
+//   MTX_SUB, MTX_MUL, MTX_DIV, MTX_ABS
+//   MTX_GT, MTX_EQ       Lane-wise comparisons returning MTX_MASK
+//   MTX_OR               Mask union
+//   MTX_SEL(a, b, m)     Lane-wise (m ? b : a)
+//   MTX_SPLAT(f)         Broadcast a float to all lanes
+
+// Inverts one matrix per lane.  src and mtx hold the 16 matrix elements in
+// structure-of-arrays form (src[k] carries element k of every matrix).
+// Each lane follows exactly the same sequence of operations as mtxInvert so
+// the results are bit-identical, including the identity fallback for
+// singular matrices.
+static void MTX_KERNEL(InvertSoA)(MTX_VEC* mtx, const MTX_VEC* src)
+{
+	MTX_VEC tmp[16];
+	MTX_VEC val, val_inv, ind, a, b;
+	MTX_MASK swap, singular;
+	const MTX_VEC zero = MTX_SPLAT(0.0f);
+	const MTX_VEC one  = MTX_SPLAT(1.0f);
+	int i, j, k, r;
+
+	// tmp = src, mtx = IdentityMatrix
+	for(k = 0; k < 16; k++)
+	{
+		tmp[k] = src[k];
+		mtx[k] = ((k & 3) == (k >> 2)) ? one : zero;
+	}
+
+	singular = MTX_EQ(one, zero);
+
+	for(i = 0; i != 4; i++)
+	{
+		// Find the pivot in column i
+		val = tmp[(i << 2) + i];
+		ind = MTX_SPLAT((float)i);
+
+		for(j = i + 1; j != 4; j++)
+		{
+			swap = MTX_GT(MTX_ABS(tmp[(i << 2) + j]), MTX_ABS(val));
+			ind = MTX_SEL(ind, MTX_SPLAT((float)j), swap);
+			val = MTX_SEL(val, tmp[(i << 2) + j], swap);
+		}
+
+		// Swap row i with the pivot row in lanes where they differ
+		for(j = i + 1; j != 4; j++)
+		{
+			swap = MTX_EQ(ind, MTX_SPLAT((float)j));
+
+			for(k = 0; k < 16; k += 4)
+			{
+				a = mtx[i + k];
+				b = mtx[j + k];
+				mtx[i + k] = MTX_SEL(a, b, swap);
+				mtx[j + k] = MTX_SEL(b, a, swap);
+
+				a = tmp[i + k];
+				b = tmp[j + k];
+				tmp[i + k] = MTX_SEL(a, b, swap);
+				tmp[j + k] = MTX_SEL(b, a, swap);
+			}
+		}
+
+		// Lanes with a zero pivot resolve to the identity at the end
+		singular = MTX_OR(singular, MTX_EQ(val, zero));
+
+		val_inv = MTX_DIV(one, val);
+
+		for(k = 0; k < 16; k += 4)
+		{
+			tmp[i + k] = MTX_MUL(tmp[i + k], val_inv);
+			mtx[i + k] = MTX_MUL(mtx[i + k], val_inv);
+		}
+
+		for(r = 0; r != 4; r++)
+		{
+			if(r == i)
+			{
+				continue;
+			}
+
+			val = tmp[(i << 2) + r];
+
+			for(k = 0; k < 16; k += 4)
+			{
+				tmp[r + k] = MTX_SUB(tmp[r + k], MTX_MUL(tmp[i + k], val));
+				mtx[r + k] = MTX_SUB(mtx[r + k], MTX_MUL(mtx[i + k], val));
+			}
+		}
+	}
+
+	for(k = 0; k < 16; k++)
+	{
+		mtx[k] = MTX_SEL(mtx[k], ((k & 3) == (k >> 2)) ? one : zero, singular);
+	}
+}
@@ -0,0 +1,687 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for reordering the triangles and vertices of a model so that it
+  draws efficiently.
+ */
+
+#include "meshUtil.h"
+#include "vectorUtil.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define MESH_NO_VERTEX 0xFFFFFFFF
+
+typedef struct meshClusterRec
+{
+	GLuint firstTriangle;
+	GLuint numTriangles;
+	GLfloat sortKey;
+} meshCluster;
+
+static GLsizei mshTypeSize(GLenum type)
+{
+	switch (type) {
+		case GL_BYTE:
+			return sizeof(GLbyte);
+		case GL_UNSIGNED_BYTE:
+			return sizeof(GLubyte);
+		case GL_SHORT:
+			return sizeof(GLshort);
+		case GL_UNSIGNED_SHORT:
+			return sizeof(GLushort);
+		case GL_INT:
+			return sizeof(GLint);
+		case GL_UNSIGNED_INT:
+			return sizeof(GLuint);
+		case GL_FLOAT:
+			return sizeof(GLfloat);
+	}
+	return 0;
+}
+
+// Returns the model's elements widened to GLuint, or NULL if the element
+// type is not supported or an element references a vertex out of range
+static GLuint* mshCopyElements(const demoModel* model)
+{
+	GLuint* indices = (GLuint*)malloc(model->numElements * sizeof(GLuint));
+	GLuint elemNum;
+
+	if(NULL == indices)
+	{
+		return NULL;
+	}
+
+	for(elemNum = 0; elemNum < model->numElements; elemNum++)
+	{
+		switch(model->elementType)
+		{
+			case GL_UNSIGNED_INT:
+				memcpy(&indices[elemNum], model->elements + elemNum * sizeof(GLuint), sizeof(GLuint));
+				break;
+			case GL_UNSIGNED_SHORT:
+			{
+				GLushort element;
+				memcpy(&element, model->elements + elemNum * sizeof(GLushort), sizeof(GLushort));
+				indices[elemNum] = element;
+				break;
+			}
+			case GL_UNSIGNED_BYTE:
+				indices[elemNum] = model->elements[elemNum];
+				break;
+			default:
+				free(indices);
+				return NULL;
+		}
+
+		if(indices[elemNum] >= model->numVertcies)
+		{
+			free(indices);
+			return NULL;
+		}
+	}
+
+	return indices;
+}
+
+// Writes indices back into the model's elements in their original type
+static int mshStoreElements(demoModel* model, const GLuint* indices)
+{
+	GLubyte* elements = model->elements;
+	GLuint elemNum;
+
+	if(mdlIsMappedArray(model, elements))
+	{
+		elements = (GLubyte*)malloc(model->elementArraySize);
+
+		if(NULL == elements)
+		{
+			return 0;
+		}
+	}
+
+	for(elemNum = 0; elemNum < model->numElements; elemNum++)
+	{
+		switch(model->elementType)
+		{
+			case GL_UNSIGNED_INT:
+				((GLuint*)elements)[elemNum] = indices[elemNum];
+				break;
+			case GL_UNSIGNED_SHORT:
+				((GLushort*)elements)[elemNum] = (GLushort)indices[elemNum];
+				break;
+			case GL_UNSIGNED_BYTE:
+				elements[elemNum] = (GLubyte)indices[elemNum];
+				break;
+		}
+	}
+
+	model->elements = elements;
+
+	return 1;
+}
+
+void mshAnalyzeVertexCache(const demoModel* model, GLuint cacheSize, demoMeshStats* stats)
+{
+	GLuint* indices = mshCopyElements(model);
+	GLuint* cacheTime = (GLuint*)calloc(model->numVertcies, sizeof(GLuint));
+	GLuint numTriangles = model->numElements / 3;
+	GLuint elemNum, vertNum;
+
+	stats->acmr = 0;
+	stats->atvr = 0;
+
+	if(NULL == indices || NULL == cacheTime || 0 == numTriangles || 0 == cacheSize)
+	{
+		free(indices);
+		free(cacheTime);
+		return;
+	}
+
+	// A vertex is in the FIFO cache if fewer than cacheSize misses
+	//  have happened since it was inserted.  Starting the clock at
+	//  cacheSize makes every vertex miss the first time it is used.
+	GLuint misses = 0;
+	GLuint clock = cacheSize;
+
+	for(elemNum = 0; elemNum < numTriangles * 3; elemNum++)
+	{
+		GLuint vertex = indices[elemNum];
+
+		if(clock - cacheTime[vertex] >= cacheSize)
+		{
+			cacheTime[vertex] = clock++;
+			misses++;
+		}
+	}
+
+	GLuint numUsed = 0;
+
+	for(vertNum = 0; vertNum < model->numVertcies; vertNum++)
+	{
+		numUsed += (0 != cacheTime[vertNum]);
+	}
+
+	stats->acmr = (GLfloat)misses / numTriangles;
+	stats->atvr = (GLfloat)misses / numUsed;
+
+	free(indices);
+	free(cacheTime);
+}
+
+// Pops vertices off the dead-end stack, then scans the input order, until
+// a vertex with live triangles is found
+static GLuint mshSkipDeadEnd(const GLuint* liveCount, const GLuint* deadEnd, GLuint* deadEndSize,
+							 GLuint* cursor, GLuint numVertices)
+{
+	while(*deadEndSize)
+	{
+		GLuint vertex = deadEnd[--(*deadEndSize)];
+
+		if(liveCount[vertex] > 0)
+		{
+			return vertex;
+		}
+	}
+
+	while(*cursor < numVertices)
+	{
+		GLuint vertex = (*cursor)++;
+
+		if(liveCount[vertex] > 0)
+		{
+			return vertex;
+		}
+	}
+
+	return MESH_NO_VERTEX;
+}
+
+// Sorts clusters by descending occlusion potential
+static int mshCompareClusters(const void* lhs, const void* rhs)
+{
+	const meshCluster* lhsCluster = (const meshCluster*)lhs;
+	const meshCluster* rhsCluster = (const meshCluster*)rhs;
+
+	if(lhsCluster->sortKey != rhsCluster->sortKey)
+	{
+		return (lhsCluster->sortKey > rhsCluster->sortKey) ? -1 : 1;
+	}
+
+	return (lhsCluster->firstTriangle < rhsCluster->firstTriangle) ? -1 : 1;
+}
+
+// Splits the hard clusters found by Tipsify at soft boundaries and orders
+// them so that clusters facing away from the mesh center draw first.
+// triangles holds triangle numbers in draw order and is reordered in place.
+static int mshSortClusters(const demoModel* model, const GLuint* indices, GLuint* triangles,
+						   const GLubyte* hardBoundary, GLuint cacheSize, GLfloat threshold)
+{
+	GLuint numTriangles = model->numElements / 3;
+	GLuint positionStride = model->positionSize;
+	const GLfloat* positions = (const GLfloat*)model->positions;
+
+	meshCluster* clusters = (meshCluster*)malloc(numTriangles * sizeof(meshCluster));
+	GLuint* cacheTime = (GLuint*)calloc(model->numVertcies, sizeof(GLuint));
+	GLfloat* geometry = (GLfloat*)malloc(numTriangles * 6 * sizeof(GLfloat));
+	GLuint* sorted = (GLuint*)malloc(numTriangles * sizeof(GLuint));
+
+	if(NULL == clusters || NULL == cacheTime || NULL == geometry || NULL == sorted)
+	{
+		free(clusters);
+		free(cacheTime);
+		free(geometry);
+		free(sorted);
+		return 0;
+	}
+
+	GLuint triNum, vertNum, clusterNum, component;
+	GLuint clock = cacheSize;
+	GLuint misses = 0;
+
+	// ACMR of the Tipsify order, which the clusters are measured against
+	for(triNum = 0; triNum < numTriangles; triNum++)
+	{
+		const GLuint* triangle = &indices[triangles[triNum] * 3];
+
+		for(vertNum = 0; vertNum < 3; vertNum++)
+		{
+			if(clock - cacheTime[triangle[vertNum]] >= cacheSize)
+			{
+				cacheTime[triangle[vertNum]] = clock++;
+				misses++;
+			}
+		}
+	}
+
+	threshold *= (GLfloat)misses / numTriangles;
+
+	meshCluster* cluster = NULL;
+	GLuint numClusters = 0;
+	GLuint clusterMisses = 0;
+	GLboolean splitPending = GL_FALSE;
+
+	for(triNum = 0; triNum < numTriangles; triNum++)
+	{
+		if(NULL == cluster || hardBoundary[triNum] || splitPending)
+		{
+			// Each cluster starts with an empty cache since clusters
+			//  will no longer be drawn next to their current neighbours
+			cluster = &clusters[numClusters++];
+			cluster->firstTriangle = triNum;
+			cluster->numTriangles = 0;
+			clusterMisses = 0;
+			clock += cacheSize;
+		}
+
+		const GLuint* triangle = &indices[triangles[triNum] * 3];
+
+		for(vertNum = 0; vertNum < 3; vertNum++)
+		{
+			if(clock - cacheTime[triangle[vertNum]] >= cacheSize)
+			{
+				cacheTime[triangle[vertNum]] = clock++;
+				clusterMisses++;
+			}
+		}
+
+		cluster->numTriangles++;
+
+		// Soft boundary: once the cluster has amortized its cache warm up
+		//  it can end without raising the overall miss ratio above threshold
+		splitPending = ((GLfloat)clusterMisses / cluster->numTriangles < threshold);
+	}
+
+	// Area weighted centroid (first 3 floats) and normal (last 3 floats)
+	//  of each cluster, and the centroid of the whole mesh
+	GLfloat meshCentroid[3] = { 0, 0, 0 };
+	GLfloat meshArea = 0;
+
+	for(clusterNum = 0; clusterNum < numClusters; clusterNum++)
+	{
+		GLfloat* centroid = &geometry[clusterNum * 6];
+		GLfloat* normal = &geometry[clusterNum * 6 + 3];
+		GLfloat area = 0;
+
+		cluster = &clusters[clusterNum];
+		memset(centroid, 0, 6 * sizeof(GLfloat));
+
+		for(triNum = cluster->firstTriangle; triNum < cluster->firstTriangle + cluster->numTriangles; triNum++)
+		{
+			const GLuint* triangle = &indices[triangles[triNum] * 3];
+			const GLfloat* p0 = &positions[triangle[0] * positionStride];
+			const GLfloat* p1 = &positions[triangle[1] * positionStride];
+			const GLfloat* p2 = &positions[triangle[2] * positionStride];
+			GLfloat edge1[3], edge2[3], faceNormal[3];
+
+			vec3Subtract(edge1, p1, p0);
+			vec3Subtract(edge2, p2, p0);
+			vec3CrossProduct(faceNormal, edge1, edge2);
+
+			// The cross product's length is twice the triangle's area
+			GLfloat faceArea = vec3Length(faceNormal);
+
+			vec3Add(normal, normal, faceNormal);
+			area += faceArea;
+
+			for(component = 0; component < 3; component++)
+			{
+				centroid[component] += (p0[component] + p1[component] + p2[component]) * faceArea / 3.0f;
+			}
+		}
+
+		vec3Add(meshCentroid, meshCentroid, centroid);
+		meshArea += area;
+
+		if(area > 0)
+		{
+			for(component = 0; component < 3; component++)
+			{
+				centroid[component] /= area;
+			}
+
+			vec3Normalize(normal, normal);
+		}
+	}
+
+	if(meshArea > 0)
+	{
+		for(component = 0; component < 3; component++)
+		{
+			meshCentroid[component] /= meshArea;
+		}
+	}
+
+	// Clusters far out along their own normal are likely to occlude the
+	//  rest of the mesh from most viewpoints so they should draw first
+	for(clusterNum = 0; clusterNum < numClusters; clusterNum++)
+	{
+		GLfloat offset[3];
+
+		vec3Subtract(offset, &geometry[clusterNum * 6], meshCentroid);
+		clusters[clusterNum].sortKey = vec3DotProduct(offset, &geometry[clusterNum * 6 + 3]);
+	}
+
+	qsort(clusters, numClusters, sizeof(meshCluster), mshCompareClusters);
+
+	GLuint numSorted = 0;
+
+	for(clusterNum = 0; clusterNum < numClusters; clusterNum++)
+	{
+		memcpy(&sorted[numSorted], &triangles[clusters[clusterNum].firstTriangle],
+			   clusters[clusterNum].numTriangles * sizeof(GLuint));
+		numSorted += clusters[clusterNum].numTriangles;
+	}
+
+	memcpy(triangles, sorted, numTriangles * sizeof(GLuint));
+
+	free(clusters);
+	free(cacheTime);
+	free(geometry);
+	free(sorted);
+	return 1;
+}
+
+int mshOptimizeVertexCache(demoModel* model, GLuint cacheSize, GLfloat overdrawThreshold)
+{
+	GLuint numTriangles = model->numElements / 3;
+	GLuint numVertices = model->numVertcies;
+	GLuint triNum, vertNum, elemNum;
+
+	if(0 == numTriangles || 0 == cacheSize || model->numSubmeshes)
+	{
+		return 0;
+	}
+
+	if(overdrawThreshold > 0 && (GL_FLOAT != model->positionType || model->positionSize < 3))
+	{
+		return 0;
+	}
+
+	GLuint* indices = mshCopyElements(model);
+
+	// Vertex to triangle adjacency stored as offsets into a single array
+	GLuint* adjacencyOffset = (GLuint*)calloc(numVertices + 1, sizeof(GLuint));
+	GLuint* adjacency = (GLuint*)malloc(numTriangles * 3 * sizeof(GLuint));
+	GLuint* liveCount = (GLuint*)calloc(numVertices, sizeof(GLuint));
+	GLuint* cacheTime = (GLuint*)calloc(numVertices, sizeof(GLuint));
+	GLuint* deadEnd = (GLuint*)malloc(numTriangles * 3 * sizeof(GLuint));
+	GLuint* candidates = (GLuint*)malloc(numTriangles * 3 * sizeof(GLuint));
+	GLubyte* emitted = (GLubyte*)calloc(numTriangles, sizeof(GLubyte));
+	GLubyte* hardBoundary = (GLubyte*)calloc(numTriangles, sizeof(GLubyte));
+	GLuint* triangles = (GLuint*)malloc(numTriangles * sizeof(GLuint));
+	GLuint* reordered = (GLuint*)malloc(numTriangles * 3 * sizeof(GLuint));
+	int success = 0;
+
+	if(NULL == indices || NULL == adjacencyOffset || NULL == adjacency || NULL == liveCount ||
+	   NULL == cacheTime || NULL == deadEnd || NULL == candidates || NULL == emitted ||
+	   NULL == hardBoundary || NULL == triangles || NULL == reordered)
+	{
+		goto cleanup;
+	}
+
+	for(elemNum = 0; elemNum < numTriangles * 3; elemNum++)
+	{
+		liveCount[indices[elemNum]]++;
+	}
+
+	for(vertNum = 0; vertNum < numVertices; vertNum++)
+	{
+		adjacencyOffset[vertNum + 1] = adjacencyOffset[vertNum] + liveCount[vertNum];
+	}
+
+	// Fill using cacheTime as a per vertex write cursor, then clear it
+	for(elemNum = 0; elemNum < numTriangles * 3; elemNum++)
+	{
+		GLuint vertex = indices[elemNum];
+		adjacency[adjacencyOffset[vertex] + cacheTime[vertex]++] = elemNum / 3;
+	}
+
+	memset(cacheTime, 0, numVertices * sizeof(GLuint));
+
+	GLuint fanVertex = 0;
+	GLuint clock = cacheSize + 1;
+	GLuint cursor = 1;
+	GLuint deadEndSize = 0;
+	GLuint numEmitted = 0;
+	GLboolean startsHardCluster = GL_TRUE;
+
+	while(MESH_NO_VERTEX != fanVertex)
+	{
+		GLuint numCandidates = 0;
+		GLuint adjNum;
+
+		// Emit every remaining triangle around the fanning vertex
+		for(adjNum = adjacencyOffset[fanVertex]; adjNum < adjacencyOffset[fanVertex + 1]; adjNum++)
+		{
+			GLuint triangle = adjacency[adjNum];
+
+			if(emitted[triangle])
+			{
+				continue;
+			}
+
+			for(vertNum = 0; vertNum < 3; vertNum++)
+			{
+				GLuint vertex = indices[triangle * 3 + vertNum];
+
+				deadEnd[deadEndSize++] = vertex;
+				candidates[numCandidates++] = vertex;
+				liveCount[vertex]--;
+
+				if(clock - cacheTime[vertex] > cacheSize)
+				{
+					cacheTime[vertex] = clock++;
+				}
+			}
+
+			emitted[triangle] = 1;
+			hardBoundary[numEmitted] = startsHardCluster;
+			triangles[numEmitted++] = triangle;
+			startsHardCluster = GL_FALSE;
+		}
+
+		// Pick the candidate that will still be in the cache after its own
+		//  fan is emitted, preferring the oldest such vertex
+		GLuint nextVertex = MESH_NO_VERTEX;
+		GLint bestPriority = -1;
+		GLuint candNum;
+
+		for(candNum = 0; candNum < numCandidates; candNum++)
+		{
+			GLuint vertex = candidates[candNum];
+
+			if(liveCount[vertex] > 0)
+			{
+				GLint priority = 0;
+
+				if(clock - cacheTime[vertex] + 2 * liveCount[vertex] <= cacheSize)
+				{
+					priority = clock - cacheTime[vertex];
+				}
+
+				if(priority > bestPriority)
+				{
+					bestPriority = priority;
+					nextVertex = vertex;
+				}
+			}
+		}
+
+		if(MESH_NO_VERTEX == nextVertex)
+		{
+			nextVertex = mshSkipDeadEnd(liveCount, deadEnd, &deadEndSize, &cursor, numVertices);
+			startsHardCluster = GL_TRUE;
+		}
+
+		fanVertex = nextVertex;
+	}
+
+	// Every triangle should have been emitted unless the mesh has degenerate
+	//  triangles repeating a vertex, which drive live counts below zero
+	if(numEmitted != numTriangles)
+	{
+		for(triNum = 0; triNum < numTriangles; triNum++)
+		{
+			if(!emitted[triNum])
+			{
+				hardBoundary[numEmitted] = GL_TRUE;
+				triangles[numEmitted++] = triNum;
+			}
+		}
+	}
+
+	if(overdrawThreshold > 0 &&
+	   !mshSortClusters(model, indices, triangles, hardBoundary, cacheSize, overdrawThreshold))
+	{
+		goto cleanup;
+	}
+
+	for(triNum = 0; triNum < numTriangles; triNum++)
+	{
+		memcpy(&reordered[triNum * 3], &indices[triangles[triNum] * 3], 3 * sizeof(GLuint));
+	}
+
+	// Any elements after the last whole triangle keep their place
+	memcpy(indices, reordered, numTriangles * 3 * sizeof(GLuint));
+
+	success = mshStoreElements(model, indices);
+
+cleanup:
+	free(indices);
+	free(adjacencyOffset);
+	free(adjacency);
+	free(liveCount);
+	free(cacheTime);
+	free(deadEnd);
+	free(candidates);
+	free(emitted);
+	free(hardBoundary);
+	free(triangles);
+	free(reordered);
+
+	return success;
+}
+
+// Moves each vertex of an attribute array to its new position in remap
+static int mshRemapAttribute(demoModel* model, GLubyte** array, GLsizei arraySize,
+							 GLenum type, GLuint size, const GLuint* remap)
+{
+	GLsizei stride = mshTypeSize(type) * size;
+	GLuint vertNum;
+
+	if(NULL == *array)
+	{
+		return 1;
+	}
+
+	if(0 == stride || (GLsizei)(stride * model->numVertcies) > arraySize)
+	{
+		return 0;
+	}
+
+	GLubyte* remapped = (GLubyte*)malloc(arraySize);
+
+	if(NULL == remapped)
+	{
+		return 0;
+	}
+
+	for(vertNum = 0; vertNum < model->numVertcies; vertNum++)
+	{
+		memcpy(remapped + remap[vertNum] * stride, *array + vertNum * stride, stride);
+	}
+
+	if(!mdlIsMappedArray(model, *array))
+	{
+		free(*array);
+	}
+
+	*array = remapped;
+
+	return 1;
+}
+
+int mshOptimizeVertexFetch(demoModel* model)
+{
+	// Submesh elements are relative to each submesh's first vertex
+	if(model->numSubmeshes)
+	{
+		return 0;
+	}
+
+	GLuint* indices = mshCopyElements(model);
+	GLuint* remap = (GLuint*)malloc(model->numVertcies * sizeof(GLuint));
+	GLuint elemNum, vertNum;
+	int success = 0;
+
+	if(NULL == indices || NULL == remap)
+	{
+		free(indices);
+		free(remap);
+		return 0;
+	}
+
+	memset(remap, 0xFF, model->numVertcies * sizeof(GLuint));
+
+	GLuint nextVertex = 0;
+
+	for(elemNum = 0; elemNum < model->numElements; elemNum++)
+	{
+		GLuint vertex = indices[elemNum];
+
+		if(MESH_NO_VERTEX == remap[vertex])
+		{
+			remap[vertex] = nextVertex++;
+		}
+
+		indices[elemNum] = remap[vertex];
+	}
+
+	// Unreferenced vertices go to the end
+	for(vertNum = 0; vertNum < model->numVertcies; vertNum++)
+	{
+		if(MESH_NO_VERTEX == remap[vertNum])
+		{
+			remap[vertNum] = nextVertex++;
+		}
+	}
+
+	success = mshRemapAttribute(model, &model->positions, model->positionArraySize,
+								model->positionType, model->positionSize, remap) &&
+	          mshRemapAttribute(model, &model->texcoords, model->texcoordArraySize,
+								model->texcoordType, model->texcoordSize, remap) &&
+	          mshRemapAttribute(model, &model->normals, model->normalArraySize,
+								model->normalType, model->normalSize, remap) &&
+	          mshStoreElements(model, indices);
+
+	free(indices);
+	free(remap);
+
+	return success;
+}
+
+int mshOptimizeModel(demoModel* model, GLfloat overdrawThreshold,
+					 demoMeshStats* statsBefore, demoMeshStats* statsAfter)
+{
+	if(statsBefore)
+	{
+		mshAnalyzeVertexCache(model, MESH_DEFAULT_CACHE_SIZE, statsBefore);
+	}
+
+	if(!mshOptimizeVertexCache(model, MESH_DEFAULT_CACHE_SIZE, overdrawThreshold) ||
+	   !mshOptimizeVertexFetch(model))
+	{
+		return 0;
+	}
+
+	if(statsAfter)
+	{
+		mshAnalyzeVertexCache(model, MESH_DEFAULT_CACHE_SIZE, statsAfter);
+	}
+
+	return 1;
+}
@@ -0,0 +1,60 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for reordering the triangles and vertices of a model so that it
+  draws efficiently: fewer vertex shader invocations through better use of
+  the post-transform vertex cache, better locality of vertex fetches, and
+  less overdraw.
+ */
+
+#ifndef __MESH_UTIL_H__
+#define __MESH_UTIL_H__
+
+#include "modelUtil.h"
+
+// Reasonable post-transform cache size for the GPUs this sample targets
+#define MESH_DEFAULT_CACHE_SIZE 16
+
+// Default relative ACMR tolerance when splitting clusters for overdraw ordering
+#define MESH_DEFAULT_OVERDRAW_THRESHOLD 1.05f
+
+typedef struct demoMeshStatsRec
+{
+	// Average cache miss ratio: transformed vertices per triangle (0.5 - 3.0)
+	GLfloat acmr;
+
+	// Average transform to vertex ratio: transformed vertices per unique vertex (1.0 is ideal)
+	GLfloat atvr;
+
+} demoMeshStats;
+
+// All functions treat the model's elements as a triangle list, the only
+// primitive type the renderer draws.  Arrays that point into a mapped model
+// file are replaced with heap copies before they are modified.  Models that
+// have been split into submeshes are not supported; optimize them first.
+
+// Simulates a FIFO post-transform vertex cache of cacheSize entries
+void mshAnalyzeVertexCache(const demoModel* model, GLuint cacheSize, demoMeshStats* stats);
+
+// Reorders triangles for the vertex cache using the Tipsify algorithm
+// (Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality
+// and Reduced Overdraw", SIGGRAPH 2007).  If overdrawThreshold is greater
+// than zero the triangles are further grouped into clusters which are
+// ordered so that outward facing clusters draw first; a cluster is split
+// wherever its ACMR is below overdrawThreshold times the ACMR of the cache
+// optimized order (1.05 allows the ACMR to get up to 5% worse; a larger
+// value gives more, smaller clusters and less overdraw).  Requires
+// GL_FLOAT positions when reordering for overdraw.  Returns 0 on failure.
+int mshOptimizeVertexCache(demoModel* model, GLuint cacheSize, GLfloat overdrawThreshold);
+
+// Reorders vertices into the order the elements first reference them so
+// that vertex fetches walk memory linearly.  Run after mshOptimizeVertexCache.
+int mshOptimizeVertexFetch(demoModel* model);
+
+// Runs both passes above and fills in the cache statistics before and
+// after optimization (either may be NULL).  Returns 0 on failure.
+int mshOptimizeModel(demoModel* model, GLfloat overdrawThreshold,
+					 demoMeshStats* statsBefore, demoMeshStats* statsAfter);
+
+#endif // __MESH_UTIL_H__
@@ -11,6 +11,17 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dispatch/dispatch.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
 
 typedef struct modelHeaderRec
 {
@@ -37,6 +48,66 @@ typedef struct modelAttribRec
 	unsigned int numElements;
 } modelAttrib;
 
+// Narrows 32-bit elements to 16 bits.  Returns 0 if any element is 0xFFFF or
+// larger, in which case the contents of dst are undefined.
+static int mdlNarrowIndices(GLushort* dst, const GLubyte* src, GLuint count)
+{
+	GLuint elemNum = 0;
+	GLuint outOfRange = 0;
+	
+#if defined(__SSE2__)
+	// SSE2 has no unsigned compare or pack so bias the values into
+	// signed range before comparing and packing them
+	const __m128i bias32 = _mm_set1_epi32((int)0x80000000);
+	const __m128i limit32 = _mm_set1_epi32((int)(0x80000000 ^ 0xFFFE));
+	const __m128i bias16 = _mm_set1_epi32(0x8000);
+	const __m128i unbias16 = _mm_set1_epi16((short)0x8000);
+	__m128i bad = _mm_setzero_si128();
+	
+	for(; elemNum + 8 <= count; elemNum += 8)
+	{
+		__m128i lo = _mm_loadu_si128((const __m128i*)(src + elemNum * sizeof(GLuint)));
+		__m128i hi = _mm_loadu_si128((const __m128i*)(src + (elemNum + 4) * sizeof(GLuint)));
+		
+		bad = _mm_or_si128(bad, _mm_cmpgt_epi32(_mm_xor_si128(lo, bias32), limit32));
+		bad = _mm_or_si128(bad, _mm_cmpgt_epi32(_mm_xor_si128(hi, bias32), limit32));
+		
+		__m128i packed = _mm_packs_epi32(_mm_sub_epi32(lo, bias16), _mm_sub_epi32(hi, bias16));
+		_mm_storeu_si128((__m128i*)(dst + elemNum), _mm_add_epi16(packed, unbias16));
+	}
+	
+	outOfRange = _mm_movemask_epi8(bad);
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+	const uint32x4_t limit32 = vdupq_n_u32(0xFFFE);
+	uint32x4_t bad = vdupq_n_u32(0);
+	
+	for(; elemNum + 8 <= count; elemNum += 8)
+	{
+		uint32x4_t lo = vld1q_u32((const uint32_t*)(src + elemNum * sizeof(GLuint)));
+		uint32x4_t hi = vld1q_u32((const uint32_t*)(src + (elemNum + 4) * sizeof(GLuint)));
+		
+		bad = vorrq_u32(bad, vcgtq_u32(lo, limit32));
+		bad = vorrq_u32(bad, vcgtq_u32(hi, limit32));
+		
+		vst1q_u16(dst + elemNum, vcombine_u16(vmovn_u32(lo), vmovn_u32(hi)));
+	}
+	
+	outOfRange = vmaxvq_u32(bad);
+#endif
+	
+	for(; elemNum < count; elemNum++)
+	{
+		GLuint element;
+		memcpy(&element, src + elemNum * sizeof(GLuint), sizeof(GLuint));
+		
+		outOfRange |= (element >= 0xFFFF);
+		
+		dst[elemNum] = (GLushort)element;
+	}
+	
+	return !outOfRange;
+}
+
 demoModel* mdlLoadModel(const char* filepathname)
 {
 	if(NULL == filepathname)
@@ -148,25 +219,20 @@ demoModel* mdlLoadModel(const char* filepathname)
 			return NULL;
 		}
 		
-		GLuint elemNum = 0;
-		for(elemNum = 0; elemNum < model->numElements; elemNum++)
+		//If an element is out of the UNSIGNED_SHORT range keep the UI elements
+		// and split the model into submeshes once its vertices are loaded
+		if(!mdlNarrowIndices((GLushort*)model->elements, uiElements, model->numElements))
 		{
-			//We can't handle this model if an element is out of the UNSIGNED_INT range
-			if(((GLuint*)uiElements)[elemNum] >= 0xFFFF)
-			{
-				fclose(curFile);
-				mdlDestroyModel(model);		
-				return NULL;
-			}
+			free(model->elements);
+			model->elements = uiElements;
+		}
+		else
+		{
+			free(uiElements);
 			
-			((GLushort*)model->elements)[elemNum] = ((GLuint*)uiElements)[elemNum];
+			model->elementType = GL_UNSIGNED_SHORT;
+			model->elementArraySize = model->numElements * sizeof(GLushort);
 		}
-		
-		free(uiElements);
-	
-		
-		model->elementType = GL_UNSIGNED_SHORT;
-		model->elementArraySize = model->numElements * sizeof(GLushort);
 	}
 	else 
 	{	
@@ -293,8 +359,775 @@ demoModel* mdlLoadModel(const char* filepathname)
 	
 	fclose(curFile);
 	
+	if(GL_UNSIGNED_INT == model->elementType && !mdlSplitModel(model))
+	{
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
+	return model;
+	
+}
+
+int mdlIsMappedArray(const demoModel* model, const void* array)
+{
+	const GLubyte* base = (const GLubyte*)model->mappedData;
+	
+	return (NULL != base) && ((const GLubyte*)array >= base) && ((const GLubyte*)array < base + model->mappedSize);
+}
+
+// Reads the attribute header at offset in a mapped model file and returns
+// a pointer to the data following it.  Returns NULL if the header or data
+// would extend past the end of the file.
+static GLubyte* mdlMapAttrib(modelAttrib* attrib, const demoModel* model,
+							 unsigned int offset, unsigned int attribHeaderSize)
+{
+	GLubyte* base = (GLubyte*)model->mappedData;
+	size_t dataOffset = (size_t)offset + attribHeaderSize;
+	
+	if(dataOffset > model->mappedSize)
+	{
+		return NULL;
+	}
+	
+	memset(attrib, 0, sizeof(modelAttrib));
+	memcpy(attrib, base + offset, attribHeaderSize);
+	
+	if(attrib->byteSize > model->mappedSize - dataOffset)
+	{
+		return NULL;
+	}
+	
+	return base + dataOffset;
+}
+
+// Points the model's arrays at the model file in mappedData.  Returns 0 if
+// the data is not a valid model file.
+static int mdlAttachMappedData(demoModel* model)
+{
+	if(model->mappedSize < sizeof(modelHeader) + sizeof(modelTOC))
+	{
+		return 0;
+	}
+	
+	modelHeader header;
+	
+	memcpy(&header, model->mappedData, sizeof(modelHeader));
+	
+	if(strncmp(header.fileIdentifier, "AppleOpenGLDemoModelWWDC2010", sizeof(header.fileIdentifier)))
+	{
+		return 0;
+	}
+	
+	if(header.majorVersion != 0 && header.minorVersion != 1)
+	{
+		return 0;
+	}
+	
+	modelTOC toc;
+	
+	memcpy(&toc, (GLubyte*)model->mappedData + sizeof(modelHeader), sizeof(modelTOC));
+	
+	if(toc.attribHeaderSize > sizeof(modelAttrib))
+	{
+		return 0;
+	}
+	
+	modelAttrib attrib;
+	
+	model->elements = mdlMapAttrib(&attrib, model, toc.byteElementOffset, toc.attribHeaderSize);
+	
+	if(NULL == model->elements)
+	{
+		return 0;
+	}
+	
+	model->elementArraySize = attrib.byteSize;
+	model->elementType = attrib.datatype;
+	model->numElements = attrib.numElements;
+	
+	model->positions = mdlMapAttrib(&attrib, model, toc.bytePositionOffset, toc.attribHeaderSize);
+	
+	if(NULL == model->positions)
+	{
+		return 0;
+	}
+	
+	model->positionArraySize = attrib.byteSize;
+	model->positionType = attrib.datatype;
+	model->positionSize = attrib.sizePerElement;
+	model->numVertcies = attrib.numElements;
+	
+	model->texcoords = mdlMapAttrib(&attrib, model, toc.byteTexcoordOffset, toc.attribHeaderSize);
+	
+	//Must have the same number of texcoords as positions
+	if(NULL == model->texcoords || model->numVertcies != attrib.numElements)
+	{
+		return 0;
+	}
+	
+	model->texcoordArraySize = attrib.byteSize;
+	model->texcoordType = attrib.datatype;
+	model->texcoordSize = attrib.sizePerElement;
+	
+	model->normals = mdlMapAttrib(&attrib, model, toc.byteNormalOffset, toc.attribHeaderSize);
+	
+	//Must have the same number of normals as positions
+	if(NULL == model->normals || model->numVertcies != attrib.numElements)
+	{
+		return 0;
+	}
+	
+	model->normalArraySize = attrib.byteSize;
+	model->normalType = attrib.datatype;
+	model->normalSize = attrib.sizePerElement;
+	
+	return 1;
+}
+
+demoModel* mdlMapModel(const char* filepathname)
+{
+	if(NULL == filepathname)
+	{
+		return NULL;
+	}
+	
+	demoModel* model = (demoModel*) calloc(sizeof(demoModel), 1);
+	
+	if(NULL == model)
+	{
+		return NULL;
+	}
+	
+	int fd = open(filepathname, O_RDONLY);
+	
+	if(fd < 0)
+	{
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
+	struct stat fileStat;
+	
+	if(fstat(fd, &fileStat) < 0 || fileStat.st_size <= 0)
+	{
+		close(fd);
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
+	void* fileData = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	
+	// The mapping holds its own reference to the file
+	close(fd);
+	
+	if(MAP_FAILED == fileData)
+	{
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
+	model->mappedData = fileData;
+	model->mappedSize = (size_t)fileStat.st_size;
+	model->ownsMapping = 1;
+	
+	// Every page is touched when the arrays are uploaded to GL
+	// so ask the kernel to start reading them in now
+	madvise(fileData, model->mappedSize, MADV_WILLNEED);
+	
+	if(!mdlAttachMappedData(model))
+	{
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
+	return model;
+}
+
+demoModel* mdlModelWithData(const void* data, size_t size)
+{
+	if(NULL == data)
+	{
+		return NULL;
+	}
+	
+	demoModel* model = (demoModel*) calloc(sizeof(demoModel), 1);
+	
+	if(NULL == model)
+	{
+		return NULL;
+	}
+	
+	model->mappedData = (void*)data;
+	model->mappedSize = size;
+	
+	if(!mdlAttachMappedData(model))
+	{
+		mdlDestroyModel(model);
+		return NULL;
+	}
+	
 	return model;
+}
+
+int mdlNarrowElements(demoModel* model)
+{
+	if(GL_UNSIGNED_INT != model->elementType)
+	{
+		return 1;
+	}
+	
+	GLushort* elements = (GLushort*)malloc(model->numElements * sizeof(GLushort));
+	
+	if(NULL == elements)
+	{
+		return 0;
+	}
+	
+	if(!mdlNarrowIndices(elements, model->elements, model->numElements))
+	{
+		free(elements);
+		return 0;
+	}
+	
+	if(!mdlIsMappedArray(model, model->elements))
+	{
+		free(model->elements);
+	}
+	
+	model->elements = (GLubyte*)elements;
+	model->elementType = GL_UNSIGNED_SHORT;
+	model->elementArraySize = model->numElements * sizeof(GLushort);
+	
+	return 1;
+}
+
+// Submeshes index at most MDL_MAX_SUBMESH_VERTICES vertices so every element
+// fits in 16 bits with 0xFFFF left free (it is the primitive restart index)
+#define MDL_MAX_SUBMESH_VERTICES 0xFFFF
+
+// Each chunk is split independently so at most one submesh per chunk is
+// smaller than it could be
+#define MDL_SPLIT_CHUNK_TRIANGLES (1 << 18)
+
+// Open addressing hash table mapping model vertices to submesh vertices.
+// Entries from earlier submeshes are recognized by their stamp so the
+// table never needs to be cleared.
+#define MDL_VERTEX_TABLE_SIZE (1 << 17)
+
+typedef struct mdlVertexTableRec
+{
+	GLuint vertex[MDL_VERTEX_TABLE_SIZE];
+	GLuint stamp[MDL_VERTEX_TABLE_SIZE];
+	GLushort local[MDL_VERTEX_TABLE_SIZE];
+	GLuint currentStamp;
+	GLuint numVertices;
+} mdlVertexTable;
+
+static mdlVertexTable* mdlCreateVertexTable(void)
+{
+	// Stamp 0 marks an empty entry
+	mdlVertexTable* table = (mdlVertexTable*) calloc(sizeof(mdlVertexTable), 1);
+	
+	if(table)
+	{
+		table->currentStamp = 1;
+	}
+	
+	return table;
+}
+
+static void mdlResetVertexTable(mdlVertexTable* table)
+{
+	table->currentStamp++;
+	table->numVertices = 0;
+}
+
+// Returns the entry for vertex, which is empty if the vertex is not in the table
+static GLuint mdlFindVertex(const mdlVertexTable* table, GLuint vertex)
+{
+	GLuint entry = (vertex * 0x9E3779B1u) >> 15;
+	
+	while(table->stamp[entry] == table->currentStamp && table->vertex[entry] != vertex)
+	{
+		entry = (entry + 1) & (MDL_VERTEX_TABLE_SIZE - 1);
+	}
+	
+	return entry;
+}
+
+static GLushort mdlInsertVertex(mdlVertexTable* table, GLuint entry, GLuint vertex)
+{
+	table->vertex[entry] = vertex;
+	table->stamp[entry] = table->currentStamp;
+	table->local[entry] = (GLushort)table->numVertices;
+	
+	return (GLushort)table->numVertices++;
+}
+
+static GLuint mdlElementAt(const GLubyte* elements, GLuint elemNum)
+{
+	GLuint element;
+	memcpy(&element, elements + elemNum * sizeof(GLuint), sizeof(GLuint));
+	return element;
+}
+
+typedef struct mdlSplitChunkRec
+{
+	GLuint firstTriangle;
+	GLuint numTriangles;
+	
+	// Submeshes found in this chunk
+	demoSubmesh* submeshes;
+	GLuint numSubmeshes;
+	int failed;
+} mdlSplitChunk;
+
+typedef struct mdlSplitContextRec
+{
+	demoModel* model;
+	mdlSplitChunk* chunks;
+	
+	// New arrays being filled in
+	GLubyte* elements;
+	GLubyte* attribArrays[3];
+	const GLubyte* srcAttribArrays[3];
+	GLsizei attribStrides[3];
+	
+	// Set by each submesh that could not be built
+	int* submeshFailed;
+	
+	int failed;
+} mdlSplitContext;
+
+// Finds submesh boundaries within a chunk by adding triangles to the
+// current submesh until the next one would take it over the vertex limit
+static void mdlSplitChunkTriangles(void* context, size_t index)
+{
+	mdlSplitContext* split = (mdlSplitContext*)context;
+	mdlSplitChunk* chunk = &split->chunks[index];
+	const GLubyte* elements = split->model->elements;
+	
+	// Every submesh but the last holds at least a third of the vertex limit in triangles
+	GLuint maxSubmeshes = chunk->numTriangles / (MDL_MAX_SUBMESH_VERTICES / 3) + 1;
+	
+	chunk->submeshes = (demoSubmesh*) calloc(sizeof(demoSubmesh), maxSubmeshes);
+	mdlVertexTable* table = mdlCreateVertexTable();
+	
+	if(NULL == chunk->submeshes || NULL == table)
+	{
+		free(table);
+		chunk->failed = 1;
+		return;
+	}
+	
+	demoSubmesh* submesh = &chunk->submeshes[0];
+	GLuint triNum, vertNum;
+	
+	submesh->firstElement = chunk->firstTriangle * 3;
+	chunk->numSubmeshes = 1;
+	
+	for(triNum = chunk->firstTriangle; triNum < chunk->firstTriangle + chunk->numTriangles; triNum++)
+	{
+		GLuint entries[3];
+		GLuint numNew = 0;
+		
+		for(vertNum = 0; vertNum < 3; vertNum++)
+		{
+			GLuint vertex = mdlElementAt(elements, triNum * 3 + vertNum);
+			
+			entries[vertNum] = mdlFindVertex(table, vertex);
+			numNew += (table->stamp[entries[vertNum]] != table->currentStamp);
+		}
+		
+		if(table->numVertices + numNew > MDL_MAX_SUBMESH_VERTICES)
+		{
+			submesh->numVertices = table->numVertices;
+			submesh = &chunk->submeshes[chunk->numSubmeshes++];
+			submesh->firstElement = triNum * 3;
+			
+			mdlResetVertexTable(table);
+		}
+		
+		for(vertNum = 0; vertNum < 3; vertNum++)
+		{
+			GLuint vertex = mdlElementAt(elements, triNum * 3 + vertNum);
+			GLuint entry = mdlFindVertex(table, vertex);
+			
+			if(table->stamp[entry] != table->currentStamp)
+			{
+				mdlInsertVertex(table, entry, vertex);
+			}
+		}
+		
+		submesh->numElements += 3;
+	}
+	
+	submesh->numVertices = table->numVertices;
+	
+	free(table);
+}
+
+// Writes a submesh's 16-bit elements and copies the vertices it uses
+static void mdlBuildSubmesh(void* context, size_t index)
+{
+	mdlSplitContext* split = (mdlSplitContext*)context;
+	const demoSubmesh* submesh = &split->model->submeshes[index];
+	const GLubyte* elements = split->model->elements;
+	GLushort* submeshElements = (GLushort*)split->elements + submesh->firstElement;
+	GLuint elemNum, attribNum;
+	
+	mdlVertexTable* table = mdlCreateVertexTable();
+	
+	if(NULL == table)
+	{
+		split->submeshFailed[index] = 1;
+		return;
+	}
+	
+	for(elemNum = 0; elemNum < submesh->numElements; elemNum++)
+	{
+		GLuint vertex = mdlElementAt(elements, submesh->firstElement + elemNum);
+		GLuint entry = mdlFindVertex(table, vertex);
+		GLushort local;
+		
+		if(table->stamp[entry] != table->currentStamp)
+		{
+			local = mdlInsertVertex(table, entry, vertex);
+			
+			for(attribNum = 0; attribNum < 3; attribNum++)
+			{
+				GLsizei stride = split->attribStrides[attribNum];
+				
+				if(split->attribArrays[attribNum])
+				{
+					memcpy(split->attribArrays[attribNum] + (submesh->baseVertex + local) * stride,
+						   split->srcAttribArrays[attribNum] + vertex * stride, stride);
+				}
+			}
+		}
+		else
+		{
+			local = table->local[entry];
+		}
+		
+		submeshElements[elemNum] = local;
+	}
+	
+	free(table);
+}
+
+static GLsizei mdlAttribStride(GLenum type, GLuint size)
+{
+	switch(type)
+	{
+		case GL_BYTE:
+		case GL_UNSIGNED_BYTE:
+			return size;
+		case GL_SHORT:
+		case GL_UNSIGNED_SHORT:
+			return size * 2;
+		case GL_INT:
+		case GL_UNSIGNED_INT:
+		case GL_FLOAT:
+			return size * 4;
+	}
+	return 0;
+}
+
+int mdlSplitModel(demoModel* model)
+{
+	if(GL_UNSIGNED_INT != model->elementType || model->numSubmeshes)
+	{
+		return 1;
+	}
+	
+	// Most models fit in 16 bits without splitting
+	if(mdlNarrowElements(model))
+	{
+		return 1;
+	}
+	
+	GLuint numTriangles = model->numElements / 3;
+	GLuint numChunks = (numTriangles + MDL_SPLIT_CHUNK_TRIANGLES - 1) / MDL_SPLIT_CHUNK_TRIANGLES;
+	GLuint chunkNum, submeshNum, attribNum, elemNum;
+	
+	// The elements must be whole triangles that reference existing vertices
+	if(numTriangles * 3 != model->numElements || 
+	   (size_t)model->elementArraySize < (size_t)model->numElements * sizeof(GLuint))
+	{
+		return 0;
+	}
+	
+	for(elemNum = 0; elemNum < model->numElements; elemNum++)
+	{
+		if(mdlElementAt(model->elements, elemNum) >= model->numVertcies)
+		{
+			return 0;
+		}
+	}
+	
+	mdlSplitContext split;
+	
+	memset(&split, 0, sizeof(mdlSplitContext));
+	split.model = model;
+	split.chunks = (mdlSplitChunk*) calloc(sizeof(mdlSplitChunk), numChunks);
+	
+	if(NULL == split.chunks)
+	{
+		return 0;
+	}
+	
+	for(chunkNum = 0; chunkNum < numChunks; chunkNum++)
+	{
+		split.chunks[chunkNum].firstTriangle = chunkNum * MDL_SPLIT_CHUNK_TRIANGLES;
+		split.chunks[chunkNum].numTriangles = numTriangles - split.chunks[chunkNum].firstTriangle;
+		
+		if(split.chunks[chunkNum].numTriangles > MDL_SPLIT_CHUNK_TRIANGLES)
+		{
+			split.chunks[chunkNum].numTriangles = MDL_SPLIT_CHUNK_TRIANGLES;
+		}
+	}
+	
+	dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0);
+	
+	dispatch_apply_f(numChunks, queue, &split, mdlSplitChunkTriangles);
+	
+	// Gather the submeshes from each chunk and give each its own range of vertices
+	GLuint numSubmeshes = 0;
+	GLuint numVertices = 0;
+	
+	for(chunkNum = 0; chunkNum < numChunks; chunkNum++)
+	{
+		split.failed |= split.chunks[chunkNum].failed;
+		numSubmeshes += split.chunks[chunkNum].numSubmeshes;
+	}
+	
+	demoSubmesh* submeshes = split.failed ? NULL : (demoSubmesh*) calloc(sizeof(demoSubmesh), numSubmeshes);
+	
+	if(submeshes)
+	{
+		numSubmeshes = 0;
+		
+		for(chunkNum = 0; chunkNum < numChunks; chunkNum++)
+		{
+			for(submeshNum = 0; submeshNum < split.chunks[chunkNum].numSubmeshes; submeshNum++)
+			{
+				submeshes[numSubmeshes] = split.chunks[chunkNum].submeshes[submeshNum];
+				submeshes[numSubmeshes].baseVertex = numVertices;
+				numVertices += submeshes[numSubmeshes].numVertices;
+				numSubmeshes++;
+			}
+		}
+	}
+	
+	for(chunkNum = 0; chunkNum < numChunks; chunkNum++)
+	{
+		free(split.chunks[chunkNum].submeshes);
+	}
+	
+	free(split.chunks);
+	
+	if(NULL == submeshes)
+	{
+		return 0;
+	}
+	
+	// Vertices shared between submeshes are duplicated, one copy for each
+	GLubyte** attribs[3] = { &model->positions, &model->texcoords, &model->normals };
+	
+	split.attribStrides[0] = mdlAttribStride(model->positionType, model->positionSize);
+	split.attribStrides[1] = mdlAttribStride(model->texcoordType, model->texcoordSize);
+	split.attribStrides[2] = mdlAttribStride(model->normalType, model->normalSize);
+	split.elements = (GLubyte*) malloc(model->numElements * sizeof(GLushort));
+	split.submeshFailed = (int*) calloc(sizeof(int), numSubmeshes);
+	split.failed = (NULL == split.elements || NULL == split.submeshFailed);
+	
+	for(attribNum = 0; attribNum < 3; attribNum++)
+	{
+		if(*attribs[attribNum])
+		{
+			split.srcAttribArrays[attribNum] = *attribs[attribNum];
+			split.attribArrays[attribNum] = (GLubyte*) malloc((size_t)numVertices * split.attribStrides[attribNum]);
+			split.failed |= (0 == split.attribStrides[attribNum] || NULL == split.attribArrays[attribNum]);
+		}
+	}
+	
+	model->submeshes = submeshes;
+	
+	if(!split.failed)
+	{
+		dispatch_apply_f(numSubmeshes, queue, &split, mdlBuildSubmesh);
+		
+		for(submeshNum = 0; submeshNum < numSubmeshes; submeshNum++)
+		{
+			split.failed |= split.submeshFailed[submeshNum];
+		}
+	}
+	
+	free(split.submeshFailed);
+	
+	if(split.failed)
+	{
+		model->submeshes = NULL;
+		free(submeshes);
+		free(split.elements);
+		
+		for(attribNum = 0; attribNum < 3; attribNum++)
+		{
+			free(split.attribArrays[attribNum]);
+		}
+		
+		return 0;
+	}
+	
+	// Replace the model's arrays with the split ones
+	if(!mdlIsMappedArray(model, model->elements))
+	{
+		free(model->elements);
+	}
+	
+	model->elements = split.elements;
+	model->elementType = GL_UNSIGNED_SHORT;
+	model->elementArraySize = model->numElements * sizeof(GLushort);
+	model->numSubmeshes = numSubmeshes;
+	model->numVertcies = numVertices;
+	
+	GLsizei* attribArraySizes[3] = { &model->positionArraySize, &model->texcoordArraySize, &model->normalArraySize };
+	
+	for(attribNum = 0; attribNum < 3; attribNum++)
+	{
+		if(*attribs[attribNum])
+		{
+			if(!mdlIsMappedArray(model, *attribs[attribNum]))
+			{
+				free(*attribs[attribNum]);
+			}
+			
+			*attribs[attribNum] = split.attribArrays[attribNum];
+			*attribArraySizes[attribNum] = numVertices * split.attribStrides[attribNum];
+		}
+	}
+	
+	return 1;
+}
+
+int mdlSubmeshModel(const demoModel* model, GLuint submeshNum, demoModel* submeshModel)
+{
+	*submeshModel = *model;
+	
+	// A model that was not split is its own single submesh
+	submeshModel->submeshes = NULL;
+	submeshModel->numSubmeshes = 0;
+	submeshModel->mappedData = NULL;
+	submeshModel->mappedSize = 0;
+	submeshModel->ownsMapping = 0;
+	
+	if(0 == model->numSubmeshes)
+	{
+		return (0 == submeshNum);
+	}
+	
+	if(submeshNum >= model->numSubmeshes)
+	{
+		return 0;
+	}
+	
+	const demoSubmesh* submesh = &model->submeshes[submeshNum];
+	GLsizei positionStride = mdlAttribStride(model->positionType, model->positionSize);
+	GLsizei texcoordStride = mdlAttribStride(model->texcoordType, model->texcoordSize);
+	GLsizei normalStride = mdlAttribStride(model->normalType, model->normalSize);
+	
+	submeshModel->numVertcies = submesh->numVertices;
+	
+	submeshModel->positions = model->positions + submesh->baseVertex * positionStride;
+	submeshModel->positionArraySize = submesh->numVertices * positionStride;
+	
+	if(model->texcoords)
+	{
+		submeshModel->texcoords = model->texcoords + submesh->baseVertex * texcoordStride;
+		submeshModel->texcoordArraySize = submesh->numVertices * texcoordStride;
+	}
+	
+	if(model->normals)
+	{
+		submeshModel->normals = model->normals + submesh->baseVertex * normalStride;
+		submeshModel->normalArraySize = submesh->numVertices * normalStride;
+	}
+	
+	submeshModel->elements = model->elements + submesh->firstElement * sizeof(GLushort);
+	submeshModel->numElements = submesh->numElements;
+	submeshModel->elementArraySize = submesh->numElements * sizeof(GLushort);
+	
+	return 1;
+}
+
+static int mdlWriteAttrib(FILE* curFile, GLenum datatype, GLenum primType, GLuint sizePerElement,
+						  GLuint numElements, const GLubyte* data, GLsizei byteSize)
+{
+	modelAttrib attrib;
+	
+	memset(&attrib, 0, sizeof(modelAttrib));
+	attrib.byteSize = byteSize;
+	attrib.datatype = datatype;
+	attrib.primType = primType;
+	attrib.sizePerElement = sizePerElement;
+	attrib.numElements = numElements;
+	
+	return (fwrite(&attrib, sizeof(modelAttrib), 1, curFile) == 1) &&
+	       (fwrite(data, 1, byteSize, curFile) == (size_t)byteSize);
+}
+
+int mdlSaveModel(const demoModel* model, const char* filepathname)
+{
+	// The file format has no way to describe submeshes
+	if(model->numSubmeshes)
+	{
+		return 0;
+	}
+	
+	FILE* curFile = fopen(filepathname, "wb");
+	
+	if(!curFile)
+	{
+		return 0;
+	}
+	
+	modelHeader header;
+	
+	memset(&header, 0, sizeof(modelHeader));
+	strncpy(header.fileIdentifier, "AppleOpenGLDemoModelWWDC2010", sizeof(header.fileIdentifier));
+	header.majorVersion = 0;
+	header.minorVersion = 1;
+	
+	// Each attribute is stored as a header followed directly by its data,
+	// in the same order as the files this sample ships with
+	modelTOC toc;
 	
+	toc.attribHeaderSize = sizeof(modelAttrib);
+	toc.byteElementOffset = sizeof(modelHeader) + sizeof(modelTOC);
+	toc.bytePositionOffset = toc.byteElementOffset + sizeof(modelAttrib) + model->elementArraySize;
+	toc.byteTexcoordOffset = toc.bytePositionOffset + sizeof(modelAttrib) + model->positionArraySize;
+	toc.byteNormalOffset = toc.byteTexcoordOffset + sizeof(modelAttrib) + model->texcoordArraySize;
+	
+	int success =
+		fwrite(&header, sizeof(modelHeader), 1, curFile) == 1 &&
+		fwrite(&toc, sizeof(modelTOC), 1, curFile) == 1 &&
+		mdlWriteAttrib(curFile, model->elementType, GL_TRIANGLES, 1, model->numElements,
+					   model->elements, model->elementArraySize) &&
+		mdlWriteAttrib(curFile, model->positionType, 0, model->positionSize, model->numVertcies,
+					   model->positions, model->positionArraySize) &&
+		mdlWriteAttrib(curFile, model->texcoordType, 0, model->texcoordSize, model->numVertcies,
+					   model->texcoords, model->texcoordArraySize) &&
+		mdlWriteAttrib(curFile, model->normalType, 0, model->normalSize, model->numVertcies,
+					   model->normals, model->normalArraySize);
+	
+	if(fclose(curFile) != 0)
+	{
+		success = 0;
+	}
+	
+	return success;
 }
 
 demoModel* mdlLoadQuadModel()
@@ -372,10 +1205,33 @@ void mdlDestroyModel(demoModel* model)
 		return;
 	}
 	
-	free(model->elements);
-	free(model->positions);
-	free(model->normals);
-	free(model->texcoords);
+	// Arrays pointing into a mapped file go away with the mapping
+	if(!mdlIsMappedArray(model, model->elements))
+	{
+		free(model->elements);
+	}
+	
+	if(!mdlIsMappedArray(model, model->positions))
+	{
+		free(model->positions);
+	}
+	
+	if(!mdlIsMappedArray(model, model->normals))
+	{
+		free(model->normals);
+	}
+	
+	if(!mdlIsMappedArray(model, model->texcoords))
+	{
+		free(model->texcoords);
+	}
+	
+	free(model->submeshes);
+	
+	if(model->ownsMapping)
+	{
+		munmap(model->mappedData, model->mappedSize);
+	}
 	
 	free(model);
 }
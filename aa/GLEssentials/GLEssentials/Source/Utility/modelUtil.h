@@ -11,6 +11,17 @@
 #define __MODEL_UTIL_H__
 
 #include "glUtil.h"
+#include <stddef.h>
+
+// A range of a split model's elements which index only a range of its
+// vertices; elements are relative to baseVertex
+typedef struct demoSubmeshRec
+{
+	GLuint firstElement;
+	GLuint numElements;
+	GLuint baseVertex;
+	GLuint numVertices;
+} demoSubmesh;
 
 typedef struct demoModelRec
 {
@@ -38,10 +49,57 @@ typedef struct demoModelRec
 		
 	GLenum primType;
 	
+	// Set by mdlSplitModel if the model had to be split, otherwise
+	// the whole model is drawn with one call
+	demoSubmesh* submeshes;
+	GLuint numSubmeshes;
+	
+	// Non-NULL if the attribute arrays point into a mapping of the
+	// model file (see mdlMapModel and mdlModelWithData)
+	void* mappedData;
+	size_t mappedSize;
+	int ownsMapping;
+	
 } demoModel;
 
+// GL_UNSIGNED_INT elements are converted to GL_UNSIGNED_SHORT, splitting
+// the model into submeshes (see mdlSplitModel) if they do not fit
 demoModel* mdlLoadModel(const char* filepathname);
 
+// Maps the model file into memory and points the attribute and element
+// arrays directly at the data in the file without copying it.  Unlike
+// mdlLoadModel, GL_UNSIGNED_INT elements are kept as is; call
+// mdlNarrowElements if the renderer cannot draw with them.
+demoModel* mdlMapModel(const char* filepathname);
+
+// Same as mdlMapModel but for a model file that is already in memory.
+// The model references data directly so it must outlive the model.
+demoModel* mdlModelWithData(const void* data, size_t size);
+
+// Converts GL_UNSIGNED_INT elements to GL_UNSIGNED_SHORT.  Returns 0 (and
+// leaves the model untouched) if any element does not fit in 16 bits.
+int mdlNarrowElements(demoModel* model);
+
+// Converts GL_UNSIGNED_INT elements to GL_UNSIGNED_SHORT.  If they do not
+// fit the model is split into submeshes of at most 65535 vertices, each
+// with its own copy of the vertices it uses, and elements relative to its
+// first vertex.  Boundaries are found in parallel over chunks of the
+// element array.  Returns 0 (and leaves the model untouched) on failure.
+int mdlSplitModel(demoModel* model);
+
+// Fills in submeshModel with a view of one submesh of the model, pointing
+// into the model's arrays, that can be drawn on its own.  A model that was
+// not split has a single submesh 0.  The view must not be destroyed.
+int mdlSubmeshModel(const demoModel* model, GLuint submeshNum, demoModel* submeshModel);
+
+// Writes the model in the format read by mdlLoadModel.  Returns 0 on failure
+// or if the model was split into submeshes.
+int mdlSaveModel(const demoModel* model, const char* filepathname);
+
+// Returns true if array points into the model's mapped file data, in which
+// case it must not be modified or freed
+int mdlIsMappedArray(const demoModel* model, const void* array);
+
 demoModel* mdlLoadQuadModel();
 
 void mdlDestroyModel(demoModel* model);
@@ -0,0 +1,104 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ On-disk layout of asset pack files.  Shared by the pack loader (packUtil.c)
+  and the packassets tool, so this header does not depend on OpenGL.
+ */
+
+#ifndef __PACK_FORMAT_H__
+#define __PACK_FORMAT_H__
+
+#include <stdint.h>
+#include <string.h>
+
+// A pack file is laid out as:
+//
+// [ packHeader ]
+// [ uint32_t bucket[numBuckets] ]  Hash table of (entry index + 1), 0 if empty
+// [ packEntry entry[numEntries] ]
+// [ padding to PACK_PAGE_SIZE ]
+// [ entry data, each entry starting on a PACK_PAGE_SIZE boundary ]
+//
+// Buckets are found by hashing the entry name with packHashName and probing
+// linearly from (hash & (numBuckets - 1)).  numBuckets is a power of two
+// and always larger than numEntries so a lookup finds an empty bucket for
+// names that are not in the pack.  All values are little endian.
+
+#define PACK_FILE_IDENTIFIER "AppleOpenGLDemoAssetPack"
+#define PACK_MAJOR_VERSION 1
+#define PACK_MINOR_VERSION 0
+#define PACK_PAGE_SIZE 4096
+#define PACK_MAX_NAME_LENGTH 56
+
+enum
+{
+	PACK_KIND_UNKNOWN,
+	PACK_KIND_MODEL,   // demoModel file, see modelUtil.h
+	PACK_KIND_SOURCE,  // Shader source, see sourceUtil.h
+	PACK_KIND_IMAGE    // Image file, see imageUtil.h
+};
+
+typedef struct packHeaderRec
+{
+	char fileIdentifier[32];
+	uint32_t majorVersion;
+	uint32_t minorVersion;
+	uint32_t numEntries;
+	uint32_t numBuckets;
+} packHeader;
+
+typedef struct packEntryRec
+{
+	char name[PACK_MAX_NAME_LENGTH]; // Null terminated file name without directories
+	uint32_t nameHash;
+	uint32_t kind;
+	uint64_t byteOffset;
+	uint64_t byteSize;
+} packEntry;
+
+// 32-bit FNV-1a hash of a null terminated name
+static inline uint32_t packHashName(const char* name)
+{
+	uint32_t hash = 2166136261u;
+
+	while(*name)
+	{
+		hash ^= (uint8_t)*name++;
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+// Determines the kind of an entry from its file name suffix
+static inline uint32_t packKindForName(const char* name)
+{
+	const char* suffix = strrchr(name, '.');
+
+	if(NULL == suffix)
+	{
+		return PACK_KIND_UNKNOWN;
+	}
+
+	if(0 == strcmp(suffix, ".model"))
+	{
+		return PACK_KIND_MODEL;
+	}
+
+	if(0 == strcmp(suffix, ".vsh") || 0 == strcmp(suffix, ".fsh"))
+	{
+		return PACK_KIND_SOURCE;
+	}
+
+	if(0 == strcmp(suffix, ".png") || 0 == strcmp(suffix, ".jpg") ||
+	   0 == strcmp(suffix, ".jpeg") || 0 == strcmp(suffix, ".tif") ||
+	   0 == strcmp(suffix, ".tiff"))
+	{
+		return PACK_KIND_IMAGE;
+	}
+
+	return PACK_KIND_UNKNOWN;
+}
+
+#endif // __PACK_FORMAT_H__
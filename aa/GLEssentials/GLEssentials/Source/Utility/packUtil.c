@@ -0,0 +1,290 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for loading models, shader sources and images by name from a
+  single memory-mapped asset pack file.
+ */
+
+#include "packUtil.h"
+#include "packFormat.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <dispatch/dispatch.h>
+
+struct demoPackRec
+{
+	void* mappedData;
+	size_t mappedSize;
+
+	const packHeader* header;
+	const uint32_t* buckets;
+	const packEntry* entries;
+};
+
+demoPack* pakOpen(const char* filepathname)
+{
+	if(NULL == filepathname)
+	{
+		return NULL;
+	}
+
+	demoPack* pack = (demoPack*) calloc(sizeof(demoPack), 1);
+
+	if(NULL == pack)
+	{
+		return NULL;
+	}
+
+	int fd = open(filepathname, O_RDONLY);
+
+	if(fd < 0)
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	struct stat fileStat;
+
+	if(fstat(fd, &fileStat) < 0 || fileStat.st_size < (off_t)sizeof(packHeader))
+	{
+		close(fd);
+		pakClose(pack);
+		return NULL;
+	}
+
+	void* fileData = mmap(NULL, (size_t)fileStat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+	// The mapping holds its own reference to the file
+	close(fd);
+
+	if(MAP_FAILED == fileData)
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	pack->mappedData = fileData;
+	pack->mappedSize = (size_t)fileStat.st_size;
+	pack->header = (const packHeader*)fileData;
+
+	const packHeader* header = pack->header;
+
+	if(strncmp(header->fileIdentifier, PACK_FILE_IDENTIFIER, sizeof(header->fileIdentifier)) ||
+	   header->majorVersion != PACK_MAJOR_VERSION)
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	// Lookups rely on there always being an empty bucket
+	if(header->numBuckets <= header->numEntries ||
+	   (header->numBuckets & (header->numBuckets - 1)))
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	size_t tocSize = sizeof(packHeader) +
+	                 (size_t)header->numBuckets * sizeof(uint32_t) +
+	                 (size_t)header->numEntries * sizeof(packEntry);
+
+	if(tocSize > pack->mappedSize)
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	pack->buckets = (const uint32_t*)(header + 1);
+	pack->entries = (const packEntry*)(pack->buckets + header->numBuckets);
+
+	// Every bucket is empty or names an entry, and every entry has one bucket,
+	// so a lookup stays in the entry table and always finds an empty bucket
+	uint32_t bucketNum;
+	uint32_t usedBuckets = 0;
+
+	for(bucketNum = 0; bucketNum < header->numBuckets; bucketNum++)
+	{
+		if(pack->buckets[bucketNum] > header->numEntries)
+		{
+			pakClose(pack);
+			return NULL;
+		}
+
+		if(pack->buckets[bucketNum])
+		{
+			usedBuckets++;
+		}
+	}
+
+	if(usedBuckets != header->numEntries)
+	{
+		pakClose(pack);
+		return NULL;
+	}
+
+	uint32_t entryNum;
+
+	for(entryNum = 0; entryNum < header->numEntries; entryNum++)
+	{
+		const packEntry* entry = &pack->entries[entryNum];
+
+		if(entry->byteOffset > pack->mappedSize ||
+		   entry->byteSize > pack->mappedSize - entry->byteOffset ||
+		   entry->name[PACK_MAX_NAME_LENGTH - 1] != 0)
+		{
+			pakClose(pack);
+			return NULL;
+		}
+	}
+
+	return pack;
+}
+
+void pakClose(demoPack* pack)
+{
+	if(NULL == pack)
+	{
+		return;
+	}
+
+	if(NULL != pack->mappedData)
+	{
+		munmap(pack->mappedData, pack->mappedSize);
+	}
+
+	free(pack);
+}
+
+const void* pakFindEntry(const demoPack* pack, const char* name, size_t* byteSize, unsigned int* kind)
+{
+	uint32_t hash = packHashName(name);
+	uint32_t mask = pack->header->numBuckets - 1;
+	uint32_t bucket;
+
+	for(bucket = hash & mask; pack->buckets[bucket]; bucket = (bucket + 1) & mask)
+	{
+		const packEntry* entry = &pack->entries[pack->buckets[bucket] - 1];
+
+		if(entry->nameHash == hash && 0 == strcmp(entry->name, name))
+		{
+			if(byteSize)
+			{
+				*byteSize = (size_t)entry->byteSize;
+			}
+
+			if(kind)
+			{
+				*kind = entry->kind;
+			}
+
+			return (const GLubyte*)pack->mappedData + entry->byteOffset;
+		}
+	}
+
+	return NULL;
+}
+
+demoModel* pakLoadModel(const demoPack* pack, const char* name)
+{
+	size_t byteSize;
+	unsigned int kind;
+	const void* data = pakFindEntry(pack, name, &byteSize, &kind);
+
+	if(NULL == data || PACK_KIND_MODEL != kind)
+	{
+		return NULL;
+	}
+
+	return mdlModelWithData(data, byteSize);
+}
+
+demoSource* pakLoadSource(const demoPack* pack, const char* name)
+{
+	size_t byteSize;
+	unsigned int kind;
+	const void* data = pakFindEntry(pack, name, &byteSize, &kind);
+
+	if(NULL == data || PACK_KIND_SOURCE != kind)
+	{
+		return NULL;
+	}
+
+	return srcSourceWithData(name, (const char*)data, byteSize);
+}
+
+demoImage* pakLoadImage(const demoPack* pack, const char* name, int flipVertical)
+{
+	size_t byteSize;
+	unsigned int kind;
+	const void* data = pakFindEntry(pack, name, &byteSize, &kind);
+
+	if(NULL == data || PACK_KIND_IMAGE != kind)
+	{
+		return NULL;
+	}
+
+	return imgLoadImageData(data, byteSize, flipVertical);
+}
+
+typedef struct pakLoadContextRec
+{
+	const demoPack* pack;
+	demoPackRequest* requests;
+} pakLoadContext;
+
+static void pakLoadRequest(void* context, size_t index)
+{
+	const demoPack* pack = ((pakLoadContext*)context)->pack;
+	demoPackRequest* request = &((pakLoadContext*)context)->requests[index];
+	size_t byteSize;
+	unsigned int kind = PACK_KIND_UNKNOWN;
+	const void* data = pakFindEntry(pack, request->name, &byteSize, &kind);
+
+	request->asset = NULL;
+
+	if(NULL != data)
+	{
+		// Fault in the entry's pages now, in parallel with the other requests
+		madvise((void*)((uintptr_t)data & ~(uintptr_t)(PACK_PAGE_SIZE - 1)),
+		        byteSize + ((uintptr_t)data & (PACK_PAGE_SIZE - 1)), MADV_WILLNEED);
+
+		switch(kind)
+		{
+			case PACK_KIND_MODEL:
+				request->asset = mdlModelWithData(data, byteSize);
+				break;
+			case PACK_KIND_SOURCE:
+				request->asset = srcSourceWithData(request->name, (const char*)data, byteSize);
+				break;
+			case PACK_KIND_IMAGE:
+				request->asset = imgLoadImageData(data, byteSize, request->flipVertical);
+				break;
+		}
+	}
+
+	request->kind = (NULL != request->asset) ? kind : PACK_KIND_UNKNOWN;
+}
+
+unsigned int pakLoadAssets(const demoPack* pack, demoPackRequest* requests, unsigned int count)
+{
+	pakLoadContext context = { pack, requests };
+	unsigned int requestNum;
+	unsigned int numLoaded = 0;
+
+	// dispatch_apply_f returns once every request has been processed
+	dispatch_apply_f(count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+	                 &context, pakLoadRequest);
+
+	for(requestNum = 0; requestNum < count; requestNum++)
+	{
+		numLoaded += (NULL != requests[requestNum].asset);
+	}
+
+	return numLoaded;
+}
@@ -0,0 +1,52 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for loading models, shader sources and images by name from a
+  single memory-mapped asset pack file.  Packs are built with the
+  packassets tool (see packFormat.h for the file layout).
+ */
+
+#ifndef __PACK_UTIL_H__
+#define __PACK_UTIL_H__
+
+#include "modelUtil.h"
+#include "sourceUtil.h"
+#include "imageUtil.h"
+
+typedef struct demoPackRec demoPack;
+
+typedef struct demoPackRequestRec
+{
+	const char* name;
+
+	int flipVertical; // Only used for images
+
+	// Set by pakLoadAssets to PACK_KIND_MODEL, PACK_KIND_SOURCE or
+	// PACK_KIND_IMAGE with the matching demoModel*, demoSource* or
+	// demoImage* in asset, or to PACK_KIND_UNKNOWN and NULL on failure
+	unsigned int kind;
+	void* asset;
+
+} demoPackRequest;
+
+demoPack* pakOpen(const char* filepathname);
+
+// Models loaded from a pack point into the pack's mapping
+// so they must be destroyed before the pack is closed
+void pakClose(demoPack* pack);
+
+// Returns the raw bytes of an entry, or NULL if the pack has no entry with that name
+const void* pakFindEntry(const demoPack* pack, const char* name, size_t* byteSize, unsigned int* kind);
+
+demoModel* pakLoadModel(const demoPack* pack, const char* name);
+
+demoSource* pakLoadSource(const demoPack* pack, const char* name);
+
+demoImage* pakLoadImage(const demoPack* pack, const char* name, int flipVertical);
+
+// Loads every request concurrently on the global dispatch queue
+// Returns the number of requests that were loaded successfully
+unsigned int pakLoadAssets(const demoPack* pack, demoPackRequest* requests, unsigned int count);
+
+#endif // __PACK_UTIL_H__
@@ -0,0 +1,201 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for caching linked program binaries on disk so that shaders
+  only need to be compiled the first time they are used.
+ */
+
+#include "programUtil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <unistd.h>
+
+// Program binaries are core in OpenGL 4.1 and an extension in OpenGL ES 2.0.
+// The Legacy OpenGL Profile does not support them.
+#if TARGET_IOS
+#if defined(GL_OES_get_program_binary)
+#define PROGRAM_BINARIES_SUPPORTED 1
+#define PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#define PROGRAM_NUM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#define prgGetProgramBinary glGetProgramBinaryOES
+#define prgProgramBinary glProgramBinaryOES
+#endif
+#elif ESSENTIAL_GL_PRACTICES_SUPPORT_GL3 && defined(GL_PROGRAM_BINARY_LENGTH)
+#define PROGRAM_BINARIES_SUPPORTED 1
+#define PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH
+#define PROGRAM_NUM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS
+#define prgGetProgramBinary glGetProgramBinary
+#define prgProgramBinary glProgramBinary
+#endif
+
+#ifndef PROGRAM_BINARIES_SUPPORTED
+#define PROGRAM_BINARIES_SUPPORTED 0
+#endif
+
+#define PROGRAM_FILE_IDENTIFIER "AppleOpenGLDemoProgramBinary"
+
+typedef struct programHeaderRec
+{
+	char fileIdentifier[32];
+	uint64_t hash;
+	unsigned int binaryFormat;
+	unsigned int byteSize;
+} programHeader;
+
+static uint64_t prgHashString(uint64_t hash, const char* string)
+{
+	// Include the null terminator so that adjacent strings cannot run together
+	if(NULL == string)
+	{
+		string = "";
+	}
+	
+	return srcHashData(hash, string, strlen(string) + 1);
+}
+
+uint64_t prgHashProgram(const demoSource* vertexSource, const demoSource* fragmentSource,
+						GLuint glslVersion, const GLchar** attribNames, GLuint numAttribs)
+{
+	uint64_t hash = SOURCE_HASH_SEED;
+	GLuint attribNum;
+	
+	hash = prgHashString(hash, (const char*)glGetString(GL_RENDERER));
+	hash = prgHashString(hash, (const char*)glGetString(GL_VERSION));
+	hash = srcHashData(hash, &glslVersion, sizeof(glslVersion));
+	hash = srcHashData(hash, &vertexSource->hash, sizeof(vertexSource->hash));
+	hash = srcHashData(hash, &fragmentSource->hash, sizeof(fragmentSource->hash));
+	
+	for(attribNum = 0; attribNum < numAttribs; attribNum++)
+	{
+		hash = prgHashString(hash, attribNames[attribNum]);
+	}
+	
+	return hash;
+}
+
+int prgBinariesSupported(void)
+{
+#if PROGRAM_BINARIES_SUPPORTED
+	GLint numFormats = 0;
+	
+	glGetIntegerv(PROGRAM_NUM_BINARY_FORMATS, &numFormats);
+	
+	return numFormats > 0;
+#else
+	return 0;
+#endif
+}
+
+void prgSetBinaryRetrievable(GLuint prgName)
+{
+#if PROGRAM_BINARIES_SUPPORTED && !TARGET_IOS
+	glProgramParameteri(prgName, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+#endif
+}
+
+static void prgBinaryPath(char* path, size_t size, const char* cacheDirectory, uint64_t hash)
+{
+	snprintf(path, size, "%s/%016llx.program", cacheDirectory, (unsigned long long)hash);
+}
+
+GLint prgLoadBinary(GLuint prgName, const char* cacheDirectory, uint64_t hash)
+{
+	GLint status = 0;
+	
+#if PROGRAM_BINARIES_SUPPORTED
+	char path[PATH_MAX];
+	
+	prgBinaryPath(path, sizeof(path), cacheDirectory, hash);
+	
+	FILE* curFile = fopen(path, "rb");
+	
+	if(!curFile)
+	{
+		return 0;
+	}
+	
+	programHeader header;
+	void* binary = NULL;
+	
+	if(fread(&header, sizeof(programHeader), 1, curFile) == 1 &&
+	   0 == strncmp(header.fileIdentifier, PROGRAM_FILE_IDENTIFIER, sizeof(header.fileIdentifier)) &&
+	   header.hash == hash && header.byteSize > 0 &&
+	   NULL != (binary = malloc(header.byteSize)) &&
+	   fread(binary, header.byteSize, 1, curFile) == 1)
+	{
+		prgProgramBinary(prgName, header.binaryFormat, binary, header.byteSize);
+		
+		// Drivers reject binaries made by other versions of themselves
+		glGetProgramiv(prgName, GL_LINK_STATUS, &status);
+	}
+	
+	free(binary);
+	fclose(curFile);
+#endif
+	
+	return status;
+}
+
+int prgSaveBinary(GLuint prgName, const char* cacheDirectory, uint64_t hash)
+{
+	int success = 0;
+	
+#if PROGRAM_BINARIES_SUPPORTED
+	GLint byteSize = 0;
+	GLenum binaryFormat = 0;
+	
+	glGetProgramiv(prgName, PROGRAM_BINARY_LENGTH, &byteSize);
+	
+	void* binary = (byteSize > 0) ? malloc(byteSize) : NULL;
+	
+	if(NULL == binary)
+	{
+		return 0;
+	}
+	
+	prgGetProgramBinary(prgName, byteSize, &byteSize, &binaryFormat, binary);
+	
+	programHeader header;
+	
+	memset(&header, 0, sizeof(programHeader));
+	strncpy(header.fileIdentifier, PROGRAM_FILE_IDENTIFIER, sizeof(header.fileIdentifier));
+	header.hash = hash;
+	header.binaryFormat = binaryFormat;
+	header.byteSize = byteSize;
+	
+	// Write to a temporary file and rename it into place so that a reader
+	//  never sees a partially written binary
+	char path[PATH_MAX];
+	char tempPath[PATH_MAX];
+	
+	prgBinaryPath(path, sizeof(path), cacheDirectory, hash);
+	snprintf(tempPath, sizeof(tempPath), "%s.%d", path, (int)getpid());
+	
+	FILE* curFile = fopen(tempPath, "wb");
+	
+	if(curFile)
+	{
+		success = fwrite(&header, sizeof(programHeader), 1, curFile) == 1 &&
+		          fwrite(binary, byteSize, 1, curFile) == 1;
+		
+		if(fclose(curFile) != 0)
+		{
+			success = 0;
+		}
+		
+		if(!success || rename(tempPath, path) != 0)
+		{
+			unlink(tempPath);
+			success = 0;
+		}
+	}
+	
+	free(binary);
+#endif
+	
+	return success;
+}
@@ -0,0 +1,34 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for caching linked program binaries on disk so that shaders
+  only need to be compiled the first time they are used.
+ */
+
+#ifndef __PROGRAM_UTIL_H__
+#define __PROGRAM_UTIL_H__
+
+#include "sourceUtil.h"
+
+// Hashes everything that affects the linked program: the renderer and driver
+// version, the GLSL version the sources are compiled with, both sources and
+// the attribute bindings (one "name" or NULL per attribute index)
+uint64_t prgHashProgram(const demoSource* vertexSource, const demoSource* fragmentSource,
+						GLuint glslVersion, const GLchar** attribNames, GLuint numAttribs);
+
+// Returns true if the context can retrieve and load program binaries
+int prgBinariesSupported(void);
+
+// Call on a new program before linking it so that its binary can be retrieved
+void prgSetBinaryRetrievable(GLuint prgName);
+
+// Loads the binary cached for hash in cacheDirectory into prgName.  Returns
+// the program's link status, which is 0 if there is no binary or the driver
+// rejected it, in which case the program should be compiled from source.
+GLint prgLoadBinary(GLuint prgName, const char* cacheDirectory, uint64_t hash);
+
+// Caches a linked program's binary for hash in cacheDirectory.  Returns 0 on failure.
+int prgSaveBinary(GLuint prgName, const char* cacheDirectory, uint64_t hash);
+
+#endif // __PROGRAM_UTIL_H__
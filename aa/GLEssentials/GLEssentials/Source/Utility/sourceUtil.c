@@ -12,32 +12,68 @@
 #include <stdlib.h>
 #include <string.h>
 
-demoSource* srcLoadSource(const char* filepathname)
+static GLenum srcShaderTypeForName(const char* filepathname)
 {
-	demoSource* source = (demoSource*) calloc(sizeof(demoSource), 1);
+	size_t length = strlen(filepathname);
+	
+	if(length < 4)
+	{
+		return 0;
+	}
 	
 	// Check the file name suffix to determine what type of shader this is
-	const char* suffixBegin = filepathname + strlen(filepathname) - 4;
+	const char* suffixBegin = filepathname + length - 4;
 	
 	if(0 == strncmp(suffixBegin, ".fsh", 4))
 	{
-		source->shaderType = GL_FRAGMENT_SHADER;
+		return GL_FRAGMENT_SHADER;
 	}
 	else if(0 == strncmp(suffixBegin, ".vsh", 4))
 	{
-		source->shaderType = GL_VERTEX_SHADER;
+		return GL_VERTEX_SHADER;
 	}
-	else
+	
+	// Unknown suffix
+	return 0;
+}
+
+demoSource* srcLoadSource(const char* filepathname)
+{
+	if(NULL == filepathname)
 	{
-		// Unknown suffix
-		source->shaderType = 0;
+		return NULL;
 	}
 	
 	FILE* curFile = fopen(filepathname, "r");
 	
+	if(!curFile)
+	{
+		return NULL;
+	}
+	
 	// Get the size of the source
-	fseek(curFile, 0, SEEK_END);
-	long fileSize = ftell (curFile);
+	long fileSize = -1;
+	
+	if(0 == fseek(curFile, 0, SEEK_END))
+	{
+		fileSize = ftell(curFile);
+	}
+	
+	if(fileSize < 0 || 0 != fseek(curFile, 0, SEEK_SET))
+	{
+		fclose(curFile);
+		return NULL;
+	}
+	
+	demoSource* source = (demoSource*) calloc(sizeof(demoSource), 1);
+	
+	if(NULL == source)
+	{
+		fclose(curFile);
+		return NULL;
+	}
+	
+	source->shaderType = srcShaderTypeForName(filepathname);
 	
 	// Add 1 to the file size to include the null terminator for the string
 	source->byteSize =  (GLsizei)fileSize + 1;
@@ -46,19 +82,75 @@ demoSource* srcLoadSource(const char* filepathname)
 	source->string = malloc(source->byteSize);
 	
 	// Read entire file into the string from beginning of the file
-	fseek(curFile, 0, SEEK_SET);
-	fread(source->string, 1, fileSize, curFile);
+	if(NULL == source->string ||
+	   fread(source->string, 1, fileSize, curFile) != (size_t)fileSize)
+	{
+		fclose(curFile);
+		srcDestroySource(source);
+		return NULL;
+	}
 	
 	fclose(curFile);
 	
 	// Insert null terminator
 	source->string[fileSize] = 0;
 	
+	source->hash = srcHashData(SOURCE_HASH_SEED, source->string, fileSize);
+	
 	return source;
 }
 
+demoSource* srcSourceWithData(const char* name, const char* string, size_t byteSize)
+{
+	demoSource* source = (demoSource*) calloc(sizeof(demoSource), 1);
+	
+	if(NULL == source)
+	{
+		return NULL;
+	}
+	
+	source->shaderType = srcShaderTypeForName(name);
+	
+	// Add 1 to the size to include the null terminator for the string
+	source->byteSize = (GLsizei)byteSize + 1;
+	source->string = malloc(source->byteSize);
+	
+	if(NULL == source->string)
+	{
+		free(source);
+		return NULL;
+	}
+	
+	memcpy(source->string, string, byteSize);
+	source->string[byteSize] = 0;
+	
+	source->hash = srcHashData(SOURCE_HASH_SEED, source->string, byteSize);
+	
+	return source;
+}
+
+uint64_t srcHashData(uint64_t hash, const void* data, size_t byteSize)
+{
+	const unsigned char* bytes = (const unsigned char*)data;
+	size_t byteNum;
+	
+	// 64-bit FNV-1a
+	for(byteNum = 0; byteNum < byteSize; byteNum++)
+	{
+		hash ^= bytes[byteNum];
+		hash *= 1099511628211ull;
+	}
+	
+	return hash;
+}
+
 void srcDestroySource(demoSource* source)
 {
+	if(NULL == source)
+	{
+		return;
+	}
+	
 	free(source->string);
 	free(source);
 }
\ No newline at end of file
@@ -11,6 +11,11 @@
 #define __SOURCE_UTIL_H__
 
 #include "glUtil.h"
+#include <stddef.h>
+#include <stdint.h>
+
+// Starting value for srcHashData
+#define SOURCE_HASH_SEED 14695981039346656037ull
 
 typedef struct demoSourceRec
 {
@@ -20,10 +25,21 @@ typedef struct demoSourceRec
 	
 	GLenum shaderType; // Vertex or Fragment
 	
+	uint64_t hash; // Hash of the source string, see srcHashData
+	
 } demoSource;
 
+// Returns NULL if the file cannot be read
 demoSource* srcLoadSource(const char* filepathname);
 
+// Creates a source from a string of byteSize characters (which need not be
+// null terminated).  The shader type is determined from the suffix of name.
+demoSource* srcSourceWithData(const char* name, const char* string, size_t byteSize);
+
+// Continues a 64-bit FNV-1a hash over byteSize bytes of data.  Start with
+// SOURCE_HASH_SEED or chain the hashes of several pieces of data together.
+uint64_t srcHashData(uint64_t hash, const void* data, size_t byteSize);
+
 void srcDestroySource(demoSource* source);
 
 #endif // __SOURCE_UTIL_H__
@@ -0,0 +1,355 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for converting a model's separate attribute arrays into a single
+  interleaved vertex stream with optionally quantized attributes.
+ */
+
+#include "vertexUtil.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#define VERTEX_ALIGN(size) (((size) + 3) & ~3)
+
+// Converts to IEEE half precision rounding to nearest even
+static GLushort vtxHalfFromFloat(GLfloat value)
+{
+	GLuint bits;
+
+	memcpy(&bits, &value, sizeof(bits));
+
+	GLuint sign = (bits >> 16) & 0x8000;
+	GLuint exponent = (bits >> 23) & 0xFF;
+	GLuint mantissa = bits & 0x7FFFFF;
+
+	if(0xFF == exponent)
+	{
+		// Infinity stays infinity and NaN stays NaN
+		return (GLushort)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+	}
+
+	GLint halfExponent = (GLint)exponent - 127 + 15;
+
+	if(halfExponent >= 31)
+	{
+		return (GLushort)(sign | 0x7C00);
+	}
+
+	if(halfExponent <= 0)
+	{
+		if(halfExponent < -10)
+		{
+			return (GLushort)sign;
+		}
+
+		// Denormal, shift in the implicit leading bit
+		mantissa |= 0x800000;
+
+		GLuint shift = (GLuint)(14 - halfExponent);
+		GLuint half = mantissa >> shift;
+		GLuint remainder = mantissa & ((1u << shift) - 1);
+		GLuint halfway = 1u << (shift - 1);
+
+		if(remainder > halfway || (remainder == halfway && (half & 1)))
+		{
+			half++;
+		}
+
+		return (GLushort)(sign | half);
+	}
+
+	GLuint half = ((GLuint)halfExponent << 10) | (mantissa >> 13);
+	GLuint remainder = mantissa & 0x1FFF;
+
+	// A carry out of the mantissa correctly bumps the exponent
+	if(remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+	{
+		half++;
+	}
+
+	return (GLushort)(sign | half);
+}
+
+static GLfloat vtxSign(GLfloat value)
+{
+	return (value >= 0.0f) ? 1.0f : -1.0f;
+}
+
+// Projects a normal onto the octahedron and unfolds it into [-1, 1]^2
+static void vtxOctahedralEncode(GLfloat* encoded, const GLfloat* normal)
+{
+	GLfloat length = fabsf(normal[0]) + fabsf(normal[1]) + fabsf(normal[2]);
+
+	if(0.0f == length)
+	{
+		encoded[0] = encoded[1] = 0.0f;
+		return;
+	}
+
+	GLfloat x = normal[0] / length;
+	GLfloat y = normal[1] / length;
+
+	if(normal[2] < 0.0f)
+	{
+		GLfloat foldedX = (1.0f - fabsf(y)) * vtxSign(x);
+		GLfloat foldedY = (1.0f - fabsf(x)) * vtxSign(y);
+
+		x = foldedX;
+		y = foldedY;
+	}
+
+	encoded[0] = x;
+	encoded[1] = y;
+}
+
+static GLint vtxQuantizeSigned(GLfloat value, GLint maxValue)
+{
+	if(value > 1.0f) value = 1.0f;
+	if(value < -1.0f) value = -1.0f;
+
+	return (GLint)lrintf(value * maxValue);
+}
+
+static GLuint vtxQuantizeUnsigned(GLfloat value, GLuint maxValue)
+{
+	if(value > 1.0f) value = 1.0f;
+	if(value < 0.0f) value = 0.0f;
+
+	return (GLuint)lrintf(value * maxValue);
+}
+
+// Returns the attribute's float array if it can be read for every vertex
+static const GLfloat* vtxFloatArray(const GLubyte* array, GLsizei arraySize, GLenum type,
+									GLuint size, GLuint numVertices)
+{
+	if(NULL == array || GL_FLOAT != type || 0 == size ||
+	   (size_t)size * sizeof(GLfloat) * numVertices > (size_t)arraySize)
+	{
+		return NULL;
+	}
+
+	return (const GLfloat*)array;
+}
+
+demoVertexStream* vtxInterleaveModel(const demoModel* model, GLuint positionFormat,
+									 GLuint normalFormat, GLuint texcoordFormat)
+{
+	GLuint numVertices = model->numVertcies;
+	GLuint vertNum, component;
+
+	const GLfloat* positions = vtxFloatArray(model->positions, model->positionArraySize,
+											 model->positionType, model->positionSize, numVertices);
+	const GLfloat* normals = vtxFloatArray(model->normals, model->normalArraySize,
+										   model->normalType, model->normalSize, numVertices);
+	const GLfloat* texcoords = vtxFloatArray(model->texcoords, model->texcoordArraySize,
+											 model->texcoordType, model->texcoordSize, numVertices);
+
+	// Every attribute the model has must be convertible
+	if(NULL == positions || model->positionSize > 4 ||
+	   (model->normals && (NULL == normals || model->normalSize > 4)) ||
+	   (model->texcoords && (NULL == texcoords || model->texcoordSize > 4)))
+	{
+		return NULL;
+	}
+
+	// Octahedral encoding needs all three components of the normal
+	if(normals && model->normalSize != 3)
+	{
+		normalFormat = VERTEX_NORMAL_FLOAT;
+	}
+
+	// Texcoords that wrap or mirror cannot be stored normalized
+	if(texcoords && VERTEX_TEXCOORD_UNORM16 == texcoordFormat)
+	{
+		for(vertNum = 0; vertNum < numVertices * model->texcoordSize; vertNum++)
+		{
+			if(texcoords[vertNum] < 0.0f || texcoords[vertNum] > 1.0f)
+			{
+				texcoordFormat = VERTEX_TEXCOORD_FLOAT;
+				break;
+			}
+		}
+	}
+
+	demoVertexStream* stream = (demoVertexStream*) calloc(sizeof(demoVertexStream), 1);
+
+	if(NULL == stream)
+	{
+		return NULL;
+	}
+
+	stream->numVertices = numVertices;
+	stream->normalFormat = normals ? normalFormat : VERTEX_NORMAL_FLOAT;
+	stream->texcoordFormat = texcoords ? texcoordFormat : VERTEX_TEXCOORD_FLOAT;
+
+	// Lay out the attributes, each starting on a 4 byte boundary
+	GLsizei offset = 0;
+
+	stream->position.offset = offset;
+
+	if(VERTEX_POSITION_HALF == positionFormat)
+	{
+		stream->position.size = 4;
+		stream->position.type = VERTEX_HALF_FLOAT_TYPE;
+		offset += 4 * sizeof(GLushort);
+	}
+	else
+	{
+		stream->position.size = model->positionSize;
+		stream->position.type = GL_FLOAT;
+		offset += model->positionSize * sizeof(GLfloat);
+	}
+
+	if(normals)
+	{
+		stream->normal.offset = offset;
+
+		switch(stream->normalFormat)
+		{
+			case VERTEX_NORMAL_OCT16:
+				stream->normal.size = 2;
+				stream->normal.type = GL_SHORT;
+				stream->normal.normalized = GL_TRUE;
+				offset += 2 * sizeof(GLshort);
+				break;
+			case VERTEX_NORMAL_OCT8:
+				stream->normal.size = 2;
+				stream->normal.type = GL_BYTE;
+				stream->normal.normalized = GL_TRUE;
+				offset += VERTEX_ALIGN(2 * sizeof(GLbyte));
+				break;
+			default:
+				stream->normalFormat = VERTEX_NORMAL_FLOAT;
+				stream->normal.size = model->normalSize;
+				stream->normal.type = GL_FLOAT;
+				offset += model->normalSize * sizeof(GLfloat);
+				break;
+		}
+	}
+
+	if(texcoords)
+	{
+		stream->texcoord.offset = offset;
+
+		if(VERTEX_TEXCOORD_UNORM16 == stream->texcoordFormat)
+		{
+			stream->texcoord.size = model->texcoordSize;
+			stream->texcoord.type = GL_UNSIGNED_SHORT;
+			stream->texcoord.normalized = GL_TRUE;
+			offset += VERTEX_ALIGN(model->texcoordSize * sizeof(GLushort));
+		}
+		else
+		{
+			stream->texcoordFormat = VERTEX_TEXCOORD_FLOAT;
+			stream->texcoord.size = model->texcoordSize;
+			stream->texcoord.type = GL_FLOAT;
+			offset += model->texcoordSize * sizeof(GLfloat);
+		}
+	}
+
+	stream->stride = offset;
+	stream->vertexArraySize = stream->stride * numVertices;
+	stream->vertices = (GLubyte*) calloc(stream->vertexArraySize, 1);
+
+	if(NULL == stream->vertices)
+	{
+		vtxDestroyStream(stream);
+		return NULL;
+	}
+
+	for(vertNum = 0; vertNum < numVertices; vertNum++)
+	{
+		GLubyte* vertex = stream->vertices + vertNum * stream->stride;
+		const GLfloat* position = &positions[vertNum * model->positionSize];
+
+		if(VERTEX_HALF_FLOAT_TYPE == stream->position.type)
+		{
+			// Missing components default to (0, 0, 0, 1) as they would in GL
+			GLfloat padded[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+			GLushort half[4];
+
+			memcpy(padded, position, model->positionSize * sizeof(GLfloat));
+
+			for(component = 0; component < 4; component++)
+			{
+				half[component] = vtxHalfFromFloat(padded[component]);
+			}
+
+			memcpy(vertex + stream->position.offset, half, sizeof(half));
+		}
+		else
+		{
+			memcpy(vertex + stream->position.offset, position, model->positionSize * sizeof(GLfloat));
+		}
+
+		if(normals)
+		{
+			const GLfloat* normal = &normals[vertNum * model->normalSize];
+			GLfloat encoded[2];
+
+			switch(stream->normalFormat)
+			{
+				case VERTEX_NORMAL_OCT16:
+				{
+					GLshort packed[2];
+
+					vtxOctahedralEncode(encoded, normal);
+					packed[0] = (GLshort)vtxQuantizeSigned(encoded[0], 32767);
+					packed[1] = (GLshort)vtxQuantizeSigned(encoded[1], 32767);
+					memcpy(vertex + stream->normal.offset, packed, sizeof(packed));
+					break;
+				}
+				case VERTEX_NORMAL_OCT8:
+				{
+					GLbyte packed[2];
+
+					vtxOctahedralEncode(encoded, normal);
+					packed[0] = (GLbyte)vtxQuantizeSigned(encoded[0], 127);
+					packed[1] = (GLbyte)vtxQuantizeSigned(encoded[1], 127);
+					memcpy(vertex + stream->normal.offset, packed, sizeof(packed));
+					break;
+				}
+				default:
+					memcpy(vertex + stream->normal.offset, normal, model->normalSize * sizeof(GLfloat));
+					break;
+			}
+		}
+
+		if(texcoords)
+		{
+			const GLfloat* texcoord = &texcoords[vertNum * model->texcoordSize];
+
+			if(VERTEX_TEXCOORD_UNORM16 == stream->texcoordFormat)
+			{
+				GLushort packed[4];
+
+				for(component = 0; component < model->texcoordSize; component++)
+				{
+					packed[component] = (GLushort)vtxQuantizeUnsigned(texcoord[component], 65535);
+				}
+
+				memcpy(vertex + stream->texcoord.offset, packed, model->texcoordSize * sizeof(GLushort));
+			}
+			else
+			{
+				memcpy(vertex + stream->texcoord.offset, texcoord, model->texcoordSize * sizeof(GLfloat));
+			}
+		}
+	}
+
+	return stream;
+}
+
+void vtxDestroyStream(demoVertexStream* stream)
+{
+	if(NULL == stream)
+	{
+		return;
+	}
+
+	free(stream->vertices);
+	free(stream);
+}
@@ -0,0 +1,91 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Functions for converting a model's separate attribute arrays into a single
+  interleaved vertex stream with optionally quantized attributes.
+ */
+
+#ifndef __VERTEX_UTIL_H__
+#define __VERTEX_UTIL_H__
+
+#include "modelUtil.h"
+
+// Half float vertex attributes are an extension in OpenGL ES 2.0
+// which uses a different enum value than desktop OpenGL
+#if TARGET_IOS
+#define VERTEX_HALF_FLOAT_TYPE GL_HALF_FLOAT_OES
+#else
+#define VERTEX_HALF_FLOAT_TYPE 0x140B // GL_HALF_FLOAT
+#endif
+
+enum
+{
+	VERTEX_POSITION_FLOAT,    // Unchanged
+	VERTEX_POSITION_HALF      // 4 half floats (8 bytes)
+};
+
+enum
+{
+	VERTEX_NORMAL_FLOAT,      // Unchanged
+	VERTEX_NORMAL_OCT16,      // Octahedral encoding in 2 normalized shorts (4 bytes)
+	VERTEX_NORMAL_OCT8        // Octahedral encoding in 2 normalized bytes (2 bytes + 2 padding)
+};
+
+enum
+{
+	VERTEX_TEXCOORD_FLOAT,    // Unchanged
+	VERTEX_TEXCOORD_UNORM16   // 2 normalized unsigned shorts (4 bytes)
+};
+
+// Octahedral normals arrive in the vertex shader as a vec2 in [-1, 1]
+// and must be decoded before use:
+//
+//  vec3 decodeNormal(vec2 e)
+//  {
+//      vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+//      if(n.z < 0.0)
+//          n.xy = (1.0 - abs(n.yx)) * sign(n.xy);
+//      return normalize(n);
+//  }
+
+typedef struct demoVertexAttribRec
+{
+	// Arguments for glVertexAttribPointer; size is 0 if the model has no such attribute
+	GLint size;
+	GLenum type;
+	GLboolean normalized;
+	GLsizei offset;
+
+} demoVertexAttrib;
+
+typedef struct demoVertexStreamRec
+{
+	GLuint numVertices;
+
+	GLubyte *vertices;
+	GLsizei vertexArraySize;
+
+	// Bytes between vertices; always a multiple of 4 as is every attribute offset
+	GLsizei stride;
+
+	demoVertexAttrib position;
+	demoVertexAttrib normal;
+	demoVertexAttrib texcoord;
+
+	// The VERTEX_NORMAL_ format actually used, so callers know which shader to build
+	GLuint normalFormat;
+	GLuint texcoordFormat;
+
+} demoVertexStream;
+
+// Interleaves the model's positions, normals and texcoords, which must be
+// GL_FLOAT, converting each to the requested format.  Texcoords outside of
+// [0, 1] cannot be stored as VERTEX_TEXCOORD_UNORM16 and are left as floats
+// (check texcoordFormat).  Returns NULL on failure.
+demoVertexStream* vtxInterleaveModel(const demoModel* model, GLuint positionFormat,
+									 GLuint normalFormat, GLuint texcoordFormat);
+
+void vtxDestroyStream(demoVertexStream* stream);
+
+#endif // __VERTEX_UTIL_H__
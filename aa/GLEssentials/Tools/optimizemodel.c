@@ -0,0 +1,75 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Command line tool that reorders a model's triangles and vertices for the
+  post-transform vertex cache, vertex fetch locality and overdraw (see
+  meshUtil.h) and reports the cache statistics before and after.
+
+  Usage: optimizemodel [-t <overdraw threshold>] <input.model> <output.model>
+
+  A threshold of 0 optimizes for the vertex cache only.
+
+  Build with:
+   cc -O2 -I../GLEssentials/Source/Utility -o optimizemodel optimizemodel.c \
+      ../GLEssentials/Source/Utility/meshUtil.c \
+      ../GLEssentials/Source/Utility/modelUtil.c \
+      ../GLEssentials/Source/Utility/vectorUtil.c
+ */
+
+#include "meshUtil.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+int main(int argc, char** argv)
+{
+	GLfloat overdrawThreshold = MESH_DEFAULT_OVERDRAW_THRESHOLD;
+	int argNum = 1;
+
+	if(argc > 2 && 0 == strcmp(argv[1], "-t"))
+	{
+		overdrawThreshold = (GLfloat)atof(argv[2]);
+		argNum = 3;
+	}
+
+	if(argc - argNum != 2)
+	{
+		fprintf(stderr, "Usage: %s [-t <overdraw threshold>] <input.model> <output.model>\n", argv[0]);
+		return 1;
+	}
+
+	demoModel* model = mdlMapModel(argv[argNum]);
+
+	if(NULL == model)
+	{
+		fprintf(stderr, "Could not load %s\n", argv[argNum]);
+		return 1;
+	}
+
+	demoMeshStats statsBefore, statsAfter;
+
+	if(!mshOptimizeModel(model, overdrawThreshold, &statsBefore, &statsAfter))
+	{
+		fprintf(stderr, "Could not optimize %s\n", argv[argNum]);
+		mdlDestroyModel(model);
+		return 1;
+	}
+
+	printf("%u vertices, %u triangles (cache size %d)\n",
+		   model->numVertcies, model->numElements / 3, MESH_DEFAULT_CACHE_SIZE);
+	printf("ACMR %.3f -> %.3f\n", statsBefore.acmr, statsAfter.acmr);
+	printf("ATVR %.3f -> %.3f\n", statsBefore.atvr, statsAfter.atvr);
+
+	if(!mdlSaveModel(model, argv[argNum + 1]))
+	{
+		fprintf(stderr, "Could not write %s\n", argv[argNum + 1]);
+		mdlDestroyModel(model);
+		return 1;
+	}
+
+	mdlDestroyModel(model);
+
+	return 0;
+}
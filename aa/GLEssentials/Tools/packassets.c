@@ -0,0 +1,198 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Command line tool that builds an asset pack for pakOpen (see packUtil.h).
+
+  Usage: packassets <output.pack> <file> [<file> ...]
+
+  Each file is stored under its name without directories; the entry kind
+  is derived from the suffix (.model, .vsh/.fsh or an image suffix).
+
+  Build with:
+   cc -O2 -I../GLEssentials/Source/Utility -o packassets packassets.c
+ */
+
+#include "packFormat.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char* baseName(const char* filepathname)
+{
+	const char* slash = strrchr(filepathname, '/');
+
+	return slash ? slash + 1 : filepathname;
+}
+
+static uint64_t pageAlign(uint64_t offset)
+{
+	return (offset + PACK_PAGE_SIZE - 1) & ~(uint64_t)(PACK_PAGE_SIZE - 1);
+}
+
+static int copyFile(FILE* outFile, const char* filepathname, uint64_t byteSize)
+{
+	char buffer[64 * 1024];
+	FILE* inFile = fopen(filepathname, "rb");
+
+	if(!inFile)
+	{
+		return 0;
+	}
+
+	while(byteSize)
+	{
+		size_t chunk = byteSize < sizeof(buffer) ? (size_t)byteSize : sizeof(buffer);
+
+		if(fread(buffer, 1, chunk, inFile) != chunk ||
+		   fwrite(buffer, 1, chunk, outFile) != chunk)
+		{
+			fclose(inFile);
+			return 0;
+		}
+
+		byteSize -= chunk;
+	}
+
+	fclose(inFile);
+	return 1;
+}
+
+int main(int argc, const char* argv[])
+{
+	if(argc < 3)
+	{
+		fprintf(stderr, "usage: %s <output.pack> <file> [<file> ...]\n", argv[0]);
+		return 1;
+	}
+
+	uint32_t numEntries = (uint32_t)(argc - 2);
+	uint32_t numBuckets = 1;
+
+	// Keep the table at most half full so probe sequences stay short
+	while(numBuckets < 2 * numEntries)
+	{
+		numBuckets <<= 1;
+	}
+
+	packEntry* entries = (packEntry*) calloc(numEntries, sizeof(packEntry));
+	uint32_t* buckets = (uint32_t*) calloc(numBuckets, sizeof(uint32_t));
+
+	if(NULL == entries || NULL == buckets)
+	{
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+
+	uint64_t offset = pageAlign(sizeof(packHeader) +
+	                            numBuckets * sizeof(uint32_t) +
+	                            numEntries * sizeof(packEntry));
+	uint32_t entryNum;
+
+	for(entryNum = 0; entryNum < numEntries; entryNum++)
+	{
+		const char* filepathname = argv[entryNum + 2];
+		const char* name = baseName(filepathname);
+		packEntry* entry = &entries[entryNum];
+
+		if(strlen(name) >= PACK_MAX_NAME_LENGTH)
+		{
+			fprintf(stderr, "%s: name is longer than %d characters\n", filepathname, PACK_MAX_NAME_LENGTH - 1);
+			return 1;
+		}
+
+		FILE* inFile = fopen(filepathname, "rb");
+
+		if(!inFile || fseek(inFile, 0, SEEK_END) < 0)
+		{
+			fprintf(stderr, "%s: cannot read file\n", filepathname);
+			return 1;
+		}
+
+		long fileSize = ftell(inFile);
+		fclose(inFile);
+
+		if(fileSize < 0)
+		{
+			fprintf(stderr, "%s: cannot read file\n", filepathname);
+			return 1;
+		}
+
+		strcpy(entry->name, name);
+		entry->nameHash = packHashName(name);
+		entry->kind = packKindForName(name);
+		entry->byteOffset = offset;
+		entry->byteSize = (uint64_t)fileSize;
+
+		if(PACK_KIND_UNKNOWN == entry->kind)
+		{
+			fprintf(stderr, "warning: %s: unknown asset kind\n", filepathname);
+		}
+
+		uint32_t bucket = entry->nameHash & (numBuckets - 1);
+
+		while(buckets[bucket])
+		{
+			if(0 == strcmp(entries[buckets[bucket] - 1].name, name))
+			{
+				fprintf(stderr, "%s: duplicate entry name '%s'\n", filepathname, name);
+				return 1;
+			}
+
+			bucket = (bucket + 1) & (numBuckets - 1);
+		}
+
+		buckets[bucket] = entryNum + 1;
+
+		offset = pageAlign(offset + entry->byteSize);
+	}
+
+	packHeader header;
+
+	memset(&header, 0, sizeof(header));
+	strncpy(header.fileIdentifier, PACK_FILE_IDENTIFIER, sizeof(header.fileIdentifier));
+	header.majorVersion = PACK_MAJOR_VERSION;
+	header.minorVersion = PACK_MINOR_VERSION;
+	header.numEntries = numEntries;
+	header.numBuckets = numBuckets;
+
+	FILE* outFile = fopen(argv[1], "wb");
+
+	if(!outFile ||
+	   fwrite(&header, sizeof(header), 1, outFile) != 1 ||
+	   fwrite(buckets, sizeof(uint32_t), numBuckets, outFile) != numBuckets ||
+	   fwrite(entries, sizeof(packEntry), numEntries, outFile) != numEntries)
+	{
+		fprintf(stderr, "%s: cannot write file\n", argv[1]);
+		return 1;
+	}
+
+	for(entryNum = 0; entryNum < numEntries; entryNum++)
+	{
+		const packEntry* entry = &entries[entryNum];
+
+		if(fseek(outFile, (long)entry->byteOffset, SEEK_SET) < 0 ||
+		   !copyFile(outFile, argv[entryNum + 2], entry->byteSize))
+		{
+			fprintf(stderr, "%s: cannot copy into %s\n", argv[entryNum + 2], argv[1]);
+			return 1;
+		}
+	}
+
+	// Pad the last entry so the file ends on a page boundary
+	if(ftell(outFile) != (long)offset)
+	{
+		if(fseek(outFile, (long)offset - 1, SEEK_SET) < 0 || fputc(0, outFile) == EOF)
+		{
+			fprintf(stderr, "%s: cannot write file\n", argv[1]);
+			return 1;
+		}
+	}
+
+	fclose(outFile);
+	free(entries);
+	free(buckets);
+
+	return 0;
+}
@@ -87,6 +87,9 @@ typedef struct {
   // Buffer Objects
   GLuint vboId;
   
+  // Signalled once the programs built on a worker context are ready
+  dispatch_group_t programGroup;
+  
   BOOL initialized;
 }
 
@@ -125,6 +128,9 @@ typedef struct {
     
     // Make sure to start with a cleared buffer
     needsErase = YES;
+    
+    // Compile the shaders while the view is being laid out
+    [self createProgramsAsync];
   }
   
   return self;
@@ -151,8 +157,13 @@ typedef struct {
   }
 }
 
-- (void)setupShaders
+- (void)createPrograms
 {
+  NSString *cachesDirectory = NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES)[0];
+  NSString *shaderCacheDirectory = [cachesDirectory stringByAppendingPathComponent:@"Shaders"];
+  
+  [[NSFileManager defaultManager] createDirectoryAtPath:shaderCacheDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+  
   for (int i = 0; i < NUM_PROGRAMS; i++)
   {
     char *vsrc = readFile(pathForResource(program[i].vert));
@@ -167,6 +178,14 @@ typedef struct {
       "MVP", "pointSize", "vertexColor", "texture",
     };
     
+    if (!vsrc || !fsrc)
+    {
+      NSLog(@"failed to read shader sources %s %s", program[i].vert, program[i].frag);
+      free(vsrc);
+      free(fsrc);
+      continue;
+    }
+    
     // auto-assign known attribs
     for (int j = 0; j < NUM_ATTRIBS; j++)
     {
@@ -177,13 +196,48 @@ typedef struct {
       }
     }
     
-    glueCreateProgram(vsrc, fsrc,
-                      attribCt, (const GLchar **)&attribUsed[0], attrib,
-                      NUM_UNIFORMS, &uniformName[0], program[i].uniform,
-                      &program[i].id);
+    // Reuse the linked program from the binary cache when the sources haven't changed
+    glueCreateProgramCached(shaderCacheDirectory.fileSystemRepresentation, NULL, vsrc, fsrc,
+                            attribCt, (const GLchar **)&attribUsed[0], attrib,
+                            NUM_UNIFORMS, &uniformName[0], program[i].uniform,
+                            &program[i].id);
     free(vsrc);
     free(fsrc);
+  }
+}
+
+- (void)createProgramsAsync
+{
+  // A second context in the same sharegroup lets the compile and link run on a worker thread
+  EAGLContext *workerContext = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES2 sharegroup:context.sharegroup];
+  
+  programGroup = dispatch_group_create();
+  
+  if (!workerContext)
+    return;
+  
+  dispatch_group_async(programGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+    [EAGLContext setCurrentContext:workerContext];
+    
+    [self createPrograms];
+    
+    // Flush so the programs are complete before the view's context uses them
+    glFlush();
     
+    [EAGLContext setCurrentContext:nil];
+  });
+}
+
+- (void)setupShaders
+{
+  // Wait for the programs started in -initWithCoder:, building them here if that failed
+  dispatch_group_wait(programGroup, DISPATCH_TIME_FOREVER);
+  
+  if (!program[0].id)
+    [self createPrograms];
+  
+  for (int i = 0; i < NUM_PROGRAMS; i++)
+  {
     // Set constant/initalize uniforms
     if (i == PROGRAM_POINT)
     {
@@ -19,13 +19,26 @@ char *readFile(const char *name)
 	FILE *fh;
 	char *source;
 	
+	if (name == 0)
+		return 0;
+	
 	fh = fopen(name, "r");
 	if (fh == 0)
 		return 0;
 	
-	stat(name, &statbuf);
+	if (fstat(fileno(fh), &statbuf) != 0)
+	{
+		fclose(fh);
+		return 0;
+	}
+	
 	source = (char *) malloc(statbuf.st_size + 1);
-	fread(source, statbuf.st_size, 1, fh);
+	if (source == 0 || fread(source, 1, statbuf.st_size, fh) != (size_t)statbuf.st_size)
+	{
+		free(source);
+		fclose(fh);
+		return 0;
+	}
 	source[statbuf.st_size] = '\0';
 	fclose(fh);
 	
@@ -7,6 +7,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
+#include <limits.h>
+#include <unistd.h>
 #include <sys/stat.h>
 #include "shaderUtil.h"
 #include "debug.h"
@@ -150,3 +153,241 @@ GLint glueCreateProgram(const GLchar *vertSource, const GLchar *fragSource,
 		
 	return status;
 }
+
+
+/* Program binaries are an extension on OpenGL ES 2.0 and core in OpenGL ES 3.0 */
+#if defined(GL_ES_VERSION_3_0)
+#define GLUE_PROGRAM_BINARY 1
+#define GLUE_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS
+#define GLUE_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH
+#define glueGetProgramBinary glGetProgramBinary
+#define glueProgramBinary glProgramBinary
+#elif defined(GL_OES_get_program_binary)
+#define GLUE_PROGRAM_BINARY 1
+#define GLUE_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+#define GLUE_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+#define glueGetProgramBinary glGetProgramBinaryOES
+#define glueProgramBinary glProgramBinaryOES
+#else
+#define GLUE_PROGRAM_BINARY 0
+#endif
+
+#define GLUE_BINARY_IDENTIFIER "GLUEPROGRAMBIN1"
+
+typedef struct
+{
+	char identifier[16];
+	uint64_t hash;
+	uint32_t format;
+	uint32_t length;
+} glueBinaryHeader;
+
+static uint64_t glueHashBytes(uint64_t hash, const void *bytes, size_t length)
+{
+	const unsigned char *byte = (const unsigned char *)bytes;
+	size_t i;
+	
+	/* 64-bit FNV-1a */
+	for (i = 0; i < length; i++)
+	{
+		hash ^= byte[i];
+		hash *= 1099511628211ull;
+	}
+	
+	return hash;
+}
+
+static uint64_t glueHashString(uint64_t hash, const char *string)
+{
+	/* Include the terminator so adjacent strings can't run together */
+	return string ? glueHashBytes(hash, string, strlen(string) + 1) : glueHashBytes(hash, "", 1);
+}
+
+/* Hash of everything that affects the linked program, including the driver */
+uint64_t glueHashProgram(const GLchar *defines, const GLchar *vertSource, const GLchar *fragSource,
+                         GLsizei attribNameCt, const GLchar **attribNames, const GLint *attribLocations)
+{
+	uint64_t hash = 14695981039346656037ull;
+	GLsizei i;
+	
+	hash = glueHashString(hash, (const char *)glGetString(GL_RENDERER));
+	hash = glueHashString(hash, (const char *)glGetString(GL_VERSION));
+	hash = glueHashString(hash, defines);
+	hash = glueHashString(hash, vertSource);
+	hash = glueHashString(hash, fragSource);
+	
+	for (i = 0; i < attribNameCt; i++)
+	{
+		hash = glueHashString(hash, attribNames[i]);
+		hash = glueHashBytes(hash, &attribLocations[i], sizeof(GLint));
+	}
+	
+	return hash;
+}
+
+static int glueProgramBinarySupported(void)
+{
+#if GLUE_PROGRAM_BINARY
+	GLint formatCt = 0;
+	
+	glGetIntegerv(GLUE_NUM_PROGRAM_BINARY_FORMATS, &formatCt);
+	
+	return formatCt > 0;
+#else
+	return 0;
+#endif
+}
+
+/* Load a cached binary into program, returns the link status */
+GLint glueLoadProgramBinary(const char *path, uint64_t hash, GLuint program)
+{
+	GLint status = 0;
+#if GLUE_PROGRAM_BINARY
+	glueBinaryHeader header;
+	void *binary = NULL;
+	FILE *file = fopen(path, "rb");
+	
+	if (!file)
+		return 0;
+	
+	if (fread(&header, sizeof(header), 1, file) == 1 &&
+		strncmp(header.identifier, GLUE_BINARY_IDENTIFIER, sizeof(header.identifier)) == 0 &&
+		header.hash == hash && header.length > 0 &&
+		(binary = malloc(header.length)) != NULL &&
+		fread(binary, header.length, 1, file) == 1)
+	{
+		glueProgramBinary(program, header.format, binary, header.length);
+		
+		/* The driver may reject binaries from an older version of itself */
+		glGetProgramiv(program, GL_LINK_STATUS, &status);
+	}
+	
+	free(binary);
+	fclose(file);
+#endif
+	return status;
+}
+
+/* Write a linked program's binary to path, returns 0 on failure */
+GLint glueSaveProgramBinary(const char *path, uint64_t hash, GLuint program)
+{
+	GLint status = 0;
+#if GLUE_PROGRAM_BINARY
+	glueBinaryHeader header;
+	GLint length = 0;
+	GLenum format = 0;
+	char tempPath[PATH_MAX];
+	
+	glGetProgramiv(program, GLUE_PROGRAM_BINARY_LENGTH, &length);
+	
+	void *binary = (length > 0) ? malloc(length) : NULL;
+	
+	if (!binary)
+		return 0;
+	
+	glueGetProgramBinary(program, length, &length, &format, binary);
+	
+	memset(&header, 0, sizeof(header));
+	strncpy(header.identifier, GLUE_BINARY_IDENTIFIER, sizeof(header.identifier));
+	header.hash = hash;
+	header.format = format;
+	header.length = length;
+	
+	/* Write to a temporary file and rename it so readers never see a partial binary */
+	snprintf(tempPath, sizeof(tempPath), "%s.%d", path, (int)getpid());
+	
+	FILE *file = fopen(tempPath, "wb");
+	
+	if (file)
+	{
+		status = fwrite(&header, sizeof(header), 1, file) == 1 &&
+		         fwrite(binary, length, 1, file) == 1;
+		status &= (fclose(file) == 0);
+		
+		if (!status || rename(tempPath, path) != 0)
+		{
+			unlink(tempPath);
+			status = 0;
+		}
+	}
+	
+	free(binary);
+#endif
+	return status;
+}
+
+/* Like glueCreateProgram, but the defines are prepended to both sources and
+   the linked program is reused from a binary in cacheDirectory when possible */
+GLint glueCreateProgramCached(const char *cacheDirectory, const GLchar *defines,
+                              const GLchar *vertSource, const GLchar *fragSource,
+                              GLsizei attribNameCt, const GLchar **attribNames,
+                              const GLint *attribLocations,
+                              GLsizei uniformNameCt, const GLchar **uniformNames,
+                              GLint *uniformLocations,
+                              GLuint *program)
+{
+	GLuint vertShader = 0, fragShader = 0, prog = 0, status = 0, i;
+	const GLchar *vertSources[2] = { defines ? defines : "", vertSource };
+	const GLchar *fragSources[2] = { defines ? defines : "", fragSource };
+	char path[PATH_MAX] = "";
+	uint64_t hash = 0;
+	
+	if (!vertSource || !fragSource)
+		return 0;
+	
+	prog = glCreateProgram();
+	
+	if (cacheDirectory && glueProgramBinarySupported())
+	{
+		hash = glueHashProgram(defines, vertSource, fragSource, attribNameCt, attribNames, attribLocations);
+		snprintf(path, sizeof(path), "%s/%016llx.bin", cacheDirectory, (unsigned long long)hash);
+		
+		status = glueLoadProgramBinary(path, hash, prog);
+	}
+	
+	if (!status)
+	{
+		/* Start over with a fresh program in case the binary left it in an error state */
+		glDeleteProgram(prog);
+		prog = glCreateProgram();
+		status = 1;
+		
+		status *= glueCompileShader(GL_VERTEX_SHADER, 2, vertSources, &vertShader);
+		status *= glueCompileShader(GL_FRAGMENT_SHADER, 2, fragSources, &fragShader);
+		
+		glAttachShader(prog, vertShader);
+		glAttachShader(prog, fragShader);
+		
+		for (i = 0; i < attribNameCt; i++)
+		{
+			if(strlen(attribNames[i]))
+				glBindAttribLocation(prog, attribLocations[i], attribNames[i]);
+		}
+		
+		status *= glueLinkProgram(prog);
+		
+		if (status && path[0])
+			glueSaveProgramBinary(path, hash, prog);
+		
+		if (vertShader)
+			glDeleteShader(vertShader);
+		if (fragShader)
+			glDeleteShader(fragShader);
+	}
+	
+	if (status)
+	{
+		for(i = 0; i < uniformNameCt; i++)
+		{
+			if(strlen(uniformNames[i]))
+				uniformLocations[i] = glueGetUniformLocation(prog, uniformNames[i]);
+		}
+		*program = prog;
+	}
+	else
+	{
+		glDeleteProgram(prog);
+	}
+	
+	return status;
+}
@@ -0,0 +1,117 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ The subset of Apple's <simd/simd.h> used by AAPLTransforms, for building
+  the math benchmarks on platforms without the simd library.  The types are
+  plain scalar structs, so timings of AAPLTransforms measured with this
+  header are comparable with each other but not with an Apple build.
+ */
+
+#ifndef _MATH_BENCHMARKS_SIMD_H_
+#define _MATH_BENCHMARKS_SIMD_H_
+
+#include <cmath>
+
+namespace simd
+{
+    struct float3
+    {
+        float x, y, z;
+    };
+    
+    struct float4
+    {
+        union
+        {
+            struct
+            {
+                float x, y, z, w;
+            };
+            
+            float3 xyz;
+        };
+    };
+    
+    struct float4x4
+    {
+        float4 columns[4];
+        
+        float4x4() {}
+        
+        // Diagonal matrix, as with the simd library
+        explicit float4x4(const float4& diagonal)
+        {
+            columns[0] = (float4){diagonal.x, 0.0f, 0.0f, 0.0f};
+            columns[1] = (float4){0.0f, diagonal.y, 0.0f, 0.0f};
+            columns[2] = (float4){0.0f, 0.0f, diagonal.z, 0.0f};
+            columns[3] = (float4){0.0f, 0.0f, 0.0f, diagonal.w};
+        }
+        
+        float4x4(const float4& P, const float4& Q, const float4& R, const float4& S)
+        {
+            columns[0] = P;
+            columns[1] = Q;
+            columns[2] = R;
+            columns[3] = S;
+        }
+    };
+    
+    inline float3 operator*(const float& s, const float3& v)
+    {
+        return (float3){s * v.x, s * v.y, s * v.z};
+    }
+    
+    inline float3 operator-(const float3& a, const float3& b)
+    {
+        return (float3){a.x - b.x, a.y - b.y, a.z - b.z};
+    }
+    
+    inline float4 operator*(const float4& v, const float& s)
+    {
+        return (float4){v.x * s, v.y * s, v.z * s, v.w * s};
+    }
+    
+    inline float4 operator+(const float4& a, const float4& b)
+    {
+        return (float4){a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w};
+    }
+    
+    inline float dot(const float3& a, const float3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+    
+    inline float3 cross(const float3& a, const float3& b)
+    {
+        return (float3){a.y * b.z - a.z * b.y,
+                        a.z * b.x - a.x * b.z,
+                        a.x * b.y - a.y * b.x};
+    }
+    
+    inline float3 normalize(const float3& v)
+    {
+        return (1.0f / std::sqrt(dot(v, v))) * v;
+    }
+    
+    inline float4 operator*(const float4x4& m, const float4& v)
+    {
+        return m.columns[0] * v.x + m.columns[1] * v.y + m.columns[2] * v.z + m.columns[3] * v.w;
+    }
+    
+    inline float4x4 operator*(const float4x4& a, const float4x4& b)
+    {
+        return float4x4(a * b.columns[0], a * b.columns[1], a * b.columns[2], a * b.columns[3]);
+    }
+} // simd
+
+static const simd::float4x4 matrix_identity_float4x4((simd::float4){1.0f, 1.0f, 1.0f, 1.0f});
+
+// Computes the sine and cosine of pi times angle
+inline void __sincospif(float angle, float* s, float* c)
+{
+    *s = std::sin(float(M_PI) * angle);
+    *c = std::cos(float(M_PI) * angle);
+}
+
+#endif
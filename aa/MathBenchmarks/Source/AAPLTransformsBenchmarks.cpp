@@ -0,0 +1,132 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Benchmarks for MetalVideoCapture's AAPL:: transforms.
+ */
+
+#include "benchmarkUtil.h"
+#include "AAPLTransforms.h"
+
+#include <cstring>
+#include <vector>
+
+static std::vector<simd::float4x4> bmkAffineTransforms(unsigned int count, unsigned int seed)
+{
+	std::vector<float> values(count * 16);
+	std::vector<simd::float4x4> transforms(count);
+	
+	bmkFillAffine(values.data(), count, seed);
+	
+	for(unsigned int mtxNum = 0; mtxNum < count; mtxNum++)
+	{
+		for(unsigned int column = 0; column < 4; column++)
+		{
+			memcpy(&transforms[mtxNum].columns[column], &values[mtxNum * 16 + column * 4], 4 * sizeof(float));
+		}
+	}
+	
+	return transforms;
+}
+
+static void BM_AAPL_Multiply(benchmark::State& state)
+{
+	std::vector<simd::float4x4> a = bmkAffineTransforms(BENCHMARK_NUM_INPUTS, 1);
+	std::vector<simd::float4x4> b = bmkAffineTransforms(BENCHMARK_NUM_INPUTS, 2);
+	unsigned int inputNum = 0;
+	
+	for(auto _ : state)
+	{
+		simd::float4x4 M = a[inputNum] * b[inputNum];
+		benchmark::DoNotOptimize(M);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_AAPL_Multiply);
+
+static void BM_AAPL_PerspectiveFov(benchmark::State& state)
+{
+	float aspects[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(aspects, BENCHMARK_NUM_INPUTS, 4);
+	
+	for(auto _ : state)
+	{
+		simd::float4x4 M = AAPL::perspective_fov(65.0f, 1.5f + aspects[inputNum], 0.1f, 100.0f);
+		benchmark::DoNotOptimize(M);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_AAPL_PerspectiveFov);
+
+static void BM_AAPL_Ortho2d(benchmark::State& state)
+{
+	float extents[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(extents, BENCHMARK_NUM_INPUTS, 5);
+	
+	for(auto _ : state)
+	{
+		float extent = 2.0f + extents[inputNum];
+		simd::float4x4 M = AAPL::ortho2d_oc(-extent, extent, -1.0f, 1.0f, 0.1f, 100.0f);
+		benchmark::DoNotOptimize(M);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_AAPL_Ortho2d);
+
+// The model view projection matrix as AAPLRenderer builds it every frame
+static void BM_AAPL_RotateChain(benchmark::State& state)
+{
+	float angles[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(angles, BENCHMARK_NUM_INPUTS, 6);
+	
+	const float eye[3] = { 0.0f, 0.0f, 0.0f };
+	const float center[3] = { 0.0f, 0.0f, 1.0f };
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	simd::float4x4 projection = AAPL::perspective_fov(65.0f, 1.5f, 0.1f, 100.0f);
+	simd::float4x4 view = AAPL::lookAt(eye, center, up);
+	
+	for(auto _ : state)
+	{
+		simd::float4x4 model = AAPL::translate(0.0f, 0.0f, 5.0f) *
+		                       AAPL::rotate(180.0f * angles[inputNum], 0.0f, 1.0f, 0.0f);
+		simd::float4x4 M = projection * (view * model);
+		benchmark::DoNotOptimize(M);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_AAPL_RotateChain);
+
+static void BM_AAPL_LookAt(benchmark::State& state)
+{
+	float eyes[BENCHMARK_NUM_INPUTS * 3];
+	const float center[3] = { 0.0f, 0.0f, 0.0f };
+	const float up[3] = { 0.0f, 1.0f, 0.0f };
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(eyes, BENCHMARK_NUM_INPUTS * 3, 7);
+	
+	for(auto _ : state)
+	{
+		float eye[3] = { eyes[inputNum * 3], eyes[inputNum * 3 + 1], eyes[inputNum * 3 + 2] - 4.0f };
+		simd::float4x4 M = AAPL::lookAt(eye, center, up);
+		benchmark::DoNotOptimize(M);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_AAPL_LookAt);
@@ -0,0 +1,135 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Benchmarks for SharedMath called directly, where the compiler can inline it.
+ */
+
+#include "benchmarkUtil.h"
+#include "SharedMath.h"
+
+#include <string.h>
+#include <vector>
+
+using namespace SharedMath;
+
+static std::vector<mat4> bmkAffineMatrices(unsigned int seed)
+{
+	std::vector<mat4> matrices(BENCHMARK_NUM_INPUTS);
+	std::vector<float> values(BENCHMARK_NUM_INPUTS * 16);
+	
+	bmkFillAffine(values.data(), BENCHMARK_NUM_INPUTS, seed);
+	memcpy(matrices.data(), values.data(), values.size() * sizeof(float));
+	
+	return matrices;
+}
+
+static void BM_SharedMath_Multiply(benchmark::State& state)
+{
+	std::vector<mat4> a = bmkAffineMatrices(1);
+	std::vector<mat4> b = bmkAffineMatrices(2);
+	unsigned int inputNum = 0;
+	
+	for(auto _ : state)
+	{
+		mat4 m = a[inputNum] * b[inputNum];
+		benchmark::DoNotOptimize(m);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_Multiply);
+
+static void BM_SharedMath_Inverse(benchmark::State& state)
+{
+	std::vector<mat4> src = bmkAffineMatrices(3);
+	unsigned int inputNum = 0;
+	
+	for(auto _ : state)
+	{
+		mat4 m = inverse(src[inputNum]);
+		benchmark::DoNotOptimize(m);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_Inverse);
+
+static void BM_SharedMath_InverseAffine(benchmark::State& state)
+{
+	std::vector<mat4> src = bmkAffineMatrices(3);
+	unsigned int inputNum = 0;
+	
+	for(auto _ : state)
+	{
+		mat4 m = inverseAffine(src[inputNum]);
+		benchmark::DoNotOptimize(m);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_InverseAffine);
+
+static void BM_SharedMath_PerspectiveRH(benchmark::State& state)
+{
+	float aspects[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(aspects, BENCHMARK_NUM_INPUTS, 4);
+	
+	for(auto _ : state)
+	{
+		mat4 m = perspectiveRH(1.5707963f, 1.5f + aspects[inputNum], 5.0f, 10000.0f);
+		benchmark::DoNotOptimize(m);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_PerspectiveRH);
+
+// Same chain as BM_mtxRotateApplyChain, written as products of constructed matrices
+static void BM_SharedMath_RotateChain(benchmark::State& state)
+{
+	float angles[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(angles, BENCHMARK_NUM_INPUTS, 6);
+	
+	for(auto _ : state)
+	{
+		mat4 m = translation(vec3(0.0f, 150.0f, -450.0f)) *
+				 rotationX(radians(-90.0f)) *
+				 rotationZ(kPi * angles[inputNum]) *
+				 scaling(vec3(1.0f, -1.0f, 1.0f));
+		benchmark::DoNotOptimize(m);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_RotateChain);
+
+static void BM_SharedMath_Slerp(benchmark::State& state)
+{
+	float angles[BENCHMARK_NUM_INPUTS];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(angles, BENCHMARK_NUM_INPUTS, 7);
+	
+	quat a = quatFromAxisAngle(vec3(0.0f, 1.0f, 0.0f), 0.25f);
+	
+	for(auto _ : state)
+	{
+		quat b = quatFromAxisAngle(vec3(1.0f, 1.0f, 0.0f), kPi * angles[inputNum]);
+		quat q = slerp(a, b, 0.5f);
+		benchmark::DoNotOptimize(q);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_SharedMath_Slerp);
@@ -0,0 +1,47 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Inputs and reporting shared by the math benchmarks.
+ */
+
+#include "benchmarkUtil.h"
+
+#include <cmath>
+
+void bmkFillRandom(float* values, unsigned int count, unsigned int seed)
+{
+	// xorshift32; the same values on every platform and run
+	unsigned int state = seed * 2654435761u + 1;
+	
+	for(unsigned int valueNum = 0; valueNum < count; valueNum++)
+	{
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		
+		values[valueNum] = (float)(state >> 8) * (2.0f / 16777216.0f) - 1.0f;
+	}
+}
+
+void bmkFillAffine(float* matrices, unsigned int count, unsigned int seed)
+{
+	for(unsigned int mtxNum = 0; mtxNum < count; mtxNum++)
+	{
+		float* mtx = &matrices[mtxNum * 16];
+		
+		bmkFillRandom(mtx, 16, seed + mtxNum);
+		
+		// A dominant diagonal keeps the matrix far from singular
+		mtx[0] += 4.0f;
+		mtx[5] += 4.0f;
+		mtx[10] += 4.0f;
+		mtx[3] = mtx[7] = mtx[11] = 0.0f;
+		mtx[15] = 1.0f;
+	}
+}
+
+void bmkSetOps(benchmark::State& state, int64_t opsPerIteration)
+{
+	state.SetItemsProcessed(state.iterations() * opsPerIteration);
+}
@@ -0,0 +1,31 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Inputs and reporting shared by the math benchmarks.
+ */
+
+#ifndef __BENCHMARK_UTIL_H__
+#define __BENCHMARK_UTIL_H__
+
+#include <benchmark/benchmark.h>
+
+// Each benchmark cycles through this many inputs so that results cannot be
+// hoisted out of the timing loop, while keeping the inputs in L1
+#define BENCHMARK_NUM_INPUTS 64
+#define BENCHMARK_INPUT_MASK (BENCHMARK_NUM_INPUTS - 1)
+
+// Matrices processed per iteration by the batch benchmarks
+#define BENCHMARK_BATCH_SIZE 1024
+
+// Fills count floats with deterministic values in [-1, 1]
+void bmkFillRandom(float* values, unsigned int count, unsigned int seed);
+
+// Fills count column major 4x4 matrices with well conditioned affine transforms
+void bmkFillAffine(float* matrices, unsigned int count, unsigned int seed);
+
+// Reports opsPerIteration operations per iteration as items_per_second,
+// from which the summary's ns/op and the regression check are computed
+void bmkSetOps(benchmark::State& state, int64_t opsPerIteration);
+
+#endif // __BENCHMARK_UTIL_H__
@@ -0,0 +1,193 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Runs the math benchmarks and optionally compares them against a saved
+  baseline, failing if any benchmark got slower by more than a threshold.
+
+  Usage: mathbenchmarks [--baseline=<file>] [--save-baseline=<file>]
+                        [--threshold=<fraction>] [benchmark options]
+
+  A baseline file holds one "<benchmark name> <ns/op>" line per benchmark.
+  The default threshold of 0.10 fails a benchmark more than 10% slower than
+  its baseline.  All other options are passed to Google Benchmark, e.g.
+  --benchmark_filter=mtx --benchmark_repetitions=5.
+ */
+
+#include "benchmarkUtil.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#define BENCHMARK_DEFAULT_THRESHOLD 0.10
+
+// Prints results as usual and records ns/op for each benchmark
+class BaselineReporter : public benchmark::ConsoleReporter
+{
+public:
+	std::map<std::string, double> nsPerOp;
+	
+	void ReportRuns(const std::vector<Run>& runs) override
+	{
+		ConsoleReporter::ReportRuns(runs);
+		
+		for(const Run& run : runs)
+		{
+			// With repetitions the median is least affected by outliers
+			if(run.error_occurred ||
+			   (run.run_type == Run::RT_Aggregate && run.aggregate_name != "median"))
+			{
+				continue;
+			}
+			
+			auto items = run.counters.find("items_per_second");
+			
+			if(items == run.counters.end() || items->second.value <= 0.0)
+			{
+				continue;
+			}
+			
+			nsPerOp[run.run_name.str()] = 1e9 / items->second.value;
+		}
+	}
+};
+
+static bool bmkReadBaseline(const char* path, std::map<std::string, double>& baseline)
+{
+	std::ifstream file(path);
+	std::string name;
+	double value;
+	
+	if(!file)
+	{
+		return false;
+	}
+	
+	while(file >> name >> value)
+	{
+		baseline[name] = value;
+	}
+	
+	return true;
+}
+
+static bool bmkWriteBaseline(const char* path, const std::map<std::string, double>& results)
+{
+	FILE* curFile = fopen(path, "w");
+	
+	if(!curFile)
+	{
+		return false;
+	}
+	
+	for(const auto& result : results)
+	{
+		fprintf(curFile, "%s %.4f\n", result.first.c_str(), result.second);
+	}
+	
+	return fclose(curFile) == 0;
+}
+
+// Prints ns/op and throughput for each benchmark, and the change from the
+// baseline if there is one.  Returns the number of benchmarks that regressed.
+static int bmkSummarize(const std::map<std::string, double>& baseline,
+                        const std::map<std::string, double>& results, double threshold)
+{
+	int numRegressed = 0;
+	
+	printf("\n%-28s %12s %12s %12s %9s\n", "Benchmark", "ns/op", "Mops/s", "Baseline", "Change");
+	
+	for(const auto& result : results)
+	{
+		auto base = baseline.find(result.first);
+		
+		printf("%-28s %12.2f %12.2f", result.first.c_str(), result.second, 1e3 / result.second);
+		
+		if(base == baseline.end())
+		{
+			printf(" %12s %9s\n", "-", "-");
+			continue;
+		}
+		
+		double change = result.second / base->second - 1.0;
+		bool regressed = change > threshold;
+		
+		printf(" %12.2f %+8.1f%%%s\n", base->second, 100.0 * change, regressed ? "  REGRESSED" : "");
+		
+		numRegressed += regressed;
+	}
+	
+	return numRegressed;
+}
+
+int main(int argc, char** argv)
+{
+	const char* baselinePath = NULL;
+	const char* savePath = NULL;
+	double threshold = BENCHMARK_DEFAULT_THRESHOLD;
+	std::vector<char*> benchmarkArgs;
+	
+	for(int argNum = 0; argNum < argc; argNum++)
+	{
+		if(0 == strncmp(argv[argNum], "--baseline=", 11))
+		{
+			baselinePath = argv[argNum] + 11;
+		}
+		else if(0 == strncmp(argv[argNum], "--save-baseline=", 16))
+		{
+			savePath = argv[argNum] + 16;
+		}
+		else if(0 == strncmp(argv[argNum], "--threshold=", 12))
+		{
+			threshold = atof(argv[argNum] + 12);
+		}
+		else
+		{
+			benchmarkArgs.push_back(argv[argNum]);
+		}
+	}
+	
+	int benchmarkArgc = (int)benchmarkArgs.size();
+	
+	benchmark::Initialize(&benchmarkArgc, benchmarkArgs.data());
+	
+	if(benchmark::ReportUnrecognizedArguments(benchmarkArgc, benchmarkArgs.data()))
+	{
+		return 1;
+	}
+	
+	BaselineReporter reporter;
+	
+	benchmark::RunSpecifiedBenchmarks(&reporter);
+	benchmark::Shutdown();
+	
+	if(savePath && !bmkWriteBaseline(savePath, reporter.nsPerOp))
+	{
+		fprintf(stderr, "Could not write baseline %s\n", savePath);
+		return 1;
+	}
+	
+	std::map<std::string, double> baseline;
+	
+	if(baselinePath && !bmkReadBaseline(baselinePath, baseline))
+	{
+		fprintf(stderr, "Could not read baseline %s\n", baselinePath);
+		return 1;
+	}
+	
+	int numRegressed = bmkSummarize(baseline, reporter.nsPerOp, threshold);
+	
+	if(numRegressed)
+	{
+		printf("\n%d benchmark(s) more than %.0f%% slower than the baseline\n",
+		       numRegressed, 100.0 * threshold);
+		return 2;
+	}
+	
+	return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Benchmarks for VideoSnake's mat4f functions.
+ */
+
+#include "benchmarkUtil.h"
+
+extern "C"
+{
+#include "matrix.h"
+}
+
+#include <vector>
+
+static void BM_mat4f_MultiplyMat4f(benchmark::State& state)
+{
+	std::vector<float> a(BENCHMARK_NUM_INPUTS * 16);
+	std::vector<float> b(BENCHMARK_NUM_INPUTS * 16);
+	float mout[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillAffine(a.data(), BENCHMARK_NUM_INPUTS, 1);
+	bmkFillAffine(b.data(), BENCHMARK_NUM_INPUTS, 2);
+	
+	for(auto _ : state)
+	{
+		mat4f_MultiplyMat4f(&a[inputNum * 16], &b[inputNum * 16], mout);
+		benchmark::DoNotOptimize(mout);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mat4f_MultiplyMat4f);
+
+static void BM_mat4f_LoadPerspective(benchmark::State& state)
+{
+	float aspects[BENCHMARK_NUM_INPUTS];
+	float mout[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(aspects, BENCHMARK_NUM_INPUTS, 4);
+	
+	for(auto _ : state)
+	{
+		mat4f_LoadPerspective(1.5707963f, 1.5f + aspects[inputNum], 5.0f, 10000.0f, mout);
+		benchmark::DoNotOptimize(mout);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mat4f_LoadPerspective);
+
+static void BM_mat4f_LoadOrtho(benchmark::State& state)
+{
+	float extents[BENCHMARK_NUM_INPUTS];
+	float mout[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(extents, BENCHMARK_NUM_INPUTS, 5);
+	
+	for(auto _ : state)
+	{
+		float extent = 2.0f + extents[inputNum];
+		
+		mat4f_LoadOrtho(-extent, extent, -1.0f, 1.0f, 0.1f, 100.0f, mout);
+		benchmark::DoNotOptimize(mout);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mat4f_LoadOrtho);
+
+// The library has no apply functions, so each step loads a matrix and multiplies
+static void BM_mat4f_RotateChain(benchmark::State& state)
+{
+	float angles[BENCHMARK_NUM_INPUTS];
+	float translation[3] = { 0.0f, 150.0f, -450.0f };
+	float scale[3] = { 1.0f, -1.0f, 1.0f };
+	float modelView[16], step[16], temp[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(angles, BENCHMARK_NUM_INPUTS, 6);
+	
+	for(auto _ : state)
+	{
+		mat4f_LoadTranslation(translation, modelView);
+		mat4f_LoadXRotation(-1.5707963f, step);
+		mat4f_MultiplyMat4f(modelView, step, temp);
+		mat4f_LoadZRotation(3.1415927f * angles[inputNum], step);
+		mat4f_MultiplyMat4f(temp, step, modelView);
+		mat4f_LoadScale(scale, step);
+		mat4f_MultiplyMat4f(modelView, step, temp);
+		benchmark::DoNotOptimize(temp);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mat4f_RotateChain);
@@ -0,0 +1,280 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Benchmarks for GLEssentials' matrixUtil and vectorUtil.
+ */
+
+#include "benchmarkUtil.h"
+
+extern "C"
+{
+#include "matrixUtil.h"
+#include "affineUtil.h"
+#include "vectorUtil.h"
+}
+
+#include <vector>
+
+static void BM_mtxMultiply(benchmark::State& state)
+{
+	std::vector<float> lhs(BENCHMARK_NUM_INPUTS * 16);
+	std::vector<float> rhs(BENCHMARK_NUM_INPUTS * 16);
+	float ret[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillAffine(lhs.data(), BENCHMARK_NUM_INPUTS, 1);
+	bmkFillAffine(rhs.data(), BENCHMARK_NUM_INPUTS, 2);
+	
+	for(auto _ : state)
+	{
+		mtxMultiply(ret, &lhs[inputNum * 16], &rhs[inputNum * 16]);
+		benchmark::DoNotOptimize(ret);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtxMultiply);
+
+static void BM_mtxMultiplyBatch(benchmark::State& state)
+{
+	std::vector<float> lhs(BENCHMARK_BATCH_SIZE * 16);
+	std::vector<float> rhs(BENCHMARK_BATCH_SIZE * 16);
+	std::vector<float> ret(BENCHMARK_BATCH_SIZE * 16);
+	
+	bmkFillAffine(lhs.data(), BENCHMARK_BATCH_SIZE, 1);
+	bmkFillAffine(rhs.data(), BENCHMARK_BATCH_SIZE, 2);
+	
+	for(auto _ : state)
+	{
+		mtxMultiplyBatch(ret.data(), lhs.data(), rhs.data(), BENCHMARK_BATCH_SIZE);
+		benchmark::ClobberMemory();
+	}
+	
+	bmkSetOps(state, BENCHMARK_BATCH_SIZE);
+}
+BENCHMARK(BM_mtxMultiplyBatch);
+
+static void BM_mtxInvert(benchmark::State& state)
+{
+	std::vector<float> src(BENCHMARK_NUM_INPUTS * 16);
+	float mtx[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillAffine(src.data(), BENCHMARK_NUM_INPUTS, 3);
+	
+	for(auto _ : state)
+	{
+		mtxInvert(mtx, &src[inputNum * 16]);
+		benchmark::DoNotOptimize(mtx);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtxInvert);
+
+static void BM_mtxInvertBatch(benchmark::State& state)
+{
+	std::vector<float> src(BENCHMARK_BATCH_SIZE * 16);
+	std::vector<float> mtx(BENCHMARK_BATCH_SIZE * 16);
+	
+	bmkFillAffine(src.data(), BENCHMARK_BATCH_SIZE, 3);
+	
+	for(auto _ : state)
+	{
+		mtxInvertBatch(mtx.data(), src.data(), BENCHMARK_BATCH_SIZE);
+		benchmark::ClobberMemory();
+	}
+	
+	bmkSetOps(state, BENCHMARK_BATCH_SIZE);
+}
+BENCHMARK(BM_mtxInvertBatch);
+
+// Builds affine transforms of the given kind from the same rotations
+static void bmkFillAffineKind(demoAffine* transforms, unsigned int count, unsigned int kind)
+{
+	float angles[BENCHMARK_NUM_INPUTS * 2];
+	
+	bmkFillRandom(angles, count * 2, 10);
+	
+	for(unsigned int affNum = 0; affNum < count; affNum++)
+	{
+		affLoadTranslate(&transforms[affNum], 0, 150, -450);
+		affRotateXApply(&transforms[affNum], 180.0f * angles[affNum * 2]);
+		affRotateApply(&transforms[affNum], 180.0f * angles[affNum * 2 + 1], 0.7f, 0.3f, 1.0f);
+		
+		if(AFFINE_UNIFORM_SCALE == kind)
+		{
+			affScaleApply(&transforms[affNum], 2.0f, 2.0f, 2.0f);
+		}
+		else if(AFFINE_GENERAL == kind)
+		{
+			affScaleApply(&transforms[affNum], 1.0f, 2.0f, 3.0f);
+		}
+	}
+}
+
+static void BM_affInvert(benchmark::State& state)
+{
+	demoAffine src[BENCHMARK_NUM_INPUTS];
+	demoAffine aff;
+	unsigned int inputNum = 0;
+	
+	bmkFillAffineKind(src, BENCHMARK_NUM_INPUTS, (unsigned int)state.range(0));
+	
+	for(auto _ : state)
+	{
+		affInvert(&aff, &src[inputNum]);
+		benchmark::DoNotOptimize(aff);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_affInvert)->Arg(AFFINE_RIGID)->Arg(AFFINE_UNIFORM_SCALE)->Arg(AFFINE_GENERAL);
+
+// The normal matrix computed the general way, for comparison with affNormalMatrix
+static void BM_mtx3x3NormalMatrix(benchmark::State& state)
+{
+	demoAffine src[BENCHMARK_NUM_INPUTS];
+	float topLeft[9], inverse[9], normalMatrix[9];
+	unsigned int inputNum = 0;
+	
+	bmkFillAffineKind(src, BENCHMARK_NUM_INPUTS, AFFINE_GENERAL);
+	
+	for(auto _ : state)
+	{
+		mtx3x3FromTopLeftOf4x4(topLeft, src[inputNum].mtx);
+		mtx3x3Invert(inverse, topLeft);
+		mtx3x3Transpose(normalMatrix, inverse);
+		benchmark::DoNotOptimize(normalMatrix);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtx3x3NormalMatrix);
+
+static void BM_affNormalMatrix(benchmark::State& state)
+{
+	demoAffine src[BENCHMARK_NUM_INPUTS];
+	float normalMatrix[9];
+	unsigned int inputNum = 0;
+	
+	bmkFillAffineKind(src, BENCHMARK_NUM_INPUTS, (unsigned int)state.range(0));
+	
+	for(auto _ : state)
+	{
+		affNormalMatrix(normalMatrix, &src[inputNum]);
+		benchmark::DoNotOptimize(normalMatrix);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_affNormalMatrix)->Arg(AFFINE_RIGID)->Arg(AFFINE_UNIFORM_SCALE)->Arg(AFFINE_GENERAL);
+
+static void BM_mtxLoadPerspective(benchmark::State& state)
+{
+	float aspects[BENCHMARK_NUM_INPUTS];
+	float mtx[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(aspects, BENCHMARK_NUM_INPUTS, 4);
+	
+	for(auto _ : state)
+	{
+		mtxLoadPerspective(mtx, 90.0f, 1.5f + aspects[inputNum], 5.0f, 10000.0f);
+		benchmark::DoNotOptimize(mtx);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtxLoadPerspective);
+
+static void BM_mtxLoadOrthographic(benchmark::State& state)
+{
+	float extents[BENCHMARK_NUM_INPUTS];
+	float mtx[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(extents, BENCHMARK_NUM_INPUTS, 5);
+	
+	for(auto _ : state)
+	{
+		float extent = 2.0f + extents[inputNum];
+		
+		mtxLoadOrthographic(mtx, -extent, extent, -1.0f, 1.0f, 0.1f, 100.0f);
+		benchmark::DoNotOptimize(mtx);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtxLoadOrthographic);
+
+// The character's model view matrix as OpenGLRenderer builds it every frame
+static void BM_mtxRotateApplyChain(benchmark::State& state)
+{
+	float angles[BENCHMARK_NUM_INPUTS];
+	float modelView[16];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(angles, BENCHMARK_NUM_INPUTS, 6);
+	
+	for(auto _ : state)
+	{
+		mtxLoadTranslate(modelView, 0, 150, -450);
+		mtxRotateXApply(modelView, -90.0f);
+		mtxRotateApply(modelView, 180.0f * angles[inputNum], 0.7f, 0.3f, 1.0f);
+		mtxScaleApply(modelView, 1, -1, 1);
+		benchmark::DoNotOptimize(modelView);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_mtxRotateApplyChain);
+
+static void BM_vec3Normalize(benchmark::State& state)
+{
+	float src[BENCHMARK_NUM_INPUTS * 3];
+	float vec[3];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(src, BENCHMARK_NUM_INPUTS * 3, 7);
+	
+	for(auto _ : state)
+	{
+		vec3Normalize(vec, &src[inputNum * 3]);
+		benchmark::DoNotOptimize(vec);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_vec3Normalize);
+
+static void BM_vec3CrossProduct(benchmark::State& state)
+{
+	float lhs[BENCHMARK_NUM_INPUTS * 3];
+	float rhs[BENCHMARK_NUM_INPUTS * 3];
+	float vec[3];
+	unsigned int inputNum = 0;
+	
+	bmkFillRandom(lhs, BENCHMARK_NUM_INPUTS * 3, 8);
+	bmkFillRandom(rhs, BENCHMARK_NUM_INPUTS * 3, 9);
+	
+	for(auto _ : state)
+	{
+		vec3CrossProduct(vec, &lhs[inputNum * 3], &rhs[inputNum * 3]);
+		benchmark::DoNotOptimize(vec);
+		inputNum = (inputNum + 1) & BENCHMARK_INPUT_MASK;
+	}
+	
+	bmkSetOps(state, 1);
+}
+BENCHMARK(BM_vec3CrossProduct);
@@ -0,0 +1,173 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A counter-based random number generator shared by the shaders, the renderer
+    and the CPU engine. Every cell's random value is a pure function of a seed,
+    the cell's coordinates and a stream, so grids can be seeded in parallel in
+    any order, on any device, with bit-identical results.
+*/
+
+#ifndef AAPLLifeRandom_h
+#define AAPLLifeRandom_h
+
+#ifdef __METAL_VERSION__
+typedef uint AAPLLifeRandomWord;
+#else
+#include <stdint.h>
+typedef uint32_t AAPLLifeRandomWord;
+#endif
+
+// Streams keep the random values used for different purposes independent
+#define AAPL_LIFE_RANDOM_STREAM_SEED       0u
+#define AAPL_LIFE_RANDOM_STREAM_ACTIVATION 1u
+
+// Probabilities as thresholds on a 32 bit random word: a cell is chosen when
+// its word is below the threshold. These are 0.1 and 0.444 times 2^32.
+#define AAPL_LIFE_INITIAL_ALIVE_THRESHOLD 429496730u
+#define AAPL_LIFE_SPAWN_THRESHOLD         1906965479u
+
+// The seed, split into the two 32 bit halves of a Philox key
+typedef struct
+{
+    AAPLLifeRandomWord key0;
+    AAPLLifeRandomWord key1;
+} AAPLLifeRandomKey;
+
+typedef struct
+{
+    AAPLLifeRandomWord x, y, z, w;
+} AAPLLifeRandomBlock;
+
+static inline AAPLLifeRandomWord AAPLLifeRandomMulHi(AAPLLifeRandomWord a, AAPLLifeRandomWord b)
+{
+#ifdef __METAL_VERSION__
+    return mulhi(a, b);
+#else
+    return (AAPLLifeRandomWord)(((uint64_t)a * b) >> 32);
+#endif
+}
+
+// Philox4x32-10 (Salmon et al., "Parallel Random Numbers: As Easy as 1, 2, 3",
+// SC 2011): four random words from a 128 bit counter and a 64 bit key
+static inline AAPLLifeRandomBlock AAPLLifeRandomPhilox(AAPLLifeRandomBlock counter, AAPLLifeRandomKey key)
+{
+    for (int round = 0; round < 10; ++round)
+    {
+        AAPLLifeRandomWord hi0 = AAPLLifeRandomMulHi(0xD2511F53u, counter.x);
+        AAPLLifeRandomWord lo0 = 0xD2511F53u * counter.x;
+        AAPLLifeRandomWord hi1 = AAPLLifeRandomMulHi(0xCD9E8D57u, counter.z);
+        AAPLLifeRandomWord lo1 = 0xCD9E8D57u * counter.z;
+        
+        AAPLLifeRandomBlock next = { hi1 ^ counter.y ^ key.key0, lo1, hi0 ^ counter.w ^ key.key1, lo0 };
+        counter = next;
+        
+        key.key0 += 0x9E3779B9u;
+        key.key1 += 0xBB67AE85u;
+    }
+    
+    return counter;
+}
+
+// One Philox block covers four horizontally adjacent cells, so seeding a row
+// costs a quarter of a block per cell. sequence distinguishes repeated uses of
+// a stream, such as successive activations.
+static inline AAPLLifeRandomBlock AAPLLifeRandomCellBlock(AAPLLifeRandomKey key, AAPLLifeRandomWord x,
+                                                          AAPLLifeRandomWord y, AAPLLifeRandomWord stream,
+                                                          AAPLLifeRandomWord sequence)
+{
+    AAPLLifeRandomBlock counter = { x >> 2, y, stream, sequence };
+    
+    return AAPLLifeRandomPhilox(counter, key);
+}
+
+static inline AAPLLifeRandomWord AAPLLifeRandomCell(AAPLLifeRandomKey key, AAPLLifeRandomWord x,
+                                                    AAPLLifeRandomWord y, AAPLLifeRandomWord stream,
+                                                    AAPLLifeRandomWord sequence)
+{
+    AAPLLifeRandomBlock block = AAPLLifeRandomCellBlock(key, x, y, stream, sequence);
+    
+    switch (x & 3)
+    {
+        case 0: return block.x;
+        case 1: return block.y;
+        case 2: return block.z;
+        default: return block.w;
+    }
+}
+
+#ifndef __METAL_VERSION__
+
+// Blocks generated side by side when seeding a row; the rounds are written
+// lane by lane so the compiler can map the lanes onto vector registers
+#define AAPL_LIFE_RANDOM_LANES 16
+
+// Fills a row of the game state texture with cells that are alive with
+// probability threshold / 2^32, dead cells being maximally dead. Rows are
+// independent, so callers may seed them concurrently.
+static inline void AAPLLifeRandomSeedRow(uint8_t *cells, uint32_t width, uint32_t y,
+                                         AAPLLifeRandomKey key, AAPLLifeRandomWord threshold)
+{
+    const uint32_t cellsPerPass = AAPL_LIFE_RANDOM_LANES * 4;
+    uint32_t x = 0;
+    
+    for (; x + cellsPerPass <= width; x += cellsPerPass)
+    {
+        AAPLLifeRandomWord c0[AAPL_LIFE_RANDOM_LANES], c1[AAPL_LIFE_RANDOM_LANES];
+        AAPLLifeRandomWord c2[AAPL_LIFE_RANDOM_LANES], c3[AAPL_LIFE_RANDOM_LANES];
+        AAPLLifeRandomKey roundKey = key;
+        
+        for (int lane = 0; lane < AAPL_LIFE_RANDOM_LANES; ++lane)
+        {
+            c0[lane] = (x >> 2) + lane;
+            c1[lane] = y;
+            c2[lane] = AAPL_LIFE_RANDOM_STREAM_SEED;
+            c3[lane] = 0;
+        }
+        
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int lane = 0; lane < AAPL_LIFE_RANDOM_LANES; ++lane)
+            {
+                uint64_t product0 = (uint64_t)0xD2511F53u * c0[lane];
+                uint64_t product1 = (uint64_t)0xCD9E8D57u * c2[lane];
+                AAPLLifeRandomWord next0 = (AAPLLifeRandomWord)(product1 >> 32) ^ c1[lane] ^ roundKey.key0;
+                AAPLLifeRandomWord next2 = (AAPLLifeRandomWord)(product0 >> 32) ^ c3[lane] ^ roundKey.key1;
+                
+                c1[lane] = (AAPLLifeRandomWord)product1;
+                c3[lane] = (AAPLLifeRandomWord)product0;
+                c0[lane] = next0;
+                c2[lane] = next2;
+            }
+            
+            roundKey.key0 += 0x9E3779B9u;
+            roundKey.key1 += 0xBB67AE85u;
+        }
+        
+        for (int lane = 0; lane < AAPL_LIFE_RANDOM_LANES; ++lane)
+        {
+            uint8_t *block = cells + x + lane * 4;
+            
+            block[0] = c0[lane] < threshold ? 0 : 255;
+            block[1] = c1[lane] < threshold ? 0 : 255;
+            block[2] = c2[lane] < threshold ? 0 : 255;
+            block[3] = c3[lane] < threshold ? 0 : 255;
+        }
+    }
+    
+    for (; x < width; ++x)
+    {
+        cells[x] = AAPLLifeRandomCell(key, x, y, AAPL_LIFE_RANDOM_STREAM_SEED, 0) < threshold ? 0 : 255;
+    }
+}
+
+static inline AAPLLifeRandomKey AAPLLifeRandomKeyMake(uint64_t seed)
+{
+    AAPLLifeRandomKey key = { (AAPLLifeRandomWord)seed, (AAPLLifeRandomWord)(seed >> 32) };
+    
+    return key;
+}
+
+#endif
+
+#endif /* AAPLLifeRandom_h */
@@ -0,0 +1,429 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Parsing and formatting of the cellular automaton rules in AAPLLifeRule.h.
+*/
+
+#include "AAPLLifeRule.h"
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static void AAPLLifeRuleMaskSet(AAPLLifeRuleWord *mask, AAPLLifeRuleWord count)
+{
+    mask[count / 32] |= 1u << (count % 32);
+}
+
+// Reads a decimal number, advancing the cursor; returns 0 if there is none
+static int AAPLLifeRuleReadNumber(const char **cursor, unsigned long *value)
+{
+    char *end;
+    
+    if (!isdigit((unsigned char)**cursor))
+    {
+        return 0;
+    }
+    
+    *value = strtoul(*cursor, &end, 10);
+    *cursor = end;
+    
+    return 1;
+}
+
+// Reads single digit counts up to the next '/' or the end, as in B36 or 23
+static int AAPLLifeRuleReadDigits(const char **cursor, AAPLLifeRuleWord *mask)
+{
+    for (; **cursor && **cursor != '/'; ++*cursor)
+    {
+        if (!isdigit((unsigned char)**cursor) || **cursor == '9')
+        {
+            return 0;
+        }
+        
+        AAPLLifeRuleMaskSet(mask, (AAPLLifeRuleWord)(**cursor - '0'));
+    }
+    
+    return 1;
+}
+
+// Parses the B/S/C and S/B/C forms, which have a radius 1 Moore neighborhood
+static int AAPLLifeRuleParseSlashed(AAPLLifeRule *rule, const char *string)
+{
+    const char *cursor = string;
+    int field = 0;
+    int numeric = isdigit((unsigned char)*cursor) || *cursor == '/';
+    
+    for (;; ++field)
+    {
+        char letter = (char)toupper((unsigned char)*cursor);
+        
+        if (numeric)
+        {
+            // Fields are survival, birth and then the number of states
+            letter = "SBC"[field < 3 ? field : 2];
+            
+            if (field > 2)
+            {
+                return 0;
+            }
+        }
+        else if (letter == 'B' || letter == 'S' || letter == 'C' || letter == 'G')
+        {
+            ++cursor;
+        }
+        else
+        {
+            return 0;
+        }
+        
+        if (letter == 'B')
+        {
+            if (!AAPLLifeRuleReadDigits(&cursor, rule->birth))
+            {
+                return 0;
+            }
+        }
+        else if (letter == 'S')
+        {
+            if (!AAPLLifeRuleReadDigits(&cursor, rule->survival))
+            {
+                return 0;
+            }
+        }
+        else
+        {
+            unsigned long states;
+            
+            if (!AAPLLifeRuleReadNumber(&cursor, &states) || states < 2 || states > 256)
+            {
+                return 0;
+            }
+            
+            rule->states = (AAPLLifeRuleWord)states;
+        }
+        
+        if (*cursor == '\0')
+        {
+            return 1;
+        }
+        
+        if (*cursor != '/')
+        {
+            return 0;
+        }
+        
+        ++cursor;
+    }
+}
+
+// Parses the comma separated Larger than Life form
+static int AAPLLifeRuleParseLarger(AAPLLifeRule *rule, const char *string)
+{
+    const char *cursor = string;
+    AAPLLifeRuleWord *list = NULL;
+    unsigned long value;
+    
+    while (*cursor)
+    {
+        char letter = (char)toupper((unsigned char)*cursor);
+        
+        if (isdigit((unsigned char)*cursor))
+        {
+            // Another count or range of counts for the last S or B field
+            unsigned long first, last;
+            
+            if (!list || !AAPLLifeRuleReadNumber(&cursor, &first))
+            {
+                return 0;
+            }
+            
+            last = first;
+            
+            if (cursor[0] == '.' && cursor[1] == '.')
+            {
+                cursor += 2;
+                
+                if (!AAPLLifeRuleReadNumber(&cursor, &last) || last < first)
+                {
+                    return 0;
+                }
+            }
+            else if (cursor[0] == '-')
+            {
+                cursor += 1;
+                
+                if (!AAPLLifeRuleReadNumber(&cursor, &last) || last < first)
+                {
+                    return 0;
+                }
+            }
+            
+            // The radius may not be known yet, so counts are checked afterward
+            if (last >= AAPL_LIFE_RULE_MASK_WORDS * 32)
+            {
+                return 0;
+            }
+            
+            for (unsigned long count = first; count <= last; ++count)
+            {
+                AAPLLifeRuleMaskSet(list, (AAPLLifeRuleWord)count);
+            }
+        }
+        else
+        {
+            ++cursor;
+            list = NULL;
+            
+            switch (letter)
+            {
+                case 'R':
+                    if (!AAPLLifeRuleReadNumber(&cursor, &value) || value < 1 || value > AAPL_LIFE_RULE_MAX_RADIUS)
+                    {
+                        return 0;
+                    }
+                    rule->radius = (AAPLLifeRuleWord)value;
+                    break;
+                case 'C':
+                    if (!AAPLLifeRuleReadNumber(&cursor, &value) || value == 1 || value > 256)
+                    {
+                        return 0;
+                    }
+                    rule->states = value < 2 ? 2 : (AAPLLifeRuleWord)value;
+                    break;
+                case 'M':
+                    if (!AAPLLifeRuleReadNumber(&cursor, &value) || value > 1)
+                    {
+                        return 0;
+                    }
+                    rule->includesCenter = (AAPLLifeRuleWord)value;
+                    break;
+                case 'S':
+                    list = rule->survival;
+                    break;
+                case 'B':
+                    list = rule->birth;
+                    break;
+                case 'N':
+                    letter = (char)toupper((unsigned char)*cursor++);
+                    if (letter != 'M' && letter != 'N')
+                    {
+                        return 0;
+                    }
+                    rule->neighborhood = letter == 'M' ? AAPL_LIFE_RULE_MOORE : AAPL_LIFE_RULE_VON_NEUMANN;
+                    break;
+                default:
+                    return 0;
+            }
+        }
+        
+        if (*cursor == ',')
+        {
+            ++cursor;
+        }
+        else if (*cursor && !(list && isdigit((unsigned char)*cursor)))
+        {
+            return 0;
+        }
+    }
+    
+    // No count may exceed the size of the neighborhood
+    AAPLLifeRuleWord maxCount = AAPLLifeRuleMaxCount(rule);
+    
+    for (AAPLLifeRuleWord count = maxCount + 1; count < AAPL_LIFE_RULE_MASK_WORDS * 32; ++count)
+    {
+        if (AAPLLifeRuleMaskTest(rule->birth, count) || AAPLLifeRuleMaskTest(rule->survival, count))
+        {
+            return 0;
+        }
+    }
+    
+    return 1;
+}
+
+int AAPLLifeRuleParse(AAPLLifeRule *rule, const char *string)
+{
+    AAPLLifeRule parsed;
+    char compact[256];
+    size_t length = 0;
+    
+    if (string == NULL)
+    {
+        return 0;
+    }
+    
+    // Spaces are ignored anywhere
+    for (; *string; ++string)
+    {
+        if (isspace((unsigned char)*string))
+        {
+            continue;
+        }
+        
+        if (length + 1 == sizeof(compact))
+        {
+            return 0;
+        }
+        
+        compact[length++] = *string;
+    }
+    
+    compact[length] = '\0';
+    
+    memset(&parsed, 0, sizeof(parsed));
+    parsed.states = 2;
+    parsed.radius = 1;
+    parsed.neighborhood = AAPL_LIFE_RULE_MOORE;
+    
+    int valid;
+    
+    if (length >= 2 && toupper((unsigned char)compact[0]) == 'R' && isdigit((unsigned char)compact[1]))
+    {
+        valid = AAPLLifeRuleParseLarger(&parsed, compact);
+    }
+    else
+    {
+        valid = length > 0 && AAPLLifeRuleParseSlashed(&parsed, compact);
+    }
+    
+    if (valid)
+    {
+        *rule = parsed;
+    }
+    
+    return valid;
+}
+
+void AAPLLifeRuleMakeLife(AAPLLifeRule *rule)
+{
+    AAPLLifeRuleParse(rule, "B3/S23");
+}
+
+int AAPLLifeRuleIsLife(const AAPLLifeRule *rule)
+{
+    AAPLLifeRule life;
+    AAPLLifeRuleMakeLife(&life);
+    
+    return rule->states == 2 && rule->radius == 1 && rule->neighborhood == AAPL_LIFE_RULE_MOORE &&
+           !rule->includesCenter && !memcmp(rule->birth, life.birth, sizeof(life.birth)) &&
+           !memcmp(rule->survival, life.survival, sizeof(life.survival));
+}
+
+AAPLLifeRuleWord AAPLLifeRuleMaxCount(const AAPLLifeRule *rule)
+{
+    AAPLLifeRuleWord radius = rule->radius;
+    AAPLLifeRuleWord cells;
+    
+    if (rule->neighborhood == AAPL_LIFE_RULE_VON_NEUMANN)
+    {
+        cells = 2 * radius * (radius + 1) + 1;
+    }
+    else
+    {
+        cells = (2 * radius + 1) * (2 * radius + 1);
+    }
+    
+    return rule->includesCenter ? cells : cells - 1;
+}
+
+// Appends the counts in mask as comma separated values and ranges
+static int AAPLLifeRuleFormatRanges(const AAPLLifeRuleWord *mask, AAPLLifeRuleWord maxCount,
+                                    char *buffer, size_t size)
+{
+    int length = 0;
+    
+    for (AAPLLifeRuleWord count = 0; count <= maxCount; ++count)
+    {
+        if (!AAPLLifeRuleMaskTest(mask, count))
+        {
+            continue;
+        }
+        
+        AAPLLifeRuleWord last = count;
+        
+        while (last < maxCount && AAPLLifeRuleMaskTest(mask, last + 1))
+        {
+            ++last;
+        }
+        
+        size_t offset = (size_t)length < size ? (size_t)length : size;
+        const char *separator = length ? "," : "";
+        
+        if (last > count)
+        {
+            length += snprintf(buffer + offset, size - offset, "%s%u..%u", separator, count, last);
+        }
+        else
+        {
+            length += snprintf(buffer + offset, size - offset, "%s%u", separator, count);
+        }
+        
+        count = last;
+    }
+    
+    return length;
+}
+
+int AAPLLifeRuleFormat(const AAPLLifeRule *rule, char *buffer, size_t size)
+{
+    AAPLLifeRuleWord maxCount = AAPLLifeRuleMaxCount(rule);
+    int length = 0;
+    
+    #define AAPL_LIFE_RULE_APPEND(...) \
+        length += snprintf(buffer + ((size_t)length < size ? (size_t)length : size), \
+                           (size_t)length < size ? size - (size_t)length : 0, __VA_ARGS__)
+    
+    if (rule->radius == 1 && rule->neighborhood == AAPL_LIFE_RULE_MOORE && !rule->includesCenter)
+    {
+        AAPL_LIFE_RULE_APPEND("B");
+        
+        for (AAPLLifeRuleWord count = 0; count <= 8; ++count)
+        {
+            if (AAPLLifeRuleMaskTest(rule->birth, count))
+            {
+                AAPL_LIFE_RULE_APPEND("%u", count);
+            }
+        }
+        
+        AAPL_LIFE_RULE_APPEND("/S");
+        
+        for (AAPLLifeRuleWord count = 0; count <= 8; ++count)
+        {
+            if (AAPLLifeRuleMaskTest(rule->survival, count))
+            {
+                AAPL_LIFE_RULE_APPEND("%u", count);
+            }
+        }
+        
+        if (rule->states > 2)
+        {
+            AAPL_LIFE_RULE_APPEND("/C%u", rule->states);
+        }
+    }
+    else
+    {
+        AAPL_LIFE_RULE_APPEND("R%u,C%u,M%u,S", rule->radius, rule->states > 2 ? rule->states : 0,
+                              rule->includesCenter);
+        length += AAPLLifeRuleFormatRanges(rule->survival, maxCount,
+                                           buffer + ((size_t)length < size ? (size_t)length : size),
+                                           (size_t)length < size ? size - (size_t)length : 0);
+        AAPL_LIFE_RULE_APPEND(",B");
+        length += AAPLLifeRuleFormatRanges(rule->birth, maxCount,
+                                           buffer + ((size_t)length < size ? (size_t)length : size),
+                                           (size_t)length < size ? size - (size_t)length : 0);
+        AAPL_LIFE_RULE_APPEND(",N%c", rule->neighborhood == AAPL_LIFE_RULE_VON_NEUMANN ? 'N' : 'M');
+    }
+    
+    #undef AAPL_LIFE_RULE_APPEND
+    
+    return length;
+}
+
+int AAPLLifeRuleKernelName(const AAPLLifeRule *rule, char *buffer, size_t size)
+{
+    const char *neighborhood = rule->neighborhood == AAPL_LIFE_RULE_VON_NEUMANN ? "von_neumann" : "moore";
+    
+    return snprintf(buffer, size, "cellular_automaton_%s_%u", neighborhood, rule->radius);
+}
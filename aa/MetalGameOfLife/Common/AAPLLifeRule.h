@@ -0,0 +1,93 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Cellular automaton rules that generalize the Game of Life, shared by the
+    shaders, the renderer and the CPU engine: Life-like birth and survival
+    rules, Generations rules with dying states, and Larger than Life rules
+    with neighborhoods of any radius up to AAPL_LIFE_RULE_MAX_RADIUS.
+
+    Cells keep the game state texture's encoding. 0 is alive and any other
+    value counts the generations since the cell was last alive, saturating at
+    255. Under a Generations rule with n states, values 1 through n - 2 are
+    dying cells, which neither count as live neighbors nor can be born.
+*/
+
+#ifndef AAPLLifeRule_h
+#define AAPLLifeRule_h
+
+#ifdef __METAL_VERSION__
+typedef uint AAPLLifeRuleWord;
+#else
+#include <stddef.h>
+#include <stdint.h>
+typedef uint32_t AAPLLifeRuleWord;
+#endif
+
+#define AAPL_LIFE_RULE_MAX_RADIUS 7
+
+// Neighbor counts run from 0 to (2 * 7 + 1)^2 = 225, one bit per count
+#define AAPL_LIFE_RULE_MASK_WORDS 8
+
+#define AAPL_LIFE_RULE_MOORE       0u
+#define AAPL_LIFE_RULE_VON_NEUMANN 1u
+
+typedef struct
+{
+    // Bit n is set if a dead cell with n live neighbors is born, or if a live
+    // cell with n live neighbors survives
+    AAPLLifeRuleWord birth[AAPL_LIFE_RULE_MASK_WORDS];
+    AAPLLifeRuleWord survival[AAPL_LIFE_RULE_MASK_WORDS];
+
+    // 2 for Life-like rules, up to 256 for Generations rules
+    AAPLLifeRuleWord states;
+
+    // Cells within radius steps of the cell in both directions (Moore) or in
+    // total (von Neumann); the cell itself counts only if includesCenter
+    AAPLLifeRuleWord radius;
+    AAPLLifeRuleWord neighborhood;
+    AAPLLifeRuleWord includesCenter;
+} AAPLLifeRule;
+
+#ifndef __METAL_VERSION__
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Parses a rule in any of these forms, ignoring case:
+//   B3/S23, 23/3                       Life-like rules, the second in S/B order
+//   B2/S345/C4, 345/2/4                Generations rules with 4 states
+//   R5,C0,M1,S34..58,B34..45,NM        Larger than Life; C is the number of
+//                                      states (0 or 2 for two), M1 counts the
+//                                      center cell and NM or NN selects the
+//                                      Moore or von Neumann neighborhood
+// Returns 0 if the string is not a valid rule, leaving rule unchanged.
+int AAPLLifeRuleParse(AAPLLifeRule *rule, const char *string);
+
+// Conway's Game of Life, B3/S23, as simulated by game_of_life
+void AAPLLifeRuleMakeLife(AAPLLifeRule *rule);
+int AAPLLifeRuleIsLife(const AAPLLifeRule *rule);
+
+// Writes the rule in the notation above, B/S for radius 1 Moore rules and R,C
+// otherwise. Returns the length of the full string, as snprintf does.
+int AAPLLifeRuleFormat(const AAPLLifeRule *rule, char *buffer, size_t size);
+
+// Largest possible neighbor count under the rule
+AAPLLifeRuleWord AAPLLifeRuleMaxCount(const AAPLLifeRule *rule);
+
+// Name of the kernel in Shaders.metal specialized for the rule's neighborhood
+int AAPLLifeRuleKernelName(const AAPLLifeRule *rule, char *buffer, size_t size);
+
+static inline int AAPLLifeRuleMaskTest(const AAPLLifeRuleWord *mask, AAPLLifeRuleWord count)
+{
+    return (mask[count / 32] >> (count % 32)) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
+
+#endif /* AAPLLifeRule_h */
@@ -0,0 +1,148 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+The ring of per-generation counters in AAPLLifeTelemetry.h. Recording takes the
+    lock to copy one entry in; polling copies entries out a chunk at a time,
+    dropping the lock between chunks, so a poll holds up a step for no longer
+    than it takes to copy one chunk.
+*/
+
+#include "AAPLLifeTelemetry.h"
+
+#include <pthread.h>
+#include <stdlib.h>
+
+// Entries copied out under one hold of the lock
+#define AAPL_LIFE_TELEMETRY_COPY_CHUNK 64
+
+struct AAPLLifeTelemetry
+{
+    pthread_mutex_t lock;
+    AAPLLifeGenerationStats *entries;
+    size_t capacity;
+    
+    // Entry n lives in slot n % capacity
+    uint64_t recordedCount;
+};
+
+AAPLLifeTelemetry *AAPLLifeTelemetryCreate(size_t capacity)
+{
+    AAPLLifeTelemetry *telemetry = (AAPLLifeTelemetry *)calloc(1, sizeof(AAPLLifeTelemetry));
+    
+    if (!telemetry)
+    {
+        return NULL;
+    }
+    
+    telemetry->capacity = capacity ? capacity : AAPL_LIFE_TELEMETRY_DEFAULT_CAPACITY;
+    telemetry->entries = (AAPLLifeGenerationStats *)calloc(telemetry->capacity, sizeof(AAPLLifeGenerationStats));
+    
+    if (!telemetry->entries)
+    {
+        free(telemetry);
+        return NULL;
+    }
+    
+    pthread_mutex_init(&telemetry->lock, NULL);
+    
+    return telemetry;
+}
+
+void AAPLLifeTelemetryDestroy(AAPLLifeTelemetry *telemetry)
+{
+    if (!telemetry)
+    {
+        return;
+    }
+    
+    pthread_mutex_destroy(&telemetry->lock);
+    free(telemetry->entries);
+    free(telemetry);
+}
+
+size_t AAPLLifeTelemetryCapacity(const AAPLLifeTelemetry *telemetry)
+{
+    return telemetry->capacity;
+}
+
+void AAPLLifeTelemetryRecord(AAPLLifeTelemetry *telemetry, const AAPLLifeGenerationStats *stats)
+{
+    pthread_mutex_lock(&telemetry->lock);
+    telemetry->entries[telemetry->recordedCount % telemetry->capacity] = *stats;
+    ++telemetry->recordedCount;
+    pthread_mutex_unlock(&telemetry->lock);
+}
+
+uint64_t AAPLLifeTelemetryRecordedCount(AAPLLifeTelemetry *telemetry)
+{
+    pthread_mutex_lock(&telemetry->lock);
+    uint64_t recordedCount = telemetry->recordedCount;
+    pthread_mutex_unlock(&telemetry->lock);
+    
+    return recordedCount;
+}
+
+int AAPLLifeTelemetryLatest(AAPLLifeTelemetry *telemetry, AAPLLifeGenerationStats *stats)
+{
+    int found = 0;
+    
+    pthread_mutex_lock(&telemetry->lock);
+    
+    if (telemetry->recordedCount > 0)
+    {
+        *stats = telemetry->entries[(telemetry->recordedCount - 1) % telemetry->capacity];
+        found = 1;
+    }
+    
+    pthread_mutex_unlock(&telemetry->lock);
+    
+    return found;
+}
+
+size_t AAPLLifeTelemetryCopySince(AAPLLifeTelemetry *telemetry, uint64_t *cursor,
+                                  AAPLLifeGenerationStats *stats, size_t maxCount)
+{
+    size_t copied = 0;
+    uint64_t next = *cursor;
+    
+    while (copied < maxCount)
+    {
+        pthread_mutex_lock(&telemetry->lock);
+        
+        uint64_t recordedCount = telemetry->recordedCount;
+        uint64_t oldest = recordedCount > telemetry->capacity ? recordedCount - telemetry->capacity : 0;
+        
+        // Generations overwritten before the copy began are skipped; once some
+        // have been copied, stop short rather than leave a gap after them
+        if (next < oldest)
+        {
+            if (copied)
+            {
+                pthread_mutex_unlock(&telemetry->lock);
+                break;
+            }
+            
+            next = oldest;
+        }
+        
+        size_t chunk = 0;
+        
+        while (next < recordedCount && copied < maxCount && chunk < AAPL_LIFE_TELEMETRY_COPY_CHUNK)
+        {
+            stats[copied++] = telemetry->entries[next++ % telemetry->capacity];
+            ++chunk;
+        }
+        
+        pthread_mutex_unlock(&telemetry->lock);
+        
+        if (chunk < AAPL_LIFE_TELEMETRY_COPY_CHUNK)
+        {
+            break;
+        }
+    }
+    
+    *cursor = next;
+    
+    return copied;
+}
@@ -0,0 +1,89 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Per-generation counters for the simulation, shared by the shaders, the
+    renderer and the CPU engine. Each step counts the live cells, births and
+    deaths and the tiles that changed as it goes, and the totals for every
+    generation are kept in a fixed size ring that tools can poll from any
+    thread. A run has stabilized once generations go by without births or
+    deaths, or, for an oscillator, once no tile stops changing.
+*/
+
+#ifndef AAPLLifeTelemetry_h
+#define AAPLLifeTelemetry_h
+
+// Slots of the counter buffer the step kernels add to, one threadgroup at a time
+#define AAPL_LIFE_COUNTER_POPULATION   0
+#define AAPL_LIFE_COUNTER_BIRTHS       1
+#define AAPL_LIFE_COUNTER_DEATHS       2
+#define AAPL_LIFE_COUNTER_ACTIVE_TILES 3
+#define AAPL_LIFE_COUNTER_COUNT        4
+
+// Generations kept by a ring created with a capacity of 0
+#define AAPL_LIFE_TELEMETRY_DEFAULT_CAPACITY 4096
+
+#ifndef __METAL_VERSION__
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct
+{
+    // The generation these counts lead to
+    uint64_t generation;
+
+    // Live cells after the step, and the cells that came alive or died in it
+    uint64_t population;
+    uint64_t births;
+    uint64_t deaths;
+
+    // Tiles in which any cell changed, out of all the tiles of the grid. The
+    // CPU engine's tiles are those it steps in; the renderer's are threadgroups.
+    uint32_t activeTiles;
+    uint32_t tileCount;
+
+    // Time taken by the step. The renderer can only time the whole command
+    // buffer, from commit until the GPU has finished drawing the frame too.
+    double stepSeconds;
+} AAPLLifeGenerationStats;
+
+typedef struct AAPLLifeTelemetry AAPLLifeTelemetry;
+
+// Creates a ring that keeps the last capacity generations, or
+// AAPL_LIFE_TELEMETRY_DEFAULT_CAPACITY if capacity is 0
+AAPLLifeTelemetry *AAPLLifeTelemetryCreate(size_t capacity);
+void AAPLLifeTelemetryDestroy(AAPLLifeTelemetry *telemetry);
+
+size_t AAPLLifeTelemetryCapacity(const AAPLLifeTelemetry *telemetry);
+
+// Appends a generation, overwriting the oldest once the ring is full. Safe to
+// call from any one thread while others read.
+void AAPLLifeTelemetryRecord(AAPLLifeTelemetry *telemetry, const AAPLLifeGenerationStats *stats);
+
+// Generations recorded since the ring was created, including overwritten ones
+uint64_t AAPLLifeTelemetryRecordedCount(AAPLLifeTelemetry *telemetry);
+
+// Copies the most recent generation; returns 0 if nothing has been recorded
+int AAPLLifeTelemetryLatest(AAPLLifeTelemetry *telemetry, AAPLLifeGenerationStats *stats);
+
+// For polling: copies up to maxCount generations recorded after *cursor,
+// oldest first, and advances *cursor past them. Start *cursor at 0. A poller
+// that falls more than a ring behind skips the generations overwritten since;
+// it can tell from *cursor having moved further than the count returned. The
+// lock is dropped every few entries so that recording is not held up, and if
+// recording laps the copy meanwhile it returns the generations copied so far.
+size_t AAPLLifeTelemetryCopySince(AAPLLifeTelemetry *telemetry, uint64_t *cursor,
+                                  AAPLLifeGenerationStats *stats, size_t maxCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __METAL_VERSION__
+
+#endif /* AAPLLifeTelemetry_h */
@@ -9,10 +9,29 @@ The renderer class for the Game of Life sample. Responsible for enqueuing comput
 @import Foundation;
 @import MetalKit;
 
+#import "AAPLLifeTelemetry.h"
+
 @interface AAPLRenderer : NSObject <MTKViewDelegate>
 
 @property (nonatomic, readonly) MTLSize gridSize;
 
+/// Seed for the initial game state and for activated cells. The same seed
+/// always produces the same grid. Takes effect the next time the grid is built.
+@property (nonatomic, assign) uint64_t randomSeed;
+
+/// The cellular automaton rule the simulation runs, in any notation
+/// AAPLLifeRule.h accepts: B3/S23 (the default), B2/S345/C4 or
+/// R5,C0,M1,S34..58,B34..45,NM, for example. A string that does not parse is
+/// ignored. Reads back in canonical form. Takes effect on the next frame.
+@property (nonatomic, copy) NSString *ruleString;
+
+/// The population, births, deaths and active threadgroups of every
+/// generation, counted by the simulation kernels as they step and recorded
+/// once the GPU finishes each frame; cells activated by touches or clicks
+/// count from the next generation. Owned by the renderer; tools can poll it
+/// from any thread with AAPLLifeTelemetryCopySince.
+@property (nonatomic, readonly) AAPLLifeTelemetry *telemetry;
+
 /// Creates a new renderer and makes it the delegate of the view.
 /// The grid size of the simulation is derived from the current
 /// drawableSize of the view
@@ -23,4 +42,18 @@ The renderer class for the Game of Life sample. Responsible for enqueuing comput
 /// to add interactivity to the simulation.
 - (void)activateRandomCellsInNeighborhoodOfCell:(CGPoint)cell;
 
+/// Records every generation from the next frame on to a file that
+/// AAPLLifeRecording.h can play back. Recording stops when the grid changes
+/// size or the renderer seeks. Returns NO if the file cannot be created.
+- (BOOL)startRecordingToPath:(NSString *)path;
+
+/// Waits for the frames in flight, then finishes the recording. Returns NO
+/// if any frame could not be written.
+- (BOOL)stopRecording;
+
+/// Replaces the game state with a recorded generation and carries on the
+/// simulation from there. The recording must match the grid size. Returns NO
+/// if the generation was not recorded.
+- (BOOL)seekToGeneration:(uint64_t)generation inRecordingAtPath:(NSString *)path;
+
 @end
@@ -7,11 +7,16 @@ The renderer class for the Game of Life sample. Responsible for enqueuing comput
 */
 
 #import "AAPLRenderer.h"
+#import "AAPLLifeRandom.h"
+#import "AAPLLifeRule.h"
+#import "AAPLLifeTelemetry.h"
+#import "AAPLLifeRecording.h"
 
 static const NSUInteger kTextureCount = 3;
-static const CGFloat kInitialAliveProbability = 0.1;
-static const uint8_t kCellValueAlive = 0;
-static const uint8_t kCellValueDead = 255;
+static const uint64_t kDefaultRandomSeed = 0x2016;
+
+// Rows seeded by each concurrent block when building the initial game state
+static const size_t kSeedRowsPerBlock = 64;
 
 static const NSInteger kMaxInflightBuffers = 3;
 
@@ -23,6 +28,10 @@ static const NSInteger kMaxInflightBuffers = 3;
 @property (nonatomic, strong) id<MTLRenderPipelineState> renderPipelineState;
 @property (nonatomic, strong) id<MTLComputePipelineState> simulationPipelineState;
 @property (nonatomic, strong) id<MTLComputePipelineState> activationPipelineState;
+@property (nonatomic, strong) id<MTLComputePipelineState> resizePipelineState;
+@property (nonatomic, strong) NSMutableDictionary<NSString *, id<MTLComputePipelineState>> *rulePipelineStates;
+@property (nonatomic, strong) id<MTLComputePipelineState> rulePipelineState;
+@property (nonatomic, assign) AAPLLifeRule rule;
 @property (nonatomic, strong) id<MTLSamplerState> samplerState;
 @property (nonatomic, strong) NSMutableArray<id<MTLTexture>> *textureQueue;
 @property (nonatomic, strong) id<MTLTexture> currentGameStateTexture;
@@ -31,6 +40,12 @@ static const NSInteger kMaxInflightBuffers = 3;
 @property (nonatomic, strong) NSMutableArray<NSValue *> *activationPoints;
 @property (nonatomic, strong) dispatch_semaphore_t inflightSemaphore;
 @property (nonatomic, strong) NSDate *nextResizeTimestamp;
+@property (nonatomic, assign) uint32_t activationCount;
+@property (nonatomic, strong) NSArray<id<MTLBuffer>> *counterBuffers;
+@property (nonatomic, assign) NSUInteger counterBufferIndex;
+@property (nonatomic, assign) uint64_t generation;
+@property (nonatomic, assign) AAPLLifeRecorderRef recorder;
+@property (nonatomic, strong) NSArray<id<MTLBuffer>> *captureBuffers;
 @end
 
 @implementation AAPLRenderer
@@ -53,12 +68,19 @@ static const NSInteger kMaxInflightBuffers = 3;
         _library = [_device newDefaultLibrary];
         _commandQueue = [_device newCommandQueue];
         
+        _randomSeed = kDefaultRandomSeed;
+        _ruleString = @"B3/S23";
+        AAPLLifeRuleMakeLife(&_rule);
+        _rulePipelineStates = [NSMutableDictionary dictionary];
         _activationPoints = [NSMutableArray array];
         _textureQueue = [NSMutableArray arrayWithCapacity:kTextureCount];
         
+        _telemetry = AAPLLifeTelemetryCreate(0);
+        
         [self buildRenderResources];
         [self buildRenderPipeline];
         [self buildComputePipelines];
+        [self buildCounterBuffers];
         
         [self reshapeWithDrawableSize:_view.drawableSize];
 
@@ -68,6 +90,27 @@ static const NSInteger kMaxInflightBuffers = 3;
     return self;
 }
 
+- (void)dealloc
+{
+    // Frames still in flight record into the telemetry ring and the recording
+    // when they complete, so both outlive the last of them
+    [self waitForInflightFrames];
+    
+    if (_recorder)
+        AAPLLifeRecorderClose(_recorder);
+    AAPLLifeTelemetryDestroy(_telemetry);
+}
+
+- (void)waitForInflightFrames
+{
+    // Take back every slot, so the last frame in flight has finished, then
+    // return them, as a semaphore must not be released below its initial value
+    for (NSInteger i = 0; i < kMaxInflightBuffers; ++i)
+        dispatch_semaphore_wait(_inflightSemaphore, DISPATCH_TIME_FOREVER);
+    for (NSInteger i = 0; i < kMaxInflightBuffers; ++i)
+        dispatch_semaphore_signal(_inflightSemaphore);
+}
+
 #pragma mark - Resource and Pipeline Creation
 
 #if TARGET_OS_IOS || TARGET_OS_TV
@@ -116,6 +159,22 @@ static const NSInteger kMaxInflightBuffers = 3;
     _vertexBuffer.label = @"Fullscreen Quad Vertices";
 }
 
+- (void)buildCounterBuffers
+{
+    // Each frame in flight has its own counters for the simulation kernels to
+    // add to, read back once the GPU has finished with them
+    NSMutableArray<id<MTLBuffer>> *counterBuffers = [NSMutableArray arrayWithCapacity:kMaxInflightBuffers];
+    
+    for (NSInteger i = 0; i < kMaxInflightBuffers; ++i) {
+        id<MTLBuffer> buffer = [_device newBufferWithLength:AAPL_LIFE_COUNTER_COUNT * sizeof(uint32_t)
+                                                    options:MTLResourceStorageModeShared];
+        buffer.label = [NSString stringWithFormat:@"Step Counters %d", (int)i];
+        [counterBuffers addObject:buffer];
+    }
+    
+    _counterBuffers = counterBuffers;
+}
+
 - (void)buildRenderPipeline {
     NSError *error = nil;
     
@@ -157,12 +216,27 @@ static const NSInteger kMaxInflightBuffers = 3;
     MTLSize proposedGridSize = MTLSizeMake(drawableSize.width / scale, drawableSize.height / scale, 1);
     
     if (_gridSize.width != proposedGridSize.width || _gridSize.height != proposedGridSize.height) {
+        // A recording holds one grid size
+        if (_recorder) {
+            NSLog(@"Stopping recording as the grid is changing size");
+            [self stopRecording];
+        }
+        
+        // The last texture in the queue holds the latest game state, which is
+        // carried across to the new grid rather than starting over
+        id<MTLTexture> previousGameStateTexture = [_textureQueue lastObject];
+        
         _gridSize = proposedGridSize;
-        [self buildComputeResources];
+        
+        if (previousGameStateTexture && self.resizePipelineState) {
+            [self resizeComputeResourcesFromTexture:previousGameStateTexture];
+        } else {
+            [self buildComputeResources];
+        }
     }
 }
 
-- (void)buildComputeResources
+- (void)buildGameStateTextures
 {
     [_textureQueue removeAllObjects];
     _currentGameStateTexture = nil;
@@ -182,19 +256,31 @@ static const NSInteger kMaxInflightBuffers = 3;
         texture.label = [NSString stringWithFormat:@"Game State %d", (int)i];
         [_textureQueue addObject:texture];
     }
+}
+
+- (void)buildComputeResources
+{
+    [self buildGameStateTextures];
     
     // In order to make the simulation visually interesting, we need to seed it with
     // an initial game state that has some living and some dead cells. Here, we create
     // a temporary buffer that holds the initial, randomly-generated game state.
-    uint8_t *randomGrid = (uint8_t *)malloc(_gridSize.width * _gridSize.height);
-    for (NSUInteger i = 0; i < _gridSize.width; ++i)
-    {
-        for (NSUInteger j = 0; j < _gridSize.height; ++j)
+    // Each cell's value depends only on the seed and its coordinates, so bands
+    // of rows are filled concurrently and the result is the same every time.
+    uint32_t width = (uint32_t)_gridSize.width;
+    uint32_t height = (uint32_t)_gridSize.height;
+    uint8_t *randomGrid = (uint8_t *)malloc(width * height);
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(_randomSeed);
+    size_t blockCount = (height + kSeedRowsPerBlock - 1) / kSeedRowsPerBlock;
+    
+    dispatch_apply(blockCount, dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0), ^(size_t block) {
+        uint32_t endRow = (uint32_t)MIN((block + 1) * kSeedRowsPerBlock, height);
+        
+        for (uint32_t row = (uint32_t)(block * kSeedRowsPerBlock); row < endRow; ++row)
         {
-            uint8_t alive = drand48() < kInitialAliveProbability ? kCellValueAlive : kCellValueDead;
-            randomGrid[j * _gridSize.width + i] = alive;
+            AAPLLifeRandomSeedRow(randomGrid + (size_t)row * width, width, row, key, AAPL_LIFE_INITIAL_ALIVE_THRESHOLD);
         }
-    }
+    });
     
     // The texture that will be read from at the start of the simulation is the one
     // at the end of the queue we use to store textures, so we overwrite its
@@ -209,6 +295,40 @@ static const NSInteger kMaxInflightBuffers = 3;
     free(randomGrid);
 }
 
+- (void)resizeComputeResourcesFromTexture:(id<MTLTexture>)previousGameStateTexture
+{
+    [self buildGameStateTextures];
+    
+    // The old grid is centered on the new one, so growing the view exposes
+    // fresh cells around the edges and shrinking it crops them. The copy is
+    // queued ahead of the next simulation step, so the command buffer keeps
+    // the old texture alive until it has been read.
+    int32_t oldOrigin[2] = {
+        ((int32_t)previousGameStateTexture.width - (int32_t)_gridSize.width) / 2,
+        ((int32_t)previousGameStateTexture.height - (int32_t)_gridSize.height) / 2,
+    };
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(_randomSeed);
+    
+    MTLSize threadsPerThreadgroup = MTLSizeMake(16, 16, 1);
+    MTLSize threadgroupCount = MTLSizeMake((_gridSize.width + threadsPerThreadgroup.width - 1) / threadsPerThreadgroup.width,
+                                           (_gridSize.height + threadsPerThreadgroup.height - 1) / threadsPerThreadgroup.height,
+                                           1);
+    
+    id<MTLCommandBuffer> commandBuffer = [_commandQueue commandBuffer];
+    commandBuffer.label = @"Resize Game State";
+    
+    id<MTLComputeCommandEncoder> commandEncoder = [commandBuffer computeCommandEncoder];
+    [commandEncoder setComputePipelineState:self.resizePipelineState];
+    [commandEncoder setTexture:previousGameStateTexture atIndex:0];
+    [commandEncoder setTexture:[_textureQueue lastObject] atIndex:1];
+    [commandEncoder setBytes:oldOrigin length:sizeof(oldOrigin) atIndex:0];
+    [commandEncoder setBytes:&key length:sizeof(key) atIndex:1];
+    [commandEncoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadsPerThreadgroup];
+    [commandEncoder endEncoding];
+    
+    [commandBuffer commit];
+}
+
 - (void)buildComputePipelines
 {
     NSError *error = nil;
@@ -243,6 +363,20 @@ static const NSInteger kMaxInflightBuffers = 3;
         NSLog(@"Error when compiling activation pipeline state: %@", error);
     }
     
+    // The resize pipeline carries the game state across when the view changes
+    // size, seeding only the cells the old grid did not cover
+    descriptor.computeFunction = [_library newFunctionWithName:@"resize_game_state"];
+    descriptor.label = @"Resize Game State";
+    _resizePipelineState = [_device newComputePipelineStateWithDescriptor:descriptor
+                                                                  options:MTLPipelineOptionNone
+                                                               reflection:nil
+                                                                    error:&error];
+    
+    if (!_resizePipelineState)
+    {
+        NSLog(@"Error when compiling resize pipeline state: %@", error);
+    }
+    
     // Create a sampler state we can use in the compute kernel to read the
     // game state texture, wrapping around the edges in each direction.
     MTLSamplerDescriptor *samplerDescriptor = [MTLSamplerDescriptor new];
@@ -254,6 +388,174 @@ static const NSInteger kMaxInflightBuffers = 3;
     _samplerState = [_device newSamplerStateWithDescriptor:samplerDescriptor];
 }
 
+- (id<MTLComputePipelineState>)pipelineStateForRule:(const AAPLLifeRule *)rule
+{
+    // Rules share a kernel whenever their neighborhoods match, so a sweep over
+    // thousands of rules builds at most one pipeline per neighborhood
+    char kernelName[64];
+    AAPLLifeRuleKernelName(rule, kernelName, sizeof(kernelName));
+    NSString *name = @(kernelName);
+    
+    id<MTLComputePipelineState> pipelineState = self.rulePipelineStates[name];
+    
+    if (!pipelineState)
+    {
+        NSError *error = nil;
+        MTLComputePipelineDescriptor *descriptor = [MTLComputePipelineDescriptor new];
+        descriptor.computeFunction = [_library newFunctionWithName:name];
+        descriptor.label = name;
+        pipelineState = [_device newComputePipelineStateWithDescriptor:descriptor
+                                                               options:MTLPipelineOptionNone
+                                                            reflection:nil
+                                                                 error:&error];
+        
+        if (!pipelineState)
+        {
+            NSLog(@"Error when compiling rule pipeline state %@: %@", name, error);
+            return nil;
+        }
+        
+        self.rulePipelineStates[name] = pipelineState;
+    }
+    
+    return pipelineState;
+}
+
+#pragma mark - Rules
+
+- (void)setRuleString:(NSString *)ruleString
+{
+    AAPLLifeRule rule;
+    
+    if (!AAPLLifeRuleParse(&rule, ruleString.UTF8String))
+    {
+        NSLog(@"Ignoring unrecognized rule %@", ruleString);
+        return;
+    }
+    
+    // Life itself keeps running on game_of_life
+    id<MTLComputePipelineState> pipelineState = nil;
+    
+    if (!AAPLLifeRuleIsLife(&rule))
+    {
+        pipelineState = [self pipelineStateForRule:&rule];
+        
+        if (!pipelineState)
+        {
+            return;
+        }
+    }
+    
+    char canonicalRule[256];
+    AAPLLifeRuleFormat(&rule, canonicalRule, sizeof(canonicalRule));
+    
+    _ruleString = @(canonicalRule);
+    self.rule = rule;
+    self.rulePipelineState = pipelineState;
+}
+
+#pragma mark - Recording and Playback
+
+- (BOOL)startRecordingToPath:(NSString *)path
+{
+    [self stopRecording];
+    
+    NSUInteger width = _gridSize.width;
+    NSUInteger height = _gridSize.height;
+    NSMutableArray<id<MTLBuffer>> *captureBuffers = [NSMutableArray arrayWithCapacity:kMaxInflightBuffers];
+    
+    for (NSInteger i = 0; i < kMaxInflightBuffers; ++i) {
+        id<MTLBuffer> buffer = [_device newBufferWithLength:width * height
+                                                    options:MTLResourceStorageModeShared];
+        buffer.label = [NSString stringWithFormat:@"Recorded Game State %d", (int)i];
+        [captureBuffers addObject:buffer];
+    }
+    
+    AAPLLifeRecorderRef recorder = AAPLLifeRecorderCreate(path.fileSystemRepresentation,
+                                                          (uint32_t)width, (uint32_t)height);
+    
+    if (!recorder)
+    {
+        NSLog(@"Could not record to %@", path);
+        return NO;
+    }
+    
+    self.captureBuffers = captureBuffers;
+    self.recorder = recorder;
+    return YES;
+}
+
+- (BOOL)stopRecording
+{
+    // Frames in flight hand their game state to the recorder when they complete
+    [self waitForInflightFrames];
+    
+    if (!_recorder)
+        return YES;
+    
+    BOOL written = AAPLLifeRecorderClose(_recorder) != 0;
+    self.recorder = NULL;
+    self.captureBuffers = nil;
+    
+    if (!written)
+        NSLog(@"Some frames of the recording could not be written");
+    
+    return written;
+}
+
+- (BOOL)seekToGeneration:(uint64_t)generation inRecordingAtPath:(NSString *)path
+{
+    AAPLLifeRecordingReaderRef reader = AAPLLifeRecordingReaderOpen(path.fileSystemRepresentation);
+    
+    if (!reader)
+    {
+        NSLog(@"Could not open recording %@", path);
+        return NO;
+    }
+    
+    NSUInteger width = _gridSize.width;
+    NSUInteger height = _gridSize.height;
+    
+    if (AAPLLifeRecordingReaderWidth(reader) != width || AAPLLifeRecordingReaderHeight(reader) != height)
+    {
+        NSLog(@"Recording %@ is %ux%u, but the grid is %ux%u", path,
+              AAPLLifeRecordingReaderWidth(reader), AAPLLifeRecordingReaderHeight(reader),
+              (unsigned)width, (unsigned)height);
+        AAPLLifeRecordingReaderClose(reader);
+        return NO;
+    }
+    
+    uint8_t *cells = (uint8_t *)malloc(width * height);
+    BOOL found = AAPLLifeRecordingReaderSeek(reader, generation, cells, width) != 0;
+    AAPLLifeRecordingReaderClose(reader);
+    
+    if (found)
+    {
+        // A recording only goes forward, and no frame in flight may still be
+        // reading or writing the game state that is about to be replaced
+        [self stopRecording];
+        
+        // The next frame steps on from the texture at the end of the queue,
+        // as it does from the seed
+        id<MTLTexture> currentReadTexture = [_textureQueue lastObject];
+        
+        [currentReadTexture replaceRegion:MTLRegionMake2D(0, 0, width, height)
+                              mipmapLevel:0
+                                withBytes:cells
+                              bytesPerRow:width];
+        
+        self.currentGameStateTexture = currentReadTexture;
+        self.generation = generation;
+    }
+    else
+    {
+        NSLog(@"Generation %llu is not in recording %@", (unsigned long long)generation, path);
+    }
+    
+    free(cells);
+    return found;
+}
+
 #pragma mark - Interactivity
 
 - (void)activateRandomCellsInNeighborhoodOfCell:(CGPoint)cell
@@ -283,11 +585,32 @@ static const NSInteger kMaxInflightBuffers = 3;
                                            ceil((float)self.gridSize.height / threadsPerThreadgroup.height),
                                            1);
     
-    // Configure the compute command encoder and dispatch the actual work
-    [commandEncoder setComputePipelineState:self.simulationPipelineState];
-    [commandEncoder setTexture:readTexture atIndex:0];
-    [commandEncoder setTexture:writeTexture atIndex:1];
-    [commandEncoder setSamplerState:self.samplerState atIndex:0];
+    // The frame that last used these counters has finished and been recorded,
+    // as the in-flight semaphore is only signaled after that
+    NSUInteger frameSlot = self.counterBufferIndex;
+    id<MTLBuffer> counterBuffer = self.counterBuffers[frameSlot];
+    self.counterBufferIndex = (frameSlot + 1) % self.counterBuffers.count;
+    memset(counterBuffer.contents, 0, counterBuffer.length);
+    [commandEncoder setBuffer:counterBuffer offset:0 atIndex:1];
+    
+    // Configure the compute command encoder and dispatch the actual work. Rules
+    // other than Life run on the kernel for their neighborhood, reading the
+    // rule itself from a small implicit buffer.
+    if (self.rulePipelineState)
+    {
+        AAPLLifeRule rule = self.rule;
+        [commandEncoder setComputePipelineState:self.rulePipelineState];
+        [commandEncoder setTexture:readTexture atIndex:0];
+        [commandEncoder setTexture:writeTexture atIndex:1];
+        [commandEncoder setBytes:&rule length:sizeof(rule) atIndex:0];
+    }
+    else
+    {
+        [commandEncoder setComputePipelineState:self.simulationPipelineState];
+        [commandEncoder setTexture:readTexture atIndex:0];
+        [commandEncoder setTexture:writeTexture atIndex:1];
+        [commandEncoder setSamplerState:self.samplerState atIndex:0];
+    }
     [commandEncoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadsPerThreadgroup];
     
     // If the user has interacted with the simulation, we now need to dispatch a smaller
@@ -313,9 +636,15 @@ static const NSInteger kMaxInflightBuffers = 3;
         MTLSize threadsPerThreadgroup = MTLSizeMake(self.activationPoints.count, 1, 1);
         MTLSize threadgroupCount = MTLSizeMake(1, 1, 1);
         
+        // Each activation draws from its own part of the random stream
+        AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(self.randomSeed);
+        uint32_t activationIndex = self.activationCount++;
+        
         [commandEncoder setComputePipelineState:self.activationPipelineState];
         [commandEncoder setTexture:writeTexture atIndex:0];
         [commandEncoder setBytes:cellPositions length:byteCount atIndex:0];
+        [commandEncoder setBytes:&key length:sizeof(key) atIndex:1];
+        [commandEncoder setBytes:&activationIndex length:sizeof(activationIndex) atIndex:2];
         [commandEncoder dispatchThreadgroups:threadgroupCount threadsPerThreadgroup:threadsPerThreadgroup];
         
         [self.activationPoints removeAllObjects];
@@ -324,6 +653,55 @@ static const NSInteger kMaxInflightBuffers = 3;
     
     [commandEncoder endEncoding];
     
+    // When recording, the new game state is copied to a buffer of the frame's
+    // own, in the texture's layout, for the recorder to read once it is done
+    AAPLLifeRecorderRef recorder = self.recorder;
+    id<MTLBuffer> captureBuffer = nil;
+    NSUInteger width = self.gridSize.width;
+    NSUInteger height = self.gridSize.height;
+    
+    if (recorder)
+    {
+        captureBuffer = self.captureBuffers[frameSlot];
+        
+        id<MTLBlitCommandEncoder> blitEncoder = [commandBuffer blitCommandEncoder];
+        [blitEncoder copyFromTexture:writeTexture
+                         sourceSlice:0
+                         sourceLevel:0
+                        sourceOrigin:MTLOriginMake(0, 0, 0)
+                          sourceSize:MTLSizeMake(width, height, 1)
+                            toBuffer:captureBuffer
+                   destinationOffset:0
+              destinationBytesPerRow:width
+            destinationBytesPerImage:width * height];
+        [blitEncoder endEncoding];
+    }
+    
+    // Once the GPU is done, the counters are recorded as this frame's generation
+    AAPLLifeTelemetry *telemetry = self.telemetry;
+    uint64_t generation = ++self.generation;
+    uint32_t tileCount = (uint32_t)(threadgroupCount.width * threadgroupCount.height);
+    CFTimeInterval commitTime = CACurrentMediaTime();
+    
+    [commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> buffer) {
+        const uint32_t *counters = (const uint32_t *)counterBuffer.contents;
+        AAPLLifeGenerationStats stats = {
+            .generation = generation,
+            .population = counters[AAPL_LIFE_COUNTER_POPULATION],
+            .births = counters[AAPL_LIFE_COUNTER_BIRTHS],
+            .deaths = counters[AAPL_LIFE_COUNTER_DEATHS],
+            .activeTiles = counters[AAPL_LIFE_COUNTER_ACTIVE_TILES],
+            .tileCount = tileCount,
+            .stepSeconds = CACurrentMediaTime() - commitTime,
+        };
+        AAPLLifeTelemetryRecord(telemetry, &stats);
+        
+        // The recorder copies the frame and writes it on its own thread. A
+        // failed write is reported when the recording stops.
+        if (recorder)
+            AAPLLifeRecorderRecord(recorder, (const uint8_t *)captureBuffer.contents, width, generation);
+    }];
+    
     // Rotate the queue so the texture we just wrote can be in-flight for the next couple of frames
     self.currentGameStateTexture = [self.textureQueue firstObject];
     [self.textureQueue removeObjectAtIndex:0];
@@ -358,14 +736,15 @@ static const NSInteger kMaxInflightBuffers = 3;
 // Called whenever view changes orientation or layout is changed
 - (void)mtkView:(nonnull MTKView *)view drawableSizeWillChange:(CGSize)size
 {
-    // Since we need to restart the simulation when the drawable size changes,
-    // coalesce rapid changes (such as during window resize) into less frequent
-    // updates to avoid re-creating expensive resources too often.
+    // The game state is carried across when the drawable size changes, but
+    // every resize crops the cells past the new edges, so coalesce rapid
+    // changes (such as during window resize) into one resize to the final
+    // size rather than losing cells to the sizes passed through on the way.
     static const NSTimeInterval resizeHysteresis = 0.200;
     self.nextResizeTimestamp = [NSDate dateWithTimeIntervalSinceNow:resizeHysteresis];
     dispatch_after(dispatch_time(0, resizeHysteresis * NSEC_PER_SEC), dispatch_get_main_queue(), ^{
         if ([self.nextResizeTimestamp timeIntervalSinceNow] <= 0) {
-            NSLog(@"Restarting simulation after window was resized...");
+            NSLog(@"Resizing simulation after window was resized...");
             [self reshapeWithDrawableSize:self.view.drawableSize];
         }
     });
@@ -378,14 +757,16 @@ static const NSInteger kMaxInflightBuffers = 3;
     
     id<MTLCommandBuffer> commandBuffer = [self.commandQueue commandBuffer];
     
+    [self encodeComputeWorkInBuffer:commandBuffer];
+    
+    [self encodeRenderWorkInBuffer:commandBuffer];
+    
+    // Completed handlers run in the order they were added, so the frame's
+    // counters have been read by the time its slot is handed back
     __block dispatch_semaphore_t blockSemaphore = self.inflightSemaphore;
     [commandBuffer addCompletedHandler:^(id<MTLCommandBuffer> buffer) {
         dispatch_semaphore_signal(blockSemaphore);
     }];
-    
-    [self encodeComputeWorkInBuffer:commandBuffer];
-    
-    [self encodeRenderWorkInBuffer:commandBuffer];
 
     [commandBuffer commit];
 }
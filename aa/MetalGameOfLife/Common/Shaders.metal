@@ -10,6 +10,10 @@ Shader functions for the Game of Life sample. Define the core of the GPU-based s
 #include <metal_stdlib>
 #include <simd/simd.h>
 
+#include "AAPLLifeRandom.h"
+#include "AAPLLifeRule.h"
+#include "AAPLLifeTelemetry.h"
+
 using namespace metal;
 
 // Set of vectors to the eight neighbors of a grid cell
@@ -20,9 +24,6 @@ constant float2 kNeighborDirections[] =
     float2( 1, -1), float2( 1, 0), float2( 1, 1),
 };
 
-// Likelihood that a random cell will become alive when interaction happens at an adjacent cell
-constant float kSpawnProbability = 0.444;
-
 // Values that represent "aliveness" and "maximum deadness"
 constant int kCellValueAlive = 0;
 constant int kCellValueDead = 255;
@@ -63,41 +64,134 @@ fragment half4 lighting_fragment(FragmentVertex in [[stage_in]],
     return color;
 }
 
-/// This utility function transforms a 2D integral vector into a random-looking
-/// number between 0 and 1 with roughly uniform distribution
-static float hash(int2 v){
-    return fract(sin(dot(float2(v), float2(12.9898, 78.233))) * 43758.5453);
-}
-
 kernel void activate_random_neighbors(texture2d<uint, access::write> writeTexture [[texture(0)]],
                                       constant uint2 *cellPositions [[buffer(0)]],
+                                      constant AAPLLifeRandomKey &randomKey [[buffer(1)]],
+                                      constant uint &activationIndex [[buffer(2)]],
                                       ushort2 gridPosition [[thread_position_in_grid]])
 {
-    // Iterate over the eight neighbors of this grid cell, quasi-randomly setting each neighbor
-    // to either alive or maximally dead
+    // Iterate over the eight neighbors of this grid cell, randomly setting each neighbor
+    // to either alive or maximally dead. A neighbor becomes alive with probability
+    // AAPL_LIFE_SPAWN_THRESHOLD / 2^32, or 0.444; the same seed, position and
+    // activation index always produce the same cells, here or on the CPU.
     for (ushort i = 0; i < 8; ++i)
     {
         int2 neighborPosition = int2(cellPositions[gridPosition.x]) + int2(kNeighborDirections[i]);
-        ushort cellValue = hash(neighborPosition) < kSpawnProbability ? kCellValueAlive : kCellValueDead;
+        uint random = AAPLLifeRandomCell(randomKey, uint(neighborPosition.x), uint(neighborPosition.y),
+                                         AAPL_LIFE_RANDOM_STREAM_ACTIVATION, activationIndex);
+        ushort cellValue = random < AAPL_LIFE_SPAWN_THRESHOLD ? kCellValueAlive : kCellValueDead;
         writeTexture.write(cellValue, uint2(neighborPosition));
     }
 }
 
+/// This kernel function carries the game state across to a grid of a new size,
+/// centering the old grid on the new one. oldOrigin is the position in the old
+/// grid of the new grid's origin; cells the old grid does not cover are seeded
+/// as the renderer seeds a new grid, and cells past the new edges are dropped.
+kernel void resize_game_state(texture2d<uint, access::read> oldTexture [[texture(0)]],
+                              texture2d<uint, access::write> newTexture [[texture(1)]],
+                              constant int2 &oldOrigin [[buffer(0)]],
+                              constant AAPLLifeRandomKey &randomKey [[buffer(1)]],
+                              ushort2 gridPosition [[thread_position_in_grid]])
+{
+    if (gridPosition.x >= newTexture.get_width() || gridPosition.y >= newTexture.get_height())
+    {
+        return;
+    }
+    
+    int2 oldPosition = int2(gridPosition) + oldOrigin;
+    ushort cellValue;
+    
+    if (all(oldPosition >= 0) && oldPosition.x < int(oldTexture.get_width()) && oldPosition.y < int(oldTexture.get_height()))
+    {
+        cellValue = oldTexture.read(uint2(oldPosition)).r;
+    }
+    else
+    {
+        uint random = AAPLLifeRandomCell(randomKey, gridPosition.x, gridPosition.y, AAPL_LIFE_RANDOM_STREAM_SEED, 0);
+        cellValue = random < AAPL_LIFE_INITIAL_ALIVE_THRESHOLD ? kCellValueAlive : kCellValueDead;
+    }
+    
+    newTexture.write(cellValue, uint2(gridPosition));
+}
+
+/// Clears a threadgroup's step counters. Every thread of the threadgroup calls
+/// this before stepping its cell.
+static void begin_step_counters(threadgroup atomic_uint *groupCounters, ushort threadIndex)
+{
+    if (threadIndex < AAPL_LIFE_COUNTER_COUNT)
+    {
+        atomic_store_explicit(&groupCounters[threadIndex], 0, memory_order_relaxed);
+    }
+    
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+}
+
+/// Tallies one cell's step in threadgroup memory, then adds the threadgroup's
+/// totals to the frame's counters, so the device counters see a few atomics
+/// per threadgroup rather than one per cell. A threadgroup in which any cell
+/// changed counts as an active tile. Every thread of the threadgroup calls
+/// this, including those past the edge of the grid, with inGrid false.
+static void end_step_counters(threadgroup atomic_uint *groupCounters, device atomic_uint *counters,
+                              bool inGrid, bool wasAlive, bool isAlive, ushort threadIndex)
+{
+    if (inGrid)
+    {
+        if (isAlive)
+        {
+            atomic_fetch_add_explicit(&groupCounters[AAPL_LIFE_COUNTER_POPULATION], 1, memory_order_relaxed);
+        }
+        
+        if (isAlive != wasAlive)
+        {
+            uint counter = isAlive ? AAPL_LIFE_COUNTER_BIRTHS : AAPL_LIFE_COUNTER_DEATHS;
+            atomic_fetch_add_explicit(&groupCounters[counter], 1, memory_order_relaxed);
+        }
+    }
+    
+    threadgroup_barrier(mem_flags::mem_threadgroup);
+    
+    if (threadIndex == 0)
+    {
+        uint population = atomic_load_explicit(&groupCounters[AAPL_LIFE_COUNTER_POPULATION], memory_order_relaxed);
+        uint births = atomic_load_explicit(&groupCounters[AAPL_LIFE_COUNTER_BIRTHS], memory_order_relaxed);
+        uint deaths = atomic_load_explicit(&groupCounters[AAPL_LIFE_COUNTER_DEATHS], memory_order_relaxed);
+        
+        atomic_fetch_add_explicit(&counters[AAPL_LIFE_COUNTER_POPULATION], population, memory_order_relaxed);
+        
+        if (births + deaths > 0)
+        {
+            atomic_fetch_add_explicit(&counters[AAPL_LIFE_COUNTER_BIRTHS], births, memory_order_relaxed);
+            atomic_fetch_add_explicit(&counters[AAPL_LIFE_COUNTER_DEATHS], deaths, memory_order_relaxed);
+            atomic_fetch_add_explicit(&counters[AAPL_LIFE_COUNTER_ACTIVE_TILES], 1, memory_order_relaxed);
+        }
+    }
+}
+
 /// This kernel function runs one step of a Game of Life simulation, reading
 /// the previous game state from one texture, and writing the updated state
-/// into another texture
+/// into another texture. The population, births and deaths are counted into
+/// the buffer of AAPL_LIFE_COUNTER_COUNT counters as the cells are stepped.
 kernel void game_of_life(texture2d<uint, access::sample> readTexture [[texture(0)]],
                          texture2d<uint, access::write> writeTexture [[texture(1)]],
                          sampler wrapSampler [[sampler(0)]],
-                         ushort2 gridPosition [[thread_position_in_grid]])
+                         device atomic_uint *counters [[buffer(1)]],
+                         ushort2 gridPosition [[thread_position_in_grid]],
+                         ushort threadIndex [[thread_index_in_threadgroup]])
 {
+    threadgroup atomic_uint groupCounters[AAPL_LIFE_COUNTER_COUNT];
+    begin_step_counters(groupCounters, threadIndex);
+    
     ushort width = readTexture.get_width();
     ushort height = readTexture.get_height();
     float2 bounds(width, height);
     float2 position = float2(gridPosition);
+    bool inGrid = gridPosition.x < width && gridPosition.y < height;
+    bool wasAlive = false;
+    bool isAlive = false;
     
     // Don't perform the update or the write if we would be going out of bounds of the grid
-    if (gridPosition.x < width && gridPosition.y < height)
+    if (inGrid)
     {
         // Count up the number of neighbors of this cell that are alive
         ushort neighbors = 0;
@@ -126,5 +220,123 @@ kernel void game_of_life(texture2d<uint, access::sample> readTexture [[texture(0
         
         // Finally, write the new "aliveness" of this cell into the next game state texture
         writeTexture.write(cellValue, uint2(position));
+        
+        wasAlive = deadFrames == kCellValueAlive;
+        isAlive = alive;
     }
+    
+    end_step_counters(groupCounters, counters, inGrid, wasAlive, isAlive, threadIndex);
 }
+
+static bool rule_mask_test(constant AAPLLifeRuleWord *mask, uint count)
+{
+    return (mask[count / 32] >> (count % 32)) & 1;
+}
+
+/// Runs one step of any rule in AAPLLifeRule.h. The neighborhood's shape and
+/// radius are template parameters, so each kernel below has its loops unrolled
+/// for one neighborhood, while the birth and survival masks and the number of
+/// states come from the rule buffer. Changing rules only changes the buffer,
+/// unless the new rule has a different neighborhood.
+template <int Radius, bool VonNeumann>
+static void step_rule_cell(texture2d<uint, access::read> readTexture,
+                           texture2d<uint, access::write> writeTexture,
+                           constant AAPLLifeRule &rule,
+                           ushort2 gridPosition,
+                           thread bool &wasAlive,
+                           thread bool &isAlive)
+{
+    int width = readTexture.get_width();
+    int height = readTexture.get_height();
+    
+    // Count the live cells in the neighborhood, wrapping around edges; the
+    // modulo is taken twice because a large radius can reach past a small grid
+    int2 position = int2(gridPosition);
+    uint neighbors = 0;
+    for (int dy = -Radius; dy <= Radius; ++dy)
+    {
+        int reach = VonNeumann ? Radius - abs(dy) : Radius;
+        uint y = ((position.y + dy) % height + height) % height;
+        for (int dx = -reach; dx <= reach; ++dx)
+        {
+            uint x = ((position.x + dx) % width + width) % width;
+            neighbors += (readTexture.read(uint2(x, y)).r == kCellValueAlive) ? 1 : 0;
+        }
+    }
+    
+    uint deadFrames = readTexture.read(uint2(position)).r;
+    
+    // A live cell survives by the survival mask, not counting itself unless the
+    // rule says so. Only cells that have been dead for states - 1 generations
+    // or more can be born; younger ones are dying cells of a Generations rule.
+    bool alive;
+    if (deadFrames == kCellValueAlive)
+    {
+        alive = rule_mask_test(rule.survival, rule.includesCenter ? neighbors : neighbors - 1);
+    }
+    else
+    {
+        alive = deadFrames + 1 >= rule.states && rule_mask_test(rule.birth, neighbors);
+    }
+    
+    uint cellValue = alive ? kCellValueAlive : min(deadFrames + 1, uint(kCellValueDead));
+    writeTexture.write(cellValue, uint2(position));
+    
+    wasAlive = deadFrames == kCellValueAlive;
+    isAlive = alive;
+}
+
+/// Steps one cell, if it is on the grid, and counts the step as game_of_life does
+template <int Radius, bool VonNeumann>
+static void step_rule(texture2d<uint, access::read> readTexture,
+                      texture2d<uint, access::write> writeTexture,
+                      constant AAPLLifeRule &rule,
+                      device atomic_uint *counters,
+                      threadgroup atomic_uint *groupCounters,
+                      ushort2 gridPosition,
+                      ushort threadIndex)
+{
+    begin_step_counters(groupCounters, threadIndex);
+    
+    bool inGrid = gridPosition.x < readTexture.get_width() && gridPosition.y < readTexture.get_height();
+    bool wasAlive = false;
+    bool isAlive = false;
+    
+    if (inGrid)
+    {
+        step_rule_cell<Radius, VonNeumann>(readTexture, writeTexture, rule, gridPosition, wasAlive, isAlive);
+    }
+    
+    end_step_counters(groupCounters, counters, inGrid, wasAlive, isAlive, threadIndex);
+}
+
+/// One kernel for each neighborhood AAPLLifeRuleKernelName can name, taking the
+/// rule in buffer 0 and the step counters in buffer 1
+#define RULE_KERNEL(name, radius, vonNeumann) \
+kernel void name(texture2d<uint, access::read> readTexture [[texture(0)]], \
+                 texture2d<uint, access::write> writeTexture [[texture(1)]], \
+                 constant AAPLLifeRule &rule [[buffer(0)]], \
+                 device atomic_uint *counters [[buffer(1)]], \
+                 ushort2 gridPosition [[thread_position_in_grid]], \
+                 ushort threadIndex [[thread_index_in_threadgroup]]) \
+{ \
+    threadgroup atomic_uint groupCounters[AAPL_LIFE_COUNTER_COUNT]; \
+    step_rule<radius, vonNeumann>(readTexture, writeTexture, rule, counters, groupCounters, \
+                                  gridPosition, threadIndex); \
+}
+
+RULE_KERNEL(cellular_automaton_moore_1, 1, false)
+RULE_KERNEL(cellular_automaton_moore_2, 2, false)
+RULE_KERNEL(cellular_automaton_moore_3, 3, false)
+RULE_KERNEL(cellular_automaton_moore_4, 4, false)
+RULE_KERNEL(cellular_automaton_moore_5, 5, false)
+RULE_KERNEL(cellular_automaton_moore_6, 6, false)
+RULE_KERNEL(cellular_automaton_moore_7, 7, false)
+
+RULE_KERNEL(cellular_automaton_von_neumann_1, 1, true)
+RULE_KERNEL(cellular_automaton_von_neumann_2, 2, true)
+RULE_KERNEL(cellular_automaton_von_neumann_3, 3, true)
+RULE_KERNEL(cellular_automaton_von_neumann_4, 4, true)
+RULE_KERNEL(cellular_automaton_von_neumann_5, 5, true)
+RULE_KERNEL(cellular_automaton_von_neumann_6, 6, true)
+RULE_KERNEL(cellular_automaton_von_neumann_7, 7, true)
@@ -0,0 +1,676 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A HashLife simulation of an unbounded Game of Life universe. The universe is a
+    quadtree whose identical subtrees are shared and whose futures are memoized,
+    so sparse or repetitive patterns can be advanced 2^k generations at a time.
+    Any region can be rasterized into the renderer's game state layout.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <unordered_map>
+
+#include "AAPLHashLife.h"
+#include "AAPLLifeGrid.h"
+
+#pragma mark -
+#pragma mark Private - Nodes
+
+// A square of 2^level cells on a side. Level 0 nodes are single cells; every
+// other node is made of four children one level down and is unique, so equal
+// subtrees are the same node and can share a memoized successor.
+struct AAPL::HashLife::Node
+{
+    Node *nw;
+    Node *ne;
+    Node *sw;
+    Node *se;
+    
+    // The center half of this node, 2^nextExponent generations on
+    Node *next;
+    uint32_t nextExponent;
+    uint32_t level;
+    
+    uint64_t population;
+    Node *hashNext;
+};
+
+static const uint32_t kAAPLNoSuccessor = ~0u;
+
+// Coordinates are 64 bit, which bounds the universe
+static const uint32_t kAAPLHashLifeMaxLevel = 60;
+
+struct AAPL::HashLife::NodeStore
+{
+    static const size_t kBlockSize = 4096;
+    
+    std::vector<std::unique_ptr<Node[]>> blocks;
+    size_t blockUsed = kBlockSize;
+    std::vector<Node *> buckets;
+    size_t count = 0;
+    
+    Node deadCell;
+    Node aliveCell;
+    
+    NodeStore() : buckets(1 << 16, nullptr)
+    {
+        memset(&deadCell, 0, sizeof(Node));
+        memset(&aliveCell, 0, sizeof(Node));
+        aliveCell.population = 1;
+    }
+    
+    static size_t hash(const Node *nw, const Node *ne, const Node *sw, const Node *se)
+    {
+        uint64_t h = (uint64_t)(uintptr_t)nw * 0x9E3779B97F4A7C15ull;
+        h = (h ^ (uint64_t)(uintptr_t)ne) * 0xC2B2AE3D27D4EB4Full;
+        h = (h ^ (uint64_t)(uintptr_t)sw) * 0x165667B19E3779F9ull;
+        h = (h ^ (uint64_t)(uintptr_t)se) * 0x9E3779B97F4A7C15ull;
+        
+        return (size_t)(h ^ (h >> 29));
+    }
+    
+    void grow()
+    {
+        std::vector<Node *> larger(buckets.size() * 2, nullptr);
+        size_t mask = larger.size() - 1;
+        
+        for (Node *node : buckets)
+        {
+            while (node)
+            {
+                Node *following = node->hashNext;
+                size_t index = hash(node->nw, node->ne, node->sw, node->se) & mask;
+                
+                node->hashNext = larger[index];
+                larger[index] = node;
+                node = following;
+            }
+        }
+        
+        buckets.swap(larger);
+    }
+    
+    Node *find(Node *nw, Node *ne, Node *sw, Node *se)
+    {
+        size_t index = hash(nw, ne, sw, se) & (buckets.size() - 1);
+        
+        for (Node *node = buckets[index]; node; node = node->hashNext)
+        {
+            if (node->nw == nw && node->ne == ne && node->sw == sw && node->se == se)
+            {
+                return node;
+            }
+        }
+        
+        if (count >= buckets.size())
+        {
+            grow();
+            index = hash(nw, ne, sw, se) & (buckets.size() - 1);
+        }
+        
+        if (blockUsed == kBlockSize)
+        {
+            blocks.emplace_back(new Node[kBlockSize]);
+            blockUsed = 0;
+        }
+        
+        Node *node = &blocks.back()[blockUsed++];
+        
+        node->nw = nw;
+        node->ne = ne;
+        node->sw = sw;
+        node->se = se;
+        node->next = nullptr;
+        node->nextExponent = kAAPLNoSuccessor;
+        node->level = nw->level + 1;
+        node->population = nw->population + ne->population + sw->population + se->population;
+        node->hashNext = buckets[index];
+        buckets[index] = node;
+        ++count;
+        
+        return node;
+    }
+};
+
+// Next generation of the center 2x2 of a 4x4 block, indexed by the block's
+// cells with bit y * 4 + x set for each live cell
+static const uint8_t *AAPLHashLifeBlockTable()
+{
+    static const std::vector<uint8_t> table = []()
+    {
+        std::vector<uint8_t> results(1 << 16);
+        
+        for (uint32_t block = 0; block < (1u << 16); ++block)
+        {
+            uint8_t result = 0;
+            
+            for (uint32_t y = 1; y <= 2; ++y)
+            {
+                for (uint32_t x = 1; x <= 2; ++x)
+                {
+                    uint32_t neighbors = 0;
+                    
+                    for (int dy = -1; dy <= 1; ++dy)
+                    {
+                        for (int dx = -1; dx <= 1; ++dx)
+                        {
+                            if (dx || dy)
+                            {
+                                neighbors += (block >> ((y + dy) * 4 + x + dx)) & 1;
+                            }
+                        }
+                    }
+                    
+                    bool alive = (block >> (y * 4 + x)) & 1;
+                    
+                    if (neighbors == 3 || (alive && neighbors == 2))
+                    {
+                        result |= 1 << ((y - 1) * 2 + (x - 1));
+                    }
+                }
+            }
+            
+            results[block] = result;
+        }
+        
+        return results;
+    }();
+    
+    return table.data();
+} // AAPLHashLifeBlockTable
+
+#pragma mark -
+#pragma mark Public - Construction
+
+AAPL::HashLife::HashLife(size_t maxNodes)
+: _maxNodes(maxNodes)
+{
+    clear();
+} // HashLife
+
+AAPL::HashLife::~HashLife()
+{
+} // ~HashLife
+
+void AAPL::HashLife::clear()
+{
+    _store.reset(new NodeStore);
+    _emptyNodes.clear();
+    _root = emptyNode(3);
+    _nodeCount = _store->count;
+    _generation = 0;
+} // clear
+
+#pragma mark -
+#pragma mark Private - Quadtree
+
+AAPL::HashLife::Node *AAPL::HashLife::join(Node *nw, Node *ne, Node *sw, Node *se)
+{
+    Node *node = _store->find(nw, ne, sw, se);
+    
+    _nodeCount = _store->count;
+    
+    return node;
+} // join
+
+AAPL::HashLife::Node *AAPL::HashLife::emptyNode(uint32_t level)
+{
+    if (_emptyNodes.empty())
+    {
+        _emptyNodes.push_back(&_store->deadCell);
+    }
+    
+    while (_emptyNodes.size() <= level)
+    {
+        Node *child = _emptyNodes.back();
+        _emptyNodes.push_back(join(child, child, child, child));
+    }
+    
+    return _emptyNodes[level];
+} // emptyNode
+
+// Doubles the size of a node, keeping it centered
+AAPL::HashLife::Node *AAPL::HashLife::expand(Node *node)
+{
+    Node *empty = emptyNode(node->level - 1);
+    
+    return join(join(empty, empty, empty, node->nw),
+                join(empty, empty, node->ne, empty),
+                join(empty, node->sw, empty, empty),
+                join(node->se, empty, empty, empty));
+} // expand
+
+// The center half of a node
+AAPL::HashLife::Node *AAPL::HashLife::centeredSubnode(Node *node)
+{
+    return join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+} // centeredSubnode
+
+// The node straddling the boundary between two horizontally adjacent nodes
+AAPL::HashLife::Node *AAPL::HashLife::centeredHorizontal(Node *w, Node *e)
+{
+    return join(w->ne, e->nw, w->se, e->sw);
+} // centeredHorizontal
+
+// The node straddling the boundary between two vertically adjacent nodes
+AAPL::HashLife::Node *AAPL::HashLife::centeredVertical(Node *n, Node *s)
+{
+    return join(n->sw, n->se, s->nw, s->ne);
+} // centeredVertical
+
+AAPL::HashLife::Node *AAPL::HashLife::levelTwoSuccessor(Node *node)
+{
+    Node *quadrants[4] = { node->nw, node->ne, node->sw, node->se };
+    uint32_t block = 0;
+    
+    for (uint32_t q = 0; q < 4; ++q)
+    {
+        uint32_t shift = (q >> 1) * 8 + (q & 1) * 2;
+        
+        block |= (uint32_t)quadrants[q]->nw->population << shift;
+        block |= (uint32_t)quadrants[q]->ne->population << (shift + 1);
+        block |= (uint32_t)quadrants[q]->sw->population << (shift + 4);
+        block |= (uint32_t)quadrants[q]->se->population << (shift + 5);
+    }
+    
+    uint8_t result = AAPLHashLifeBlockTable()[block];
+    Node *cells[2] = { &_store->deadCell, &_store->aliveCell };
+    
+    return join(cells[result & 1], cells[(result >> 1) & 1],
+                cells[(result >> 2) & 1], cells[(result >> 3) & 1]);
+} // levelTwoSuccessor
+
+// The center half of node, 2^exponent generations on; exponent is at most level - 2
+AAPL::HashLife::Node *AAPL::HashLife::successor(Node *node, uint32_t exponent)
+{
+    if (node->next && node->nextExponent == exponent)
+    {
+        return node->next;
+    }
+    
+    Node *result;
+    
+    if (node->population == 0)
+    {
+        result = emptyNode(node->level - 1);
+    }
+    else if (node->level == 2)
+    {
+        result = levelTwoSuccessor(node);
+    }
+    else
+    {
+        // Nine overlapping subnodes, each a quarter of the node
+        Node *n00 = node->nw;
+        Node *n01 = centeredHorizontal(node->nw, node->ne);
+        Node *n02 = node->ne;
+        Node *n10 = centeredVertical(node->nw, node->sw);
+        Node *n11 = centeredSubnode(node);
+        Node *n12 = centeredVertical(node->ne, node->se);
+        Node *n20 = node->sw;
+        Node *n21 = centeredHorizontal(node->sw, node->se);
+        Node *n22 = node->se;
+        
+        uint32_t halfExponent = exponent;
+        
+        if (exponent == node->level - 2)
+        {
+            // Full speed: half the generations here and half below
+            halfExponent = exponent - 1;
+            n00 = successor(n00, halfExponent);
+            n01 = successor(n01, halfExponent);
+            n02 = successor(n02, halfExponent);
+            n10 = successor(n10, halfExponent);
+            n11 = successor(n11, halfExponent);
+            n12 = successor(n12, halfExponent);
+            n20 = successor(n20, halfExponent);
+            n21 = successor(n21, halfExponent);
+            n22 = successor(n22, halfExponent);
+        }
+        else
+        {
+            // Fewer generations than the node allows: all of them below
+            n00 = centeredSubnode(n00);
+            n01 = centeredSubnode(n01);
+            n02 = centeredSubnode(n02);
+            n10 = centeredSubnode(n10);
+            n11 = centeredSubnode(n11);
+            n12 = centeredSubnode(n12);
+            n20 = centeredSubnode(n20);
+            n21 = centeredSubnode(n21);
+            n22 = centeredSubnode(n22);
+        }
+        
+        result = join(successor(join(n00, n01, n10, n11), halfExponent),
+                      successor(join(n01, n02, n11, n12), halfExponent),
+                      successor(join(n10, n11, n20, n21), halfExponent),
+                      successor(join(n11, n12, n21, n22), halfExponent));
+    }
+    
+    node->next = result;
+    node->nextExponent = exponent;
+    
+    return result;
+} // successor
+
+// Copies the reachable nodes into a new store, dropping memoized successors
+void AAPL::HashLife::collectGarbage()
+{
+    std::unique_ptr<NodeStore> oldStore(std::move(_store));
+    std::unordered_map<const Node *, Node *> copies;
+    
+    _store.reset(new NodeStore);
+    _emptyNodes.clear();
+    
+    copies[&oldStore->deadCell] = &_store->deadCell;
+    copies[&oldStore->aliveCell] = &_store->aliveCell;
+    
+    // Children are copied before their parents, without recursion
+    std::vector<std::pair<Node *, bool>> stack(1, std::make_pair(_root, false));
+    
+    while (!stack.empty())
+    {
+        Node *node = stack.back().first;
+        bool childrenCopied = stack.back().second;
+        
+        if (copies.count(node))
+        {
+            stack.pop_back();
+            continue;
+        }
+        
+        if (!childrenCopied)
+        {
+            stack.back().second = true;
+            
+            for (Node *child : { node->nw, node->ne, node->sw, node->se })
+            {
+                if (!copies.count(child))
+                {
+                    stack.push_back(std::make_pair(child, false));
+                }
+            }
+            
+            continue;
+        }
+        
+        copies[node] = _store->find(copies[node->nw], copies[node->ne], copies[node->sw], copies[node->se]);
+        stack.pop_back();
+    }
+    
+    _root = copies[_root];
+    _nodeCount = _store->count;
+} // collectGarbage
+
+#pragma mark -
+#pragma mark Public - Cells
+
+bool AAPL::HashLife::contains(int64_t x, int64_t y) const
+{
+    int64_t half = (int64_t)1 << (_root->level - 1);
+    
+    return x >= -half && x < half && y >= -half && y < half;
+} // contains
+
+bool AAPL::HashLife::cell(int64_t x, int64_t y) const
+{
+    if (!contains(x, y))
+    {
+        return false;
+    }
+    
+    const Node *node = _root;
+    int64_t half = (int64_t)1 << (node->level - 1);
+    
+    // Relative to the node's top left corner
+    x += half;
+    y += half;
+    
+    while (node->level > 0 && node->population > 0)
+    {
+        half = (int64_t)1 << (node->level - 1);
+        
+        bool east = x >= half;
+        bool south = y >= half;
+        
+        node = south ? (east ? node->se : node->sw) : (east ? node->ne : node->nw);
+        x -= east ? half : 0;
+        y -= south ? half : 0;
+    }
+    
+    return node->population > 0;
+} // cell
+
+AAPL::HashLife::Node *AAPL::HashLife::setCell(Node *node, int64_t x, int64_t y, bool alive)
+{
+    if (node->level == 0)
+    {
+        return alive ? &_store->aliveCell : &_store->deadCell;
+    }
+    
+    int64_t half = (int64_t)1 << (node->level - 1);
+    
+    if (y < half)
+    {
+        if (x < half)
+        {
+            return join(setCell(node->nw, x, y, alive), node->ne, node->sw, node->se);
+        }
+        
+        return join(node->nw, setCell(node->ne, x - half, y, alive), node->sw, node->se);
+    }
+    
+    if (x < half)
+    {
+        return join(node->nw, node->ne, setCell(node->sw, x, y - half, alive), node->se);
+    }
+    
+    return join(node->nw, node->ne, node->sw, setCell(node->se, x - half, y - half, alive));
+} // setCell
+
+void AAPL::HashLife::setCell(int64_t x, int64_t y, bool alive)
+{
+    while (!contains(x, y))
+    {
+        if (!alive || _root->level >= kAAPLHashLifeMaxLevel)
+        {
+            return;
+        }
+        
+        _root = expand(_root);
+    }
+    
+    int64_t half = (int64_t)1 << (_root->level - 1);
+    
+    _root = setCell(_root, x + half, y + half, alive);
+} // setCell
+
+void AAPL::HashLife::loadCells(const uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow,
+                               int64_t x, int64_t y)
+{
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        const uint8_t *values = cells + row * bytesPerRow;
+        
+        for (uint32_t column = 0; column < width; ++column)
+        {
+            bool alive = values[column] == kLifeCellAlive;
+            
+            // Skip the lookup and path copy for cells that do not change
+            if (alive || cell(x + column, y + row))
+            {
+                setCell(x + column, y + row, alive);
+            }
+        }
+        
+        if (_nodeCount > _maxNodes)
+        {
+            collectGarbage();
+        }
+    }
+} // loadCells
+
+uint64_t AAPL::HashLife::population() const
+{
+    return _root->population;
+} // population
+
+#pragma mark -
+#pragma mark Public - Simulation
+
+void AAPL::HashLife::stepPow2(uint32_t exponent)
+{
+    if (_nodeCount > _maxNodes)
+    {
+        collectGarbage();
+    }
+    
+    // Pad until the pattern lies in the center quarter of the root, with
+    // room to grow at the speed of light for 2^exponent generations, so that
+    // the successor (the center half) holds the whole result
+    while (_root->level < exponent + 3 ||
+           centeredSubnode(centeredSubnode(_root))->population != _root->population)
+    {
+        if (_root->level >= kAAPLHashLifeMaxLevel)
+        {
+            return;
+        }
+        
+        _root = expand(_root);
+    }
+    
+    _root = successor(_root, exponent);
+    _generation += (uint64_t)1 << exponent;
+} // stepPow2
+
+void AAPL::HashLife::step(uint64_t generations)
+{
+    for (uint32_t exponent = 0; generations != 0; ++exponent, generations >>= 1)
+    {
+        if (generations & 1)
+        {
+            stepPow2(exponent);
+        }
+    }
+} // step
+
+#pragma mark -
+#pragma mark Public - Rasterization
+
+bool AAPL::HashLife::bounds(int64_t& minX, int64_t& minY, int64_t& maxX, int64_t& maxY) const
+{
+    if (_root->population == 0)
+    {
+        return false;
+    }
+    
+    int64_t half = (int64_t)1 << (_root->level - 1);
+    std::vector<std::pair<const Node *, std::pair<int64_t, int64_t>>> stack;
+    
+    minX = minY = INT64_MAX;
+    maxX = maxY = INT64_MIN;
+    stack.push_back(std::make_pair(_root, std::make_pair(-half, -half)));
+    
+    while (!stack.empty())
+    {
+        const Node *node = stack.back().first;
+        int64_t x = stack.back().second.first;
+        int64_t y = stack.back().second.second;
+        int64_t size = (int64_t)1 << node->level;
+        
+        stack.pop_back();
+        
+        // Nodes wholly inside the bounds found so far cannot extend them
+        if (node->population == 0 || (x >= minX && x + size - 1 <= maxX && y >= minY && y + size - 1 <= maxY))
+        {
+            continue;
+        }
+        
+        if (node->level <= 3)
+        {
+            minX = std::min(minX, x);
+            minY = std::min(minY, y);
+            maxX = std::max(maxX, x + size - 1);
+            maxY = std::max(maxY, y + size - 1);
+            continue;
+        }
+        
+        int64_t childSize = size / 2;
+        
+        stack.push_back(std::make_pair(node->nw, std::make_pair(x, y)));
+        stack.push_back(std::make_pair(node->ne, std::make_pair(x + childSize, y)));
+        stack.push_back(std::make_pair(node->sw, std::make_pair(x, y + childSize)));
+        stack.push_back(std::make_pair(node->se, std::make_pair(x + childSize, y + childSize)));
+    }
+    
+    return true;
+} // bounds
+
+void AAPL::HashLife::markLiveCells(const Node *node, int64_t nodeX, int64_t nodeY, int64_t x, int64_t y,
+                                   uint32_t width, uint32_t height, uint32_t shift,
+                                   uint8_t *cells, size_t bytesPerRow) const
+{
+    int64_t size = (int64_t)1 << node->level;
+    int64_t right = x + ((int64_t)width << shift);
+    int64_t bottom = y + ((int64_t)height << shift);
+    
+    if (node->population == 0 || nodeX >= right || nodeY >= bottom || nodeX + size <= x || nodeY + size <= y)
+    {
+        return;
+    }
+    
+    // Pixels covered by the node's first and last cells; arithmetic shifts
+    // round toward negative infinity
+    int64_t left = (std::max(nodeX, x) - x) >> shift;
+    int64_t top = (std::max(nodeY, y) - y) >> shift;
+    int64_t last = (std::min(nodeX + size, right) - 1 - x) >> shift;
+    int64_t lastRow = (std::min(nodeY + size, bottom) - 1 - y) >> shift;
+    
+    if (left == last && top == lastRow)
+    {
+        cells[top * bytesPerRow + left] = kLifeCellAlive;
+        return;
+    }
+    
+    int64_t half = size / 2;
+    
+    markLiveCells(node->nw, nodeX, nodeY, x, y, width, height, shift, cells, bytesPerRow);
+    markLiveCells(node->ne, nodeX + half, nodeY, x, y, width, height, shift, cells, bytesPerRow);
+    markLiveCells(node->sw, nodeX, nodeY + half, x, y, width, height, shift, cells, bytesPerRow);
+    markLiveCells(node->se, nodeX + half, nodeY + half, x, y, width, height, shift, cells, bytesPerRow);
+} // markLiveCells
+
+void AAPL::HashLife::rasterize(int64_t x, int64_t y, uint32_t width, uint32_t height, uint32_t shift,
+                               uint8_t *cells, size_t bytesPerRow) const
+{
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        memset(cells + row * bytesPerRow, kLifeCellDead, width);
+    }
+    
+    int64_t half = (int64_t)1 << (_root->level - 1);
+    
+    markLiveCells(_root, -half, -half, x, y, width, height, shift, cells, bytesPerRow);
+} // rasterize
+
+void AAPL::HashLife::rasterizeDeadAges(int64_t x, int64_t y, uint32_t width, uint32_t height, uint32_t shift,
+                                       uint8_t *cells, size_t bytesPerRow, uint64_t elapsedGenerations) const
+{
+    uint32_t elapsed = (uint32_t)std::min(elapsedGenerations, (uint64_t)kLifeCellDead);
+    
+    for (uint32_t row = 0; row < height; ++row)
+    {
+        uint8_t *values = cells + row * bytesPerRow;
+        
+        for (uint32_t column = 0; column < width; ++column)
+        {
+            values[column] = (uint8_t)std::min((uint32_t)values[column] + elapsed, (uint32_t)kLifeCellDead);
+        }
+    }
+    
+    int64_t half = (int64_t)1 << (_root->level - 1);
+    
+    markLiveCells(_root, -half, -half, x, y, width, height, shift, cells, bytesPerRow);
+} // rasterizeDeadAges
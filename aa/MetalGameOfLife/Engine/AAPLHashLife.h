@@ -0,0 +1,105 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A HashLife simulation of an unbounded Game of Life universe. The universe is a
+    quadtree whose identical subtrees are shared and whose futures are memoized,
+    so sparse or repetitive patterns can be advanced 2^k generations at a time.
+    Any region can be rasterized into the renderer's game state layout.
+*/
+
+#ifndef _AAPL_HASH_LIFE_H_
+#define _AAPL_HASH_LIFE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace AAPL
+{
+    class HashLife
+    {
+    public:
+        // maxNodes is a soft limit on the node store (64 bytes per node): it is
+        // checked before each step and after each row loaded, when unreachable
+        // nodes and memoized results are discarded if it is exceeded. A single
+        // step can build many more nodes than maxNodes before it is checked.
+        explicit HashLife(size_t maxNodes = 1 << 22);
+        ~HashLife();
+        
+        HashLife(const HashLife&) = delete;
+        HashLife& operator=(const HashLife&) = delete;
+        
+        // Removes every live cell and resets the generation count
+        void clear();
+        
+        // Cells are addressed by signed coordinates with y increasing downward,
+        // as in the game state texture. Unlike LifeGrid the universe has no edges.
+        bool cell(int64_t x, int64_t y) const;
+        void setCell(int64_t x, int64_t y, bool alive);
+        
+        // Sets the cells of a width x height region from the renderer's texture
+        // layout, where 0 is alive and anything else is dead
+        void loadCells(const uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow,
+                       int64_t x, int64_t y);
+        
+        // Advances the universe 2^exponent generations in one step
+        void stepPow2(uint32_t exponent);
+        
+        // Advances the universe by any number of generations, as a series of
+        // power of two steps
+        void step(uint64_t generations);
+        
+        uint64_t generation() const { return _generation; }
+        uint64_t population() const;
+        size_t nodeCount() const { return _nodeCount; }
+        
+        // Bounding box of the live cells, which may be loose by up to a quadtree
+        // node of 8x8 cells; returns false if the universe is empty
+        bool bounds(int64_t& minX, int64_t& minY, int64_t& maxX, int64_t& maxY) const;
+        
+        // Writes the width x height pixel region whose top left pixel covers cell
+        // (x, y) into the renderer's texture layout. Each pixel covers a square
+        // of 2^shift cells on a side and is alive if any of them is. Dead pixels
+        // are written as kLifeCellDead.
+        void rasterize(int64_t x, int64_t y, uint32_t width, uint32_t height, uint32_t shift,
+                       uint8_t *cells, size_t bytesPerRow) const;
+        
+        // As rasterize, but treats cells as the previous rasterization of the
+        // same region and ages its dead pixels by elapsedGenerations, saturating
+        // at kLifeCellDead. Exact when stepping one generation at a time.
+        void rasterizeDeadAges(int64_t x, int64_t y, uint32_t width, uint32_t height, uint32_t shift,
+                               uint8_t *cells, size_t bytesPerRow, uint64_t elapsedGenerations) const;
+        
+        struct Node;
+        
+    private:
+        struct NodeStore;
+        
+        Node *join(Node *nw, Node *ne, Node *sw, Node *se);
+        Node *emptyNode(uint32_t level);
+        Node *expand(Node *node);
+        Node *centeredSubnode(Node *node);
+        Node *centeredHorizontal(Node *w, Node *e);
+        Node *centeredVertical(Node *n, Node *s);
+        Node *successor(Node *node, uint32_t exponent);
+        Node *levelTwoSuccessor(Node *node);
+        Node *setCell(Node *node, int64_t x, int64_t y, bool alive);
+        bool contains(int64_t x, int64_t y) const;
+        void collectGarbage();
+        
+        void markLiveCells(const Node *node, int64_t nodeX, int64_t nodeY, int64_t x, int64_t y,
+                           uint32_t width, uint32_t height, uint32_t shift,
+                           uint8_t *cells, size_t bytesPerRow) const;
+        
+        std::unique_ptr<NodeStore> _store;
+        std::vector<Node *> _emptyNodes;
+        Node *_root;
+        size_t _nodeCount;
+        size_t _maxNodes;
+        uint64_t _generation;
+    };
+} // AAPL
+
+#endif
@@ -0,0 +1,474 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Headless parameter sweeps over many independent boards. Each board is seeded
+    from its own seed, size and rule, run for a number of generations and
+    summarized by its population, the generation it died out, if it did, and
+    the period it settled into. Narrow boards under Life-like rules are packed
+    side by side into the lanes of shared words, small boards run one to a
+    worker and large boards are spread across all of the workers in turn.
+*/
+
+#include <algorithm>
+#include <map>
+#include <unordered_map>
+#include <utility>
+
+#include "AAPLLifeBatch.h"
+#include "AAPLLifeGrid.h"
+#include "AAPLLifeRuleGrid.h"
+#include "AAPLLifeSeed.h"
+#include "AAPLLifeWorkers.h"
+
+static inline uint64_t AAPLLifeBatchMix(uint64_t hash, uint64_t word)
+{
+    hash = (hash ^ word) * 0x9E3779B97F4A7C15ull;
+    
+    return hash ^ (hash >> 29);
+} // AAPLLifeBatchMix
+
+static bool AAPLLifeBatchIsPackable(const AAPL::LifeBatchBoard& board)
+{
+    const AAPLLifeRule& rule = board.rule;
+    
+    return board.width <= AAPL::kLifeBatchMaxPackedWidth && rule.radius == 1 &&
+           rule.neighborhood == AAPL_LIFE_RULE_MOORE && rule.states == 2;
+} // AAPLLifeBatchIsPackable
+
+#pragma mark -
+#pragma mark Private - History
+
+// The hash and population of a board at every generation stepped so far. A
+// repeated state is found with Brent's algorithm, which compares each state
+// with a single checkpoint that moves at powers of two, so finding a cycle of
+// period p that starts at generation s takes under s + 2p generations.
+class AAPLLifeBatchHistory
+{
+public:
+    AAPLLifeBatchHistory()
+    : _period(0),
+      _checkpoint(0),
+      _checkpointDistance(1),
+      _sinceCheckpoint(0)
+    {
+    }
+    
+    bool finished() const { return _period != 0; }
+    
+    // Returns whether the board is now known to cycle
+    bool record(uint64_t hash, uint64_t population)
+    {
+        _hashes.push_back(hash);
+        _populations.push_back(population);
+        
+        if (_hashes.size() == 1)
+        {
+            _checkpoint = hash;
+            return false;
+        }
+        
+        ++_sinceCheckpoint;
+        
+        if (hash == _checkpoint)
+        {
+            _period = (uint32_t)_sinceCheckpoint;
+            return true;
+        }
+        
+        if (_sinceCheckpoint == _checkpointDistance)
+        {
+            _checkpoint = hash;
+            _checkpointDistance *= 2;
+            _sinceCheckpoint = 0;
+        }
+        
+        return false;
+    }
+    
+    AAPL::LifeBatchSummary summarize(uint32_t generations) const;
+
+private:
+    std::vector<uint64_t> _hashes;
+    std::vector<uint64_t> _populations;
+    uint32_t _period;
+    uint64_t _checkpoint;
+    uint64_t _checkpointDistance;
+    uint64_t _sinceCheckpoint;
+};
+
+AAPL::LifeBatchSummary AAPLLifeBatchHistory::summarize(uint32_t generations) const
+{
+    AAPL::LifeBatchSummary summary;
+    uint64_t recorded = _populations.size();
+    uint64_t cycleStart = 0;
+    uint32_t period = _period;
+    
+    if (period)
+    {
+        // Brent's algorithm finds the period but not where the cycle begins
+        while (_hashes[cycleStart] != _hashes[cycleStart + period])
+        {
+            ++cycleStart;
+        }
+    }
+    else
+    {
+        // A cycle that began too late in the run for the checkpoint to catch
+        // is still in the history
+        std::unordered_map<uint64_t, uint64_t> firstSeen;
+        
+        for (uint64_t generation = 0; generation < recorded; ++generation)
+        {
+            auto seen = firstSeen.insert(std::make_pair(_hashes[generation], generation));
+            
+            if (!seen.second)
+            {
+                cycleStart = seen.first->second;
+                period = (uint32_t)(generation - cycleStart);
+                break;
+            }
+        }
+    }
+    
+    // Every state of a cycle is in the history, so it holds the peak too
+    uint64_t last = generations;
+    
+    if (last >= recorded)
+    {
+        last = cycleStart + (last - cycleStart) % period;
+    }
+    
+    summary.population = _populations[last];
+    summary.peakPopulation = 0;
+    summary.peakGeneration = 0;
+    summary.extinctionGeneration = -1;
+    
+    for (uint64_t generation = 0; generation < recorded; ++generation)
+    {
+        uint64_t population = _populations[generation];
+        
+        if (population > summary.peakPopulation)
+        {
+            summary.peakPopulation = population;
+            summary.peakGeneration = generation;
+        }
+        
+        if (population == 0 && summary.extinctionGeneration < 0)
+        {
+            summary.extinctionGeneration = (int64_t)generation;
+        }
+    }
+    
+    summary.period = period;
+    summary.cycleStart = cycleStart;
+    summary.generationsStepped = recorded - 1;
+    
+    return summary;
+} // summarize
+
+#pragma mark -
+#pragma mark Private - Packed Boards
+
+// Steps up to kLifeBatchLanes boards of the same size, each in its own lane of
+// every row. A row is one word, so the whole pack steps with bit-sliced adders
+// written lane by lane for the compiler to map onto vector registers. Each lane
+// applies its own rule through masks that are all ones for the neighbor counts
+// at which a cell lives.
+static void AAPLLifeBatchRunPack(const std::vector<AAPL::LifeBatchBoard>& boards, const uint32_t *indices,
+                                 uint32_t laneCount, uint32_t generations, std::vector<AAPLLifeBatchHistory>& histories)
+{
+    const uint32_t lanes = AAPL::kLifeBatchLanes;
+    uint32_t width = boards[indices[0]].width;
+    uint32_t height = boards[indices[0]].height;
+    uint64_t rowMask = width == 64 ? ~0ull : (1ull << width) - 1;
+    
+    std::vector<uint64_t> cells((size_t)height * lanes, 0);
+    std::vector<uint64_t> nextCells((size_t)height * lanes, 0);
+    std::vector<uint8_t> seedCells((size_t)width * height);
+    uint64_t survives[9][lanes] = {};
+    uint64_t born[9][lanes] = {};
+    
+    for (uint32_t lane = 0; lane < laneCount; ++lane)
+    {
+        const AAPL::LifeBatchBoard& board = boards[indices[lane]];
+        
+        AAPL::LifeSeedCells(seedCells.data(), width, height, width, board.seed, board.aliveThreshold);
+        
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                cells[(size_t)y * lanes + lane] |= (uint64_t)(seedCells[(size_t)y * width + x] == AAPL::kLifeCellAlive) << x;
+            }
+        }
+        
+        // A rule that counts the center sees one more neighbor around a live cell
+        for (uint32_t count = 0; count <= 8; ++count)
+        {
+            survives[count][lane] = AAPLLifeRuleMaskTest(board.rule.survival, count + board.rule.includesCenter) ? ~0ull : 0;
+            born[count][lane] = AAPLLifeRuleMaskTest(board.rule.birth, count) ? ~0ull : 0;
+        }
+    }
+    
+    auto record = [&]() {
+        uint64_t hashes[lanes] = {};
+        uint64_t populations[lanes] = {};
+        bool running = false;
+        
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            for (uint32_t lane = 0; lane < lanes; ++lane)
+            {
+                uint64_t row = cells[(size_t)y * lanes + lane];
+                
+                hashes[lane] = AAPLLifeBatchMix(hashes[lane], row);
+                populations[lane] += __builtin_popcountll(row);
+            }
+        }
+        
+        for (uint32_t lane = 0; lane < laneCount; ++lane)
+        {
+            AAPLLifeBatchHistory& history = histories[indices[lane]];
+            
+            if (!history.finished())
+            {
+                running = !history.record(hashes[lane], populations[lane]) || running;
+            }
+        }
+        
+        return running;
+    };
+    
+    bool running = record();
+    
+    for (uint32_t generation = 0; generation < generations && running; ++generation)
+    {
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            const uint64_t *above = &cells[(size_t)(y == 0 ? height - 1 : y - 1) * lanes];
+            const uint64_t *row = &cells[(size_t)y * lanes];
+            const uint64_t *below = &cells[(size_t)(y + 1 == height ? 0 : y + 1) * lanes];
+            uint64_t *next = &nextCells[(size_t)y * lanes];
+            
+            for (uint32_t lane = 0; lane < lanes; ++lane)
+            {
+                // Rotate within the board's width to read the west and east
+                // neighbors, wrapping around as the renderer's sampler does
+                uint64_t n[8];
+                const uint64_t vertical[3] = { above[lane], row[lane], below[lane] };
+                
+                for (int i = 0; i < 3; ++i)
+                {
+                    n[i * 2] = ((vertical[i] << 1) | (vertical[i] >> (width - 1))) & rowMask;
+                    n[i * 2 + 1] = ((vertical[i] >> 1) | (vertical[i] << (width - 1))) & rowMask;
+                }
+                
+                n[6] = above[lane];
+                n[7] = below[lane];
+                
+                // Add the eight neighbors into a four bit count
+                uint64_t sumA = n[0] ^ n[1] ^ n[2];
+                uint64_t carryA = (n[0] & n[1]) | (n[2] & (n[0] ^ n[1]));
+                uint64_t sumB = n[3] ^ n[4] ^ n[5];
+                uint64_t carryB = (n[3] & n[4]) | (n[5] & (n[3] ^ n[4]));
+                uint64_t sumC = n[6] ^ n[7];
+                uint64_t carryC = n[6] & n[7];
+                
+                uint64_t bit0 = sumA ^ sumB ^ sumC;
+                uint64_t carryD = (sumA & sumB) | (sumC & (sumA ^ sumB));
+                uint64_t twos = carryA ^ carryB ^ carryC;
+                uint64_t fours = (carryA & carryB) | (carryC & (carryA ^ carryB));
+                uint64_t bit1 = twos ^ carryD;
+                uint64_t carryE = twos & carryD;
+                uint64_t bit2 = fours ^ carryE;
+                uint64_t bit3 = fours & carryE;
+                
+                uint64_t alive = row[lane];
+                uint64_t result = 0;
+                
+                for (uint32_t count = 0; count <= 8; ++count)
+                {
+                    uint64_t equal = ((count & 1) ? bit0 : ~bit0) & ((count & 2) ? bit1 : ~bit1) &
+                                     ((count & 4) ? bit2 : ~bit2) & ((count & 8) ? bit3 : ~bit3);
+                    
+                    result |= equal & ((alive & survives[count][lane]) | (~alive & born[count][lane]));
+                }
+                
+                next[lane] = result & rowMask;
+            }
+        }
+        
+        cells.swap(nextCells);
+        running = record();
+    }
+} // AAPLLifeBatchRunPack
+
+#pragma mark -
+#pragma mark Private - Single Boards
+
+static void AAPLLifeBatchRunBoard(const AAPL::LifeBatchBoard& board, uint32_t generations,
+                                  AAPL::LifeWorkers *workers, AAPLLifeBatchHistory& history)
+{
+    std::vector<uint8_t> seedCells((size_t)board.width * board.height);
+    AAPL::LifeSeedCells(seedCells.data(), board.width, board.height, board.width, board.seed,
+                        board.aliveThreshold, workers);
+    
+    if (AAPLLifeRuleIsLife(&board.rule))
+    {
+        // Only live cells matter to the summary, so dead ages are not kept
+        AAPL::LifeGrid grid(board.width, board.height, workers);
+        grid.setTracksDeadAge(false);
+        grid.loadCells(seedCells.data(), board.width);
+        
+        for (uint32_t generation = 0;; ++generation)
+        {
+            uint64_t hash = 0;
+            
+            for (uint32_t y = 0; y < grid.height(); ++y)
+            {
+                const uint64_t *row = grid.row(y);
+                
+                for (uint32_t i = 0; i < grid.usedWordsPerRow(); ++i)
+                {
+                    hash = AAPLLifeBatchMix(hash, row[i]);
+                }
+            }
+            
+            if (history.record(hash, grid.population()) || generation == generations)
+            {
+                break;
+            }
+            
+            grid.step();
+        }
+    }
+    else
+    {
+        AAPL::LifeRuleGrid grid(board.rule, board.width, board.height, workers);
+        grid.loadCells(seedCells.data(), board.width);
+        
+        // Dead ages past the last dying state do not affect the future, so
+        // they are hashed as that state
+        uint8_t dead = (uint8_t)(grid.rule().states - 1);
+        size_t cellCount = seedCells.size();
+        
+        for (uint32_t generation = 0;; ++generation)
+        {
+            const uint8_t *cells = grid.cells();
+            uint64_t hash = 0;
+            uint64_t population = 0;
+            
+            for (size_t i = 0; i < cellCount; i += 8)
+            {
+                uint64_t word = 0;
+                
+                for (size_t k = 0; k < 8 && i + k < cellCount; ++k)
+                {
+                    word |= (uint64_t)std::min(cells[i + k], dead) << (k * 8);
+                    population += cells[i + k] == AAPL::kLifeCellAlive;
+                }
+                
+                hash = AAPLLifeBatchMix(hash, word);
+            }
+            
+            if (history.record(hash, population) || generation == generations)
+            {
+                break;
+            }
+            
+            grid.step();
+        }
+    }
+} // AAPLLifeBatchRunBoard
+
+#pragma mark -
+#pragma mark Public - Running Batches
+
+std::vector<AAPL::LifeBatchSummary> AAPL::LifeRunBatch(const std::vector<LifeBatchBoard>& boards, uint32_t generations,
+                                                       LifeWorkers *workers)
+{
+    std::vector<AAPLLifeBatchHistory> histories(boards.size());
+    
+    // Packable boards are grouped by size, since every lane of a pack shares
+    // its rows; the rest are split by whether they are worth all the workers
+    std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> packableBySize;
+    std::vector<uint32_t> smallBoards;
+    std::vector<uint32_t> largeBoards;
+    
+    for (uint32_t i = 0; i < (uint32_t)boards.size(); ++i)
+    {
+        const LifeBatchBoard& board = boards[i];
+        
+        if (AAPLLifeBatchIsPackable(board))
+        {
+            packableBySize[std::make_pair(board.width, board.height)].push_back(i);
+        }
+        else if ((uint64_t)board.width * board.height > kLifeBatchLargeCells)
+        {
+            largeBoards.push_back(i);
+        }
+        else
+        {
+            smallBoards.push_back(i);
+        }
+    }
+    
+    // Each pack is a run of up to kLifeBatchLanes indices in packedBoards
+    std::vector<uint32_t> packedBoards;
+    std::vector<std::pair<uint32_t, uint32_t>> packs;
+    
+    for (const auto& group : packableBySize)
+    {
+        const std::vector<uint32_t>& indices = group.second;
+        
+        for (uint32_t first = 0; first < (uint32_t)indices.size(); first += kLifeBatchLanes)
+        {
+            uint32_t laneCount = std::min((uint32_t)indices.size() - first, kLifeBatchLanes);
+            
+            packs.push_back(std::make_pair((uint32_t)packedBoards.size(), laneCount));
+            packedBoards.insert(packedBoards.end(), indices.begin() + first, indices.begin() + first + laneCount);
+        }
+    }
+    
+    uint32_t taskCount = (uint32_t)(packs.size() + smallBoards.size());
+    
+    auto task = [&](uint32_t index, uint32_t) {
+        if (index < packs.size())
+        {
+            AAPLLifeBatchRunPack(boards, &packedBoards[packs[index].first], packs[index].second, generations, histories);
+        }
+        else
+        {
+            uint32_t board = smallBoards[index - packs.size()];
+            AAPLLifeBatchRunBoard(boards[board], generations, nullptr, histories[board]);
+        }
+    };
+    
+    if (workers)
+    {
+        workers->run(taskCount, task);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < taskCount; ++i)
+        {
+            task(i, 0);
+        }
+    }
+    
+    for (uint32_t board : largeBoards)
+    {
+        AAPLLifeBatchRunBoard(boards[board], generations, workers, histories[board]);
+    }
+    
+    std::vector<LifeBatchSummary> summaries;
+    summaries.reserve(boards.size());
+    
+    for (const AAPLLifeBatchHistory& history : histories)
+    {
+        summaries.push_back(history.summarize(generations));
+    }
+    
+    return summaries;
+} // LifeRunBatch
@@ -0,0 +1,77 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Headless parameter sweeps over many independent boards. Each board is seeded
+    from its own seed, size and rule, run for a number of generations and
+    summarized by its population, the generation it died out, if it did, and
+    the period it settled into. Narrow boards under Life-like rules are packed
+    side by side into the lanes of shared words, small boards run one to a
+    worker and large boards are spread across all of the workers in turn.
+*/
+
+#ifndef _AAPL_LIFE_BATCH_H_
+#define _AAPL_LIFE_BATCH_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AAPLLifeRandom.h"
+#include "AAPLLifeRule.h"
+
+namespace AAPL
+{
+    class LifeWorkers;
+    
+    // Boards at most one word wide under a radius 1, two state Moore rule are
+    // stepped this many at a time, one board in each lane, whatever their rules
+    static const uint32_t kLifeBatchMaxPackedWidth = 64;
+    static const uint32_t kLifeBatchLanes = 8;
+    
+    // Boards with more cells than this are stepped one at a time across every
+    // worker; smaller boards are stepped one to a worker
+    static const uint64_t kLifeBatchLargeCells = 512 * 512;
+    
+    struct LifeBatchBoard
+    {
+        LifeBatchBoard(uint32_t width, uint32_t height, uint64_t seed, const AAPLLifeRule& rule,
+                       uint32_t aliveThreshold = AAPL_LIFE_INITIAL_ALIVE_THRESHOLD)
+        : width(width), height(height), seed(seed), rule(rule), aliveThreshold(aliveThreshold) {}
+        
+        // The board wraps around at its edges and is seeded as LifeSeedCells
+        // seeds it, so a board the size of the view matches the renderer's
+        uint32_t width;
+        uint32_t height;
+        uint64_t seed;
+        AAPLLifeRule rule;
+        uint32_t aliveThreshold;
+    };
+    
+    struct LifeBatchSummary
+    {
+        // Live cells at the last generation, and the most there ever were
+        uint64_t population;
+        uint64_t peakPopulation;
+        uint64_t peakGeneration;
+        
+        // First generation without a live cell, or -1 if the board never died out
+        int64_t extinctionGeneration;
+        
+        // Once a board repeats an earlier state it cycles forever, so it is no
+        // longer stepped and the rest of the run is read from its history.
+        // period is 0 if no repeat was found; a still life, extinct or not,
+        // has period 1. States are compared by 64 bit hashes.
+        uint32_t period;
+        uint64_t cycleStart;
+        uint64_t generationsStepped;
+    };
+    
+    // Runs every board for the given number of generations and returns their
+    // summaries in the same order. Work is spread across the workers if any
+    // are given; the result does not depend on how many there are.
+    std::vector<LifeBatchSummary> LifeRunBatch(const std::vector<LifeBatchBoard>& boards, uint32_t generations,
+                                               LifeWorkers *workers = nullptr);
+} // AAPL
+
+#endif
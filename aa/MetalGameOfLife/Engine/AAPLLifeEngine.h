@@ -0,0 +1,45 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+The interface shared by the simulation engines. It is written in terms of the
+    renderer's game state texture, so a renderer can drive any engine that
+    implements it, on the CPU or otherwise, and upload the result.
+*/
+
+#ifndef _AAPL_LIFE_ENGINE_H_
+#define _AAPL_LIFE_ENGINE_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace AAPL
+{
+    // Values of the R8Uint game state, as in Shaders.metal
+    static const uint8_t kLifeCellAlive = 0;
+    static const uint8_t kLifeCellDead = 255;
+    
+    class LifeEngine
+    {
+    public:
+        virtual ~LifeEngine() {}
+        
+        virtual uint32_t width() const = 0;
+        virtual uint32_t height() const = 0;
+        virtual uint64_t generation() const = 0;
+        
+        // Reads and writes the renderer's texture layout: one byte per cell,
+        // 0 for alive and otherwise the number of generations the cell has
+        // been dead, saturating at 255
+        virtual void loadCells(const uint8_t *cells, size_t bytesPerRow) = 0;
+        virtual void storeCells(uint8_t *cells, size_t bytesPerRow) = 0;
+        
+        // Advances the simulation, identically to game_of_life
+        virtual void step(uint32_t generations = 1) = 0;
+        
+        // Live cells in the current generation
+        virtual uint64_t population() const = 0;
+    };
+} // AAPL
+
+#endif
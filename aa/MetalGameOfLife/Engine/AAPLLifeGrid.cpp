@@ -0,0 +1,788 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A bit-packed CPU implementation of the simulation in Shaders.metal. Cells are
+    stored one bit per cell and stepped 64 or 256 at a time with bit-sliced adders,
+    in tiles that can be spread across a pool of worker threads. Tiles that have
+    settled, along with their neighbors, are skipped.
+    The dead-frame counts that lighting_fragment colors by are kept in a separate
+    byte plane that is only brought up to date when it is read.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "AAPLLifeGrid.h"
+#include "AAPLLifeWorkers.h"
+
+#pragma mark -
+#pragma mark Private - Word Kernels
+
+// GCC and Clang vector extensions lower to AVX2 when it is enabled, and to
+// pairs of SSE or NEON registers otherwise
+#if defined(__GNUC__) || defined(__clang__)
+typedef uint64_t AAPLLifeVector __attribute__((vector_size(32)));
+#define AAPL_LIFE_HAS_VECTOR 1
+#endif
+
+// Loads through an out parameter; returning a vector by value would change
+// the calling convention with and without AVX
+template <typename Word>
+static inline void AAPLLifeLoad(Word& word, const uint64_t *words)
+{
+    memcpy(&word, words, sizeof(Word));
+} // AAPLLifeLoad
+
+template <typename Word>
+static inline void AAPLLifeStore(uint64_t *words, const Word& word)
+{
+    memcpy(words, &word, sizeof(Word));
+} // AAPLLifeStore
+
+// Sums each cell of a row with its east and west neighbors into a two bit
+// count (ones, twos). The row is read from ext + 1, with ext[0] holding the
+// wrapped-around west neighbor of cell 0 in bit 63 and the word after the row
+// holding the east neighbor of the last cell.
+template <typename Word>
+static uint32_t AAPLLifeRowSums(const uint64_t *ext, uint64_t *ones, uint64_t *twos,
+                                uint32_t begin, uint32_t end)
+{
+    const uint32_t wordsPerStep = sizeof(Word) / sizeof(uint64_t);
+    uint32_t i = begin;
+    
+    for (; i + wordsPerStep <= end; i += wordsPerStep)
+    {
+        Word center, following, preceding;
+        
+        AAPLLifeLoad(center, ext + i + 1);
+        AAPLLifeLoad(following, ext + i + 2);
+        AAPLLifeLoad(preceding, ext + i);
+        
+        Word east = (center >> 1) | (following << 63);
+        Word west = (center << 1) | (preceding >> 63);
+        Word half = center ^ east;
+        
+        AAPLLifeStore(ones + i, half ^ west);
+        AAPLLifeStore(twos + i, (center & east) | (west & half));
+    }
+    
+    return i;
+} // AAPLLifeRowSums
+
+// Adds the row sums above, at and below each cell, which counts the cell
+// itself along with its eight neighbors. A cell lives if that total is 3, or
+// if it is 4 and the cell was already alive.
+template <typename Word>
+static uint32_t AAPLLifeRowStep(const uint64_t *alive, uint64_t *next,
+                                const uint64_t *onesAbove, const uint64_t *twosAbove,
+                                const uint64_t *onesRow, const uint64_t *twosRow,
+                                const uint64_t *onesBelow, const uint64_t *twosBelow,
+                                uint32_t begin, uint32_t end)
+{
+    const uint32_t wordsPerStep = sizeof(Word) / sizeof(uint64_t);
+    uint32_t i = begin;
+    
+    for (; i + wordsPerStep <= end; i += wordsPerStep)
+    {
+        Word a, b, c, d, e, f, self;
+        
+        AAPLLifeLoad(a, onesAbove + i);
+        AAPLLifeLoad(b, onesRow + i);
+        AAPLLifeLoad(c, onesBelow + i);
+        AAPLLifeLoad(d, twosAbove + i);
+        AAPLLifeLoad(e, twosRow + i);
+        AAPLLifeLoad(f, twosBelow + i);
+        AAPLLifeLoad(self, alive + i);
+        
+        Word ab = a ^ b;
+        Word ones = ab ^ c;
+        Word onesCarry = (a & b) | (c & ab);
+        
+        Word de = d ^ e;
+        Word twosSum = de ^ f;
+        Word twosCarry = (d & e) | (f & de);
+        Word twos = twosSum ^ onesCarry;
+        Word twosCarry2 = twosSum & onesCarry;
+        Word fours = twosCarry ^ twosCarry2;
+        Word eights = twosCarry & twosCarry2;
+        
+        Word three = ones & twos & ~fours;
+        Word four = self & ~ones & ~twos & fours;
+        
+        AAPLLifeStore(next + i, ~eights & (three | four));
+    }
+    
+    return i;
+} // AAPLLifeRowStep
+
+// Marks the entries of the tile list for tiles that are copied, not stepped
+static const uint32_t kLifeTileCopyFlag = 1u << 31;
+
+static inline uint32_t AAPLLifeWrap(int64_t value, uint32_t size)
+{
+    int64_t wrapped = value % (int64_t)size;
+    
+    return (uint32_t)(wrapped < 0 ? wrapped + size : wrapped);
+} // AAPLLifeWrap
+
+#pragma mark -
+#pragma mark Public - Construction
+
+AAPL::LifeGrid::LifeGrid(uint32_t width, uint32_t height, LifeWorkers *workers)
+: _width(std::max(width, 1u)),
+  _height(std::max(height, 1u)),
+  _generation(0),
+  _current(0),
+  _tracksDeadAge(true),
+  _workers(workers),
+  _activeTileCount(0),
+  _telemetry(nullptr),
+  _population(0),
+  _populationKnown(false)
+{
+    _usedWordsPerRow = (_width + 63) / 64;
+    
+    // Pad rows to a whole number of 256 bit vectors
+    _wordsPerRow = (_usedWordsPerRow + 3) & ~3u;
+    _planeWords = (size_t)_wordsPerRow * _height;
+    
+    uint32_t lastBits = _width % 64;
+    _lastWordMask = lastBits ? (~0ull >> (64 - lastBits)) : ~0ull;
+    
+    _planes.assign(_planeWords * kLifeAgeHistory, 0);
+    _planeGenerations.assign(kLifeAgeHistory, -1);
+    _planeGenerations[0] = 0;
+    _deadAges.assign((size_t)_width * _height, kLifeCellDead);
+    
+    _tileWords = std::min(kLifeTileWidth / 64, _usedWordsPerRow);
+    _tileColumns = (_usedWordsPerRow + _tileWords - 1) / _tileWords;
+    _tileRows = (_height + kLifeTileHeight - 1) / kLifeTileHeight;
+    
+    // Row sums for three rows of a tile, and a tile row with its halo words
+    uint32_t workerCount = _workers ? _workers->workerCount() : 1;
+    
+    _scratchWords = (size_t)_tileWords * 7 + 2;
+    _scratch.assign(_scratchWords * workerCount, 0);
+    
+    _tileChanged.assign(tileCount(), 0);
+    _tileQuietSteps.assign(tileCount(), 0);
+    _tileList.reserve(tileCount());
+    _tileBirths.assign(tileCount(), 0);
+    _tileDeaths.assign(tileCount(), 0);
+} // LifeGrid
+
+#pragma mark -
+#pragma mark Public - Cell Access
+
+bool AAPL::LifeGrid::cell(uint32_t x, uint32_t y) const
+{
+    x = AAPLLifeWrap(x, _width);
+    y = AAPLLifeWrap(y, _height);
+    
+    return (row(y)[x / 64] >> (x % 64)) & 1;
+} // cell
+
+void AAPL::LifeGrid::setCell(uint32_t x, uint32_t y, bool alive)
+{
+    x = AAPLLifeWrap(x, _width);
+    y = AAPLLifeWrap(y, _height);
+    
+    // Fold pending generations into the dead-age plane before editing it
+    syncDeadAges();
+    
+    uint64_t bit = 1ull << (x % 64);
+    uint64_t *word = &plane(_current)[(size_t)y * _wordsPerRow + x / 64];
+    
+    uint32_t tile = (y / kLifeTileHeight) * _tileColumns + (x / 64) / _tileWords;
+    
+    _tileChanged[tile] = 1;
+    _tileQuietSteps[tile] = 0;
+    invalidatePlanes();
+    
+    if (_populationKnown && alive != ((*word & bit) != 0))
+    {
+        _population += alive ? 1 : -1;
+    }
+    
+    *word = alive ? (*word | bit) : (*word & ~bit);
+    
+    if (alive)
+    {
+        _deadAges[(size_t)y * _width + x] = kLifeCellAlive;
+    }
+    else if (_deadAges[(size_t)y * _width + x] == kLifeCellAlive)
+    {
+        _deadAges[(size_t)y * _width + x] = kLifeCellDead;
+    }
+} // setCell
+
+void AAPL::LifeGrid::loadCells(const uint8_t *cells, size_t bytesPerRow)
+{
+    _current = 0;
+    _populationKnown = false;
+    touchAllTiles();
+    
+    uint64_t *dst = plane(0);
+    
+    memset(dst, 0, _planeWords * sizeof(uint64_t));
+    
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        const uint8_t *src = cells + y * bytesPerRow;
+        uint64_t *words = dst + (size_t)y * _wordsPerRow;
+        
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            words[x / 64] |= (uint64_t)(src[x] == kLifeCellAlive) << (x % 64);
+        }
+        
+        memcpy(&_deadAges[(size_t)y * _width], src, _width);
+    }
+} // loadCells
+
+void AAPL::LifeGrid::storeCells(uint8_t *cells, size_t bytesPerRow)
+{
+    const uint8_t *ages = deadAges();
+    
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        memcpy(cells + y * bytesPerRow, ages + (size_t)y * _width, _width);
+    }
+} // storeCells
+
+uint64_t AAPL::LifeGrid::population() const
+{
+    const uint64_t *words = plane(_current);
+    uint64_t count = 0;
+    
+    for (size_t i = 0; i < _planeWords; ++i)
+    {
+        count += __builtin_popcountll(words[i]);
+    }
+    
+    return count;
+} // population
+
+#pragma mark -
+#pragma mark Public - Simulation
+
+void AAPL::LifeGrid::setTelemetry(AAPLLifeTelemetry *telemetry)
+{
+    _telemetry = telemetry;
+} // setTelemetry
+
+void AAPL::LifeGrid::step(uint32_t generations)
+{
+    for (uint32_t i = 0; i < generations; ++i)
+    {
+        std::chrono::steady_clock::time_point start;
+        
+        if (_telemetry)
+        {
+            if (!_populationKnown)
+            {
+                _population = population();
+                _populationKnown = true;
+            }
+            
+            start = std::chrono::steady_clock::now();
+        }
+        
+        uint32_t next;
+        
+        if (_tracksDeadAge)
+        {
+            // Keep every generation until the history is full
+            if (_current + 1 == kLifeAgeHistory)
+            {
+                syncDeadAges();
+            }
+            
+            next = _current + 1;
+        }
+        else
+        {
+            next = _current ^ 1;
+        }
+        
+        stepPlane(_current, next);
+        
+        _current = next;
+        ++_generation;
+        
+        if (_telemetry)
+        {
+            AAPLLifeGenerationStats stats = {};
+            
+            // Only the tiles stepped this generation can have births or deaths
+            for (uint32_t entry : _tileList)
+            {
+                if (!(entry & kLifeTileCopyFlag))
+                {
+                    stats.births += _tileBirths[entry];
+                    stats.deaths += _tileDeaths[entry];
+                }
+            }
+            
+            _population += stats.births - stats.deaths;
+            
+            stats.generation = _generation;
+            stats.population = _population;
+            stats.activeTiles = _activeTileCount;
+            stats.tileCount = tileCount();
+            stats.stepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            
+            AAPLLifeTelemetryRecord(_telemetry, &stats);
+        }
+    }
+} // step
+
+// A tile whose neighborhood did not change in the last generation cannot change
+// in this one. If the tile has been quiet since the destination plane was last
+// written, the plane already holds its cells and skipping it costs nothing;
+// otherwise its cells are copied across.
+void AAPL::LifeGrid::stepPlane(uint32_t from, uint32_t to)
+{
+    const uint64_t *src = plane(from);
+    uint64_t *dst = plane(to);
+    const int64_t dstGeneration = _planeGenerations[to];
+    
+    _tileList.clear();
+    
+    for (uint32_t row = 0; row < _tileRows; ++row)
+    {
+        uint32_t above = (row > 0 ? row - 1 : _tileRows - 1) * _tileColumns;
+        uint32_t center = row * _tileColumns;
+        uint32_t below = (row + 1 < _tileRows ? row + 1 : 0) * _tileColumns;
+        
+        for (uint32_t column = 0; column < _tileColumns; ++column)
+        {
+            uint32_t west = column > 0 ? column - 1 : _tileColumns - 1;
+            uint32_t east = column + 1 < _tileColumns ? column + 1 : 0;
+            uint32_t tile = center + column;
+            
+            bool active = _tileChanged[above + west] | _tileChanged[above + column] | _tileChanged[above + east] |
+                          _tileChanged[center + west] | _tileChanged[tile] | _tileChanged[center + east] |
+                          _tileChanged[below + west] | _tileChanged[below + column] | _tileChanged[below + east];
+            
+            if (active)
+            {
+                _tileList.push_back(tile);
+            }
+            else if (dstGeneration < 0 || dstGeneration + _tileQuietSteps[tile] < (int64_t)_generation)
+            {
+                _tileList.push_back(tile | kLifeTileCopyFlag);
+            }
+        }
+    }
+    
+    // Every flag is read above before any tile updates its own below
+    _activeTileCount = 0;
+    
+    for (uint32_t entry : _tileList)
+    {
+        if (!(entry & kLifeTileCopyFlag))
+        {
+            ++_activeTileCount;
+        }
+    }
+    
+    std::fill(_tileChanged.begin(), _tileChanged.end(), 0);
+    
+    forEachTile(_tileList, [&](uint32_t entry, uint32_t worker)
+    {
+        uint32_t tile = entry & ~kLifeTileCopyFlag;
+        
+        if (entry & kLifeTileCopyFlag)
+        {
+            copyTile(src, dst, tile);
+        }
+        else
+        {
+            _tileChanged[tile] = stepTile(src, dst, tile, &_scratch[worker * _scratchWords],
+                                          _telemetry ? &_tileBirths[tile] : nullptr,
+                                          _telemetry ? &_tileDeaths[tile] : nullptr);
+        }
+    });
+    
+    for (uint32_t tile = 0; tile < tileCount(); ++tile)
+    {
+        uint32_t quiet = _tileQuietSteps[tile];
+        _tileQuietSteps[tile] = _tileChanged[tile] ? 0 : quiet + (quiet != UINT32_MAX);
+    }
+    
+    _planeGenerations[to] = (int64_t)_generation + 1;
+} // stepPlane
+
+// Steps one tile. Each tile reads a one cell halo around itself straight from
+// the previous generation, which no tile writes to: the rows above and below,
+// and the words either side of each row, wrapping around at the grid's edges.
+// Returns whether any of the tile's cells changed, and counts the cells that
+// came alive and died if births is not null.
+bool AAPL::LifeGrid::stepTile(const uint64_t *src, uint64_t *dst, uint32_t tile, uint64_t *scratch,
+                              uint64_t *births, uint64_t *deaths) const
+{
+    uint32_t y0, y1, w0, w1;
+    tileBounds(tile, y0, y1, w0, w1);
+    
+    const uint32_t used = _usedWordsPerRow;
+    const uint32_t lastBit = (_width - 1) % 64;
+    const uint32_t words = w1 - w0;
+    
+    uint64_t *ext = scratch + 6 * words;
+    
+    // Computes the row sums of the tile's part of row y into the given buffers
+    auto rowSums = [&](uint32_t y, uint64_t *ones, uint64_t *twos)
+    {
+        const uint64_t *rowWords = src + (size_t)y * _wordsPerRow;
+        
+        memcpy(ext + 1, rowWords + w0, words * sizeof(uint64_t));
+        
+        // Only bit 63 of the west halo word and bit 0 of the east one are read
+        ext[0] = w0 > 0 ? rowWords[w0 - 1] : ((rowWords[used - 1] >> lastBit) & 1) << 63;
+        
+        if (w1 < used)
+        {
+            ext[words + 1] = rowWords[w1];
+        }
+        else
+        {
+            // The east neighbor of the last cell wraps around to the first; any
+            // bit this sets past the width is masked off after the step
+            uint64_t firstCell = rowWords[0] & 1;
+            
+            ext[words + 1] = 0;
+            
+            if (lastBit == 63)
+            {
+                ext[words + 1] = firstCell;
+            }
+            else
+            {
+                ext[words] |= firstCell << (lastBit + 1);
+            }
+        }
+        
+        uint32_t i = 0;
+
+#if AAPL_LIFE_HAS_VECTOR
+        i = AAPLLifeRowSums<AAPLLifeVector>(ext, ones, twos, i, words);
+#endif
+        AAPLLifeRowSums<uint64_t>(ext, ones, twos, i, words);
+    };
+    
+    uint64_t *onesAbove = scratch;
+    uint64_t *twosAbove = scratch + words;
+    uint64_t *onesRow = scratch + 2 * words;
+    uint64_t *twosRow = scratch + 3 * words;
+    uint64_t *onesBelow = scratch + 4 * words;
+    uint64_t *twosBelow = scratch + 5 * words;
+    
+    rowSums(y0 > 0 ? y0 - 1 : _height - 1, onesAbove, twosAbove);
+    rowSums(y0, onesRow, twosRow);
+    
+    uint64_t changes = 0;
+    uint64_t birthCount = 0;
+    uint64_t deathCount = 0;
+    
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        rowSums(y + 1 < _height ? y + 1 : 0, onesBelow, twosBelow);
+        
+        const uint64_t *alive = src + (size_t)y * _wordsPerRow + w0;
+        uint64_t *next = dst + (size_t)y * _wordsPerRow + w0;
+        uint32_t i = 0;
+
+#if AAPL_LIFE_HAS_VECTOR
+        i = AAPLLifeRowStep<AAPLLifeVector>(alive, next, onesAbove, twosAbove, onesRow, twosRow,
+                                            onesBelow, twosBelow, i, words);
+#endif
+        AAPLLifeRowStep<uint64_t>(alive, next, onesAbove, twosAbove, onesRow, twosRow,
+                                  onesBelow, twosBelow, i, words);
+        
+        if (w1 == used)
+        {
+            next[words - 1] &= _lastWordMask;
+        }
+        
+        if (births)
+        {
+            for (uint32_t j = 0; j < words; ++j)
+            {
+                uint64_t changed = next[j] ^ alive[j];
+                
+                changes |= changed;
+                birthCount += __builtin_popcountll(changed & next[j]);
+                deathCount += __builtin_popcountll(changed & alive[j]);
+            }
+        }
+        else
+        {
+            for (uint32_t j = 0; j < words; ++j)
+            {
+                changes |= next[j] ^ alive[j];
+            }
+        }
+        
+        std::swap(onesAbove, onesRow);
+        std::swap(twosAbove, twosRow);
+        std::swap(onesRow, onesBelow);
+        std::swap(twosRow, twosBelow);
+    }
+    
+    if (births)
+    {
+        *births = birthCount;
+        *deaths = deathCount;
+    }
+    
+    return changes != 0;
+} // stepTile
+
+void AAPL::LifeGrid::copyTile(const uint64_t *src, uint64_t *dst, uint32_t tile) const
+{
+    uint32_t y0, y1, w0, w1;
+    tileBounds(tile, y0, y1, w0, w1);
+    
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        size_t offset = (size_t)y * _wordsPerRow + w0;
+        memcpy(dst + offset, src + offset, (w1 - w0) * sizeof(uint64_t));
+    }
+} // copyTile
+
+// Runs task for each tile in the list, on the workers if there are any
+void AAPL::LifeGrid::forEachTile(const std::vector<uint32_t>& tiles,
+                                 const std::function<void(uint32_t tile, uint32_t worker)>& task)
+{
+    if (_workers)
+    {
+        _workers->run((uint32_t)tiles.size(), [&](uint32_t index, uint32_t worker)
+        {
+            task(tiles[index], worker);
+        });
+    }
+    else
+    {
+        for (uint32_t tile : tiles)
+        {
+            task(tile, 0);
+        }
+    }
+} // forEachTile
+
+// Rows [y0, y1) and words [w0, w1) of each row
+void AAPL::LifeGrid::tileBounds(uint32_t tile, uint32_t& y0, uint32_t& y1, uint32_t& w0, uint32_t& w1) const
+{
+    uint32_t column = tile % _tileColumns;
+    uint32_t row = tile / _tileColumns;
+    
+    y0 = row * kLifeTileHeight;
+    y1 = std::min(y0 + kLifeTileHeight, _height);
+    w0 = column * _tileWords;
+    w1 = std::min(w0 + _tileWords, _usedWordsPerRow);
+} // tileBounds
+
+// Marks every tile as just changed, after the cells or the way planes are
+// used have changed from outside of step()
+void AAPL::LifeGrid::touchAllTiles()
+{
+    std::fill(_tileChanged.begin(), _tileChanged.end(), 1);
+    std::fill(_tileQuietSteps.begin(), _tileQuietSteps.end(), 0);
+    invalidatePlanes();
+} // touchAllTiles
+
+// Only the current plane holds the current generation after it is edited
+void AAPL::LifeGrid::invalidatePlanes()
+{
+    std::fill(_planeGenerations.begin(), _planeGenerations.end(), -1);
+    _planeGenerations[_current] = (int64_t)_generation;
+} // invalidatePlanes
+
+#pragma mark -
+#pragma mark Public - Dead Age
+
+const uint8_t *AAPL::LifeGrid::deadAges()
+{
+    if (_tracksDeadAge)
+    {
+        syncDeadAges();
+    }
+    else
+    {
+        resetDeadAges();
+    }
+    
+    return _deadAges.data();
+} // deadAges
+
+void AAPL::LifeGrid::setTracksDeadAge(bool tracksDeadAge)
+{
+    if (tracksDeadAge == _tracksDeadAge)
+    {
+        return;
+    }
+    
+    if (tracksDeadAge)
+    {
+        // Ages were not kept, so restart them from the current generation
+        if (_current != 0)
+        {
+            memcpy(plane(0), plane(_current), _planeWords * sizeof(uint64_t));
+            _current = 0;
+        }
+        
+        resetDeadAges();
+    }
+    else
+    {
+        syncDeadAges();
+    }
+    
+    // The planes are about to be used in a different order
+    touchAllTiles();
+    
+    _tracksDeadAge = tracksDeadAge;
+} // setTracksDeadAge
+
+void AAPL::LifeGrid::resetDeadAges()
+{
+    const uint64_t *words = plane(_current);
+    
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        const uint64_t *rowWords = words + (size_t)y * _wordsPerRow;
+        uint8_t *ages = &_deadAges[(size_t)y * _width];
+        
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            ages[x] = ((rowWords[x / 64] >> (x % 64)) & 1) ? kLifeCellAlive : kLifeCellDead;
+        }
+    }
+} // resetDeadAges
+
+// _deadAges holds the ages for plane 0; advances them through every plane up
+// to _current, then makes the current plane plane 0
+void AAPL::LifeGrid::syncDeadAges()
+{
+    const uint32_t steps = _current;
+    
+    if (!_tracksDeadAge || steps == 0)
+    {
+        return;
+    }
+    
+    // A tile that has not changed in all of the pending generations only needs
+    // its dead cells aged, and once they have all reached kLifeCellDead it needs
+    // nothing at all. Its part of plane 0 already matches the current plane.
+    _tileList.clear();
+    
+    for (uint32_t tile = 0; tile < tileCount(); ++tile)
+    {
+        uint32_t quiet = _tileQuietSteps[tile];
+        
+        if (quiet < steps || quiet - steps < kLifeCellDead)
+        {
+            _tileList.push_back(tile);
+        }
+    }
+    
+    // Every other tile also copies its part of the current plane into plane 0
+    forEachTile(_tileList, [this, steps](uint32_t tile, uint32_t)
+    {
+        uint32_t y0, y1, w0, w1;
+        tileBounds(tile, y0, y1, w0, w1);
+        
+        bool settled = _tileQuietSteps[tile] >= steps;
+        
+        for (uint32_t y = y0; y < y1; ++y)
+        {
+            size_t rowOffset = (size_t)y * _wordsPerRow;
+            uint8_t *ages = &_deadAges[(size_t)y * _width];
+            
+            for (uint32_t i = w0; i < w1; ++i)
+            {
+                uint64_t anyAlive = 0;
+                
+                if (settled)
+                {
+                    anyAlive = plane(steps)[rowOffset + i];
+                }
+                else
+                {
+                    for (uint32_t p = 1; p <= steps; ++p)
+                    {
+                        anyAlive |= plane(p)[rowOffset + i];
+                    }
+                }
+                
+                uint32_t x0 = i * 64;
+                uint32_t count = std::min(64u, _width - x0);
+                uint8_t *wordAges = ages + x0;
+                
+                // Cells dead throughout, which is almost every cell of a quiet
+                // board, age by a saturating add the compiler vectorizes
+                for (uint32_t b = 0; b < count; ++b)
+                {
+                    uint32_t age = wordAges[b] + steps;
+                    wordAges[b] = (uint8_t)std::min(age, (uint32_t)kLifeCellDead);
+                }
+                
+                // The rest have been dead for as many generations as have passed
+                // since they were last alive
+                for (uint32_t p = steps; anyAlive != 0; --p)
+                {
+                    uint64_t lastAlive = plane(p)[rowOffset + i] & anyAlive;
+                    
+                    anyAlive &= ~lastAlive;
+                    
+                    while (lastAlive)
+                    {
+                        wordAges[__builtin_ctzll(lastAlive)] = (uint8_t)(steps - p);
+                        lastAlive &= lastAlive - 1;
+                    }
+                }
+            }
+            
+            if (!settled)
+            {
+                memcpy(plane(0) + rowOffset + w0, plane(steps) + rowOffset + w0, (w1 - w0) * sizeof(uint64_t));
+            }
+        }
+    });
+    
+    _planeGenerations[0] = (int64_t)_generation;
+    _current = 0;
+} // syncDeadAges
+
+#pragma mark -
+#pragma mark Public - Reference
+
+void AAPL::LifeStepCells(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height)
+{
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        const uint8_t *above = src + (size_t)AAPLLifeWrap((int64_t)y - 1, height) * width;
+        const uint8_t *row = src + (size_t)y * width;
+        const uint8_t *below = src + (size_t)AAPLLifeWrap((int64_t)y + 1, height) * width;
+        
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t west = (x == 0) ? width - 1 : x - 1;
+            uint32_t east = (x + 1 == width) ? 0 : x + 1;
+            
+            uint32_t neighbors = (above[west] == kLifeCellAlive) + (above[x] == kLifeCellAlive) +
+                                 (above[east] == kLifeCellAlive) + (row[west] == kLifeCellAlive) +
+                                 (row[east] == kLifeCellAlive) + (below[west] == kLifeCellAlive) +
+                                 (below[x] == kLifeCellAlive) + (below[east] == kLifeCellAlive);
+            
+            uint8_t deadFrames = row[x];
+            bool alive = (deadFrames == 0 && (neighbors == 2 || neighbors == 3)) || (deadFrames > 0 && neighbors == 3);
+            
+            // The shader's ushort result is clamped when written to the R8Uint texture
+            dst[(size_t)y * width + x] = alive ? kLifeCellAlive : (uint8_t)std::min(deadFrames + 1, (int)kLifeCellDead);
+        }
+    }
+} // LifeStepCells
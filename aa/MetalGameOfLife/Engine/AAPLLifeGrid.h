@@ -0,0 +1,151 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A bit-packed CPU implementation of the simulation in Shaders.metal. Cells are
+    stored one bit per cell and stepped 64 or 256 at a time with bit-sliced adders,
+    in tiles that can be spread across a pool of worker threads. Tiles that have
+    settled, along with their neighbors, are skipped.
+    The dead-frame counts that lighting_fragment colors by are kept in a separate
+    byte plane that is only brought up to date when it is read.
+*/
+
+#ifndef _AAPL_LIFE_GRID_H_
+#define _AAPL_LIFE_GRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "AAPLLifeEngine.h"
+#include "AAPLLifeTelemetry.h"
+
+namespace AAPL
+{
+    class LifeWorkers;
+    
+    // Generations of live bits kept before the dead-age plane must be brought up to date
+    static const uint32_t kLifeAgeHistory = 16;
+    
+    // Size in cells of the tiles the grid is stepped in. Packed rows are 64
+    // cells to a word, so tiles are much wider than they are tall to keep each
+    // tile row several cache lines long.
+    static const uint32_t kLifeTileWidth = 2048;
+    static const uint32_t kLifeTileHeight = 256;
+    
+    class LifeGrid : public LifeEngine
+    {
+    public:
+        // Creates a grid of dead cells. The grid wraps around at its edges, as
+        // the repeat sampler in the renderer does. Tiles are stepped on the
+        // calling thread unless a pool of workers is given; the pool may be
+        // shared by several grids but must outlive them.
+        LifeGrid(uint32_t width, uint32_t height, LifeWorkers *workers = nullptr);
+        
+        uint32_t width() const override { return _width; }
+        uint32_t height() const override { return _height; }
+        uint64_t generation() const override { return _generation; }
+        
+        bool cell(uint32_t x, uint32_t y) const;
+        void setCell(uint32_t x, uint32_t y, bool alive);
+        
+        void loadCells(const uint8_t *cells, size_t bytesPerRow) override;
+        void storeCells(uint8_t *cells, size_t bytesPerRow) override;
+        
+        void step(uint32_t generations = 1) override;
+        
+        uint64_t population() const override;
+        
+        // Dead-frame counts for the current generation, width bytes per row
+        const uint8_t *deadAges();
+        
+        // Soak runs that never read the dead-age plane can skip maintaining it;
+        // when turned back on every dead cell reads as maximally dead
+        void setTracksDeadAge(bool tracksDeadAge);
+        bool tracksDeadAge() const { return _tracksDeadAge; }
+        
+        // Packed rows of the current generation: bit x % 64 of word x / 64 is
+        // cell x, and bits past the width are zero
+        const uint64_t *row(uint32_t y) const { return plane(_current) + (size_t)y * _wordsPerRow; }
+        uint32_t wordsPerRow() const { return _wordsPerRow; }
+        uint32_t usedWordsPerRow() const { return _usedWordsPerRow; }
+        
+        // Tiles stepped in the last generation; the rest had settled
+        uint32_t tileCount() const { return _tileColumns * _tileRows; }
+        uint32_t activeTileCount() const { return _activeTileCount; }
+        
+        // Records the population, births, deaths, active tiles and step time of
+        // every generation stepped from now on into the ring, which must outlive
+        // the grid or be detached with nullptr. The counts are taken as each
+        // tile is stepped and summed over the active tiles afterwards.
+        void setTelemetry(AAPLLifeTelemetry *telemetry);
+        AAPLLifeTelemetry *telemetry() const { return _telemetry; }
+    
+    private:
+        const uint64_t *plane(uint32_t index) const { return &_planes[(size_t)index * _planeWords]; }
+        uint64_t *plane(uint32_t index) { return &_planes[(size_t)index * _planeWords]; }
+        
+        void stepPlane(uint32_t from, uint32_t to);
+        bool stepTile(const uint64_t *src, uint64_t *dst, uint32_t tile, uint64_t *scratch,
+                      uint64_t *births, uint64_t *deaths) const;
+        void copyTile(const uint64_t *src, uint64_t *dst, uint32_t tile) const;
+        void forEachTile(const std::vector<uint32_t>& tiles,
+                         const std::function<void(uint32_t tile, uint32_t worker)>& task);
+        void tileBounds(uint32_t tile, uint32_t& y0, uint32_t& y1, uint32_t& w0, uint32_t& w1) const;
+        void touchAllTiles();
+        void invalidatePlanes();
+        void syncDeadAges();
+        void resetDeadAges();
+        
+        uint32_t _width;
+        uint32_t _height;
+        uint32_t _usedWordsPerRow;
+        uint32_t _wordsPerRow;
+        size_t _planeWords;
+        uint64_t _lastWordMask;
+        uint64_t _generation;
+        
+        // With dead-age tracking, planes 0 through _current hold every
+        // generation since _deadAges was last brought up to date; without it
+        // the first two planes are used as a double buffer
+        std::vector<uint64_t> _planes;
+        uint32_t _current;
+        
+        // The generation each plane last held, or -1 if it is out of date; any
+        // tile quiet since then still has its cells in that plane
+        std::vector<int64_t> _planeGenerations;
+        
+        std::vector<uint8_t> _deadAges;
+        bool _tracksDeadAge;
+        
+        // Row sums and an extended row for each worker
+        LifeWorkers *_workers;
+        uint32_t _tileWords;
+        uint32_t _tileColumns;
+        uint32_t _tileRows;
+        size_t _scratchWords;
+        std::vector<uint64_t> _scratch;
+        
+        // Whether each tile changed in the last generation, and for how many
+        // generations in a row it has not
+        std::vector<uint8_t> _tileChanged;
+        std::vector<uint32_t> _tileQuietSteps;
+        std::vector<uint32_t> _tileList;
+        uint32_t _activeTileCount;
+        
+        // Births and deaths in each tile in the last generation, and the
+        // population kept up to date from them while telemetry is recorded
+        AAPLLifeTelemetry *_telemetry;
+        std::vector<uint64_t> _tileBirths;
+        std::vector<uint64_t> _tileDeaths;
+        uint64_t _population;
+        bool _populationKnown;
+    };
+    
+    // Steps a byte-per-cell grid exactly as game_of_life does; a reference for
+    // checking the packed engine and for comparing performance
+    void LifeStepCells(const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height);
+} // AAPL
+
+#endif
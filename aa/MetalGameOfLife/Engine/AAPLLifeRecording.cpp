@@ -0,0 +1,819 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Recording and playback of the game state. A recording is a file of frames in
+    the renderer's texture layout: every so often a keyframe with the cells
+    run-length encoded, and between keyframes only the cells that came alive
+    or died, as a run-length encoded XOR of the live cells of consecutive
+    generations. Dead ages are rebuilt on playback, since every dead cell ages
+    by one each generation. Frames are encoded and written on a background
+    thread, and an index at the end of the file lets playback seek to any
+    recorded generation by decoding forward from the keyframe before it.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "AAPLLifeEngine.h"
+#include "AAPLLifeRecording.h"
+
+/*
+    File layout, all integers little-endian:
+      header     "AAPLLIFE", version u32, width u32, height u32, keyframe interval u32, reserved u64
+      frames     kind u8, 3 reserved bytes, payload size u32, generation u64, payload
+      index      a frame of kind index whose payload is an entry for every frame:
+                 generation u64, file offset u64, payload size u32, kind u8, 3 reserved bytes
+      trailer    file offset of the index u64, "AAPLINDX"
+    A recording that was never closed has no index or trailer, and any frame
+    after the last complete one is ignored.
+*/
+static const char kLifeRecordingMagic[8] = { 'A', 'A', 'P', 'L', 'L', 'I', 'F', 'E' };
+static const char kLifeRecordingIndexMagic[8] = { 'A', 'A', 'P', 'L', 'I', 'N', 'D', 'X' };
+static const uint32_t kLifeRecordingVersion = 1;
+static const size_t kLifeRecordingHeaderSize = 32;
+static const size_t kLifeRecordingFrameHeaderSize = 16;
+static const size_t kLifeRecordingIndexEntrySize = 24;
+static const size_t kLifeRecordingTrailerSize = 16;
+
+enum
+{
+    kLifeRecordingKeyframe = 1,
+    kLifeRecordingDelta = 2,
+    kLifeRecordingIndex = 3
+};
+
+// Runs shorter than this are cheaper to store as literals
+static const size_t kLifeRecordingMinRun = 4;
+
+#pragma mark -
+#pragma mark Private - Encoding
+
+static void AAPLLifePut32(std::vector<uint8_t>& out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+    {
+        out.push_back((uint8_t)(value >> (i * 8)));
+    }
+} // AAPLLifePut32
+
+static void AAPLLifePut64(std::vector<uint8_t>& out, uint64_t value)
+{
+    AAPLLifePut32(out, (uint32_t)value);
+    AAPLLifePut32(out, (uint32_t)(value >> 32));
+} // AAPLLifePut64
+
+static uint32_t AAPLLifeGet32(const uint8_t *bytes)
+{
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+} // AAPLLifeGet32
+
+static uint64_t AAPLLifeGet64(const uint8_t *bytes)
+{
+    return (uint64_t)AAPLLifeGet32(bytes) | (uint64_t)AAPLLifeGet32(bytes + 4) << 32;
+} // AAPLLifeGet64
+
+static void AAPLLifePutVarint(std::vector<uint8_t>& out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back((uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    
+    out.push_back((uint8_t)value);
+} // AAPLLifePutVarint
+
+static bool AAPLLifeGetVarint(const uint8_t *bytes, size_t size, size_t& position, uint64_t& value)
+{
+    value = 0;
+    
+    for (int shift = 0; shift < 64 && position < size; shift += 7)
+    {
+        uint8_t byte = bytes[position++];
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        
+        if (!(byte & 0x80))
+        {
+            return true;
+        }
+    }
+    
+    return false;
+} // AAPLLifeGetVarint
+
+// Each token is a varint count n: n << 1 | 1 followed by a byte repeated n
+// times, or n << 1 followed by n literal bytes. Keyframes are mostly runs of
+// maximally dead cells and deltas mostly runs of unchanged cells.
+static void AAPLLifeRunEncode(const uint8_t *data, size_t size, std::vector<uint8_t>& out)
+{
+    size_t literalStart = 0;
+    size_t i = 0;
+    
+    out.clear();
+    
+    auto flushLiterals = [&](size_t end) {
+        if (end > literalStart)
+        {
+            AAPLLifePutVarint(out, (uint64_t)(end - literalStart) << 1);
+            out.insert(out.end(), data + literalStart, data + end);
+        }
+    };
+    
+    while (i < size)
+    {
+        size_t run = 1;
+        
+        while (i + run < size && data[i + run] == data[i])
+        {
+            ++run;
+        }
+        
+        if (run >= kLifeRecordingMinRun)
+        {
+            flushLiterals(i);
+            AAPLLifePutVarint(out, (uint64_t)run << 1 | 1);
+            out.push_back(data[i]);
+            literalStart = i + run;
+        }
+        
+        i += run;
+    }
+    
+    flushLiterals(size);
+} // AAPLLifeRunEncode
+
+static bool AAPLLifeRunDecode(const uint8_t *data, size_t size, uint8_t *out, size_t outSize)
+{
+    size_t position = 0;
+    size_t written = 0;
+    
+    while (position < size)
+    {
+        uint64_t token;
+        
+        if (!AAPLLifeGetVarint(data, size, position, token))
+        {
+            return false;
+        }
+        
+        uint64_t count = token >> 1;
+        
+        if (count > outSize - written)
+        {
+            return false;
+        }
+        
+        if (token & 1)
+        {
+            if (position >= size)
+            {
+                return false;
+            }
+            
+            memset(out + written, data[position++], count);
+        }
+        else
+        {
+            if (count > size - position)
+            {
+                return false;
+            }
+            
+            memcpy(out + written, data + position, count);
+            position += count;
+        }
+        
+        written += count;
+    }
+    
+    return written == outSize;
+} // AAPLLifeRunDecode
+
+// Bit i % 8 of byte i / 8 is set if cell i is alive
+static void AAPLLifePackLiveBits(const uint8_t *cells, size_t cellCount, std::vector<uint8_t>& bits)
+{
+    bits.assign((cellCount + 7) / 8, 0);
+    
+    for (size_t i = 0; i < cellCount; ++i)
+    {
+        bits[i / 8] |= (uint8_t)((cells[i] == AAPL::kLifeCellAlive) << (i % 8));
+    }
+} // AAPLLifePackLiveBits
+
+static inline uint8_t AAPLLifeAged(uint8_t value)
+{
+    return value == AAPL::kLifeCellDead ? value : value + 1;
+} // AAPLLifeAged
+
+static bool AAPLLifeWrite(FILE *file, const void *bytes, size_t size)
+{
+    return fwrite(bytes, 1, size, file) == size;
+} // AAPLLifeWrite
+
+static bool AAPLLifeRead(FILE *file, uint64_t offset, void *bytes, size_t size)
+{
+    return fseek(file, (long)offset, SEEK_SET) == 0 && fread(bytes, 1, size, file) == size;
+} // AAPLLifeRead
+
+#pragma mark -
+#pragma mark Public - Recording
+
+AAPL::LifeRecorder::LifeRecorder()
+: _file(nullptr),
+  _width(0),
+  _height(0),
+  _keyframeInterval(kLifeRecordingKeyframeInterval),
+  _lastGeneration(0),
+  _hasFrames(false),
+  _closing(false),
+  _failed(false),
+  _bytesWritten(0),
+  _previousGeneration(0),
+  _framesSinceKeyframe(0)
+{
+} // LifeRecorder
+
+AAPL::LifeRecorder::~LifeRecorder()
+{
+    close();
+} // ~LifeRecorder
+
+bool AAPL::LifeRecorder::open(const char *path, uint32_t width, uint32_t height, uint32_t keyframeInterval)
+{
+    close();
+    
+    FILE *file = fopen(path, "wb");
+    
+    if (!file)
+    {
+        return false;
+    }
+    
+    std::vector<uint8_t> header(kLifeRecordingMagic, kLifeRecordingMagic + 8);
+    AAPLLifePut32(header, kLifeRecordingVersion);
+    AAPLLifePut32(header, width);
+    AAPLLifePut32(header, height);
+    AAPLLifePut32(header, keyframeInterval);
+    AAPLLifePut64(header, 0);
+    
+    if (!AAPLLifeWrite(file, header.data(), header.size()))
+    {
+        fclose(file);
+        return false;
+    }
+    
+    _file = file;
+    _width = width;
+    _height = height;
+    _keyframeInterval = std::max(keyframeInterval, 1u);
+    _hasFrames = false;
+    _closing = false;
+    _failed = false;
+    _bytesWritten = header.size();
+    _previousCells.clear();
+    _index.clear();
+    _writer = std::thread(&LifeRecorder::writerMain, this);
+    
+    return true;
+} // open
+
+bool AAPL::LifeRecorder::record(const uint8_t *cells, size_t bytesPerRow, uint64_t generation)
+{
+    if (!_file || (_hasFrames && generation <= _lastGeneration))
+    {
+        return false;
+    }
+    
+    std::vector<uint8_t> buffer;
+    
+    {
+        std::unique_lock<std::mutex> lock(_mutex);
+        _spaceReady.wait(lock, [this]() { return _queue.size() < kLifeRecordingQueueLength || _failed; });
+        
+        if (_failed)
+        {
+            return false;
+        }
+        
+        if (!_spareBuffers.empty())
+        {
+            buffer.swap(_spareBuffers.back());
+            _spareBuffers.pop_back();
+        }
+    }
+    
+    // The copy is the only work done on the caller's thread
+    buffer.resize((size_t)_width * _height);
+    
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        memcpy(&buffer[(size_t)y * _width], cells + y * bytesPerRow, _width);
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _queue.push_back(Frame());
+        _queue.back().generation = generation;
+        _queue.back().cells.swap(buffer);
+    }
+    
+    _frameReady.notify_one();
+    
+    _hasFrames = true;
+    _lastGeneration = generation;
+    
+    return true;
+} // record
+
+bool AAPL::LifeRecorder::close()
+{
+    if (!_file)
+    {
+        return false;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closing = true;
+    }
+    
+    _frameReady.notify_one();
+    _writer.join();
+    
+    bool written = !_failed;
+    
+    if (written)
+    {
+        std::vector<uint8_t> trailer;
+        std::vector<uint8_t> frameHeader;
+        
+        frameHeader.push_back(kLifeRecordingIndex);
+        frameHeader.insert(frameHeader.end(), 3, 0);
+        AAPLLifePut32(frameHeader, (uint32_t)_index.size());
+        AAPLLifePut64(frameHeader, 0);
+        
+        AAPLLifePut64(trailer, _bytesWritten);
+        trailer.insert(trailer.end(), kLifeRecordingIndexMagic, kLifeRecordingIndexMagic + 8);
+        
+        written = AAPLLifeWrite(_file, frameHeader.data(), frameHeader.size()) &&
+                  AAPLLifeWrite(_file, _index.data(), _index.size()) &&
+                  AAPLLifeWrite(_file, trailer.data(), trailer.size());
+        
+        _bytesWritten += frameHeader.size() + _index.size() + trailer.size();
+    }
+    
+    written = fclose(_file) == 0 && written;
+    _file = nullptr;
+    _queue.clear();
+    _spareBuffers.clear();
+    
+    return written;
+} // close
+
+uint64_t AAPL::LifeRecorder::bytesWritten() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    
+    return _bytesWritten;
+} // bytesWritten
+
+#pragma mark -
+#pragma mark Private - Writer
+
+void AAPL::LifeRecorder::writerMain()
+{
+    bool written = true;
+    
+    for (;;)
+    {
+        Frame frame;
+        
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _frameReady.wait(lock, [this]() { return !_queue.empty() || _closing; });
+            
+            if (_queue.empty())
+            {
+                return;
+            }
+            
+            frame.generation = _queue.front().generation;
+            frame.cells.swap(_queue.front().cells);
+            _queue.pop_front();
+        }
+        
+        _spaceReady.notify_one();
+        
+        // After a failed write the remaining frames are dropped
+        written = written && writeFrame(frame);
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        _failed = !written;
+        _spareBuffers.push_back(std::vector<uint8_t>());
+        _spareBuffers.back().swap(frame.cells);
+    }
+} // writerMain
+
+bool AAPL::LifeRecorder::writeFrame(const Frame& frame)
+{
+    size_t cellCount = frame.cells.size();
+    const uint8_t *cells = frame.cells.data();
+    
+    AAPLLifePackLiveBits(cells, cellCount, _bits);
+    
+    bool keyframe = _previousCells.empty() || frame.generation != _previousGeneration + 1 ||
+                    _framesSinceKeyframe + 1 >= _keyframeInterval;
+    
+    // A delta holds only which cells changed, so the dead ages must follow
+    // from the last frame; an engine that does not keep them, such as a
+    // LifeGrid not tracking dead ages, gets keyframes throughout
+    for (size_t i = 0; i < cellCount && !keyframe; ++i)
+    {
+        uint8_t expected = cells[i] == AAPL::kLifeCellAlive ? AAPL::kLifeCellAlive : AAPLLifeAged(_previousCells[i]);
+        keyframe = expected != cells[i];
+    }
+    
+    if (keyframe)
+    {
+        AAPLLifeRunEncode(cells, cellCount, _encoded);
+        _framesSinceKeyframe = 0;
+    }
+    else
+    {
+        for (size_t i = 0; i < _bits.size(); ++i)
+        {
+            _previousBits[i] ^= _bits[i];
+        }
+        
+        AAPLLifeRunEncode(_previousBits.data(), _previousBits.size(), _encoded);
+        ++_framesSinceKeyframe;
+    }
+    
+    std::vector<uint8_t> frameHeader;
+    uint8_t kind = keyframe ? kLifeRecordingKeyframe : kLifeRecordingDelta;
+    
+    frameHeader.push_back(kind);
+    frameHeader.insert(frameHeader.end(), 3, 0);
+    AAPLLifePut32(frameHeader, (uint32_t)_encoded.size());
+    AAPLLifePut64(frameHeader, frame.generation);
+    
+    if (!AAPLLifeWrite(_file, frameHeader.data(), frameHeader.size()) ||
+        !AAPLLifeWrite(_file, _encoded.data(), _encoded.size()))
+    {
+        return false;
+    }
+    
+    uint64_t offset;
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        offset = _bytesWritten;
+        _bytesWritten += frameHeader.size() + _encoded.size();
+    }
+    
+    AAPLLifePut64(_index, frame.generation);
+    AAPLLifePut64(_index, offset);
+    AAPLLifePut32(_index, (uint32_t)_encoded.size());
+    _index.push_back(kind);
+    _index.insert(_index.end(), 3, 0);
+    
+    _previousCells.assign(cells, cells + cellCount);
+    _previousBits.swap(_bits);
+    _previousGeneration = frame.generation;
+    
+    return true;
+} // writeFrame
+
+#pragma mark -
+#pragma mark Public - Playback
+
+AAPL::LifeRecordingReader::LifeRecordingReader()
+: _file(nullptr),
+  _width(0),
+  _height(0),
+  _currentFrame(-1)
+{
+} // LifeRecordingReader
+
+AAPL::LifeRecordingReader::~LifeRecordingReader()
+{
+    close();
+} // ~LifeRecordingReader
+
+bool AAPL::LifeRecordingReader::open(const char *path)
+{
+    close();
+    
+    _file = fopen(path, "rb");
+    
+    if (!_file)
+    {
+        return false;
+    }
+    
+    uint8_t header[kLifeRecordingHeaderSize];
+    
+    if (!AAPLLifeRead(_file, 0, header, sizeof(header)) || memcmp(header, kLifeRecordingMagic, 8) != 0 ||
+        AAPLLifeGet32(header + 8) != kLifeRecordingVersion)
+    {
+        close();
+        return false;
+    }
+    
+    _width = AAPLLifeGet32(header + 12);
+    _height = AAPLLifeGet32(header + 16);
+    _cells.assign((size_t)_width * _height, kLifeCellDead);
+    _bits.assign(((size_t)_width * _height + 7) / 8, 0);
+    
+    if (!readIndex() && !scanFrames())
+    {
+        close();
+        return false;
+    }
+    
+    return true;
+} // open
+
+void AAPL::LifeRecordingReader::close()
+{
+    if (_file)
+    {
+        fclose(_file);
+        _file = nullptr;
+    }
+    
+    _frames.clear();
+    _currentFrame = -1;
+} // close
+
+bool AAPL::LifeRecordingReader::seek(uint64_t generation, uint8_t *cells, size_t bytesPerRow)
+{
+    auto found = std::lower_bound(_frames.begin(), _frames.end(), generation,
+                                  [](const FrameEntry& entry, uint64_t value) { return entry.generation < value; });
+    
+    if (found == _frames.end() || found->generation != generation)
+    {
+        return false;
+    }
+    
+    int64_t frame = found - _frames.begin();
+    int64_t keyframe = frame;
+    
+    while (_frames[keyframe].kind != kLifeRecordingKeyframe)
+    {
+        --keyframe;
+    }
+    
+    // Carry on from the last frame decoded if it is on the way
+    int64_t start = (_currentFrame >= keyframe && _currentFrame <= frame) ? _currentFrame + 1 : keyframe;
+    
+    for (int64_t i = start; i <= frame; ++i)
+    {
+        if (!decodeFrame((size_t)i))
+        {
+            _currentFrame = -1;
+            return false;
+        }
+        
+        _currentFrame = i;
+    }
+    
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        memcpy(cells + y * bytesPerRow, &_cells[(size_t)y * _width], _width);
+    }
+    
+    return true;
+} // seek
+
+#pragma mark -
+#pragma mark Private - Playback
+
+bool AAPL::LifeRecordingReader::readIndex()
+{
+    if (fseek(_file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    
+    uint64_t fileSize = (uint64_t)ftell(_file);
+    uint8_t trailer[kLifeRecordingTrailerSize];
+    uint8_t frameHeader[kLifeRecordingFrameHeaderSize];
+    
+    if (fileSize < kLifeRecordingHeaderSize + kLifeRecordingFrameHeaderSize + kLifeRecordingTrailerSize ||
+        !AAPLLifeRead(_file, fileSize - sizeof(trailer), trailer, sizeof(trailer)) ||
+        memcmp(trailer + 8, kLifeRecordingIndexMagic, 8) != 0)
+    {
+        return false;
+    }
+    
+    uint64_t indexOffset = AAPLLifeGet64(trailer);
+    
+    if (indexOffset + sizeof(frameHeader) > fileSize - sizeof(trailer) ||
+        !AAPLLifeRead(_file, indexOffset, frameHeader, sizeof(frameHeader)) || frameHeader[0] != kLifeRecordingIndex)
+    {
+        return false;
+    }
+    
+    uint32_t indexSize = AAPLLifeGet32(frameHeader + 4);
+    std::vector<uint8_t> index(indexSize);
+    
+    if (indexSize % kLifeRecordingIndexEntrySize != 0 ||
+        indexOffset + sizeof(frameHeader) + indexSize > fileSize - sizeof(trailer) ||
+        !AAPLLifeRead(_file, indexOffset + sizeof(frameHeader), index.data(), indexSize))
+    {
+        return false;
+    }
+    
+    _frames.clear();
+    
+    for (size_t position = 0; position < indexSize; position += kLifeRecordingIndexEntrySize)
+    {
+        FrameEntry entry;
+        entry.generation = AAPLLifeGet64(&index[position]);
+        entry.offset = AAPLLifeGet64(&index[position + 8]);
+        entry.size = AAPLLifeGet32(&index[position + 16]);
+        entry.kind = index[position + 20];
+        
+        bool valid = entry.offset + kLifeRecordingFrameHeaderSize + entry.size <= indexOffset &&
+                     (entry.kind == kLifeRecordingKeyframe || (entry.kind == kLifeRecordingDelta && !_frames.empty())) &&
+                     (_frames.empty() || entry.generation > _frames.back().generation);
+        
+        if (!valid)
+        {
+            _frames.clear();
+            return false;
+        }
+        
+        _frames.push_back(entry);
+    }
+    
+    return true;
+} // readIndex
+
+bool AAPL::LifeRecordingReader::scanFrames()
+{
+    if (fseek(_file, 0, SEEK_END) != 0)
+    {
+        return false;
+    }
+    
+    uint64_t fileSize = (uint64_t)ftell(_file);
+    uint64_t offset = kLifeRecordingHeaderSize;
+    uint8_t frameHeader[kLifeRecordingFrameHeaderSize];
+    
+    _frames.clear();
+    
+    while (AAPLLifeRead(_file, offset, frameHeader, sizeof(frameHeader)))
+    {
+        FrameEntry entry;
+        entry.generation = AAPLLifeGet64(frameHeader + 8);
+        entry.offset = offset;
+        entry.size = AAPLLifeGet32(frameHeader + 4);
+        entry.kind = frameHeader[0];
+        
+        bool valid = offset + sizeof(frameHeader) + entry.size <= fileSize &&
+                     (entry.kind == kLifeRecordingKeyframe || (entry.kind == kLifeRecordingDelta && !_frames.empty())) &&
+                     (_frames.empty() || entry.generation > _frames.back().generation);
+        
+        // The index, or a frame cut short when the recording stopped
+        if (!valid)
+        {
+            break;
+        }
+        
+        _frames.push_back(entry);
+        offset += sizeof(frameHeader) + entry.size;
+    }
+    
+    return true;
+} // scanFrames
+
+bool AAPL::LifeRecordingReader::decodeFrame(size_t frame)
+{
+    const FrameEntry& entry = _frames[frame];
+    size_t cellCount = _cells.size();
+    
+    _encoded.resize(entry.size);
+    
+    if (!AAPLLifeRead(_file, entry.offset + kLifeRecordingFrameHeaderSize, _encoded.data(), entry.size))
+    {
+        return false;
+    }
+    
+    if (entry.kind == kLifeRecordingKeyframe)
+    {
+        if (!AAPLLifeRunDecode(_encoded.data(), _encoded.size(), _cells.data(), cellCount))
+        {
+            return false;
+        }
+        
+        AAPLLifePackLiveBits(_cells.data(), cellCount, _bits);
+        return true;
+    }
+    
+    _decoded.resize(_bits.size());
+    
+    if (!AAPLLifeRunDecode(_encoded.data(), _encoded.size(), _decoded.data(), _decoded.size()))
+    {
+        return false;
+    }
+    
+    for (size_t i = 0; i < _bits.size(); ++i)
+    {
+        _bits[i] ^= _decoded[i];
+    }
+    
+    // Cells alive now are 0 and every other cell is a generation older
+    for (size_t i = 0; i < cellCount; ++i)
+    {
+        bool alive = (_bits[i / 8] >> (i % 8)) & 1;
+        _cells[i] = alive ? kLifeCellAlive : AAPLLifeAged(_cells[i]);
+    }
+    
+    return true;
+} // decodeFrame
+
+#pragma mark -
+#pragma mark Public - C Interface
+
+static AAPL::LifeRecorder *AAPLLifeRecorderCast(AAPLLifeRecorderRef recorder)
+{
+    return reinterpret_cast<AAPL::LifeRecorder *>(recorder);
+} // AAPLLifeRecorderCast
+
+static AAPL::LifeRecordingReader *AAPLLifeRecordingReaderCast(AAPLLifeRecordingReaderRef reader)
+{
+    return reinterpret_cast<AAPL::LifeRecordingReader *>(reader);
+} // AAPLLifeRecordingReaderCast
+
+AAPLLifeRecorderRef AAPLLifeRecorderCreate(const char *path, uint32_t width, uint32_t height)
+{
+    AAPL::LifeRecorder *recorder = new AAPL::LifeRecorder;
+    
+    if (!recorder->open(path, width, height))
+    {
+        delete recorder;
+        return nullptr;
+    }
+    
+    return reinterpret_cast<AAPLLifeRecorderRef>(recorder);
+} // AAPLLifeRecorderCreate
+
+int AAPLLifeRecorderRecord(AAPLLifeRecorderRef recorder, const uint8_t *cells, size_t bytesPerRow, uint64_t generation)
+{
+    return AAPLLifeRecorderCast(recorder)->record(cells, bytesPerRow, generation);
+} // AAPLLifeRecorderRecord
+
+int AAPLLifeRecorderClose(AAPLLifeRecorderRef recorder)
+{
+    AAPL::LifeRecorder *lifeRecorder = AAPLLifeRecorderCast(recorder);
+    bool written = lifeRecorder->close();
+    delete lifeRecorder;
+    return written;
+} // AAPLLifeRecorderClose
+
+AAPLLifeRecordingReaderRef AAPLLifeRecordingReaderOpen(const char *path)
+{
+    AAPL::LifeRecordingReader *reader = new AAPL::LifeRecordingReader;
+    
+    if (!reader->open(path))
+    {
+        delete reader;
+        return nullptr;
+    }
+    
+    return reinterpret_cast<AAPLLifeRecordingReaderRef>(reader);
+} // AAPLLifeRecordingReaderOpen
+
+void AAPLLifeRecordingReaderClose(AAPLLifeRecordingReaderRef reader)
+{
+    delete AAPLLifeRecordingReaderCast(reader);
+} // AAPLLifeRecordingReaderClose
+
+uint32_t AAPLLifeRecordingReaderWidth(AAPLLifeRecordingReaderRef reader)
+{
+    return AAPLLifeRecordingReaderCast(reader)->width();
+} // AAPLLifeRecordingReaderWidth
+
+uint32_t AAPLLifeRecordingReaderHeight(AAPLLifeRecordingReaderRef reader)
+{
+    return AAPLLifeRecordingReaderCast(reader)->height();
+} // AAPLLifeRecordingReaderHeight
+
+size_t AAPLLifeRecordingReaderFrameCount(AAPLLifeRecordingReaderRef reader)
+{
+    return AAPLLifeRecordingReaderCast(reader)->frameCount();
+} // AAPLLifeRecordingReaderFrameCount
+
+uint64_t AAPLLifeRecordingReaderFrameGeneration(AAPLLifeRecordingReaderRef reader, size_t frame)
+{
+    return AAPLLifeRecordingReaderCast(reader)->frameGeneration(frame);
+} // AAPLLifeRecordingReaderFrameGeneration
+
+int AAPLLifeRecordingReaderSeek(AAPLLifeRecordingReaderRef reader, uint64_t generation,
+                                uint8_t *cells, size_t bytesPerRow)
+{
+    return AAPLLifeRecordingReaderCast(reader)->seek(generation, cells, bytesPerRow);
+} // AAPLLifeRecordingReaderSeek
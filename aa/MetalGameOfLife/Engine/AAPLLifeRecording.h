@@ -0,0 +1,204 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Recording and playback of the game state. A recording is a file of frames in
+    the renderer's texture layout: every so often a keyframe with the cells
+    run-length encoded, and between keyframes only the cells that came alive
+    or died, as a run-length encoded XOR of the live cells of consecutive
+    generations. Dead ages are rebuilt on playback, since every dead cell ages
+    by one each generation. Frames are encoded and written on a background
+    thread, and an index at the end of the file lets playback seek to any
+    recorded generation by decoding forward from the keyframe before it.
+*/
+
+#ifndef _AAPL_LIFE_RECORDING_H_
+#define _AAPL_LIFE_RECORDING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+// For the renderer, which is Objective-C. A recorder is fed from one thread at
+// a time; a reader is used from one thread at a time.
+typedef struct AAPLLifeRecorder *AAPLLifeRecorderRef;
+typedef struct AAPLLifeRecordingReader *AAPLLifeRecordingReaderRef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// As LifeRecorder::open with the default keyframe interval; returns NULL if
+// the file cannot be created
+AAPLLifeRecorderRef AAPLLifeRecorderCreate(const char *path, uint32_t width, uint32_t height);
+
+// As LifeRecorder::record; returns 0 once a write has failed
+int AAPLLifeRecorderRecord(AAPLLifeRecorderRef recorder, const uint8_t *cells, size_t bytesPerRow, uint64_t generation);
+
+// Closes the recording and frees the recorder; returns whether every frame
+// was written
+int AAPLLifeRecorderClose(AAPLLifeRecorderRef recorder);
+
+// As LifeRecordingReader::open; returns NULL if the file is not a recording
+AAPLLifeRecordingReaderRef AAPLLifeRecordingReaderOpen(const char *path);
+void AAPLLifeRecordingReaderClose(AAPLLifeRecordingReaderRef reader);
+
+uint32_t AAPLLifeRecordingReaderWidth(AAPLLifeRecordingReaderRef reader);
+uint32_t AAPLLifeRecordingReaderHeight(AAPLLifeRecordingReaderRef reader);
+size_t AAPLLifeRecordingReaderFrameCount(AAPLLifeRecordingReaderRef reader);
+uint64_t AAPLLifeRecordingReaderFrameGeneration(AAPLLifeRecordingReaderRef reader, size_t frame);
+
+// As LifeRecordingReader::seek; returns 0 if the generation was not recorded
+// or the file is damaged
+int AAPLLifeRecordingReaderSeek(AAPLLifeRecordingReaderRef reader, uint64_t generation,
+                                uint8_t *cells, size_t bytesPerRow);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AAPL
+{
+    // Generations between keyframes, which bounds the frames decoded to seek
+    static const uint32_t kLifeRecordingKeyframeInterval = 64;
+    
+    // Frames waiting for the writer before record blocks
+    static const uint32_t kLifeRecordingQueueLength = 8;
+    
+    class LifeRecorder
+    {
+    public:
+        LifeRecorder();
+        ~LifeRecorder();
+        
+        LifeRecorder(const LifeRecorder&) = delete;
+        LifeRecorder& operator=(const LifeRecorder&) = delete;
+        
+        // Creates the file and starts the writer; returns false if the file
+        // cannot be created
+        bool open(const char *path, uint32_t width, uint32_t height,
+                  uint32_t keyframeInterval = kLifeRecordingKeyframeInterval);
+        
+        // Copies a generation of cells in the texture layout for the writer and
+        // returns without waiting for it, unless kLifeRecordingQueueLength
+        // frames are already waiting. Generations must increase. A frame that
+        // does not directly follow the last one is written as a keyframe.
+        // Returns false once a write has failed.
+        bool record(const uint8_t *cells, size_t bytesPerRow, uint64_t generation);
+        
+        // Writes the remaining frames and the index and closes the file;
+        // returns whether every frame was written
+        bool close();
+        
+        bool isOpen() const { return _file != nullptr; }
+        
+        // Total bytes written so far, for reporting compression
+        uint64_t bytesWritten() const;
+    
+    private:
+        struct Frame
+        {
+            uint64_t generation;
+            std::vector<uint8_t> cells;
+        };
+        
+        void writerMain();
+        bool writeFrame(const Frame& frame);
+        
+        FILE *_file;
+        uint32_t _width;
+        uint32_t _height;
+        uint32_t _keyframeInterval;
+        uint64_t _lastGeneration;
+        bool _hasFrames;
+        
+        // Frames handed to the writer, and spent buffers handed back
+        std::thread _writer;
+        mutable std::mutex _mutex;
+        std::condition_variable _frameReady;
+        std::condition_variable _spaceReady;
+        std::deque<Frame> _queue;
+        std::vector<std::vector<uint8_t>> _spareBuffers;
+        bool _closing;
+        bool _failed;
+        uint64_t _bytesWritten;
+        
+        // Owned by the writer: the last frame written, its live cells one bit
+        // per cell, and the index of every frame
+        std::vector<uint8_t> _previousCells;
+        std::vector<uint8_t> _previousBits;
+        std::vector<uint8_t> _bits;
+        std::vector<uint8_t> _encoded;
+        uint64_t _previousGeneration;
+        uint32_t _framesSinceKeyframe;
+        std::vector<uint8_t> _index;
+    };
+    
+    class LifeRecordingReader
+    {
+    public:
+        LifeRecordingReader();
+        ~LifeRecordingReader();
+        
+        LifeRecordingReader(const LifeRecordingReader&) = delete;
+        LifeRecordingReader& operator=(const LifeRecordingReader&) = delete;
+        
+        // Reads the index, or if the recording was never closed, scans the
+        // frames that were completely written; returns false if the file is
+        // not a recording
+        bool open(const char *path);
+        void close();
+        
+        uint32_t width() const { return _width; }
+        uint32_t height() const { return _height; }
+        
+        // Recorded generations, in increasing order
+        size_t frameCount() const { return _frames.size(); }
+        uint64_t frameGeneration(size_t frame) const { return _frames[frame].generation; }
+        
+        // Decodes a recorded generation in the texture layout. Reading the
+        // generations in order decodes one frame each; any other generation
+        // decodes from the keyframe before it. Returns false if the generation
+        // was not recorded or the file is damaged.
+        bool seek(uint64_t generation, uint8_t *cells, size_t bytesPerRow);
+    
+    private:
+        struct FrameEntry
+        {
+            uint64_t generation;
+            uint64_t offset;
+            uint32_t size;
+            uint8_t kind;
+        };
+        
+        bool scanFrames();
+        bool readIndex();
+        bool decodeFrame(size_t frame);
+        
+        FILE *_file;
+        uint32_t _width;
+        uint32_t _height;
+        std::vector<FrameEntry> _frames;
+        
+        // The last frame decoded, as cells and as live bits
+        int64_t _currentFrame;
+        std::vector<uint8_t> _cells;
+        std::vector<uint8_t> _bits;
+        std::vector<uint8_t> _encoded;
+        std::vector<uint8_t> _decoded;
+    };
+} // AAPL
+
+#endif // __cplusplus
+
+#endif
@@ -0,0 +1,510 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A byte-per-cell CPU engine for any rule in AAPLLifeRule.h. Setting a rule
+    compiles it into lookup tables and picks a step kernel specialized for its
+    neighborhood shape and radius, so sweeping across rules costs no more than
+    a table rebuild per rule. The cell values are those of the game state
+    texture, including the dying states of Generations rules.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "AAPLLifeRuleGrid.h"
+#include "AAPLLifeWorkers.h"
+
+static_assert(AAPL_LIFE_RULE_MAX_RADIUS == 7, "One kernel is instantiated for each radius below");
+
+// Categories of cell value; only live cells count as neighbors, and only dead
+// cells can be born
+enum
+{
+    kLifeRuleAlive = 0,
+    kLifeRuleDying = 1,
+    kLifeRuleDead = 2,
+    kLifeRuleCategoryCount = 3
+};
+
+static inline uint32_t AAPLLifeRuleWrap(int64_t value, uint32_t size)
+{
+    int64_t wrapped = value % (int64_t)size;
+    
+    return (uint32_t)(wrapped < 0 ? wrapped + size : wrapped);
+} // AAPLLifeRuleWrap
+
+// Cells in the whole neighborhood, the center included
+static uint32_t AAPLLifeRuleCellCount(const AAPLLifeRule& rule)
+{
+    return AAPLLifeRuleMaxCount(&rule) + (rule.includesCenter ? 0 : 1);
+} // AAPLLifeRuleCellCount
+
+static inline uint8_t AAPLLifeRuleAged(uint8_t value)
+{
+    return value == AAPL::kLifeCellDead ? value : value + 1;
+} // AAPLLifeRuleAged
+
+#pragma mark -
+#pragma mark Public - Construction
+
+AAPL::LifeRuleGrid::LifeRuleGrid(const AAPLLifeRule& rule, uint32_t width, uint32_t height, LifeWorkers *workers)
+: _kernel(nullptr),
+  _width(std::max(width, 1u)),
+  _height(std::max(height, 1u)),
+  _generation(0),
+  _extendedWidth(0),
+  _workers(workers),
+  _scratchStride(0),
+  _telemetry(nullptr),
+  _population(0),
+  _populationKnown(false)
+{
+    _cells.assign((size_t)_width * _height, kLifeCellDead);
+    _nextCells.resize(_cells.size());
+    _bandBirths.assign(bandCount(), 0);
+    _bandDeaths.assign(bandCount(), 0);
+    
+    setRule(rule);
+} // LifeRuleGrid
+
+#pragma mark -
+#pragma mark Public - Rules
+
+void AAPL::LifeRuleGrid::setRule(const AAPLLifeRule& rule)
+{
+    static const Kernel mooreKernels[AAPL_LIFE_RULE_MAX_RADIUS] =
+    {
+        &stepMooreBand<1>, &stepMooreBand<2>, &stepMooreBand<3>, &stepMooreBand<4>,
+        &stepMooreBand<5>, &stepMooreBand<6>, &stepMooreBand<7>,
+    };
+    
+    static const Kernel vonNeumannKernels[AAPL_LIFE_RULE_MAX_RADIUS] =
+    {
+        &stepVonNeumannBand<1>, &stepVonNeumannBand<2>, &stepVonNeumannBand<3>, &stepVonNeumannBand<4>,
+        &stepVonNeumannBand<5>, &stepVonNeumannBand<6>, &stepVonNeumannBand<7>,
+    };
+    
+    _rule = rule;
+    _rule.radius = std::min(std::max(_rule.radius, 1u), (uint32_t)AAPL_LIFE_RULE_MAX_RADIUS);
+    _rule.states = std::min(std::max(_rule.states, 2u), 256u);
+    
+    bool vonNeumann = _rule.neighborhood == AAPL_LIFE_RULE_VON_NEUMANN;
+    _kernel = vonNeumann ? vonNeumannKernels[_rule.radius - 1] : mooreKernels[_rule.radius - 1];
+    
+    // Values from states - 1 up are dead; in a two state rule that is every
+    // value but 0, as in game_of_life
+    _category.resize(256);
+    _category[0] = kLifeRuleAlive;
+    
+    for (uint32_t value = 1; value < 256; ++value)
+    {
+        _category[value] = value + 1 >= _rule.states ? kLifeRuleDead : kLifeRuleDying;
+    }
+    
+    // The kernels count live cells over the whole neighborhood, which takes
+    // in a live center cell; the tables index survival by that count so the
+    // kernels need not know whether the center counts
+    uint32_t cellCount = AAPLLifeRuleCellCount(_rule);
+    uint32_t centerCount = _rule.includesCenter ? 0 : 1;
+    
+    _countsPerCategory = cellCount + 1;
+    _transitions.assign(kLifeRuleCategoryCount * _countsPerCategory, 0);
+    
+    for (uint32_t count = 0; count <= cellCount; ++count)
+    {
+        if (count >= centerCount)
+        {
+            _transitions[kLifeRuleAlive * _countsPerCategory + count] =
+                (uint8_t)AAPLLifeRuleMaskTest(_rule.survival, count - centerCount);
+        }
+        
+        _transitions[kLifeRuleDead * _countsPerCategory + count] = (uint8_t)AAPLLifeRuleMaskTest(_rule.birth, count);
+    }
+    
+    _extendedWidth = _width + 2 * _rule.radius;
+    
+    if (vonNeumann)
+    {
+        _alive.clear();
+        _prefix.resize((size_t)(_extendedWidth + 1) * _height);
+    }
+    else
+    {
+        _prefix.clear();
+        _alive.resize((size_t)_extendedWidth * _height);
+    }
+    
+    uint32_t workerCount = _workers ? _workers->workerCount() : 1;
+    
+    _scratchStride = _extendedWidth + _width;
+    _scratch.resize(_scratchStride * workerCount);
+} // setRule
+
+#pragma mark -
+#pragma mark Public - Cells
+
+uint8_t AAPL::LifeRuleGrid::cell(uint32_t x, uint32_t y) const
+{
+    return _cells[(size_t)AAPLLifeRuleWrap(y, _height) * _width + AAPLLifeRuleWrap(x, _width)];
+} // cell
+
+void AAPL::LifeRuleGrid::setCell(uint32_t x, uint32_t y, uint8_t value)
+{
+    uint8_t& cell = _cells[(size_t)AAPLLifeRuleWrap(y, _height) * _width + AAPLLifeRuleWrap(x, _width)];
+    
+    if (_populationKnown && (value == kLifeCellAlive) != (cell == kLifeCellAlive))
+    {
+        _population += value == kLifeCellAlive ? 1 : -1;
+    }
+    
+    cell = value;
+} // setCell
+
+void AAPL::LifeRuleGrid::loadCells(const uint8_t *cells, size_t bytesPerRow)
+{
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        memcpy(&_cells[(size_t)y * _width], cells + y * bytesPerRow, _width);
+    }
+    
+    _populationKnown = false;
+} // loadCells
+
+void AAPL::LifeRuleGrid::storeCells(uint8_t *cells, size_t bytesPerRow)
+{
+    for (uint32_t y = 0; y < _height; ++y)
+    {
+        memcpy(cells + y * bytesPerRow, &_cells[(size_t)y * _width], _width);
+    }
+} // storeCells
+
+uint64_t AAPL::LifeRuleGrid::population() const
+{
+    return (uint64_t)std::count(_cells.begin(), _cells.end(), kLifeCellAlive);
+} // population
+
+#pragma mark -
+#pragma mark Public - Simulation
+
+void AAPL::LifeRuleGrid::setTelemetry(AAPLLifeTelemetry *telemetry)
+{
+    _telemetry = telemetry;
+} // setTelemetry
+
+void AAPL::LifeRuleGrid::step(uint32_t generations)
+{
+    uint32_t bandCount = this->bandCount();
+    
+    for (uint32_t i = 0; i < generations; ++i)
+    {
+        std::chrono::steady_clock::time_point start;
+        
+        if (_telemetry)
+        {
+            if (!_populationKnown)
+            {
+                _population = population();
+                _populationKnown = true;
+            }
+            
+            std::fill(_bandBirths.begin(), _bandBirths.end(), 0);
+            std::fill(_bandDeaths.begin(), _bandDeaths.end(), 0);
+            start = std::chrono::steady_clock::now();
+        }
+        
+        // Every band reads rows from its neighbors, so the extended rows are
+        // all prepared before any band is stepped
+        forEachRow(&LifeRuleGrid::prepareRow);
+        
+        if (_workers)
+        {
+            _workers->run(bandCount, [this](uint32_t band, uint32_t worker) { _kernel(*this, band, worker); });
+        }
+        else
+        {
+            for (uint32_t band = 0; band < bandCount; ++band)
+            {
+                _kernel(*this, band, 0);
+            }
+        }
+        
+        _cells.swap(_nextCells);
+        ++_generation;
+        
+        if (_telemetry)
+        {
+            AAPLLifeGenerationStats stats = {};
+            
+            for (uint32_t band = 0; band < bandCount; ++band)
+            {
+                stats.births += _bandBirths[band];
+                stats.deaths += _bandDeaths[band];
+                stats.activeTiles += _bandBirths[band] || _bandDeaths[band];
+            }
+            
+            _population += stats.births - stats.deaths;
+            
+            stats.generation = _generation;
+            stats.population = _population;
+            stats.tileCount = bandCount;
+            stats.stepSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            
+            AAPLLifeTelemetryRecord(_telemetry, &stats);
+        }
+    }
+} // step
+
+#pragma mark -
+#pragma mark Private - Kernels
+
+// Sums whether cells are alive down each column of the neighborhood, rolling
+// the sums from one row to the next, then across each row of column sums
+template <uint32_t Radius>
+void AAPL::LifeRuleGrid::stepMooreBand(LifeRuleGrid& grid, uint32_t band, uint32_t worker)
+{
+    const uint32_t span = 2 * Radius + 1;
+    uint32_t width = grid._width;
+    uint32_t extendedWidth = grid._extendedWidth;
+    uint32_t y0 = band * kLifeRuleBandHeight;
+    uint32_t y1 = std::min(y0 + kLifeRuleBandHeight, grid._height);
+    uint16_t *columns = &grid._scratch[worker * grid._scratchStride];
+    uint16_t *counts = columns + extendedWidth;
+    
+    auto aliveRow = [&](int64_t y) { return &grid._alive[(size_t)AAPLLifeRuleWrap(y, grid._height) * extendedWidth]; };
+    
+    memset(columns, 0, extendedWidth * sizeof(uint16_t));
+    
+    for (int64_t dy = -(int64_t)Radius; dy <= (int64_t)Radius; ++dy)
+    {
+        const uint8_t *row = aliveRow((int64_t)y0 + dy);
+        
+        for (uint32_t i = 0; i < extendedWidth; ++i)
+        {
+            columns[i] += row[i];
+        }
+    }
+    
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        if (y > y0)
+        {
+            const uint8_t *entering = aliveRow((int64_t)y + Radius);
+            const uint8_t *leaving = aliveRow((int64_t)y - Radius - 1);
+            
+            for (uint32_t i = 0; i < extendedWidth; ++i)
+            {
+                columns[i] += entering[i] - leaving[i];
+            }
+        }
+        
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint16_t count = 0;
+            
+            for (uint32_t i = 0; i < span; ++i)
+            {
+                count += columns[x + i];
+            }
+            
+            counts[x] = count;
+        }
+        
+        grid.finishRow(y, counts);
+    }
+} // stepMooreBand
+
+// Sums each row of the diamond as the difference of two running totals
+template <uint32_t Radius>
+void AAPL::LifeRuleGrid::stepVonNeumannBand(LifeRuleGrid& grid, uint32_t band, uint32_t worker)
+{
+    uint32_t width = grid._width;
+    uint32_t prefixStride = grid._extendedWidth + 1;
+    uint32_t y0 = band * kLifeRuleBandHeight;
+    uint32_t y1 = std::min(y0 + kLifeRuleBandHeight, grid._height);
+    uint16_t *counts = &grid._scratch[worker * grid._scratchStride];
+    
+    for (uint32_t y = y0; y < y1; ++y)
+    {
+        memset(counts, 0, width * sizeof(uint16_t));
+        
+        for (int64_t dy = -(int64_t)Radius; dy <= (int64_t)Radius; ++dy)
+        {
+            uint32_t reach = Radius - (uint32_t)(dy < 0 ? -dy : dy);
+            const uint16_t *prefix = &grid._prefix[(size_t)AAPLLifeRuleWrap((int64_t)y + dy, grid._height) * prefixStride];
+            const uint16_t *end = prefix + Radius + reach + 1;
+            const uint16_t *begin = prefix + Radius - reach;
+            
+            // The totals wrap around at 2^16, but no row of the diamond holds
+            // that many cells, so the differences are exact
+            for (uint32_t x = 0; x < width; ++x)
+            {
+                counts[x] += (uint16_t)(end[x] - begin[x]);
+            }
+        }
+        
+        grid.finishRow(y, counts);
+    }
+} // stepVonNeumannBand
+
+#pragma mark -
+#pragma mark Private - Rows
+
+void AAPL::LifeRuleGrid::prepareRow(uint32_t y)
+{
+    const uint8_t *row = &_cells[(size_t)y * _width];
+    uint32_t radius = _rule.radius;
+    
+    auto isAlive = [&](int64_t x) -> uint8_t { return row[AAPLLifeRuleWrap(x, _width)] == kLifeCellAlive; };
+    
+    if (!_alive.empty())
+    {
+        uint8_t *extended = &_alive[(size_t)y * _extendedWidth];
+        
+        for (uint32_t i = 0; i < radius; ++i)
+        {
+            extended[i] = isAlive((int64_t)i - radius);
+            extended[radius + _width + i] = isAlive((int64_t)_width + i);
+        }
+        
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            extended[radius + x] = row[x] == kLifeCellAlive;
+        }
+    }
+    else
+    {
+        uint16_t *prefix = &_prefix[(size_t)y * (_extendedWidth + 1)];
+        uint16_t total = 0;
+        
+        prefix[0] = 0;
+        
+        for (uint32_t i = 0; i < radius; ++i)
+        {
+            total += isAlive((int64_t)i - radius);
+            prefix[i + 1] = total;
+        }
+        
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            total += row[x] == kLifeCellAlive;
+            prefix[radius + x + 1] = total;
+        }
+        
+        for (uint32_t i = 0; i < radius; ++i)
+        {
+            total += isAlive((int64_t)_width + i);
+            prefix[radius + _width + i + 1] = total;
+        }
+    }
+} // prepareRow
+
+void AAPL::LifeRuleGrid::finishRow(uint32_t y, const uint16_t *counts)
+{
+    const uint8_t *row = &_cells[(size_t)y * _width];
+    uint8_t *next = &_nextCells[(size_t)y * _width];
+    const uint8_t *category = _category.data();
+    const uint8_t *transitions = _transitions.data();
+    uint32_t countsPerCategory = _countsPerCategory;
+    
+    for (uint32_t x = 0; x < _width; ++x)
+    {
+        uint8_t value = row[x];
+        bool alive = transitions[category[value] * countsPerCategory + counts[x]];
+        
+        next[x] = alive ? kLifeCellAlive : AAPLLifeRuleAged(value);
+    }
+    
+    // Each band is finished by one worker, so its counts need no atomics
+    if (_telemetry)
+    {
+        uint64_t births = 0, deaths = 0;
+        
+        for (uint32_t x = 0; x < _width; ++x)
+        {
+            bool wasAlive = row[x] == kLifeCellAlive;
+            bool isAlive = next[x] == kLifeCellAlive;
+            
+            births += !wasAlive && isAlive;
+            deaths += wasAlive && !isAlive;
+        }
+        
+        _bandBirths[y / kLifeRuleBandHeight] += births;
+        _bandDeaths[y / kLifeRuleBandHeight] += deaths;
+    }
+} // finishRow
+
+void AAPL::LifeRuleGrid::forEachRow(void (LifeRuleGrid::*function)(uint32_t y))
+{
+    uint32_t bandCount = (_height + kLifeRuleBandHeight - 1) / kLifeRuleBandHeight;
+    
+    auto band = [this, function](uint32_t band, uint32_t) {
+        uint32_t y1 = std::min((band + 1) * kLifeRuleBandHeight, _height);
+        
+        for (uint32_t y = band * kLifeRuleBandHeight; y < y1; ++y)
+        {
+            (this->*function)(y);
+        }
+    };
+    
+    if (_workers)
+    {
+        _workers->run(bandCount, band);
+    }
+    else
+    {
+        for (uint32_t i = 0; i < bandCount; ++i)
+        {
+            band(i, 0);
+        }
+    }
+} // forEachRow
+
+#pragma mark -
+#pragma mark Reference
+
+void AAPL::LifeStepRuleCells(const AAPLLifeRule& rule, const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height)
+{
+    int64_t radius = rule.radius;
+    
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            uint32_t neighbors = 0;
+            
+            for (int64_t dy = -radius; dy <= radius; ++dy)
+            {
+                int64_t reach = rule.neighborhood == AAPL_LIFE_RULE_VON_NEUMANN ? radius - std::abs(dy) : radius;
+                
+                for (int64_t dx = -reach; dx <= reach; ++dx)
+                {
+                    if ((dx == 0 && dy == 0) && !rule.includesCenter)
+                    {
+                        continue;
+                    }
+                    
+                    uint32_t nx = AAPLLifeRuleWrap((int64_t)x + dx, width);
+                    uint32_t ny = AAPLLifeRuleWrap((int64_t)y + dy, height);
+                    
+                    neighbors += src[(size_t)ny * width + nx] == kLifeCellAlive;
+                }
+            }
+            
+            uint8_t value = src[(size_t)y * width + x];
+            bool alive;
+            
+            if (value == kLifeCellAlive)
+            {
+                alive = AAPLLifeRuleMaskTest(rule.survival, neighbors);
+            }
+            else
+            {
+                alive = (AAPLLifeRuleWord)value + 1 >= rule.states && AAPLLifeRuleMaskTest(rule.birth, neighbors);
+            }
+            
+            dst[(size_t)y * width + x] = alive ? kLifeCellAlive : AAPLLifeRuleAged(value);
+        }
+    }
+} // LifeStepRuleCells
@@ -0,0 +1,123 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A byte-per-cell CPU engine for any rule in AAPLLifeRule.h. Setting a rule
+    compiles it into lookup tables and picks a step kernel specialized for its
+    neighborhood shape and radius, so sweeping across rules costs no more than
+    a table rebuild per rule. The cell values are those of the game state
+    texture, including the dying states of Generations rules.
+*/
+
+#ifndef _AAPL_LIFE_RULE_GRID_H_
+#define _AAPL_LIFE_RULE_GRID_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "AAPLLifeEngine.h"
+#include "AAPLLifeRule.h"
+#include "AAPLLifeTelemetry.h"
+
+namespace AAPL
+{
+    class LifeWorkers;
+    
+    // Rows stepped by each task when the grid is spread across workers
+    static const uint32_t kLifeRuleBandHeight = 64;
+    
+    class LifeRuleGrid : public LifeEngine
+    {
+    public:
+        // Creates a grid of dead cells that wraps around at its edges, as the
+        // rule kernels in Shaders.metal do. Bands of rows are stepped on the
+        // calling thread unless a pool of workers is given.
+        LifeRuleGrid(const AAPLLifeRule& rule, uint32_t width, uint32_t height, LifeWorkers *workers = nullptr);
+        
+        uint32_t width() const override { return _width; }
+        uint32_t height() const override { return _height; }
+        uint64_t generation() const override { return _generation; }
+        
+        const AAPLLifeRule& rule() const { return _rule; }
+        
+        // Switches rules without touching the cells; a cheap way to run many
+        // rules from one soup
+        void setRule(const AAPLLifeRule& rule);
+        
+        uint8_t cell(uint32_t x, uint32_t y) const;
+        void setCell(uint32_t x, uint32_t y, uint8_t value);
+        
+        void loadCells(const uint8_t *cells, size_t bytesPerRow) override;
+        void storeCells(uint8_t *cells, size_t bytesPerRow) override;
+        
+        // Advances the simulation, identically to the rule kernels in Shaders.metal
+        void step(uint32_t generations = 1) override;
+        
+        uint64_t population() const override;
+        
+        // Cells of the current generation, width bytes per row
+        const uint8_t *cells() const { return _cells.data(); }
+        
+        // Bands of kLifeRuleBandHeight rows, which are stepped as units; the
+        // grid's telemetry reports them as its tiles
+        uint32_t bandCount() const { return (_height + kLifeRuleBandHeight - 1) / kLifeRuleBandHeight; }
+        
+        // As LifeGrid::setTelemetry. Births and deaths are counted in each band
+        // as its rows are finished, and a band is active if any cell in it
+        // came alive or died; dying cells that only age do not count.
+        void setTelemetry(AAPLLifeTelemetry *telemetry);
+        AAPLLifeTelemetry *telemetry() const { return _telemetry; }
+    
+    private:
+        typedef void (*Kernel)(LifeRuleGrid& grid, uint32_t band, uint32_t worker);
+        
+        template <uint32_t Radius> static void stepMooreBand(LifeRuleGrid& grid, uint32_t band, uint32_t worker);
+        template <uint32_t Radius> static void stepVonNeumannBand(LifeRuleGrid& grid, uint32_t band, uint32_t worker);
+        
+        void prepareRow(uint32_t y);
+        void finishRow(uint32_t y, const uint16_t *counts);
+        void forEachRow(void (LifeRuleGrid::*function)(uint32_t y));
+        
+        AAPLLifeRule _rule;
+        Kernel _kernel;
+        
+        // Whether a cell with each value is alive, dying or dead, and whether a
+        // cell in each of those with each neighbor count is alive next
+        std::vector<uint8_t> _category;
+        std::vector<uint8_t> _transitions;
+        uint32_t _countsPerCategory;
+        
+        uint32_t _width;
+        uint32_t _height;
+        uint64_t _generation;
+        std::vector<uint8_t> _cells;
+        std::vector<uint8_t> _nextCells;
+        
+        // Rows extended by the radius on both sides with wrapped-around cells.
+        // Moore kernels read whether each cell is alive; von Neumann kernels
+        // read running totals of live cells along the row, kept modulo 2^16.
+        uint32_t _extendedWidth;
+        std::vector<uint8_t> _alive;
+        std::vector<uint16_t> _prefix;
+        
+        // Column sums and neighbor counts for each worker
+        LifeWorkers *_workers;
+        std::vector<uint16_t> _scratch;
+        size_t _scratchStride;
+        
+        // Births and deaths in each band in the last generation, and the
+        // population kept up to date from them while telemetry is recorded
+        AAPLLifeTelemetry *_telemetry;
+        std::vector<uint64_t> _bandBirths;
+        std::vector<uint64_t> _bandDeaths;
+        uint64_t _population;
+        bool _populationKnown;
+    };
+    
+    // Steps a byte-per-cell grid under any rule by visiting every neighbor of
+    // every cell; a reference for checking LifeRuleGrid and the shaders
+    void LifeStepRuleCells(const AAPLLifeRule& rule, const uint8_t *src, uint8_t *dst, uint32_t width, uint32_t height);
+} // AAPL
+
+#endif
@@ -0,0 +1,136 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Seeding and activation for the CPU engine, drawing on the same counter-based
+    generator as the renderer and shaders so that a seed produces the same
+    cells whichever of them fills the grid.
+*/
+
+#include <algorithm>
+#include <cstring>
+
+#include "AAPLLifeGrid.h"
+#include "AAPLLifeSeed.h"
+#include "AAPLLifeWorkers.h"
+
+// Rows seeded by each task when the rows are spread across workers
+static const uint32_t kLifeSeedRowsPerTask = 64;
+
+void AAPL::LifeSeedCells(uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow, uint64_t seed,
+                         uint32_t aliveThreshold, LifeWorkers *workers)
+{
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(seed);
+    uint32_t taskCount = (height + kLifeSeedRowsPerTask - 1) / kLifeSeedRowsPerTask;
+    
+    auto seedRows = [&](uint32_t task, uint32_t)
+    {
+        uint32_t endRow = std::min((task + 1) * kLifeSeedRowsPerTask, height);
+        
+        for (uint32_t row = task * kLifeSeedRowsPerTask; row < endRow; ++row)
+        {
+            AAPLLifeRandomSeedRow(cells + row * bytesPerRow, width, row, key, aliveThreshold);
+        }
+    };
+    
+    if (workers)
+    {
+        workers->run(taskCount, seedRows);
+    }
+    else
+    {
+        for (uint32_t task = 0; task < taskCount; ++task)
+        {
+            seedRows(task, 0);
+        }
+    }
+} // LifeSeedCells
+
+void AAPL::LifeResizeCells(const uint8_t *oldCells, uint32_t oldWidth, uint32_t oldHeight, size_t oldBytesPerRow,
+                           uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow, uint64_t seed,
+                           uint32_t aliveThreshold, LifeWorkers *workers)
+{
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(seed);
+    uint32_t taskCount = (height + kLifeSeedRowsPerTask - 1) / kLifeSeedRowsPerTask;
+    int64_t offsetX = ((int64_t)oldWidth - width) / 2;
+    int64_t offsetY = ((int64_t)oldHeight - height) / 2;
+    
+    // The columns of the new grid that the old grid covers
+    uint32_t copyStart = (uint32_t)std::min<int64_t>(std::max<int64_t>(-offsetX, 0), width);
+    uint32_t copyEnd = (uint32_t)std::max<int64_t>(std::min<int64_t>((int64_t)oldWidth - offsetX, width), copyStart);
+    
+    auto resizeRows = [&](uint32_t task, uint32_t)
+    {
+        uint32_t endRow = std::min((task + 1) * kLifeSeedRowsPerTask, height);
+        
+        for (uint32_t row = task * kLifeSeedRowsPerTask; row < endRow; ++row)
+        {
+            uint8_t *cellRow = cells + (size_t)row * bytesPerRow;
+            int64_t oldRow = row + offsetY;
+            
+            if (oldRow < 0 || oldRow >= oldHeight || copyStart == copyEnd)
+            {
+                AAPLLifeRandomSeedRow(cellRow, width, row, key, aliveThreshold);
+                continue;
+            }
+            
+            // Newly exposed columns are usually a narrow margin on either side,
+            // so they are seeded cell by cell rather than a block at a time
+            auto seedCell = [&](uint32_t x)
+            {
+                uint32_t random = AAPLLifeRandomCell(key, x, row, AAPL_LIFE_RANDOM_STREAM_SEED, 0);
+                cellRow[x] = random < aliveThreshold ? kLifeCellAlive : kLifeCellDead;
+            };
+            
+            for (uint32_t x = 0; x < copyStart; ++x)
+            {
+                seedCell(x);
+            }
+            
+            for (uint32_t x = copyEnd; x < width; ++x)
+            {
+                seedCell(x);
+            }
+            
+            memcpy(cellRow + copyStart, oldCells + oldRow * oldBytesPerRow + (copyStart + offsetX), copyEnd - copyStart);
+        }
+    };
+    
+    if (workers)
+    {
+        workers->run(taskCount, resizeRows);
+    }
+    else
+    {
+        for (uint32_t task = 0; task < taskCount; ++task)
+        {
+            resizeRows(task, 0);
+        }
+    }
+} // LifeResizeCells
+
+void AAPL::LifeActivateRandomNeighbors(LifeGrid& grid, uint32_t x, uint32_t y, uint64_t seed, uint32_t activationIndex)
+{
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(seed);
+    
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            int64_t neighborX = (int64_t)x + dx;
+            int64_t neighborY = (int64_t)y + dy;
+            
+            if ((dx == 0 && dy == 0) || neighborX < 0 || neighborY < 0 ||
+                neighborX >= grid.width() || neighborY >= grid.height())
+            {
+                continue;
+            }
+            
+            // The shader converts the signed position to uint in the same way
+            uint32_t random = AAPLLifeRandomCell(key, (uint32_t)neighborX, (uint32_t)neighborY,
+                                                 AAPL_LIFE_RANDOM_STREAM_ACTIVATION, activationIndex);
+            
+            grid.setCell((uint32_t)neighborX, (uint32_t)neighborY, random < AAPL_LIFE_SPAWN_THRESHOLD);
+        }
+    }
+} // LifeActivateRandomNeighbors
@@ -0,0 +1,45 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Seeding and activation for the CPU engine, drawing on the same counter-based
+    generator as the renderer and shaders so that a seed produces the same
+    cells whichever of them fills the grid.
+*/
+
+#ifndef _AAPL_LIFE_SEED_H_
+#define _AAPL_LIFE_SEED_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "AAPLLifeRandom.h"
+
+namespace AAPL
+{
+    class LifeGrid;
+    class LifeWorkers;
+    
+    // Fills cells in the game state layout exactly as the renderer seeds its
+    // grid: alive with probability aliveThreshold / 2^32, otherwise maximally
+    // dead. Bands of rows are spread across the workers if any are given.
+    void LifeSeedCells(uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow, uint64_t seed,
+                       uint32_t aliveThreshold = AAPL_LIFE_INITIAL_ALIVE_THRESHOLD, LifeWorkers *workers = nullptr);
+    
+    // Does what resize_game_state does when the renderer's grid changes size:
+    // the old cells are copied across centered, (oldWidth - width) / 2 and
+    // (oldHeight - height) / 2 rounded toward zero being the position in the
+    // old grid of the new grid's origin, so cells past the new edges are
+    // dropped and only the cells the old grid did not cover are seeded, as
+    // LifeSeedCells would seed them. Dead ages carry over unchanged.
+    void LifeResizeCells(const uint8_t *oldCells, uint32_t oldWidth, uint32_t oldHeight, size_t oldBytesPerRow,
+                         uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow, uint64_t seed,
+                         uint32_t aliveThreshold = AAPL_LIFE_INITIAL_ALIVE_THRESHOLD, LifeWorkers *workers = nullptr);
+    
+    // Does what activate_random_neighbors does for one touched cell: each of
+    // its eight neighbors becomes alive or maximally dead at random. Neighbors
+    // off the edge of the grid are left alone, as the texture write drops them.
+    void LifeActivateRandomNeighbors(LifeGrid& grid, uint32_t x, uint32_t y, uint64_t seed, uint32_t activationIndex);
+} // AAPL
+
+#endif
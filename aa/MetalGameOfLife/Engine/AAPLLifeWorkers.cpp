@@ -0,0 +1,205 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A small work-stealing thread pool for the CPU engine. Each call runs a range of
+    independent tasks, such as the tiles of one generation, split evenly across
+    the workers; a worker that runs out steals half of the remaining range of
+    another, so uneven tiles do not leave cores idle.
+*/
+
+#include <algorithm>
+
+#include "AAPLLifeWorkers.h"
+
+static inline uint64_t AAPLLifeRange(uint32_t begin, uint32_t end)
+{
+    return (uint64_t)end << 32 | begin;
+} // AAPLLifeRange
+
+#pragma mark -
+#pragma mark Public - Construction
+
+AAPL::LifeWorkers::LifeWorkers(uint32_t threadCount)
+: _task(nullptr),
+  _job(0),
+  _busy(0),
+  _quit(false)
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    
+    _workerCount = threadCount;
+    _queues = std::vector<Queue>(_workerCount);
+    
+    for (Queue& queue : _queues)
+    {
+        queue.range.store(0, std::memory_order_relaxed);
+    }
+    
+    for (uint32_t worker = 1; worker < _workerCount; ++worker)
+    {
+        _threads.emplace_back(&LifeWorkers::workerMain, this, worker);
+    }
+} // LifeWorkers
+
+AAPL::LifeWorkers::~LifeWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _quit = true;
+    }
+    
+    _wake.notify_all();
+    
+    for (std::thread& thread : _threads)
+    {
+        thread.join();
+    }
+} // ~LifeWorkers
+
+#pragma mark -
+#pragma mark Public - Running Tasks
+
+void AAPL::LifeWorkers::run(uint32_t taskCount, const Task& task)
+{
+    if (_workerCount == 1 || taskCount <= 1)
+    {
+        for (uint32_t i = 0; i < taskCount; ++i)
+        {
+            task(i, 0);
+        }
+        
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        for (uint32_t worker = 0; worker < _workerCount; ++worker)
+        {
+            uint32_t begin = (uint32_t)((uint64_t)taskCount * worker / _workerCount);
+            uint32_t end = (uint32_t)((uint64_t)taskCount * (worker + 1) / _workerCount);
+            
+            _queues[worker].range.store(AAPLLifeRange(begin, end), std::memory_order_relaxed);
+        }
+        
+        _task = &task;
+        _busy = _workerCount - 1;
+        ++_job;
+    }
+    
+    _wake.notify_all();
+    
+    work(0);
+    
+    // Workers that wake late find nothing left and report in straight away
+    std::unique_lock<std::mutex> lock(_mutex);
+    _finished.wait(lock, [this]() { return _busy == 0; });
+    _task = nullptr;
+} // run
+
+#pragma mark -
+#pragma mark Private - Workers
+
+void AAPL::LifeWorkers::workerMain(uint32_t worker)
+{
+    uint64_t job = 0;
+    
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _wake.wait(lock, [&]() { return _quit || _job != job; });
+            
+            if (_quit)
+            {
+                return;
+            }
+            
+            job = _job;
+        }
+        
+        work(worker);
+        
+        std::lock_guard<std::mutex> lock(_mutex);
+        
+        if (--_busy == 0)
+        {
+            _finished.notify_one();
+        }
+    }
+} // workerMain
+
+void AAPL::LifeWorkers::work(uint32_t worker)
+{
+    const Task& task = *_task;
+    uint32_t index;
+    
+    while (pop(worker, index) || steal(worker, index))
+    {
+        task(index, worker);
+    }
+} // work
+
+// Takes the first task of the worker's own range
+bool AAPL::LifeWorkers::pop(uint32_t worker, uint32_t& task)
+{
+    std::atomic<uint64_t>& range = _queues[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    
+    for (;;)
+    {
+        uint32_t begin = (uint32_t)current;
+        uint32_t end = (uint32_t)(current >> 32);
+        
+        if (begin >= end)
+        {
+            return false;
+        }
+        
+        if (range.compare_exchange_weak(current, AAPLLifeRange(begin + 1, end), std::memory_order_acq_rel))
+        {
+            task = begin;
+            return true;
+        }
+    }
+} // pop
+
+// Takes the back half of another worker's range, runs the first task of it
+// and keeps the rest as the worker's own range. Tasks never add tasks, so
+// once every range is seen empty the job is done.
+bool AAPL::LifeWorkers::steal(uint32_t worker, uint32_t& task)
+{
+    for (uint32_t offset = 1; offset < _workerCount; ++offset)
+    {
+        std::atomic<uint64_t>& range = _queues[(worker + offset) % _workerCount].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        
+        for (;;)
+        {
+            uint32_t begin = (uint32_t)current;
+            uint32_t end = (uint32_t)(current >> 32);
+            
+            if (begin >= end)
+            {
+                break;
+            }
+            
+            uint32_t middle = begin + (end - begin) / 2;
+            
+            if (range.compare_exchange_weak(current, AAPLLifeRange(begin, middle), std::memory_order_acq_rel))
+            {
+                // Each index is only ever in one range, so no thief can hold
+                // a stale copy of the new value
+                _queues[worker].range.store(AAPLLifeRange(middle + 1, end), std::memory_order_release);
+                task = middle;
+                return true;
+            }
+        }
+    }
+    
+    return false;
+} // steal
@@ -0,0 +1,72 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+A small work-stealing thread pool for the CPU engine. Each call runs a range of
+    independent tasks, such as the tiles of one generation, split evenly across
+    the workers; a worker that runs out steals half of the remaining range of
+    another, so uneven tiles do not leave cores idle.
+*/
+
+#ifndef _AAPL_LIFE_WORKERS_H_
+#define _AAPL_LIFE_WORKERS_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace AAPL
+{
+    class LifeWorkers
+    {
+    public:
+        typedef std::function<void(uint32_t task, uint32_t worker)> Task;
+        
+        // A threadCount of 0 uses every hardware thread. The calling thread
+        // counts as one of the workers.
+        explicit LifeWorkers(uint32_t threadCount = 0);
+        ~LifeWorkers();
+        
+        LifeWorkers(const LifeWorkers&) = delete;
+        LifeWorkers& operator=(const LifeWorkers&) = delete;
+        
+        uint32_t workerCount() const { return _workerCount; }
+        
+        // Calls task for every index in [0, taskCount) and returns once all
+        // have finished. worker is in [0, workerCount()) and identifies the
+        // thread, for per-thread scratch memory. Calls must not be nested.
+        void run(uint32_t taskCount, const Task& task);
+        
+    private:
+        // Owned range of task indices, begin in the low and end in the high
+        // 32 bits, padded to a cache line so workers do not share lines
+        struct Queue
+        {
+            std::atomic<uint64_t> range;
+            char padding[64 - sizeof(std::atomic<uint64_t>)];
+        };
+        
+        void workerMain(uint32_t worker);
+        void work(uint32_t worker);
+        bool pop(uint32_t worker, uint32_t& task);
+        bool steal(uint32_t worker, uint32_t& task);
+        
+        uint32_t _workerCount;
+        std::vector<Queue> _queues;
+        std::vector<std::thread> _threads;
+        
+        std::mutex _mutex;
+        std::condition_variable _wake;
+        std::condition_variable _finished;
+        const Task *_task;
+        uint64_t _job;
+        uint32_t _busy;
+        bool _quit;
+    };
+} // AAPL
+
+#endif
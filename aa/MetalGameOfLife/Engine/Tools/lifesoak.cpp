@@ -0,0 +1,479 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Headless soak runner for the CPU Game of Life engine. Seeds a grid the way the
+    renderer does, runs it for a number of generations and reports throughput,
+    optionally checking every generation against the byte-per-cell reference.
+    With --hashlife the soup is instead placed in an unbounded HashLife universe,
+    and with --rule it is run under another rule by the rule-generic engine.
+    With --record every generation is recorded, then played back and checked,
+    and with --telemetry the engine's per-generation counters are summarized.
+    With --resize grids of random sizes are resized instead, each compared with
+    what the resize_game_state kernel writes.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "AAPLHashLife.h"
+#include "AAPLLifeGrid.h"
+#include "AAPLLifeRecording.h"
+#include "AAPLLifeRuleGrid.h"
+#include "AAPLLifeSeed.h"
+#include "AAPLLifeWorkers.h"
+
+static void printUsage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--width=N] [--height=N] [--generations=N] [--seed=N] [--threads=N]\n"
+            "          [--no-dead-age] [--reference] [--verify] [--hashlife] [--rule=RULE]\n"
+            "          [--record=FILE] [--telemetry] [--resize]\n"
+            "  --threads    worker threads for the packed engine, 0 for one per core\n"
+            "  --reference  also time the byte-per-cell reference stepper\n"
+            "  --verify     compare against the reference every generation\n"
+            "  --hashlife   run the soup in an unbounded HashLife universe instead\n"
+            "  --rule       run the soup under a rule such as B36/S23, B2/S345/C4 or\n"
+            "               R5,C0,M1,S34..58,B34..45,NM with the rule-generic engine\n"
+            "  --record     record every generation to a file, then check it by playing it back\n"
+            "  --telemetry  count births, deaths and active tiles as the engine steps\n"
+            "  --resize     check LifeResizeCells against resize_game_state over --generations\n"
+            "               random resizes, with and without the worker threads\n", name);
+}
+
+// What resize_game_state writes for each cell of the new grid, with the old
+// grid's origin worked out as the renderer works it out
+static void resizeCellsAsKernel(const uint8_t *oldCells, uint32_t oldWidth, uint32_t oldHeight, size_t oldBytesPerRow,
+                                uint8_t *cells, uint32_t width, uint32_t height, size_t bytesPerRow, uint64_t seed)
+{
+    int32_t oldOrigin[2] = {
+        ((int32_t)oldWidth - (int32_t)width) / 2,
+        ((int32_t)oldHeight - (int32_t)height) / 2,
+    };
+    AAPLLifeRandomKey key = AAPLLifeRandomKeyMake(seed);
+    
+    for (uint32_t y = 0; y < height; ++y)
+    {
+        for (uint32_t x = 0; x < width; ++x)
+        {
+            int32_t oldX = (int32_t)x + oldOrigin[0];
+            int32_t oldY = (int32_t)y + oldOrigin[1];
+            uint8_t cellValue;
+            
+            if (oldX >= 0 && oldY >= 0 && oldX < (int32_t)oldWidth && oldY < (int32_t)oldHeight)
+            {
+                cellValue = oldCells[(size_t)oldY * oldBytesPerRow + oldX];
+            }
+            else
+            {
+                uint32_t random = AAPLLifeRandomCell(key, x, y, AAPL_LIFE_RANDOM_STREAM_SEED, 0);
+                cellValue = random < AAPL_LIFE_INITIAL_ALIVE_THRESHOLD ? AAPL::kLifeCellAlive : AAPL::kLifeCellDead;
+            }
+            
+            cells[(size_t)y * bytesPerRow + x] = cellValue;
+        }
+    }
+} // resizeCellsAsKernel
+
+// Resizes grids of random sizes and dead ages, growing and shrinking each way
+// and with padded rows, and compares every one with the kernel
+static int checkResizes(uint32_t resizeCount, uint64_t seed, AAPL::LifeWorkers& workers)
+{
+    std::mt19937_64 random(seed);
+    std::uniform_int_distribution<uint32_t> size(1, 300);
+    std::uniform_int_distribution<uint32_t> padding(0, 16);
+    std::uniform_int_distribution<uint32_t> cellValue(0, 255);
+    uint64_t cellsChecked = 0;
+    
+    for (uint32_t i = 0; i < resizeCount; ++i)
+    {
+        uint32_t oldWidth = size(random), oldHeight = size(random);
+        uint32_t width = size(random), height = size(random);
+        size_t oldBytesPerRow = oldWidth + padding(random);
+        size_t bytesPerRow = width + padding(random);
+        uint64_t resizeSeed = random();
+        
+        std::vector<uint8_t> oldCells(oldBytesPerRow * oldHeight);
+        
+        for (uint8_t& cell : oldCells)
+        {
+            cell = (uint8_t)cellValue(random);
+        }
+        
+        // Padding is left as it was, so fill it with a value the resize never writes there
+        std::vector<uint8_t> expected(bytesPerRow * height, 0xA5);
+        std::vector<uint8_t> serial(expected);
+        std::vector<uint8_t> parallel(expected);
+        
+        resizeCellsAsKernel(oldCells.data(), oldWidth, oldHeight, oldBytesPerRow,
+                            expected.data(), width, height, bytesPerRow, resizeSeed);
+        AAPL::LifeResizeCells(oldCells.data(), oldWidth, oldHeight, oldBytesPerRow,
+                              serial.data(), width, height, bytesPerRow, resizeSeed);
+        AAPL::LifeResizeCells(oldCells.data(), oldWidth, oldHeight, oldBytesPerRow,
+                              parallel.data(), width, height, bytesPerRow, resizeSeed,
+                              AAPL_LIFE_INITIAL_ALIVE_THRESHOLD, &workers);
+        
+        if (serial != expected || parallel != expected)
+        {
+            fprintf(stderr, "Resizing %ux%u to %ux%u does not match resize_game_state%s\n", oldWidth, oldHeight,
+                    width, height, serial != expected ? "" : " with workers");
+            return 2;
+        }
+        
+        cellsChecked += (uint64_t)width * height;
+    }
+    
+    printf("Matched resize_game_state for %u resizes, %llu cells, with and without %u threads\n", resizeCount,
+           (unsigned long long)cellsChecked, workers.workerCount());
+    
+    return 0;
+} // checkResizes
+
+int main(int argc, char **argv)
+{
+    uint32_t width = 1024;
+    uint32_t height = 1024;
+    uint32_t generations = 1000;
+    uint64_t seed = 1;
+    uint32_t threadCount = 1;
+    bool tracksDeadAge = true;
+    bool runReference = false;
+    bool verify = false;
+    bool hashLife = false;
+    const char *ruleString = nullptr;
+    const char *recordingPath = nullptr;
+    bool telemetry = false;
+    bool resize = false;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        
+        if (!strncmp(arg, "--width=", 8)) width = (uint32_t)strtoul(arg + 8, NULL, 10);
+        else if (!strncmp(arg, "--height=", 9)) height = (uint32_t)strtoul(arg + 9, NULL, 10);
+        else if (!strncmp(arg, "--generations=", 14)) generations = (uint32_t)strtoul(arg + 14, NULL, 10);
+        else if (!strncmp(arg, "--seed=", 7)) seed = strtoull(arg + 7, NULL, 10);
+        else if (!strncmp(arg, "--threads=", 10)) threadCount = (uint32_t)strtoul(arg + 10, NULL, 10);
+        else if (!strcmp(arg, "--no-dead-age")) tracksDeadAge = false;
+        else if (!strcmp(arg, "--reference")) runReference = true;
+        else if (!strcmp(arg, "--verify")) verify = runReference = true;
+        else if (!strcmp(arg, "--hashlife")) hashLife = true;
+        else if (!strncmp(arg, "--rule=", 7)) ruleString = arg + 7;
+        else if (!strncmp(arg, "--record=", 9)) recordingPath = arg + 9;
+        else if (!strcmp(arg, "--telemetry")) telemetry = true;
+        else if (!strcmp(arg, "--resize")) resize = true;
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    AAPLLifeRule rule;
+    AAPLLifeRuleMakeLife(&rule);
+    
+    if (width == 0 || height == 0 || (ruleString && !AAPLLifeRuleParse(&rule, ruleString)))
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (resize)
+    {
+        // Always some workers, so that rows are split across them
+        AAPL::LifeWorkers resizeWorkers(std::max(threadCount, 4u));
+        
+        return checkResizes(generations, seed, resizeWorkers);
+    }
+    
+    size_t cellCount = (size_t)width * height;
+    std::vector<uint8_t> seedCells(cellCount);
+    AAPL::LifeWorkers workers(threadCount);
+    AAPL::LifeWorkers *gridWorkers = workers.workerCount() > 1 ? &workers : nullptr;
+    
+    // The same seed gives the same soup as the renderer on a grid of this size
+    AAPL::LifeSeedCells(seedCells.data(), width, height, width, seed, AAPL_LIFE_INITIAL_ALIVE_THRESHOLD, gridWorkers);
+    
+    auto now = []() { return std::chrono::steady_clock::now(); };
+    
+    if (hashLife)
+    {
+        // The soup is no longer a torus, so it differs from the grid once anything reaches an edge
+        AAPL::HashLife universe;
+        universe.loadCells(seedCells.data(), width, height, width, 0, 0);
+        
+        auto start = now();
+        universe.step(generations);
+        double seconds = std::chrono::duration<double>(now() - start).count();
+        
+        int64_t minX = 0, minY = 0, maxX = -1, maxY = -1;
+        universe.bounds(minX, minY, maxX, maxY);
+        
+        printf("%ux%u soup, %u generations, population %llu\n", width, height, generations,
+               (unsigned long long)universe.population());
+        printf("hashlife:  %10.3f s  %zu nodes, bounds %lldx%lld\n", seconds, universe.nodeCount(),
+               (long long)(maxX - minX + 1), (long long)(maxY - minY + 1));
+        
+        return 0;
+    }
+    
+    // The packed engine runs Life itself; any other rule needs the rule-generic one
+    std::unique_ptr<AAPL::LifeGrid> lifeGrid;
+    std::unique_ptr<AAPL::LifeRuleGrid> ruleGrid;
+    AAPL::LifeEngine *engine;
+    
+    if (ruleString)
+    {
+        ruleGrid.reset(new AAPL::LifeRuleGrid(rule, width, height, gridWorkers));
+        engine = ruleGrid.get();
+        tracksDeadAge = true;
+    }
+    else
+    {
+        lifeGrid.reset(new AAPL::LifeGrid(width, height, gridWorkers));
+        lifeGrid->setTracksDeadAge(tracksDeadAge);
+        engine = lifeGrid.get();
+    }
+    
+    engine->loadCells(seedCells.data(), width);
+    
+    // Keeps every generation of the run, so the whole run can be summarized
+    std::unique_ptr<AAPLLifeTelemetry, void (*)(AAPLLifeTelemetry *)> ring(nullptr, AAPLLifeTelemetryDestroy);
+    
+    if (telemetry)
+    {
+        ring.reset(AAPLLifeTelemetryCreate(std::max(generations, 1u)));
+        
+        if (ruleGrid)
+        {
+            ruleGrid->setTelemetry(ring.get());
+        }
+        else
+        {
+            lifeGrid->setTelemetry(ring.get());
+        }
+    }
+    
+    std::vector<uint8_t> reference(seedCells);
+    std::vector<uint8_t> referenceNext(cellCount);
+    std::vector<uint8_t> packedCells(cellCount);
+    double referenceSeconds = 0.0;
+    double packedSeconds = 0.0;
+    
+    // The recorder encodes and writes frames on its own thread, so recording
+    // costs the engine only a copy of each generation
+    AAPL::LifeRecorder recorder;
+    double recordingSeconds = 0.0;
+    
+    if (recordingPath && (!recorder.open(recordingPath, width, height) ||
+                          !recorder.record(seedCells.data(), width, engine->generation())))
+    {
+        fprintf(stderr, "Could not record to %s\n", recordingPath);
+        return 1;
+    }
+    
+    // Playback seeks back and forth through the run, so each seek either reads
+    // on from the last frame decoded or decodes from a keyframe, and compares
+    // every frame it lands on with the generation as it was recorded
+    const uint64_t seekTargets[] = {
+        generations / 2, generations / 3, generations, 0, generations ? generations - 1ull : 0,
+    };
+    const size_t seekCount = sizeof(seekTargets) / sizeof(seekTargets[0]);
+    std::vector<std::vector<uint8_t>> seekReferences(seekCount);
+    
+    for (size_t i = 0; recordingPath && i < seekCount; ++i)
+    {
+        if (seekTargets[i] == 0)
+            seekReferences[i] = seedCells;
+    }
+    
+    // When verifying or recording, step one generation at a time; otherwise
+    // time each engine in one go
+    uint32_t batch = (verify || recordingPath) ? 1 : generations;
+    
+    for (uint32_t done = 0; done < generations; done += batch)
+    {
+        auto start = now();
+        engine->step(batch);
+        packedSeconds += std::chrono::duration<double>(now() - start).count();
+        
+        if (recordingPath)
+        {
+            start = now();
+            engine->storeCells(packedCells.data(), width);
+            
+            if (!recorder.record(packedCells.data(), width, engine->generation()))
+            {
+                fprintf(stderr, "Could not record generation %llu\n", (unsigned long long)engine->generation());
+                return 1;
+            }
+            
+            for (size_t i = 0; i < seekCount; ++i)
+            {
+                if (seekTargets[i] == engine->generation())
+                    seekReferences[i] = packedCells;
+            }
+            
+            recordingSeconds += std::chrono::duration<double>(now() - start).count();
+        }
+        
+        if (runReference)
+        {
+            start = now();
+            
+            for (uint32_t i = 0; i < batch; ++i)
+            {
+                if (ruleString)
+                {
+                    AAPL::LifeStepRuleCells(rule, reference.data(), referenceNext.data(), width, height);
+                }
+                else
+                {
+                    AAPL::LifeStepCells(reference.data(), referenceNext.data(), width, height);
+                }
+                
+                reference.swap(referenceNext);
+            }
+            
+            referenceSeconds += std::chrono::duration<double>(now() - start).count();
+        }
+        
+        if (verify)
+        {
+            engine->storeCells(packedCells.data(), width);
+            
+            bool matches = tracksDeadAge ? (packedCells == reference) : true;
+            
+            for (size_t i = 0; matches && i < cellCount; ++i)
+            {
+                matches = (packedCells[i] == AAPL::kLifeCellAlive) == (reference[i] == AAPL::kLifeCellAlive);
+            }
+            
+            AAPLLifeGenerationStats stats;
+            
+            if (ring && (!AAPLLifeTelemetryLatest(ring.get(), &stats) || stats.population != engine->population()))
+            {
+                matches = false;
+            }
+            
+            if (!matches)
+            {
+                fprintf(stderr, "Mismatch with the reference at generation %llu\n",
+                        (unsigned long long)engine->generation());
+                return 2;
+            }
+        }
+    }
+    
+    double cellUpdates = (double)cellCount * generations;
+    
+    printf("%ux%u, %u generations, %u threads, population %llu\n", width, height, generations,
+           workers.workerCount(), (unsigned long long)engine->population());
+    
+    if (ruleGrid)
+    {
+        char ruleName[256];
+        AAPLLifeRuleFormat(&rule, ruleName, sizeof(ruleName));
+        
+        printf("rule:      %10.3f s  %10.1f Mcells/s  (%s)\n", packedSeconds,
+               cellUpdates / packedSeconds * 1e-6, ruleName);
+    }
+    else
+    {
+        printf("packed:    %10.3f s  %10.1f Mcells/s  (%u of %u tiles active)\n", packedSeconds,
+               cellUpdates / packedSeconds * 1e-6, lifeGrid->activeTileCount(), lifeGrid->tileCount());
+    }
+    
+    if (runReference)
+    {
+        printf("reference: %10.3f s  %10.1f Mcells/s  (%.1fx)\n", referenceSeconds,
+               cellUpdates / referenceSeconds * 1e-6, referenceSeconds / packedSeconds);
+    }
+    
+    if (verify)
+    {
+        printf("Matched the reference every generation\n");
+    }
+    
+    if (ring)
+    {
+        std::vector<AAPLLifeGenerationStats> history(generations);
+        uint64_t cursor = 0;
+        size_t count = AAPLLifeTelemetryCopySince(ring.get(), &cursor, history.data(), history.size());
+        
+        uint64_t births = 0, deaths = 0;
+        double stepSeconds = 0.0;
+        uint64_t settledGeneration = 0;
+        
+        // The run settled once no step after it had births or deaths
+        for (size_t i = 0; i < count; ++i)
+        {
+            births += history[i].births;
+            deaths += history[i].deaths;
+            stepSeconds += history[i].stepSeconds;
+            
+            if (history[i].births || history[i].deaths)
+            {
+                settledGeneration = history[i].generation;
+            }
+        }
+        
+        printf("telemetry: %10.3f s  %10llu births, %llu deaths, ", stepSeconds, (unsigned long long)births,
+               (unsigned long long)deaths);
+        
+        if (count && settledGeneration < history[count - 1].generation)
+        {
+            printf("still since generation %llu\n", (unsigned long long)settledGeneration);
+        }
+        else
+        {
+            printf("still changing\n");
+        }
+    }
+    
+    if (recordingPath)
+    {
+        auto start = now();
+        bool recorded = recorder.close();
+        recordingSeconds += std::chrono::duration<double>(now() - start).count();
+        
+        AAPL::LifeRecordingReader reader;
+        std::vector<uint8_t> playedCells(cellCount);
+        bool played = recorded && reader.open(recordingPath) && reader.frameCount() == generations + 1ull;
+        double seekSeconds = 0.0;
+        
+        for (size_t i = 0; played && i < seekCount; ++i)
+        {
+            start = now();
+            played = reader.seek(seekTargets[i], playedCells.data(), width);
+            seekSeconds += std::chrono::duration<double>(now() - start).count();
+            
+            if (played && playedCells != seekReferences[i])
+            {
+                fprintf(stderr, "Generation %llu of %s does not match the run\n",
+                        (unsigned long long)seekTargets[i], recordingPath);
+                return 2;
+            }
+        }
+        
+        if (!played)
+        {
+            fprintf(stderr, "The recording in %s does not play back\n", recordingPath);
+            return 2;
+        }
+        
+        uint64_t recordingBytes = recorder.bytesWritten();
+        
+        printf("recording: %10.3f s  %10.1f KB  (%.1fx smaller than raw frames, seeks in %.3f s)\n",
+               recordingSeconds, recordingBytes / 1024.0,
+               (double)cellCount * (generations + 1) / recordingBytes, seekSeconds);
+    }
+    
+    return 0;
+}
@@ -0,0 +1,239 @@
+/*
+See LICENSE.txt for this sample’s licensing information
+
+Abstract:
+Headless parameter sweep runner. Runs a batch of independent boards, every
+    seed in a range under every rule given, and prints a summary of each board
+    along with totals for the whole sweep. With --verify every board is also
+    run on its own by the byte-per-cell reference stepper and its summary
+    compared with the batch's.
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include "AAPLLifeBatch.h"
+#include "AAPLLifeRuleGrid.h"
+#include "AAPLLifeSeed.h"
+#include "AAPLLifeWorkers.h"
+
+static void printUsage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--width=N] [--height=N] [--generations=N] [--seeds=N] [--seed=N]\n"
+            "          [--threads=N] [--rule=RULE]... [--quiet] [--verify]\n"
+            "  --seeds      number of seeds to run, starting at --seed\n"
+            "  --rule       a rule to run every seed under; may be repeated, B3/S23 by default\n"
+            "  --threads    worker threads, 0 for one per core\n"
+            "  --quiet      print only the totals\n"
+            "  --verify     check every board's summary against the reference stepper\n", name);
+}
+
+// Steps a board a generation at a time with LifeStepRuleCells, keeping every
+// state, not just its hash, until one repeats. Every generation is stepped,
+// so the population at the end is not read from the cycle either.
+static AAPL::LifeBatchSummary referenceSummary(const AAPL::LifeBatchBoard& board, uint32_t generations)
+{
+    size_t cellCount = (size_t)board.width * board.height;
+    std::vector<uint8_t> cells(cellCount);
+    std::vector<uint8_t> nextCells(cellCount);
+    AAPL::LifeSeedCells(cells.data(), board.width, board.height, board.width, board.seed, board.aliveThreshold);
+    
+    // Dead ages past the last dying state do not affect the future
+    uint8_t dead = (uint8_t)(board.rule.states - 1);
+    std::map<std::vector<uint8_t>, uint64_t> seen;
+    std::vector<uint8_t> state(cellCount);
+    
+    AAPL::LifeBatchSummary summary;
+    memset(&summary, 0, sizeof(summary));
+    summary.extinctionGeneration = -1;
+    summary.generationsStepped = generations;
+    
+    for (uint32_t generation = 0;; ++generation)
+    {
+        uint64_t population = 0;
+        
+        for (size_t i = 0; i < cellCount; ++i)
+        {
+            population += cells[i] == AAPL::kLifeCellAlive;
+            state[i] = std::min(cells[i], dead);
+        }
+        
+        if (population > summary.peakPopulation)
+        {
+            summary.peakPopulation = population;
+            summary.peakGeneration = generation;
+        }
+        
+        if (population == 0 && summary.extinctionGeneration < 0)
+        {
+            summary.extinctionGeneration = generation;
+        }
+        
+        if (!summary.period)
+        {
+            auto repeat = seen.insert(std::make_pair(state, (uint64_t)generation));
+            
+            if (!repeat.second)
+            {
+                summary.cycleStart = repeat.first->second;
+                summary.period = (uint32_t)(generation - summary.cycleStart);
+                seen.clear();
+            }
+        }
+        
+        if (generation == generations)
+        {
+            summary.population = population;
+            break;
+        }
+        
+        AAPL::LifeStepRuleCells(board.rule, cells.data(), nextCells.data(), board.width, board.height);
+        cells.swap(nextCells);
+    }
+    
+    return summary;
+} // referenceSummary
+
+int main(int argc, char **argv)
+{
+    uint32_t width = 32;
+    uint32_t height = 32;
+    uint32_t generations = 1000;
+    uint32_t seedCount = 1000;
+    uint64_t firstSeed = 1;
+    uint32_t threadCount = 0;
+    bool quiet = false;
+    bool verify = false;
+    std::vector<AAPLLifeRule> rules;
+    
+    for (int i = 1; i < argc; ++i)
+    {
+        const char *arg = argv[i];
+        AAPLLifeRule rule;
+        
+        if (!strncmp(arg, "--width=", 8)) width = (uint32_t)strtoul(arg + 8, NULL, 10);
+        else if (!strncmp(arg, "--height=", 9)) height = (uint32_t)strtoul(arg + 9, NULL, 10);
+        else if (!strncmp(arg, "--generations=", 14)) generations = (uint32_t)strtoul(arg + 14, NULL, 10);
+        else if (!strncmp(arg, "--seeds=", 8)) seedCount = (uint32_t)strtoul(arg + 8, NULL, 10);
+        else if (!strncmp(arg, "--seed=", 7)) firstSeed = strtoull(arg + 7, NULL, 10);
+        else if (!strncmp(arg, "--threads=", 10)) threadCount = (uint32_t)strtoul(arg + 10, NULL, 10);
+        else if (!strncmp(arg, "--rule=", 7) && AAPLLifeRuleParse(&rule, arg + 7)) rules.push_back(rule);
+        else if (!strcmp(arg, "--quiet")) quiet = true;
+        else if (!strcmp(arg, "--verify")) verify = true;
+        else
+        {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    
+    if (width == 0 || height == 0)
+    {
+        printUsage(argv[0]);
+        return 1;
+    }
+    
+    if (rules.empty())
+    {
+        AAPLLifeRule life;
+        AAPLLifeRuleMakeLife(&life);
+        rules.push_back(life);
+    }
+    
+    std::vector<AAPL::LifeBatchBoard> boards;
+    
+    for (uint32_t seed = 0; seed < seedCount; ++seed)
+    {
+        for (const AAPLLifeRule& rule : rules)
+        {
+            boards.push_back(AAPL::LifeBatchBoard(width, height, firstSeed + seed, rule));
+        }
+    }
+    
+    AAPL::LifeWorkers workers(threadCount);
+    
+    auto start = std::chrono::steady_clock::now();
+    std::vector<AAPL::LifeBatchSummary> summaries = AAPL::LifeRunBatch(boards, generations, &workers);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    
+    uint64_t cellGenerations = 0;
+    uint32_t extinctCount = 0;
+    uint32_t cyclingCount = 0;
+    
+    if (!quiet)
+    {
+        printf("%5s %-30s %6s  %10s %5s %8s  %6s  %11s\n", "board", "rule", "seed", "population", "peak", "extinct",
+               "period", "cycle start");
+    }
+    
+    for (size_t i = 0; i < boards.size(); ++i)
+    {
+        const AAPL::LifeBatchBoard& board = boards[i];
+        const AAPL::LifeBatchSummary& summary = summaries[i];
+        
+        cellGenerations += (uint64_t)board.width * board.height * summary.generationsStepped;
+        extinctCount += summary.extinctionGeneration >= 0;
+        cyclingCount += summary.period != 0 && summary.extinctionGeneration < 0;
+        
+        if (!quiet)
+        {
+            char ruleName[256];
+            AAPLLifeRuleFormat(&board.rule, ruleName, sizeof(ruleName));
+            
+            printf("%5zu %-30s %6llu  %10llu %5llu %8lld  %6u  %11llu\n", i, ruleName,
+                   (unsigned long long)board.seed, (unsigned long long)summary.population,
+                   (unsigned long long)summary.peakPopulation, (long long)summary.extinctionGeneration,
+                   summary.period, (unsigned long long)summary.cycleStart);
+        }
+    }
+    
+    printf("%zu boards of %ux%u, %u generations, %u threads: %.3f s, %.1f Mcells/s\n", boards.size(), width, height,
+           generations, workers.workerCount(), seconds, cellGenerations / seconds * 1e-6);
+    printf("%u died out, %u settled into a cycle, %zu neither\n", extinctCount, cyclingCount,
+           boards.size() - extinctCount - cyclingCount);
+    
+    if (verify)
+    {
+        std::vector<AAPL::LifeBatchSummary> references(boards.size());
+        
+        workers.run((uint32_t)boards.size(), [&](uint32_t index, uint32_t) {
+            references[index] = referenceSummary(boards[index], generations);
+        });
+        
+        uint32_t mismatchCount = 0;
+        
+        for (size_t i = 0; i < boards.size(); ++i)
+        {
+            const AAPL::LifeBatchSummary& summary = summaries[i];
+            const AAPL::LifeBatchSummary& reference = references[i];
+            
+            if (summary.population != reference.population || summary.peakPopulation != reference.peakPopulation ||
+                summary.peakGeneration != reference.peakGeneration ||
+                summary.extinctionGeneration != reference.extinctionGeneration ||
+                summary.period != reference.period || summary.cycleStart != reference.cycleStart)
+            {
+                fprintf(stderr, "Board %zu: population %llu, period %u from %llu; the reference has %llu, period %u from %llu\n",
+                        i, (unsigned long long)summary.population, summary.period,
+                        (unsigned long long)summary.cycleStart, (unsigned long long)reference.population,
+                        reference.period, (unsigned long long)reference.cycleStart);
+                ++mismatchCount;
+            }
+        }
+        
+        if (mismatchCount)
+        {
+            fprintf(stderr, "%u of %zu boards do not match the reference\n", mismatchCount, boards.size());
+            return 2;
+        }
+        
+        printf("Matched the reference for every board\n");
+    }
+    
+    return 0;
+}
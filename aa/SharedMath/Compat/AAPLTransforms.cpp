@@ -0,0 +1,209 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ MetalVideoCapture's AAPL:: transforms implemented with SharedMath.
+  Replaces AAPLTransforms.mm; angles are in degrees and projections are
+  left-handed with clip z in [0, 1].
+ */
+
+#include "SharedMath.h"
+#include "AAPLTransforms.h"
+
+using namespace SharedMath;
+
+static simd::float4 AAPLFromVec4(const vec4& v)
+{
+    simd::float4 V = {v.x, v.y, v.z, v.w};
+    
+    return V;
+} // AAPLFromVec4
+
+static simd::float4x4 AAPLFromMat4(const mat4& m)
+{
+    return simd::float4x4(AAPLFromVec4(m.columns[0]),
+                          AAPLFromVec4(m.columns[1]),
+                          AAPLFromVec4(m.columns[2]),
+                          AAPLFromVec4(m.columns[3]));
+} // AAPLFromMat4
+
+static vec3 AAPLVec3(const simd::float3& v)
+{
+    return vec3(v.x, v.y, v.z);
+} // AAPLVec3
+
+float AAPL::radians(const float& degrees)
+{
+    return SharedMath::radians(degrees);
+} // radians
+
+simd::float4x4 AAPL::scale(const float& x,
+                           const float& y,
+                           const float& z)
+{
+    return AAPLFromMat4(scaling(vec3(x, y, z)));
+} // scale
+
+simd::float4x4 AAPL::scale(const simd::float3& s)
+{
+    return AAPLFromMat4(scaling(AAPLVec3(s)));
+} // scale
+
+simd::float4x4 AAPL::translate(const float& x,
+                               const float& y,
+                               const float& z)
+{
+    return AAPLFromMat4(translation(vec3(x, y, z)));
+} // translate
+
+simd::float4x4 AAPL::translate(const simd::float3& t)
+{
+    return AAPLFromMat4(translation(AAPLVec3(t)));
+} // translate
+
+simd::float4x4 AAPL::rotate(const float& angle,
+                            const float& x,
+                            const float& y,
+                            const float& z)
+{
+    return AAPLFromMat4(rotation(SharedMath::radians(angle), vec3(x, y, z)));
+} // rotate
+
+simd::float4x4 AAPL::rotate(const float& angle,
+                            const simd::float3& u)
+{
+    return AAPLFromMat4(rotation(SharedMath::radians(angle), AAPLVec3(u)));
+} // rotate
+
+simd::float4x4 AAPL::frustum(const float& fovH,
+                             const float& fovV,
+                             const float& near,
+                             const float& far)
+{
+    float width  = 1.0f / std::tan(SharedMath::radians(0.5f * fovH));
+    float height = 1.0f / std::tan(SharedMath::radians(0.5f * fovV));
+    float sDepth = far / (far - near);
+    
+    return AAPLFromMat4(mat4(vec4(width, 0.0f, 0.0f, 0.0f),
+                             vec4(0.0f, height, 0.0f, 0.0f),
+                             vec4(0.0f, 0.0f, sDepth, 1.0f),
+                             vec4(0.0f, 0.0f, -sDepth * near, 0.0f)));
+} // frustum
+
+simd::float4x4 AAPL::frustum(const float& left,
+                             const float& right,
+                             const float& bottom,
+                             const float& top,
+                             const float& near,
+                             const float& far)
+{
+    float sDepth = far / (far - near);
+    
+    return AAPLFromMat4(mat4(vec4(right - left, 0.0f, 0.0f, 0.0f),
+                             vec4(0.0f, top - bottom, 0.0f, 0.0f),
+                             vec4(0.0f, 0.0f, sDepth, 1.0f),
+                             vec4(0.0f, 0.0f, -sDepth * near, 0.0f)));
+} // frustum
+
+simd::float4x4 AAPL::frustum_oc(const float& left,
+                                const float& right,
+                                const float& bottom,
+                                const float& top,
+                                const float& near,
+                                const float& far)
+{
+    float sWidth  = 1.0f / (right - left);
+    float sHeight = 1.0f / (top   - bottom);
+    float sDepth  = far  / (far   - near);
+    float dNear   = 2.0f * near;
+    
+    return AAPLFromMat4(mat4(vec4(dNear * sWidth, 0.0f, 0.0f, 0.0f),
+                             vec4(0.0f, dNear * sHeight, 0.0f, 0.0f),
+                             vec4(-sWidth * (right + left), -sHeight * (top + bottom), sDepth, 1.0f),
+                             vec4(0.0f, 0.0f, -sDepth * near, 0.0f)));
+} // frustum_oc
+
+simd::float4x4 AAPL::lookAt(const float * const pEye,
+                            const float * const pCenter,
+                            const float * const pUp)
+{
+    return AAPLFromMat4(lookAtLH(vec3(pEye[0], pEye[1], pEye[2]),
+                                 vec3(pCenter[0], pCenter[1], pCenter[2]),
+                                 vec3(pUp[0], pUp[1], pUp[2])));
+} // lookAt
+
+simd::float4x4 AAPL::lookAt(const simd::float3& eye,
+                            const simd::float3& center,
+                            const simd::float3& up)
+{
+    return AAPLFromMat4(lookAtLH(AAPLVec3(eye), AAPLVec3(center), AAPLVec3(up)));
+} // lookAt
+
+simd::float4x4 AAPL::perspective(const float& width,
+                                 const float& height,
+                                 const float& near,
+                                 const float& far)
+{
+    float zNear = 2.0f * near;
+    float zFar  = far / (far - near);
+    
+    return AAPLFromMat4(mat4(vec4(zNear / width, 0.0f, 0.0f, 0.0f),
+                             vec4(0.0f, zNear / height, 0.0f, 0.0f),
+                             vec4(0.0f, 0.0f, zFar, 1.0f),
+                             vec4(0.0f, 0.0f, -near * zFar, 0.0f)));
+} // perspective
+
+simd::float4x4 AAPL::perspective_fov(const float& fovy,
+                                     const float& aspect,
+                                     const float& near,
+                                     const float& far)
+{
+    return AAPLFromMat4(perspectiveLH(SharedMath::radians(fovy), aspect, near, far));
+} // perspective_fov
+
+simd::float4x4 AAPL::perspective_fov(const float& fovy,
+                                     const float& width,
+                                     const float& height,
+                                     const float& near,
+                                     const float& far)
+{
+    return AAPLFromMat4(perspectiveLH(SharedMath::radians(fovy), width / height, near, far));
+} // perspective_fov
+
+simd::float4x4 AAPL::ortho2d_oc(const float& left,
+                                const float& right,
+                                const float& bottom,
+                                const float& top,
+                                const float& near,
+                                const float& far)
+{
+    return AAPLFromMat4(orthoLH(left, right, bottom, top, near, far));
+} // ortho2d_oc
+
+simd::float4x4 AAPL::ortho2d_oc(const simd::float3& origin,
+                                const simd::float3& size)
+{
+    return AAPLFromMat4(orthoLH(origin.x, origin.y, origin.z, size.x, size.y, size.z));
+} // ortho2d_oc
+
+// Unlike ortho2d_oc, the original ignores the center of the volume in x and y
+simd::float4x4 AAPL::ortho2d(const float& left,
+                             const float& right,
+                             const float& bottom,
+                             const float& top,
+                             const float& near,
+                             const float& far)
+{
+    mat4 M = orthoLH(left, right, bottom, top, near, far);
+    
+    M.columns[3].x = 0.0f;
+    M.columns[3].y = 0.0f;
+    
+    return AAPLFromMat4(M);
+} // ortho2d
+
+simd::float4x4 AAPL::ortho2d(const simd::float3& origin,
+                             const simd::float3& size)
+{
+    return AAPL::ortho2d(origin.x, origin.y, origin.z, size.x, size.y, size.z);
+} // ortho2d
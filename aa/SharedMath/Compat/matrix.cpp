@@ -0,0 +1,74 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ VideoSnake's mat4f_ API implemented with SharedMath.  Replaces matrix.c;
+  angles are in radians and the output matrix is the last argument.
+ */
+
+#include "SharedMath.h"
+
+#include <string.h>
+
+extern "C" {
+#include "matrix.h"
+}
+
+using namespace SharedMath;
+
+static inline void mat4f_Store(float* mout, const mat4& m)
+{
+	memcpy(mout, &m, sizeof(m));
+}
+
+void mat4f_LoadIdentity(float* m)
+{
+	mat4f_Store(m, identity());
+}
+
+// s is a 3D vector
+void mat4f_LoadScale(float* s, float* m)
+{
+	mat4f_Store(m, scaling(vec3(s[0], s[1], s[2])));
+}
+
+void mat4f_LoadXRotation(float radians, float* mout)
+{
+	mat4f_Store(mout, rotationX(radians));
+}
+
+void mat4f_LoadYRotation(float radians, float* mout)
+{
+	mat4f_Store(mout, rotationY(radians));
+}
+
+void mat4f_LoadZRotation(float radians, float* mout)
+{
+	mat4f_Store(mout, rotationZ(radians));
+}
+
+// v is a 3D vector
+void mat4f_LoadTranslation(float* v, float* mout)
+{
+	mat4f_Store(mout, translation(vec3(v[0], v[1], v[2])));
+}
+
+void mat4f_LoadPerspective(float fov_radians, float aspect, float zNear, float zFar, float* mout)
+{
+	mat4f_Store(mout, perspectiveRH(fov_radians, aspect, zNear, zFar));
+}
+
+void mat4f_LoadOrtho(float left, float right, float bottom, float top, float near, float far, float* mout)
+{
+	mat4f_Store(mout, orthoRH(left, right, bottom, top, near, far));
+}
+
+void mat4f_MultiplyMat4f(const float* a, const float* b, float* mout)
+{
+	mat4 lhs, rhs;
+	
+	memcpy(&lhs, a, sizeof(lhs));
+	memcpy(&rhs, b, sizeof(rhs));
+	
+	mat4f_Store(mout, lhs * rhs);
+}
@@ -0,0 +1,297 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ GLEssentials' matrixUtil API implemented with SharedMath.  Replaces
+  matrixUtil.c; matrices are column major float[16] and angles are in
+  degrees or radians as documented in matrixUtil.h.
+ */
+
+#include "SharedMath.h"
+
+#include <string.h>
+#include <math.h>
+
+extern "C" {
+#include "matrixUtil.h"
+}
+
+using namespace SharedMath;
+
+static inline mat4 mtxLoad(const float* src)
+{
+	mat4 m;
+	
+	memcpy(&m, src, sizeof(m));
+	
+	return m;
+}
+
+static inline void mtxStore(float* mtx, const mat4& m)
+{
+	memcpy(mtx, &m, sizeof(m));
+}
+
+// matrixUtil converts degrees in double precision
+static inline float mtxRadians(float deg)
+{
+	return (float)(deg * (M_PI/180.0));
+}
+
+// matrixUtil's Y rotations turn the opposite way from rotationY
+static inline mat4 mtxRotationY(float rad)
+{
+	return rotationY(-rad);
+}
+
+// Rotations about a single axis take the shortcuts mtxRotateApply does,
+// which ignore the direction of the axis
+static inline mat4 mtxRotation(float deg, float xAxis, float yAxis, float zAxis)
+{
+	float rad = mtxRadians(deg);
+	
+	if(yAxis == 0.0f && zAxis == 0.0f)
+	{
+		return rotationX(rad);
+	}
+	else if(xAxis == 0.0f && zAxis == 0.0f)
+	{
+		return mtxRotationY(rad);
+	}
+	else if(xAxis == 0.0f && yAxis == 0.0f)
+	{
+		return rotationZ(rad);
+	}
+	
+	return rotation(rad, vec3(xAxis, yAxis, zAxis));
+}
+
+void mtxMultiply(float* ret, const float* lhs, const float* rhs)
+{
+	mtxStore(ret, mtxLoad(lhs) * mtxLoad(rhs));
+}
+
+void mtxLoadIdentity(float* mtx)
+{
+	mtxStore(mtx, identity());
+}
+
+void mtxTranspose(float* mtx, const float* src)
+{
+	mtxStore(mtx, transpose(mtxLoad(src)));
+}
+
+void mtxInvert(float* mtx, const float* src)
+{
+	mtxStore(mtx, inverse(mtxLoad(src)));
+}
+
+void mtxLoadPerspective(float* mtx, float fov, float aspect, float nearZ, float farZ)
+{
+	mtxStore(mtx, perspectiveRH(mtxRadians(fov), aspect, nearZ, farZ));
+}
+
+void mtxLoadOrthographic(float* mtx,
+						 float left, float right,
+						 float bottom, float top,
+						 float nearZ, float farZ)
+{
+	mtxStore(mtx, orthoRH(left, right, bottom, top, nearZ, farZ));
+}
+
+static inline float sgn(float val)
+{
+	return (val > 0.0f) ? 1.0f : ((val < 0.0f) ? -1.0f : 0.0f);
+}
+
+void mtxModifyObliqueProjection(float* mtx, const float* src, const float* plane)
+{
+	mat4 m = mtxLoad(src);
+	vec4 p(plane[0], plane[1], plane[2], plane[3]);
+	
+	vec4 q((sgn(p.x) + m.columns[2].x) / m.columns[0].x,
+		   (sgn(p.y) + m.columns[2].y) / m.columns[1].y,
+		   -1.0f,
+		   (1.0f + m.columns[2].z) / m.columns[3].z);
+	
+	vec4 c = p * (2.0f / dot(p, q));
+	
+	// Replace the third row of the projection matrix
+	m.columns[0].z = c.x;
+	m.columns[1].z = c.y;
+	m.columns[2].z = c.z;
+	m.columns[3].z = c.w;
+	
+	mtxStore(mtx, m);
+}
+
+void mtxLoadTranslate(float* mtx, float xTrans, float yTrans, float zTrans)
+{
+	mtxStore(mtx, translation(vec3(xTrans, yTrans, zTrans)));
+}
+
+void mtxLoadScale(float* mtx, float xScale, float yScale, float zScale)
+{
+	mtxStore(mtx, scaling(vec3(xScale, yScale, zScale)));
+}
+
+void mtxLoadRotate(float* mtx, float deg, float xAxis, float yAxis, float zAxis)
+{
+	mtxStore(mtx, mtxRotation(deg, xAxis, yAxis, zAxis));
+}
+
+void mtxLoadRotateX(float* mtx, float rad)
+{
+	mtxStore(mtx, rotationX(rad));
+}
+
+void mtxLoadRotateY(float* mtx, float rad)
+{
+	mtxStore(mtx, mtxRotationY(rad));
+}
+
+void mtxLoadRotateZ(float* mtx, float rad)
+{
+	mtxStore(mtx, rotationZ(rad));
+}
+
+void mtxTranslateApply(float* mtx, float xTrans, float yTrans, float zTrans)
+{
+	mtxStore(mtx, mtxLoad(mtx) * translation(vec3(xTrans, yTrans, zTrans)));
+}
+
+void mtxScaleApply(float* mtx, float xScale, float yScale, float zScale)
+{
+	mtxStore(mtx, mtxLoad(mtx) * scaling(vec3(xScale, yScale, zScale)));
+}
+
+void mtxRotateApply(float* mtx, float deg, float xAxis, float yAxis, float zAxis)
+{
+	mtxStore(mtx, mtxLoad(mtx) * mtxRotation(deg, xAxis, yAxis, zAxis));
+}
+
+void mtxRotateXApply(float* mtx, float deg)
+{
+	mtxStore(mtx, mtxLoad(mtx) * rotationX(mtxRadians(deg)));
+}
+
+void mtxRotateYApply(float* mtx, float deg)
+{
+	mtxStore(mtx, mtxLoad(mtx) * mtxRotationY(mtxRadians(deg)));
+}
+
+void mtxRotateZApply(float* mtx, float deg)
+{
+	mtxStore(mtx, mtxLoad(mtx) * rotationZ(mtxRadians(deg)));
+}
+
+void mtxTranslateMatrix(float* mtx, float xTrans, float yTrans, float zTrans)
+{
+	mtxStore(mtx, translation(vec3(xTrans, yTrans, zTrans)) * mtxLoad(mtx));
+}
+
+void mtxScaleMatrix(float* mtx, float xScale, float yScale, float zScale)
+{
+	mtxStore(mtx, scaling(vec3(xScale, yScale, zScale)) * mtxLoad(mtx));
+}
+
+void mtxRotateMatrix(float* mtx, float rad, float xAxis, float yAxis, float zAxis)
+{
+	mtxStore(mtx, mtxRotation(degrees(rad), xAxis, yAxis, zAxis) * mtxLoad(mtx));
+}
+
+void mtxRotateXMatrix(float* mtx, float rad)
+{
+	mtxStore(mtx, rotationX(rad) * mtxLoad(mtx));
+}
+
+void mtxRotateYMatrix(float* mtx, float rad)
+{
+	mtxStore(mtx, mtxRotationY(rad) * mtxLoad(mtx));
+}
+
+void mtxRotateZMatrix(float* mtx, float rad)
+{
+	mtxStore(mtx, rotationZ(rad) * mtxLoad(mtx));
+}
+
+// SharedMath has no 3x3 type; these are small enough to keep as they were
+
+void mtx3x3LoadIdentity(float* mtx)
+{
+	mtx[0] = mtx[4] = mtx[8] = 1.0f;
+	
+	mtx[1] = mtx[2] = mtx[3] =
+	mtx[5] = mtx[6] = mtx[7] = 0.0f;
+}
+
+void mtx3x3Multiply(float* mtx, const float* lhs, const float* rhs)
+{
+	float tmp[9];
+	int column, row;
+	
+	for(column = 0; column < 3; column++)
+	{
+		for(row = 0; row < 3; row++)
+		{
+			tmp[column * 3 + row] = lhs[row] * rhs[column * 3] +
+									lhs[row + 3] * rhs[column * 3 + 1] +
+									lhs[row + 6] * rhs[column * 3 + 2];
+		}
+	}
+	
+	memcpy(mtx, tmp, sizeof(tmp));
+}
+
+void mtx3x3FromTopLeftOf4x4(float* mtx, const float* src)
+{
+	mtx[0] = src[0];
+	mtx[1] = src[1];
+	mtx[2] = src[2];
+	mtx[3] = src[4];
+	mtx[4] = src[5];
+	mtx[5] = src[6];
+	mtx[6] = src[8];
+	mtx[7] = src[9];
+	mtx[8] = src[10];
+}
+
+void mtx3x3Transpose(float* mtx, const float* src)
+{
+	float tmp;
+	mtx[0] = src[0];
+	mtx[4] = src[4];
+	mtx[8] = src[8];
+	
+	tmp = src[1];
+	mtx[1] = src[3];
+	mtx[3] = tmp;
+	
+	tmp = src[2];
+	mtx[2] = src[6];
+	mtx[6] = tmp;
+	
+	tmp = src[5];
+	mtx[5] = src[7];
+	mtx[7] = tmp;
+}
+
+void mtx3x3Invert(float* mtx, const float* src)
+{
+	// The inverse is the transpose of the normal matrix
+	vec3 x(src[0], src[1], src[2]);
+	vec3 y(src[3], src[4], src[5]);
+	vec3 z(src[6], src[7], src[8]);
+	float det = dot(x, cross(y, z));
+	
+	if(fabsf(det) < 0.0005f)
+	{
+		mtx3x3LoadIdentity(mtx);
+		return;
+	}
+	
+	mat4 n = transpose(normalMatrix(mat4(vec4(x, 0.0f), vec4(y, 0.0f), vec4(z, 0.0f),
+										 vec4(0.0f, 0.0f, 0.0f, 1.0f))));
+	
+	mtx3x3FromTopLeftOf4x4(mtx, n.data());
+}
@@ -0,0 +1,606 @@
+/*
+ See LICENSE.txt for this sample’s licensing information
+
+ Abstract:
+ Header-only vector, matrix and quaternion math shared by the samples.
+
+  Conventions:
+   - Matrices are column major, as OpenGL, Metal and simd expect, and
+     multiply column vectors: v' = M * v.
+   - Angles are in radians; use radians() to convert from degrees.
+   - Projections come in two flavors: RH builds a right-handed OpenGL
+     projection with clip z in [-1, 1] (matrixUtil, mat4f_*), LH builds a
+     left-handed Metal projection with clip z in [0, 1] (AAPL::).
+
+  Construction and most vector math is constexpr.  Matrix products and
+  transforms use SSE or NEON when available; their multiplies and adds are
+  never fused, so results match the scalar code in matrixUtil.c bit for bit.
+
+  Compatibility shims that implement the samples' existing APIs on top of
+  this header are in Compat/.
+ */
+
+#ifndef _SHARED_MATH_H_
+#define _SHARED_MATH_H_
+
+#include <cmath>
+
+#if defined(__SSE__) || defined(_M_X64)
+#define SHARED_MATH_SSE 1
+#include <xmmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define SHARED_MATH_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace SharedMath
+{
+    static constexpr float kPi = 3.14159265358979323846f;
+    
+    constexpr float radians(float degrees)
+    {
+        return degrees * (kPi / 180.0f);
+    }
+    
+    constexpr float degrees(float radians)
+    {
+        return radians * (180.0f / kPi);
+    }
+    
+#pragma mark - Types
+    
+    // Packed like float[3] so that it can be used in place of the existing
+    // float* vector arrays; SIMD math is done on vec4, quat and mat4
+    struct vec3
+    {
+        float x, y, z;
+        
+        vec3() = default;
+        constexpr vec3(float x_, float y_, float z_) : x(x_), y(y_), z(z_) {}
+    };
+    
+    struct alignas(16) vec4
+    {
+        float x, y, z, w;
+        
+        vec4() = default;
+        constexpr vec4(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+        constexpr vec4(const vec3& v, float w_) : x(v.x), y(v.y), z(v.z), w(w_) {}
+        
+        constexpr vec3 xyz() const { return vec3(x, y, z); }
+    };
+    
+    // Same layout as float[16], GLfloat[16] and simd::float4x4
+    struct alignas(16) mat4
+    {
+        vec4 columns[4];
+        
+        mat4() = default;
+        constexpr mat4(const vec4& c0, const vec4& c1, const vec4& c2, const vec4& c3) : columns{c0, c1, c2, c3} {}
+        
+        // Diagonal matrix
+        constexpr explicit mat4(const vec4& d) :
+            columns{vec4(d.x, 0.0f, 0.0f, 0.0f), vec4(0.0f, d.y, 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, d.z, 0.0f), vec4(0.0f, 0.0f, 0.0f, d.w)} {}
+        
+        const float* data() const { return &columns[0].x; }
+        float* data() { return &columns[0].x; }
+    };
+    
+    // Unit quaternion (x, y, z) * sin(angle / 2) + w * cos(angle / 2)
+    struct alignas(16) quat
+    {
+        float x, y, z, w;
+        
+        quat() = default;
+        constexpr quat(float x_, float y_, float z_, float w_) : x(x_), y(y_), z(z_), w(w_) {}
+    };
+    
+#pragma mark - vec3
+    
+    constexpr vec3 operator+(const vec3& a, const vec3& b) { return vec3(a.x + b.x, a.y + b.y, a.z + b.z); }
+    constexpr vec3 operator-(const vec3& a, const vec3& b) { return vec3(a.x - b.x, a.y - b.y, a.z - b.z); }
+    constexpr vec3 operator-(const vec3& a) { return vec3(-a.x, -a.y, -a.z); }
+    constexpr vec3 operator*(const vec3& a, const vec3& b) { return vec3(a.x * b.x, a.y * b.y, a.z * b.z); }
+    constexpr vec3 operator*(const vec3& a, float s) { return vec3(a.x * s, a.y * s, a.z * s); }
+    constexpr vec3 operator*(float s, const vec3& a) { return vec3(a.x * s, a.y * s, a.z * s); }
+    
+    constexpr float dot(const vec3& a, const vec3& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z;
+    }
+    
+    constexpr vec3 cross(const vec3& a, const vec3& b)
+    {
+        return vec3(a.y * b.z - a.z * b.y,
+                    a.z * b.x - a.x * b.z,
+                    a.x * b.y - a.y * b.x);
+    }
+    
+    inline float length(const vec3& a)
+    {
+        return std::sqrt(dot(a, a));
+    }
+    
+    // Zero length vectors are returned unchanged
+    inline vec3 normalize(const vec3& a)
+    {
+        float lengthSquared = dot(a, a);
+        
+        return (lengthSquared > 0.0f) ? a * (1.0f / std::sqrt(lengthSquared)) : a;
+    }
+    
+#pragma mark - vec4
+    
+    constexpr vec4 operator+(const vec4& a, const vec4& b) { return vec4(a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w); }
+    constexpr vec4 operator-(const vec4& a, const vec4& b) { return vec4(a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w); }
+    constexpr vec4 operator*(const vec4& a, float s) { return vec4(a.x * s, a.y * s, a.z * s, a.w * s); }
+    constexpr vec4 operator*(float s, const vec4& a) { return vec4(a.x * s, a.y * s, a.z * s, a.w * s); }
+    
+    constexpr float dot(const vec4& a, const vec4& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+    
+#pragma mark - mat4 construction
+    
+    constexpr mat4 identity()
+    {
+        return mat4(vec4(1.0f, 1.0f, 1.0f, 1.0f));
+    }
+    
+    constexpr mat4 translation(const vec3& t)
+    {
+        return mat4(vec4(1.0f, 0.0f, 0.0f, 0.0f),
+                    vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, 1.0f, 0.0f),
+                    vec4(t, 1.0f));
+    }
+    
+    constexpr mat4 scaling(const vec3& s)
+    {
+        return mat4(vec4(s, 1.0f));
+    }
+    
+    constexpr mat4 transpose(const mat4& m)
+    {
+        return mat4(vec4(m.columns[0].x, m.columns[1].x, m.columns[2].x, m.columns[3].x),
+                    vec4(m.columns[0].y, m.columns[1].y, m.columns[2].y, m.columns[3].y),
+                    vec4(m.columns[0].z, m.columns[1].z, m.columns[2].z, m.columns[3].z),
+                    vec4(m.columns[0].w, m.columns[1].w, m.columns[2].w, m.columns[3].w));
+    }
+    
+    // Rotation about the axis, which need not be unit length
+    inline mat4 rotation(float angle, const vec3& axis)
+    {
+        vec3 u = normalize(axis);
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        float k = 1.0f - c;
+        
+        return mat4(vec4(u.x * u.x * k + c,       u.x * u.y * k + u.z * s, u.x * u.z * k - u.y * s, 0.0f),
+                    vec4(u.x * u.y * k - u.z * s, u.y * u.y * k + c,       u.y * u.z * k + u.x * s, 0.0f),
+                    vec4(u.x * u.z * k + u.y * s, u.y * u.z * k - u.x * s, u.z * u.z * k + c,       0.0f),
+                    vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+    inline mat4 rotationX(float angle)
+    {
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        
+        return mat4(vec4(1.0f, 0.0f, 0.0f, 0.0f), vec4(0.0f, c, s, 0.0f),
+                    vec4(0.0f, -s, c, 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+    inline mat4 rotationY(float angle)
+    {
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        
+        return mat4(vec4(c, 0.0f, -s, 0.0f), vec4(0.0f, 1.0f, 0.0f, 0.0f),
+                    vec4(s, 0.0f, c, 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+    inline mat4 rotationZ(float angle)
+    {
+        float s = std::sin(angle);
+        float c = std::cos(angle);
+        
+        return mat4(vec4(c, s, 0.0f, 0.0f), vec4(-s, c, 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, 1.0f, 0.0f), vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+#pragma mark - Projections
+    
+    // OpenGL: right-handed, clip z in [-1, 1] (gluPerspective)
+    inline mat4 perspectiveRH(float fovy, float aspect, float near, float far)
+    {
+        float f = 1.0f / std::tan(fovy / 2.0f);
+        
+        return mat4(vec4(f / aspect, 0.0f, 0.0f, 0.0f),
+                    vec4(0.0f, f, 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, (far + near) / (near - far), -1.0f),
+                    vec4(0.0f, 0.0f, 2 * far * near / (near - far), 0.0f));
+    }
+    
+    // Metal: left-handed, clip z in [0, 1]
+    inline mat4 perspectiveLH(float fovy, float aspect, float near, float far)
+    {
+        float yScale = 1.0f / std::tan(0.5f * fovy);
+        float zScale = far / (far - near);
+        
+        return mat4(vec4(yScale / aspect, 0.0f, 0.0f, 0.0f),
+                    vec4(0.0f, yScale, 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, zScale, 1.0f),
+                    vec4(0.0f, 0.0f, -near * zScale, 0.0f));
+    }
+    
+    // OpenGL: right-handed, clip z in [-1, 1] (glOrtho)
+    constexpr mat4 orthoRH(float left, float right, float bottom, float top, float near, float far)
+    {
+        return mat4(vec4(2.0f / (right - left), 0.0f, 0.0f, 0.0f),
+                    vec4(0.0f, 2.0f / (top - bottom), 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, -2.0f / (far - near), 0.0f),
+                    vec4(-(right + left) / (right - left),
+                         -(top + bottom) / (top - bottom),
+                         -(far + near) / (far - near), 1.0f));
+    }
+    
+    // Metal: left-handed, clip z in [0, 1]
+    constexpr mat4 orthoLH(float left, float right, float bottom, float top, float near, float far)
+    {
+        return mat4(vec4(2.0f * (1.0f / (right - left)), 0.0f, 0.0f, 0.0f),
+                    vec4(0.0f, 2.0f * (1.0f / (top - bottom)), 0.0f, 0.0f),
+                    vec4(0.0f, 0.0f, 1.0f / (far - near), 0.0f),
+                    vec4(-(1.0f / (right - left)) * (left + right),
+                         -(1.0f / (top - bottom)) * (top + bottom),
+                         -(1.0f / (far - near)) * near, 1.0f));
+    }
+    
+    // View matrix looking down +z (left-handed)
+    inline mat4 lookAtLH(const vec3& eye, const vec3& center, const vec3& up)
+    {
+        vec3 zAxis = normalize(center - eye);
+        vec3 xAxis = normalize(cross(up, zAxis));
+        vec3 yAxis = cross(zAxis, xAxis);
+        
+        return mat4(vec4(xAxis.x, yAxis.x, zAxis.x, 0.0f),
+                    vec4(xAxis.y, yAxis.y, zAxis.y, 0.0f),
+                    vec4(xAxis.z, yAxis.z, zAxis.z, 0.0f),
+                    vec4(-dot(xAxis, eye), -dot(yAxis, eye), -dot(zAxis, eye), 1.0f));
+    }
+    
+    // View matrix looking down -z (right-handed, gluLookAt)
+    inline mat4 lookAtRH(const vec3& eye, const vec3& center, const vec3& up)
+    {
+        vec3 zAxis = normalize(eye - center);
+        vec3 xAxis = normalize(cross(up, zAxis));
+        vec3 yAxis = cross(zAxis, xAxis);
+        
+        return mat4(vec4(xAxis.x, yAxis.x, zAxis.x, 0.0f),
+                    vec4(xAxis.y, yAxis.y, zAxis.y, 0.0f),
+                    vec4(xAxis.z, yAxis.z, zAxis.z, 0.0f),
+                    vec4(-dot(xAxis, eye), -dot(yAxis, eye), -dot(zAxis, eye), 1.0f));
+    }
+    
+#pragma mark - mat4 products
+    
+#if SHARED_MATH_SSE
+    
+    inline mat4 operator*(const mat4& a, const mat4& b)
+    {
+        __m128 a0 = _mm_load_ps(&a.columns[0].x);
+        __m128 a1 = _mm_load_ps(&a.columns[1].x);
+        __m128 a2 = _mm_load_ps(&a.columns[2].x);
+        __m128 a3 = _mm_load_ps(&a.columns[3].x);
+        mat4 m;
+        
+        for(int column = 0; column < 4; column++)
+        {
+            const vec4& bc = b.columns[column];
+            __m128 r = _mm_mul_ps(a0, _mm_set1_ps(bc.x));
+            
+            r = _mm_add_ps(r, _mm_mul_ps(a1, _mm_set1_ps(bc.y)));
+            r = _mm_add_ps(r, _mm_mul_ps(a2, _mm_set1_ps(bc.z)));
+            r = _mm_add_ps(r, _mm_mul_ps(a3, _mm_set1_ps(bc.w)));
+            
+            _mm_store_ps(&m.columns[column].x, r);
+        }
+        
+        return m;
+    }
+    
+    inline vec4 operator*(const mat4& a, const vec4& v)
+    {
+        __m128 r = _mm_mul_ps(_mm_load_ps(&a.columns[0].x), _mm_set1_ps(v.x));
+        vec4 result;
+        
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&a.columns[1].x), _mm_set1_ps(v.y)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&a.columns[2].x), _mm_set1_ps(v.z)));
+        r = _mm_add_ps(r, _mm_mul_ps(_mm_load_ps(&a.columns[3].x), _mm_set1_ps(v.w)));
+        
+        _mm_store_ps(&result.x, r);
+        
+        return result;
+    }
+    
+#elif SHARED_MATH_NEON
+    
+    // vmlaq may be fused on some cores, so multiplies and adds stay separate
+    inline mat4 operator*(const mat4& a, const mat4& b)
+    {
+        float32x4_t a0 = vld1q_f32(&a.columns[0].x);
+        float32x4_t a1 = vld1q_f32(&a.columns[1].x);
+        float32x4_t a2 = vld1q_f32(&a.columns[2].x);
+        float32x4_t a3 = vld1q_f32(&a.columns[3].x);
+        mat4 m;
+        
+        for(int column = 0; column < 4; column++)
+        {
+            const vec4& bc = b.columns[column];
+            float32x4_t r = vmulq_n_f32(a0, bc.x);
+            
+            r = vaddq_f32(r, vmulq_n_f32(a1, bc.y));
+            r = vaddq_f32(r, vmulq_n_f32(a2, bc.z));
+            r = vaddq_f32(r, vmulq_n_f32(a3, bc.w));
+            
+            vst1q_f32(&m.columns[column].x, r);
+        }
+        
+        return m;
+    }
+    
+    inline vec4 operator*(const mat4& a, const vec4& v)
+    {
+        float32x4_t r = vmulq_n_f32(vld1q_f32(&a.columns[0].x), v.x);
+        vec4 result;
+        
+        r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&a.columns[1].x), v.y));
+        r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&a.columns[2].x), v.z));
+        r = vaddq_f32(r, vmulq_n_f32(vld1q_f32(&a.columns[3].x), v.w));
+        
+        vst1q_f32(&result.x, r);
+        
+        return result;
+    }
+    
+#else
+    
+    inline vec4 operator*(const mat4& a, const vec4& v)
+    {
+        return a.columns[0] * v.x + a.columns[1] * v.y + a.columns[2] * v.z + a.columns[3] * v.w;
+    }
+    
+    inline mat4 operator*(const mat4& a, const mat4& b)
+    {
+        return mat4(a * b.columns[0], a * b.columns[1], a * b.columns[2], a * b.columns[3]);
+    }
+    
+#endif
+    
+    // Transforms a point (w = 1)
+    inline vec3 transformPoint(const mat4& m, const vec3& p)
+    {
+        return (m * vec4(p, 1.0f)).xyz();
+    }
+    
+    // Transforms a direction (w = 0)
+    inline vec3 transformVector(const mat4& m, const vec3& v)
+    {
+        return (m * vec4(v, 0.0f)).xyz();
+    }
+    
+#pragma mark - mat4 inverses
+    
+    // General inverse by cofactors; a singular matrix gives the identity
+    inline mat4 inverse(const mat4& m)
+    {
+        const float* a = m.data();
+        
+        // 2x2 determinants of the bottom two rows and of the top two rows
+        float s0 = a[0] * a[5] - a[4] * a[1];
+        float s1 = a[0] * a[9] - a[8] * a[1];
+        float s2 = a[0] * a[13] - a[12] * a[1];
+        float s3 = a[4] * a[9] - a[8] * a[5];
+        float s4 = a[4] * a[13] - a[12] * a[5];
+        float s5 = a[8] * a[13] - a[12] * a[9];
+        
+        float c5 = a[10] * a[15] - a[14] * a[11];
+        float c4 = a[6] * a[15] - a[14] * a[7];
+        float c3 = a[6] * a[11] - a[10] * a[7];
+        float c2 = a[2] * a[15] - a[14] * a[3];
+        float c1 = a[2] * a[11] - a[10] * a[3];
+        float c0 = a[2] * a[7] - a[6] * a[3];
+        
+        float det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+        
+        if(0.0f == det)
+        {
+            return identity();
+        }
+        
+        float r = 1.0f / det;
+        
+        return mat4(vec4(( a[5] * c5 - a[9] * c4 + a[13] * c3) * r,
+                         (-a[1] * c5 + a[9] * c2 - a[13] * c1) * r,
+                         ( a[1] * c4 - a[5] * c2 + a[13] * c0) * r,
+                         (-a[1] * c3 + a[5] * c1 - a[9] * c0) * r),
+                    vec4((-a[4] * c5 + a[8] * c4 - a[12] * c3) * r,
+                         ( a[0] * c5 - a[8] * c2 + a[12] * c1) * r,
+                         (-a[0] * c4 + a[4] * c2 - a[12] * c0) * r,
+                         ( a[0] * c3 - a[4] * c1 + a[8] * c0) * r),
+                    vec4(( a[7] * s5 - a[11] * s4 + a[15] * s3) * r,
+                         (-a[3] * s5 + a[11] * s2 - a[15] * s1) * r,
+                         ( a[3] * s4 - a[7] * s2 + a[15] * s0) * r,
+                         (-a[3] * s3 + a[7] * s1 - a[11] * s0) * r),
+                    vec4((-a[6] * s5 + a[10] * s4 - a[14] * s3) * r,
+                         ( a[2] * s5 - a[10] * s2 + a[14] * s1) * r,
+                         (-a[2] * s4 + a[6] * s2 - a[14] * s0) * r,
+                         ( a[2] * s3 - a[6] * s1 + a[10] * s0) * r));
+    }
+    
+    // Inverse of a matrix whose bottom row is 0 0 0 1
+    inline mat4 inverseAffine(const mat4& m)
+    {
+        vec3 x = m.columns[0].xyz();
+        vec3 y = m.columns[1].xyz();
+        vec3 z = m.columns[2].xyz();
+        vec3 t = m.columns[3].xyz();
+        
+        // The rows of the inverse are the cross products of pairs of columns
+        vec3 r0 = cross(y, z);
+        vec3 r1 = cross(z, x);
+        vec3 r2 = cross(x, y);
+        float det = dot(x, r0);
+        
+        if(0.0f == det)
+        {
+            return identity();
+        }
+        
+        float r = 1.0f / det;
+        
+        r0 = r0 * r;
+        r1 = r1 * r;
+        r2 = r2 * r;
+        
+        return mat4(vec4(r0.x, r1.x, r2.x, 0.0f),
+                    vec4(r0.y, r1.y, r2.y, 0.0f),
+                    vec4(r0.z, r1.z, r2.z, 0.0f),
+                    vec4(-dot(r0, t), -dot(r1, t), -dot(r2, t), 1.0f));
+    }
+    
+    // Inverse of rotations, reflections and translations only
+    constexpr mat4 inverseRigid(const mat4& m)
+    {
+        return mat4(vec4(m.columns[0].x, m.columns[1].x, m.columns[2].x, 0.0f),
+                    vec4(m.columns[0].y, m.columns[1].y, m.columns[2].y, 0.0f),
+                    vec4(m.columns[0].z, m.columns[1].z, m.columns[2].z, 0.0f),
+                    vec4(-dot(m.columns[0].xyz(), m.columns[3].xyz()),
+                         -dot(m.columns[1].xyz(), m.columns[3].xyz()),
+                         -dot(m.columns[2].xyz(), m.columns[3].xyz()), 1.0f));
+    }
+    
+    // Inverse transpose of the upper 3x3, for transforming normals; the
+    // remaining elements are those of the identity
+    inline mat4 normalMatrix(const mat4& m)
+    {
+        vec3 x = m.columns[0].xyz();
+        vec3 y = m.columns[1].xyz();
+        vec3 z = m.columns[2].xyz();
+        
+        // The columns of the inverse transpose are the cross products
+        vec3 c0 = cross(y, z);
+        vec3 c1 = cross(z, x);
+        vec3 c2 = cross(x, y);
+        float det = dot(x, c0);
+        
+        if(0.0f == det)
+        {
+            return identity();
+        }
+        
+        float r = 1.0f / det;
+        
+        return mat4(vec4(c0 * r, 0.0f), vec4(c1 * r, 0.0f), vec4(c2 * r, 0.0f),
+                    vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+#pragma mark - quat
+    
+    constexpr quat identityQuat()
+    {
+        return quat(0.0f, 0.0f, 0.0f, 1.0f);
+    }
+    
+    inline quat quatFromAxisAngle(const vec3& axis, float angle)
+    {
+        vec3 v = normalize(axis) * std::sin(0.5f * angle);
+        
+        return quat(v.x, v.y, v.z, std::cos(0.5f * angle));
+    }
+    
+    constexpr quat conjugate(const quat& q)
+    {
+        return quat(-q.x, -q.y, -q.z, q.w);
+    }
+    
+    constexpr float dot(const quat& a, const quat& b)
+    {
+        return a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    }
+    
+    // Applies b then a
+    constexpr quat operator*(const quat& a, const quat& b)
+    {
+        return quat(a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+                    a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+                    a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w,
+                    a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z);
+    }
+    
+    inline quat normalize(const quat& q)
+    {
+        float r = 1.0f / std::sqrt(dot(q, q));
+        
+        return quat(q.x * r, q.y * r, q.z * r, q.w * r);
+    }
+    
+    constexpr vec3 rotate(const quat& q, const vec3& v)
+    {
+        // v + 2w(u x v) + 2u x (u x v), with u the vector part of q
+        return v + cross(vec3(q.x, q.y, q.z), v) * (2.0f * q.w) +
+               cross(vec3(q.x, q.y, q.z), cross(vec3(q.x, q.y, q.z), v)) * 2.0f;
+    }
+    
+    constexpr mat4 rotation(const quat& q)
+    {
+        return mat4(vec4(1.0f - 2.0f * (q.y * q.y + q.z * q.z), 2.0f * (q.x * q.y + q.z * q.w),
+                         2.0f * (q.x * q.z - q.y * q.w), 0.0f),
+                    vec4(2.0f * (q.x * q.y - q.z * q.w), 1.0f - 2.0f * (q.x * q.x + q.z * q.z),
+                         2.0f * (q.y * q.z + q.x * q.w), 0.0f),
+                    vec4(2.0f * (q.x * q.z + q.y * q.w), 2.0f * (q.y * q.z - q.x * q.w),
+                         1.0f - 2.0f * (q.x * q.x + q.y * q.y), 0.0f),
+                    vec4(0.0f, 0.0f, 0.0f, 1.0f));
+    }
+    
+    // Normalized linear interpolation along the shorter arc; cheap and
+    // close to slerp for nearby rotations
+    inline quat nlerp(const quat& a, const quat& b, float t)
+    {
+        float s = (dot(a, b) < 0.0f) ? -t : t;
+        
+        return normalize(quat(a.x + (b.x * s - a.x * t), a.y + (b.y * s - a.y * t),
+                              a.z + (b.z * s - a.z * t), a.w + (b.w * s - a.w * t)));
+    }
+    
+    // Spherical linear interpolation along the shorter arc
+    inline quat slerp(const quat& a, const quat& b, float t)
+    {
+        float cosTheta = dot(a, b);
+        float sign = 1.0f;
+        
+        if(cosTheta < 0.0f)
+        {
+            cosTheta = -cosTheta;
+            sign = -1.0f;
+        }
+        
+        // Nearly parallel quaternions would divide by a tiny sine
+        if(cosTheta > 0.9995f)
+        {
+            return nlerp(a, b, t);
+        }
+        
+        float theta = std::acos(cosTheta);
+        float r = 1.0f / std::sin(theta);
+        float wa = std::sin((1.0f - t) * theta) * r;
+        float wb = std::sin(t * theta) * r * sign;
+        
+        return quat(a.x * wa + b.x * wb, a.y * wa + b.y * wb,
+                    a.z * wa + b.z * wb, a.w * wa + b.w * wb);
+    }
+} // SharedMath
+
+#endif
@@ -7,8 +7,8 @@
 #import <Foundation/Foundation.h>
 #import <CoreMedia/CMSampleBuffer.h>
 #import <CoreMedia/CMSync.h>
-
-@class CMDeviceMotion;
+#include "MotionSyncCore.h"
+#include "PipelineStage.h"
 
 @protocol MotionSynchronizationDelegate;
 
@@ -18,16 +18,21 @@
 @property(nonatomic, retain) __attribute__((NSObject)) CMClockRef sampleBufferClock; // safe to update if you aren't concurrently calling appendSampleBufferForSynchronization:
 
 - (void)start;
-- (void)stop;
+- (void)stop; // releases the sample buffers still waiting, synchronously with the delegate queue; don't call from the delegate queue
 
 - (void)appendSampleBufferForSynchronization:(CMSampleBufferRef)sampleBuffer;
 - (void)setSynchronizedSampleBufferDelegate:(id<MotionSynchronizationDelegate>)sampleBufferDelegate queue:(dispatch_queue_t)sampleBufferCallbackQueue;
 
+// Counters for each stage, with latencies in seconds on the motion clock: frames handed from the caller's queue to the delegate queue and held there for motion,
+// motion handed from CoreMotion, and frames through the delegate, whose service time is the delegate's and whose latency is from capture to the delegate returning
+- (void)getFrameStageStats:(PipelineStageStats *)frameStats motionStageStats:(PipelineStageStats *)motionStats outputStageStats:(PipelineStageStats *)outputStats;
+
 @end
 
 @protocol MotionSynchronizationDelegate <NSObject>
 
 @required
-- (void)motionSynchronizer:(MotionSynchronizer *)synchronizer didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer withMotion:(CMDeviceMotion*)motion;
+// motion is interpolated to the sample buffer's timestamp on the motion clock, and is NULL if no motion is available
+- (void)motionSynchronizer:(MotionSynchronizer *)synchronizer didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer withMotion:(const MotionSample *)motion;
 
 @end
@@ -0,0 +1,336 @@
+
+/*
+ <codex/>
+ */
+
+#import "MotionSynchronizer.h"
+#import <CoreMotion/CoreMotion.h>
+#include "MotionSyncCore.h"
+#include "PipelineStage.h"
+
+#define MOTION_DEFAULT_SAMPLES_PER_SECOND 60
+#define MEDIA_ARRAY_SIZE 5
+#define MOTION_ARRAY_SIZE 64
+#define FRAME_STAGE_SIZE 4
+#define FRAME_LATENCY_BUDGET 0.2 // seconds from capture; older frames are dropped rather than rendered late
+
+// When a frame was taken off the frame stage. Frames leave the synchronizer core in the order they enter it.
+struct HeldFrame {
+	double timestamp;
+	double startTime;
+};
+
+BOOL LOG = YES;
+
+@interface MotionSynchronizer () {
+	id<MotionSynchronizationDelegate> _delegate;
+	dispatch_queue_t _delegateCallbackQueue;
+	
+	// Frames and motion are handed from the video and motion queues to the delegate queue through lock-free stages,
+	// and _drainSource drains them there. The synchronizer core and the held frames are only touched on the delegate queue.
+	// _drainSource retains the synchronizer from -start until -stop cancels it.
+	VideoSnake::PipelineStage<CMSampleBufferRef> *_frameStage;
+	VideoSnake::PipelineStage<MotionSample> *_motionStage;
+	VideoSnake::PipelineStageCounters *_outputCounters;
+	VideoSnake::MotionSyncCore *_syncCore;
+	VideoSnake::TimestampRing<HeldFrame> *_heldFrames;
+	dispatch_source_t _drainSource;
+}
+
+@property(nonatomic, retain) __attribute__((NSObject)) CMClockRef motionClock;
+@property(nonatomic, retain) NSOperationQueue *motionQueue;
+@property(nonatomic, retain) CMMotionManager *motionManager;
+
+@end
+
+@implementation MotionSynchronizer
+
+- (id)init
+{
+    self = [super init];
+    if (self != nil) {
+		
+		_frameStage = new VideoSnake::PipelineStage<CMSampleBufferRef>(FRAME_STAGE_SIZE, PipelineDropOldest, FRAME_LATENCY_BUDGET);
+		_motionStage = new VideoSnake::PipelineStage<MotionSample>(MOTION_ARRAY_SIZE, PipelineDropOldest);
+		_outputCounters = new VideoSnake::PipelineStageCounters();
+		_syncCore = new VideoSnake::MotionSyncCore(MEDIA_ARRAY_SIZE, MOTION_ARRAY_SIZE);
+		_heldFrames = new VideoSnake::TimestampRing<HeldFrame>(MEDIA_ARRAY_SIZE + 1);
+		
+		_motionQueue = [[NSOperationQueue alloc] init];
+		[_motionQueue setMaxConcurrentOperationCount:1]; // Serial queue
+		
+		_motionManager = [[CMMotionManager alloc] init];
+
+		[self setMotionRate:MOTION_DEFAULT_SAMPLES_PER_SECOND];
+		
+		_motionClock = CMClockGetHostTimeClock();
+		if (_motionClock)
+			CFRetain(_motionClock);
+	}
+	
+	return self;
+}
+
+- (void)dealloc
+{	
+	[_motionManager release];
+	[_motionQueue release];
+	// The drain source has been cancelled and its handlers have finished, so nothing else can reach the stages
+	[self discardPipeline];
+	delete _frameStage;
+	delete _motionStage;
+	delete _outputCounters;
+	delete _syncCore;
+	delete _heldFrames;
+	[_delegateCallbackQueue release];
+	
+	if (_sampleBufferClock)
+		CFRelease(_sampleBufferClock);
+	if (_motionClock)
+		CFRelease(_motionClock);
+	
+	[super dealloc];
+}
+
+- (void)start
+{
+	if ( !self.motionManager.deviceMotionActive ) {
+		if ( self.sampleBufferClock == NULL ) {
+			@throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"No sample buffer clock. Please set one before calling start." userInfo:nil];
+			return;
+		}
+		
+		if ( self.motionManager.deviceMotionAvailable ) {
+			CMDeviceMotionHandler motionHandler = ^(CMDeviceMotion *motion, NSError *error) {
+				if ( !error )
+					[self appendMotionSampleForSynchronization:motion];
+				else
+					NSLog(@"%@", error);
+			};
+			
+			[self.motionManager startDeviceMotionUpdatesToQueue:self.motionQueue withHandler:motionHandler];
+		}
+	}
+	
+	if ( _delegateCallbackQueue && !_drainSource )
+		[self startDrainingOnQueue:_delegateCallbackQueue];
+}
+
+- (void)stop
+{
+	if ( self.motionManager.deviceMotionActive ) {
+		[self.motionManager stopDeviceMotionUpdates]; // no new blocks will be enqueued to self.motionQueue
+		[self.motionQueue waitUntilAllOperationsAreFinished];
+	}
+	
+	// Frames already output have been released by the time this returns; release those still waiting
+	if ( _delegateCallbackQueue ) {
+		dispatch_sync(_delegateCallbackQueue, ^{
+			[self stopDraining];
+			[self discardPipeline];
+		});
+	}
+}
+
+- (int)motionRate
+{
+	int motionHz = 1.0 / self.motionManager.deviceMotionUpdateInterval;
+	return motionHz;
+}
+
+- (void)setMotionRate:(int)motionRate
+{
+	NSTimeInterval updateIntervalSeconds = 1.0 / motionRate;
+	[self.motionManager setDeviceMotionUpdateInterval:updateIntervalSeconds];
+}
+
+- (double)currentTime
+{
+	return CMTimeGetSeconds(CMClockGetTime(self.motionClock));
+}
+
+/*
+ Outputs media samples with synchronized motion samples
+ 
+ Runs on the delegate queue whenever the video or motion queue has handed over a sample. Motion is taken first, then frames one at a time.
+ The synchronizer core outputs a frame as soon as a motion sample at or after its timestamp arrives, with motion interpolated between the two motion samples either side of it, found by binary search.
+ If MEDIA_ARRAY_SIZE frames are already waiting for motion, the oldest frame is output with the newest motion sample at hand.
+ */
+- (void)drainPipeline
+{
+	double now = [self currentTime];
+	
+	VideoSnake::PipelineStage<MotionSample>::Entry motionEntry;
+	while ( _motionStage->pop(motionEntry, now) == VideoSnake::PipelineStage<MotionSample>::Ready ) {
+		_syncCore->appendMotion(motionEntry.item);
+		_motionStage->complete(motionEntry, now, now);
+	}
+	
+	VideoSnake::PipelineStage<CMSampleBufferRef>::Entry frameEntry;
+	VideoSnake::PipelineStage<CMSampleBufferRef>::PopResult popped;
+	while ( ( popped = _frameStage->pop(frameEntry, now) ) != VideoSnake::PipelineStage<CMSampleBufferRef>::Empty ) {
+		if ( popped == VideoSnake::PipelineStage<CMSampleBufferRef>::Stale ) {
+			CFRelease(frameEntry.item);
+			continue;
+		}
+		
+		// Every frame appended is followed by outputting those made ready, so the core always has room
+		HeldFrame heldFrame = {frameEntry.captureTime, now};
+		_syncCore->appendMedia(frameEntry.captureTime, (void *)frameEntry.item);
+		_heldFrames->push(heldFrame);
+		[self outputSynchronizedSampleBuffers];
+	}
+	
+	// New motion alone can make frames ready
+	[self outputSynchronizedSampleBuffers];
+}
+
+- (void)outputSynchronizedSampleBuffers
+{
+	VideoSnake::SyncedMedia synced;
+	
+	while ( _syncCore->nextSynced(synced) ) {
+		CMSampleBufferRef sampleBuffer = (CMSampleBufferRef)synced.context;
+		double startTime = [self currentTime];
+		
+		// The frame stage's service time is the time spent waiting for motion
+		VideoSnake::PipelineStage<CMSampleBufferRef>::Entry frameEntry = {sampleBuffer, synced.timestamp, 0.0};
+		_frameStage->complete(frameEntry, _heldFrames->front().startTime, startTime);
+		_heldFrames->pop();
+		
+		@autoreleasepool {
+			[_delegate motionSynchronizer:self didOutputSampleBuffer:sampleBuffer withMotion:synced.hasMotion ? &synced.motion : NULL];
+		}
+		CFRelease(sampleBuffer);
+		
+		_outputCounters->recordCompletion(synced.timestamp, startTime, [self currentTime]);
+	}
+}
+
+// Releases every frame not yet output and forgets all motion. Called on the delegate queue, or once nothing else uses the synchronizer.
+- (void)discardPipeline
+{
+	double now = [self currentTime];
+	
+	VideoSnake::PipelineStage<MotionSample>::Entry motionEntry;
+	while ( _motionStage->pop(motionEntry, now) != VideoSnake::PipelineStage<MotionSample>::Empty )
+		;
+	_syncCore->clearMotion();
+	
+	VideoSnake::PipelineStage<CMSampleBufferRef>::Entry frameEntry;
+	while ( _frameStage->pop(frameEntry, now) != VideoSnake::PipelineStage<CMSampleBufferRef>::Empty )
+		CFRelease(frameEntry.item);
+	
+	void *context;
+	while ( _syncCore->takePendingMedia(context) )
+		CFRelease((CMSampleBufferRef)context);
+	_heldFrames->clear();
+}
+
+static void DrainPipelineHandler(void *context)
+{
+	[(MotionSynchronizer *)context drainPipeline];
+}
+
+static void DrainSourceCancelHandler(void *context)
+{
+	[(MotionSynchronizer *)context release];
+}
+
+// Handing over a sample merges into a pending drain rather than queuing a block per sample.
+// The source keeps the synchronizer alive until its cancel handler runs, after any drain in progress.
+- (void)startDrainingOnQueue:(dispatch_queue_t)queue
+{
+	_drainSource = dispatch_source_create(DISPATCH_SOURCE_TYPE_DATA_ADD, 0, 0, queue);
+	dispatch_set_context(_drainSource, [self retain]);
+	dispatch_source_set_event_handler_f(_drainSource, DrainPipelineHandler);
+	dispatch_source_set_cancel_handler_f(_drainSource, DrainSourceCancelHandler);
+	dispatch_resume(_drainSource);
+}
+
+// Called on the delegate queue, so no drain is running
+- (void)stopDraining
+{
+	if ( _drainSource ) {
+		dispatch_source_cancel(_drainSource);
+		[_drainSource release];
+		_drainSource = NULL;
+	}
+}
+
+- (void)appendMotionSampleForSynchronization:(CMDeviceMotion*)motion
+{
+	MotionSample sample;
+	CMQuaternion attitude = motion.attitude.quaternion;
+	
+	sample.timestamp = motion.timestamp;
+	sample.attitude[0] = attitude.x;
+	sample.attitude[1] = attitude.y;
+	sample.attitude[2] = attitude.z;
+	sample.attitude[3] = attitude.w;
+	sample.rotationRate[0] = motion.rotationRate.x;
+	sample.rotationRate[1] = motion.rotationRate.y;
+	sample.rotationRate[2] = motion.rotationRate.z;
+	sample.gravity[0] = motion.gravity.x;
+	sample.gravity[1] = motion.gravity.y;
+	sample.gravity[2] = motion.gravity.z;
+	sample.userAcceleration[0] = motion.userAcceleration.x;
+	sample.userAcceleration[1] = motion.userAcceleration.y;
+	sample.userAcceleration[2] = motion.userAcceleration.z;
+	
+	// The oldest motion is dropped if the delegate queue falls behind; the core only needs the newest
+	MotionSample evicted;
+	_motionStage->push(sample, sample.timestamp, [self currentTime], evicted);
+	if ( _drainSource )
+		dispatch_source_merge_data(_drainSource, 1);
+}
+
+- (void)appendSampleBufferForSynchronization:(CMSampleBufferRef)sampleBuffer
+{
+	// Convert media timestamp to motion clock if necessary (i.e. we're recording audio, so media timestamps have been synced to the audio clock)
+	CMTime mediaTime = CMSampleBufferGetPresentationTimeStamp(sampleBuffer);
+	if ( self.sampleBufferClock && self.motionClock ) {
+		if ( !CFEqual(self.sampleBufferClock, self.motionClock) ) {
+			mediaTime = CMSyncConvertTime(mediaTime, self.sampleBufferClock, self.motionClock);
+		}
+	}
+	
+	// If the delegate queue falls behind, the oldest frame waiting is dropped to keep the preview current
+	CMSampleBufferRef evicted = NULL;
+	CFRetain(sampleBuffer);
+	if ( _frameStage->push(sampleBuffer, CMTimeGetSeconds(mediaTime), [self currentTime], evicted) == VideoSnake::PipelineQueuedEvictingOldest )
+		CFRelease(evicted);
+	if ( _drainSource )
+		dispatch_source_merge_data(_drainSource, 1);
+}
+
+- (void)getFrameStageStats:(PipelineStageStats *)frameStats motionStageStats:(PipelineStageStats *)motionStats outputStageStats:(PipelineStageStats *)outputStats
+{
+	if ( frameStats )
+		_frameStage->getStats(*frameStats);
+	if ( motionStats )
+		_motionStage->getStats(*motionStats);
+	if ( outputStats )
+		_outputCounters->getStats(*outputStats, 0);
+}
+
+- (void)setSynchronizedSampleBufferDelegate:(id<MotionSynchronizationDelegate>)sampleBufferDelegate queue:(dispatch_queue_t)sampleBufferCallbackQueue
+{
+	_delegate = sampleBufferDelegate;
+	
+	if ( sampleBufferCallbackQueue != _delegateCallbackQueue ) {
+		dispatch_queue_t oldQueue = _delegateCallbackQueue;
+		_delegateCallbackQueue = sampleBufferCallbackQueue;
+		
+		if (sampleBufferCallbackQueue)
+			[sampleBufferCallbackQueue retain];
+		if (oldQueue)
+			[oldQueue release];
+		
+		// The drain source is created by -start; one already running follows the new queue
+		if ( sampleBufferCallbackQueue && _drainSource )
+			dispatch_set_target_queue(_drainSource, sampleBufferCallbackQueue);
+	}
+}
+
+@end
@@ -8,6 +8,7 @@
 
 #import <CoreMedia/CMFormatDescription.h>
 #import <CoreMedia/CMSampleBuffer.h>
+#include "FrameTiming.h"
 
 @protocol MovieRecorderDelegate;
 
@@ -29,6 +30,9 @@
 
 - (void)finishRecording; // Asynchronous, might take several hundred milliseconds. When finished the delegate's recorderDidFinishRecording: or recorder:didFailWithError: method will be called.
 
+// Pacing of the video frames appended to the movie, by presentation time; frames dropped because the writer was not ready show up as gaps
+- (void)getVideoTimingStats:(FrameTimingStats *)stats;
+
 @end
 
 @protocol MovieRecorderDelegate <NSObject>
@@ -47,6 +47,7 @@ typedef NS_ENUM( NSInteger, MovieRecorderStatus ) {
 	CMFormatDescriptionRef _videoTrackSourceFormatDescription;
 	CGAffineTransform _videoTrackTransform;
 	AVAssetWriterInput *_videoInput;
+	FrameTimingWindowRef _videoTiming;
 }
 @end
 
@@ -66,6 +67,7 @@ typedef NS_ENUM( NSInteger, MovieRecorderStatus ) {
 		_writingQueue = dispatch_queue_create( "com.apple.sample.movierecorder.writing", DISPATCH_QUEUE_SERIAL );
 		_videoTrackTransform = CGAffineTransformIdentity;
 		_URL = [URL retain];
+		_videoTiming = FrameTimingWindowCreate( 1.0, 0.0, 256 );
 	}
 	return self;
 }
@@ -290,9 +292,16 @@ typedef NS_ENUM( NSInteger, MovieRecorderStatus ) {
 
 	[_URL release];
 	
+	FrameTimingWindowRelease( _videoTiming );
+	
 	[super dealloc];
 }
 
+- (void)getVideoTimingStats:(FrameTimingStats *)stats
+{
+	FrameTimingWindowGetStats( _videoTiming, stats );
+}
+
 #pragma mark -
 #pragma mark Internal
 
@@ -332,6 +341,9 @@ typedef NS_ENUM( NSInteger, MovieRecorderStatus ) {
 			
 			if ( input.readyForMoreMediaData ) {
 				BOOL success = [input appendSampleBuffer:sampleBuffer];
+				if ( success && input == _videoInput ) {
+					FrameTimingWindowAddFrame( _videoTiming, CMTimeGetSeconds( CMSampleBufferGetPresentationTimeStamp( sampleBuffer ) ) );
+				}
 				if ( ! success ) {
 					NSError *error = _assetWriter.error;
 					@synchronized( self ) {
@@ -9,6 +9,7 @@
     
 #include <OpenGLES/ES2/gl.h>
 #include <OpenGLES/ES2/glext.h>
+#include <stdint.h>
 
 GLint glueCompileShader(GLenum target, GLsizei count, const GLchar **sources, GLuint *shader);
 GLint glueLinkProgram(GLuint program);
@@ -22,4 +23,18 @@ GLint glueCreateProgram(const GLchar *vertSource, const GLchar *fragSource,
                         GLint *uniformLocations,
                         GLuint *program);
 
+/* Shader Cache */
+uint64_t glueHashProgram(const GLchar *defines, const GLchar *vertSource, const GLchar *fragSource,
+                         GLsizei attribNameCt, const GLchar **attribNames, const GLint *attribLocations);
+GLint glueLoadProgramBinary(const char *path, uint64_t hash, GLuint program);
+GLint glueSaveProgramBinary(const char *path, uint64_t hash, GLuint program);
+
+GLint glueCreateProgramCached(const char *cacheDirectory, const GLchar *defines,
+                              const GLchar *vertSource, const GLchar *fragSource,
+                              GLsizei attribNameCt, const GLchar **attribNames,
+                              const GLint *attribLocations,
+                              GLsizei uniformNameCt, const GLchar **uniformNames,
+                              GLint *uniformLocations,
+                              GLuint *program);
+
 #endif
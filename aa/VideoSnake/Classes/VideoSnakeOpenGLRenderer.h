@@ -6,14 +6,14 @@
 #import <Foundation/Foundation.h>
 #import <CoreMedia/CoreMedia.h>
 #import <CoreVideo/CoreVideo.h>
-#import <CoreMotion/CoreMotion.h>
+#import "MotionSyncCore.h"
 
 @interface VideoSnakeOpenGLRenderer : NSObject
 
 - (void)prepareWithOutputDimensions:(CMVideoDimensions)outputDimensions retainedBufferCountHint:(size_t)retainedBufferCountHint;
 - (void)reset;
 
-- (CVPixelBufferRef)copyRenderedPixelBuffer:(CVPixelBufferRef)pixelBuffer motion:(CMDeviceMotion *)motion;
+- (CVPixelBufferRef)copyRenderedPixelBuffer:(CVPixelBufferRef)pixelBuffer motion:(const MotionSample *)motion; // motion may be NULL
 
 @property(nonatomic, assign) BOOL shouldMirrorMotion;
 @property(nonatomic, readonly) CMFormatDescriptionRef __attribute__((NSObject)) outputFormatDescription; // non-NULL once the renderer has been prepared
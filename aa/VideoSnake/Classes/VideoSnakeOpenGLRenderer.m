@@ -8,6 +8,7 @@
 #import <OpenGLES/EAGL.h>
 #import "ShaderUtilities.h"
 #import "matrix.h"
+#include "SnakeRenderer.h"
 
 enum {
     ATTRIB_VERTEX,
@@ -86,6 +87,7 @@ static void PreallocatePixelBuffersInPool( CVPixelBufferPoolRef pool, CFDictiona
 	CFDictionaryRef _bufferPoolAuxAttributes;
 	CMFormatDescriptionRef _outputFormatDescription;
     GLuint _program;
+    dispatch_group_t _programGroup;
     GLint _frame;
     GLint _backgroundColor;
     GLuint _modelView;
@@ -93,9 +95,7 @@ static void PreallocatePixelBuffersInPool( CVPixelBufferPoolRef pool, CFDictiona
 	GLuint _offscreenBufferHandle;
 	
 	// Snake effect
-    double _velocityDeltaX;
-    double _velocityDeltaY;
-    NSTimeInterval _lastMotionTime;
+	SnakeMotionState _motionState;
 }
 
 @end
@@ -122,17 +122,90 @@ static void PreallocatePixelBuffersInPool( CVPixelBufferPoolRef pool, CFDictiona
 			[self release];
 			return  nil;
 		}
+		
+		// Build the program while the capture session starts up so it is
+		// ready by the time the first frame needs to be rendered
+		[self createProgramAsync];
 	}
 	return self;
 }
 
 - (void)dealloc
 {
+	dispatch_group_wait(_programGroup, DISPATCH_TIME_FOREVER);
+	dispatch_release(_programGroup);
 	[self deleteBuffers];
 	[_oglContext release];
     [super dealloc];
 }
 
++ (NSString *)shaderCacheDirectory
+{
+	NSString *cachesDirectory = [NSSearchPathForDirectoriesInDomains(NSCachesDirectory, NSUserDomainMask, YES) objectAtIndex:0];
+	NSString *shaderCacheDirectory = [cachesDirectory stringByAppendingPathComponent:@"Shaders"];
+	
+	[[NSFileManager defaultManager] createDirectoryAtPath:shaderCacheDirectory withIntermediateDirectories:YES attributes:nil error:nil];
+	return shaderCacheDirectory;
+}
+
+// Must be called with a context current that shares objects with _oglContext
+- (BOOL)createProgram
+{
+    // Load vertex and fragment shaders
+    GLint attribLocation[NUM_ATTRIBUTES] = {
+        ATTRIB_VERTEX, ATTRIB_TEXTUREPOSITON,
+    };
+    GLchar *attribName[NUM_ATTRIBUTES] = {
+        "position", "texturecoordinate",
+    };
+    
+    const GLchar *videoSnakeVertSrc = [VideoSnakeOpenGLRenderer readFile:@"videoSnake.vsh"];
+    const GLchar *videoSnakeFragSrc = [VideoSnakeOpenGLRenderer readFile:@"videoSnake.fsh"];
+    
+    // videoSnake shader program, reused from the binary cache when the sources haven't changed
+    glueCreateProgramCached([[VideoSnakeOpenGLRenderer shaderCacheDirectory] fileSystemRepresentation], NULL,
+                            videoSnakeVertSrc, videoSnakeFragSrc,
+                            NUM_ATTRIBUTES, (const GLchar **)&attribName[0], attribLocation,
+                            0, 0, 0,
+                            &_program);
+    if (!_program) {
+        return NO;
+    }
+    _backgroundColor = glueGetUniformLocation(_program, "backgroundcolor");
+    _modelView = glueGetUniformLocation(_program, "amodelview");
+    _projection = glueGetUniformLocation(_program, "aprojection");
+  	_frame = glueGetUniformLocation(_program, "videoframe");
+    return YES;
+}
+
+- (void)createProgramAsync
+{
+	// A second context in the same sharegroup lets the compile and link run on a worker thread
+	EAGLContext *workerContext = [[EAGLContext alloc] initWithAPI:kEAGLRenderingAPIOpenGLES2 sharegroup:[_oglContext sharegroup]];
+	
+	_programGroup = dispatch_group_create();
+	
+	if (!workerContext) {
+		return;
+	}
+	
+	dispatch_group_async(_programGroup, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0), ^{
+		@autoreleasepool {
+			[EAGLContext setCurrentContext:workerContext];
+			
+			if (![self createProgram]) {
+				NSLog(@"Problem initializing the program.");
+			}
+			
+			// Flush so the program is complete before _oglContext uses it
+			glFlush();
+			
+			[EAGLContext setCurrentContext:nil];
+			[workerContext release];
+		}
+	});
+}
+
 - (void)prepareWithOutputDimensions:(CMVideoDimensions)outputDimensions retainedBufferCountHint:(size_t)retainedBufferCountHint
 {
 	[self deleteBuffers];
@@ -172,31 +245,14 @@ static void PreallocatePixelBuffersInPool( CVPixelBufferPoolRef pool, CFDictiona
 		goto bail;
     }
 
-    // Load vertex and fragment shaders
-    GLint attribLocation[NUM_ATTRIBUTES] = {
-        ATTRIB_VERTEX, ATTRIB_TEXTUREPOSITON,
-    };
-    GLchar *attribName[NUM_ATTRIBUTES] = {
-        "position", "texturecoordinate",
-    };
-    
-    const GLchar *videoSnakeVertSrc = [VideoSnakeOpenGLRenderer readFile:@"videoSnake.vsh"];
-    const GLchar *videoSnakeFragSrc = [VideoSnakeOpenGLRenderer readFile:@"videoSnake.fsh"];
-    
-    // videoSnake shader program
-    glueCreateProgram(videoSnakeVertSrc, videoSnakeFragSrc,
-                      NUM_ATTRIBUTES, (const GLchar **)&attribName[0], attribLocation,
-                      0, 0, 0,
-                      &_program);
-    if (!_program) {
+    // Wait for the program started in -init, and build it again (normally
+    // from the binary cache) if it has since been deleted by -reset
+    dispatch_group_wait(_programGroup, DISPATCH_TIME_FOREVER);
+    if (!_program && ![self createProgram]) {
 		NSLog(@"Problem initializing the program.");
         success = NO;
 		goto bail;
     }
-    _backgroundColor = glueGetUniformLocation(_program, "backgroundcolor");
-    _modelView = glueGetUniformLocation(_program, "amodelview");
-    _projection = glueGetUniformLocation(_program, "aprojection");
-  	_frame = glueGetUniformLocation(_program, "videoframe");
 	
 	// Because we will retain one buffer in _backFramePixelBuffer we increment the client's retained buffer count hint by 1
 	size_t maxRetainedBufferCount = clientRetainedBufferCountHint + 1;
@@ -289,7 +345,7 @@ bail:
 	return _outputFormatDescription;
 }
 
-- (CVPixelBufferRef)copyRenderedPixelBuffer:(CVPixelBufferRef)pixelBuffer motion:(CMDeviceMotion *)motion
+- (CVPixelBufferRef)copyRenderedPixelBuffer:(CVPixelBufferRef)pixelBuffer motion:(const MotionSample *)motion
 {
 	static const float kBlackUniform[4] = {0.0, 0.0, 0.0, 1.0};
     static const GLfloat squareVertices[] = {
@@ -305,11 +361,6 @@ bail:
         1.0f,  1.0f, // top right
     };
 	
-    static const float kMotionDampingFactor = 0.75;
-    static const float kMotionScaleFactor = 0.01;
-    static const float kFrontScaleFactor = 0.25;
-    static const float kBackScaleFactor = 0.85;
-	
 	if (0 == _offscreenBufferHandle) {
 		@throw [NSException exceptionWithName:NSInternalInconsistencyException reason:@"Unintialize buffer" userInfo:nil];
 		return NULL;
@@ -347,16 +398,8 @@ bail:
 	CVOpenGLESTextureRef backFrameTexture = NULL;
 	CVPixelBufferRef dstPixelBuffer = NULL;
 	
-    if (!_lastMotionTime) {
-        _lastMotionTime = motion.timestamp;
-    }
-    NSTimeInterval timeDelta = motion.timestamp - _lastMotionTime;
-    _lastMotionTime = motion.timestamp;
-    
-    _velocityDeltaX += motion.userAcceleration.x * timeDelta;
-	_velocityDeltaX *= kMotionDampingFactor;
-    _velocityDeltaY += motion.userAcceleration.y * timeDelta;
-	_velocityDeltaY *= kMotionDampingFactor;
+    // Shared with the CPU renderer, so both draw the trail in the same place
+    SnakeMotionStateUpdate(&_motionState, motion);
 	
     err = CVOpenGLESTextureCacheCreateTextureFromImage(kCFAllocatorDefault,
                                                        _textureCache,
@@ -429,10 +472,9 @@ bail:
 	
     if (_backFramePixelBuffer) {
 		
-		float motionPixels = kMotionScaleFactor * dstDimensions.width;
-		int motionMirroring = self.shouldMirrorMotion ? -1 : 1;
-		float transBack[3] = {-_velocityDeltaY * motionPixels, -_velocityDeltaX * motionPixels * motionMirroring, 0.};
-		float scaleBack[3] = {kBackScaleFactor, kBackScaleFactor, 0.};
+		float transBack[3] = {0., 0., 0.};
+		SnakeMotionStateGetBackTranslation(&_motionState, dstDimensions.width, self.shouldMirrorMotion, transBack);
+		float scaleBack[3] = {kSnakeBackScaleFactor, kSnakeBackScaleFactor, 0.};
 		
         err = CVOpenGLESTextureCacheCreateTextureFromImage(kCFAllocatorDefault,
                                                            _renderTextureCache,
@@ -498,7 +540,7 @@ bail:
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     
-    float scaleFront[3] = {kFrontScaleFactor, kFrontScaleFactor, 0.0};
+    float scaleFront[3] = {kSnakeFrontScaleFactor, kSnakeFrontScaleFactor, 0.0};
     mat4f_LoadScale(scaleFront, modelview);
     
     glUniformMatrix4fv(_modelView, 1, GL_FALSE, modelview);
@@ -6,6 +6,7 @@
 
 #import <AVFoundation/AVFoundation.h>
 #import <CoreMotion/CoreMotion.h>
+#include "FrameTiming.h"
 
 @protocol VideoSnakeSessionManagerDelegate;
 
@@ -33,6 +34,10 @@
 @property (readonly) float videoFrameRate;
 @property (readonly) CMVideoDimensions videoDimensions;
 
+// Frame pacing over the last second, and frames dropped since the pipeline was set up, by presentation time: of frames from the camera,
+// of frames reaching the renderer, and of frames appended to the movie, which are zero when not recording
+- (void)getCaptureTimingStats:(FrameTimingStats *)captureStats renderTimingStats:(FrameTimingStats *)renderStats recordingTimingStats:(FrameTimingStats *)recordingStats;
+
 @end
 
 @protocol VideoSnakeSessionManagerDelegate <NSObject>
@@ -35,6 +35,8 @@
 
 #define LOG_STATUS_TRANSITIONS 0
 
+#define LOG_PIPELINE_STAGES 1
+
 typedef NS_ENUM( NSInteger, VideoSnakeRecordingStatus ) {
 	VideoSnakeRecordingStatusIdle = 0,
 	VideoSnakeRecordingStatusStartingRecording,
@@ -66,12 +68,29 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 	return angle;
 }
 
+#if LOG_PIPELINE_STAGES
+
+// Frame pacing of a stage over its last second, and how many intervals strayed from the frame duration by up to 0.125 ms, 0.25 ms, ...
+static void LogFrameTiming( NSString *stage, const FrameTimingStats *stats )
+{
+	NSMutableString *jitter = [NSMutableString string];
+	for ( unsigned bucket = 0; bucket < FrameTimingJitterBucketCount; bucket++ )
+		[jitter appendFormat:@"%s%llu", bucket ? " " : "", stats->jitter[bucket]];
+	
+	NSLog( @"%@ timing: %llu frames, %llu dropped, %llu discontinuities; %.1f fps, interval p50 %.1f ms p95 %.1f ms p99 %.1f ms max %.1f ms; jitter %@",
+		  stage, stats->frames, stats->dropped, stats->discontinuities, stats->frameRate,
+		  stats->p50Interval * 1000.0, stats->p95Interval * 1000.0, stats->p99Interval * 1000.0, stats->maxInterval * 1000.0, jitter );
+}
+
+#endif // LOG_PIPELINE_STAGES
+
 @interface VideoSnakeSessionManager () <AVCaptureAudioDataOutputSampleBufferDelegate, AVCaptureVideoDataOutputSampleBufferDelegate, MovieRecorderDelegate, MotionSynchronizationDelegate>
 {
 	id <VideoSnakeSessionManagerDelegate> _delegate;
 	dispatch_queue_t _delegateCallbackQueue;
 	
-	NSMutableArray *_previousSecondTimestamps;
+	FrameTimingWindowRef _captureTiming;	// frames from the camera
+	FrameTimingWindowRef _renderTiming;		// frames reaching the renderer, which give videoFrameRate
 
 	AVCaptureSession *_captureSession;
 	AVCaptureDevice *_videoDevice;
@@ -112,7 +131,9 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 - (id)init
 {
 	if (self = [super init]) {
-		_previousSecondTimestamps = [[NSMutableArray alloc] init];
+		// Room for a second of 240 fps capture
+		_captureTiming = FrameTimingWindowCreate( 1.0, 0.0, 256 );
+		_renderTiming = FrameTimingWindowCreate( 1.0, 0.0, 256 );
 		_recordingOrientation = (AVCaptureVideoOrientation)UIDeviceOrientationPortrait;
 		
 		_recordingURL = [[NSURL alloc] initFileURLWithPath:[NSString pathWithComponents:@[NSTemporaryDirectory(), @"Movie.MOV"]]];
@@ -147,7 +168,8 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 	if ( _currentPreviewPixelBuffer )
 		CFRelease( _currentPreviewPixelBuffer );
 	
-	[_previousSecondTimestamps release];
+	FrameTimingWindowRelease( _captureTiming );
+	FrameTimingWindowRelease( _renderTiming );
 	
 	[self teardownCaptureSession];
 	
@@ -300,6 +322,10 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 		frameRate = 30;
 	}
 	frameDuration = CMTimeMake( 1, frameRate );
+	
+	// Gaps of one and a half frame durations or more count as dropped frames
+	FrameTimingWindowSetNominalFrameDuration( _captureTiming, CMTimeGetSeconds( frameDuration ) );
+	FrameTimingWindowSetNominalFrameDuration( _renderTiming, CMTimeGetSeconds( frameDuration ) );
 
 	NSError *error;
 	if ([videoDevice lockForConfiguration:&error]) {
@@ -457,6 +483,10 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 			[_renderer reset];
 			self.currentPreviewPixelBuffer = NULL;
 			
+#if LOG_PIPELINE_STAGES
+			[self logPipelineStages];
+#endif // LOG_PIPELINE_STAGES
+			
 			NSLog( @"-[%@ %@] finished teardown", NSStringFromClass([self class]), NSStringFromSelector(_cmd) );
 			
 			[self videoPipelineDidFinishRunning];
@@ -545,7 +575,7 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 {
 	// For video the basic sample flow is:
 	//	1) Frame received from video data output on _videoDataOutputQueue via captureOutput:didOutputSampleBuffer:fromConnection: (this method)
-	//	2) Frame sent to motion synchronizer to be asynchronously correlated with motion data
+	//	2) Frame handed to the motion synchronizer through a bounded lock-free queue, where it is correlated with motion data on _motionSyncedVideoQueue
 	//	3) Frame and correlated motion data received on _motionSyncedVideoQueue via motionSynchronizer:didOutputSampleBuffer:withMotion:
 	//	4) Frame and motion data rendered via VideoSnakeOpenGLRenderer while running on _motionSyncedVideoQueue
 	//	5) Rendered frame sent to the delegate for previewing
@@ -562,6 +592,7 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 			[self setupVideoPipelineWithInputFormatDescription:formatDescription];
 		}
 		
+		FrameTimingWindowAddFrame( _captureTiming, CMTimeGetSeconds( CMSampleBufferGetPresentationTimeStamp( sampleBuffer ) ) );
 		[self.motionSynchronizer appendSampleBufferForSynchronization:sampleBuffer];
 	}
 	else if ( connection == _audioConnection ) {
@@ -575,7 +606,7 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 	}
 }
 
-- (void)motionSynchronizer:(MotionSynchronizer *)synchronizer didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer withMotion:(CMDeviceMotion *)motion
+- (void)motionSynchronizer:(MotionSynchronizer *)synchronizer didOutputSampleBuffer:(CMSampleBufferRef)sampleBuffer withMotion:(const MotionSample *)motion
 {
 	CVPixelBufferRef renderedPixelBuffer = NULL;
 	CMTime timestamp = CMSampleBufferGetPresentationTimeStamp( sampleBuffer );
@@ -688,6 +719,12 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 		// We will be stopped once we save to the assets library.
 	}
 	
+#if LOG_PIPELINE_STAGES
+	FrameTimingStats recordingTiming;
+	[recorder getVideoTimingStats:&recordingTiming];
+	LogFrameTiming( @"recording", &recordingTiming );
+#endif // LOG_PIPELINE_STAGES
+	
 	self.recorder = nil;
 	
 	ALAssetsLibrary *library = [[ALAssetsLibrary alloc] init];
@@ -805,19 +842,49 @@ static CGFloat angleOffsetFromPortraitOrientationToOrientation(AVCaptureVideoOri
 
 - (void)calculateFramerateAtTimestamp:(CMTime)timestamp
 {
-	[_previousSecondTimestamps addObject:[NSValue valueWithCMTime:timestamp]];
-	
-	CMTime oneSecond = CMTimeMake( 1, 1 );
-	CMTime oneSecondAgo = CMTimeSubtract( timestamp, oneSecond );
-	
-	while( CMTIME_COMPARE_INLINE( [[_previousSecondTimestamps objectAtIndex:0] CMTimeValue], <, oneSecondAgo ) )
-		[_previousSecondTimestamps removeObjectAtIndex:0];
+	FrameTimingWindowAddFrame( _renderTiming, CMTimeGetSeconds( timestamp ) );
 	
-	if ( [_previousSecondTimestamps count] > 1 ) {
-		const Float64 duration = CMTimeGetSeconds(CMTimeSubtract([[_previousSecondTimestamps lastObject] CMTimeValue], [[_previousSecondTimestamps objectAtIndex:0] CMTimeValue]));
-		const float newRate = (float) ([_previousSecondTimestamps count] - 1) / duration;
+	const double newRate = FrameTimingWindowGetFrameRate( _renderTiming );
+	if ( newRate > 0 )
 		self.videoFrameRate = newRate;
+}
+
+- (void)getCaptureTimingStats:(FrameTimingStats *)captureStats renderTimingStats:(FrameTimingStats *)renderStats recordingTimingStats:(FrameTimingStats *)recordingStats
+{
+	FrameTimingWindowGetStats( _captureTiming, captureStats );
+	FrameTimingWindowGetStats( _renderTiming, renderStats );
+	
+	@synchronized( self ) {
+		if ( self.recorder )
+			[self.recorder getVideoTimingStats:recordingStats];
+		else
+			memset( recordingStats, 0, sizeof(*recordingStats) );
 	}
 }
 
+#if LOG_PIPELINE_STAGES
+
+// Frames dropped at each stage, and the latency each adds; the render latency is glass to rendered
+- (void)logPipelineStages
+{
+	PipelineStageStats frameStats, motionStats, renderStats;
+	[self.motionSynchronizer getFrameStageStats:&frameStats motionStageStats:&motionStats outputStageStats:&renderStats];
+	
+	NSLog( @"frames: %llu queued, %llu evicted, %llu stale, at most %u waiting; hand-off p50 %.1f ms p99 %.1f ms, waiting for motion p50 %.1f ms p99 %.1f ms",
+		  frameStats.queued, frameStats.evicted, frameStats.stale, frameStats.highWater,
+		  frameStats.wait.p50 * 1000.0, frameStats.wait.p99 * 1000.0, frameStats.service.p50 * 1000.0, frameStats.service.p99 * 1000.0 );
+	NSLog( @"motion: %llu queued, %llu evicted; hand-off p50 %.1f ms p99 %.1f ms, capture to synchronizer p99 %.1f ms",
+		  motionStats.queued, motionStats.evicted, motionStats.wait.p50 * 1000.0, motionStats.wait.p99 * 1000.0, motionStats.latency.p99 * 1000.0 );
+	NSLog( @"render: %llu frames; render p50 %.1f ms p99 %.1f ms, glass to rendered p50 %.1f ms p99 %.1f ms max %.1f ms",
+		  renderStats.completed, renderStats.service.p50 * 1000.0, renderStats.service.p99 * 1000.0,
+		  renderStats.latency.p50 * 1000.0, renderStats.latency.p99 * 1000.0, renderStats.latency.max * 1000.0 );
+	
+	FrameTimingStats captureTiming, renderTiming, recordingTiming;
+	[self getCaptureTimingStats:&captureTiming renderTimingStats:&renderTiming recordingTimingStats:&recordingTiming];
+	LogFrameTiming( @"capture", &captureTiming );
+	LogFrameTiming( @"render", &renderTiming );
+}
+
+#endif // LOG_PIPELINE_STAGES
+
 @end
@@ -0,0 +1,308 @@
+/*
+ <codex>
+ <abstract>A portable pool of reference counted frame buffers, recycled rather than freed</abstract>
+ </codex>
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "FrameBufferPool.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#ifdef __linux__
+static const size_t kHugePageSize = 2 * 1024 * 1024;
+#endif
+
+/*
+ What the pool and its buffers share. The pool holds one reference and every
+ buffer in memory holds another, so buffers released after the pool is gone
+ can still be freed.
+ */
+struct VideoSnake::FrameBufferPoolState {
+	std::atomic<uint32_t> referenceCount;
+	FrameBufferPoolOptions options;
+	size_t bytesPerRow;
+	size_t dataSize;
+
+	std::mutex lock;
+	std::vector<FrameBuffer *> freeBuffers;	// reserved to hold every buffer allocated, so releasing never allocates
+	bool poolAlive;
+	FrameBufferPoolStats stats;
+};
+
+static void releasePoolState(VideoSnake::FrameBufferPoolState *state)
+{
+	if (state->referenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		delete state;
+}
+
+#ifdef __linux__
+
+// Maps size bytes aligned to a huge page, from the reserved huge pages if
+// there are enough and otherwise as memory that can become transparent huge
+// pages. Returns NULL if neither works.
+static uint8_t *mapHugePages(size_t size)
+{
+	void *memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE, -1, 0);
+	if (memory != MAP_FAILED)
+		return (uint8_t *)memory;
+
+	// Transparent huge pages only back whole aligned 2 MB ranges, so map a
+	// page more than needed and trim both ends to a boundary
+	size_t mappedSize = size + kHugePageSize;
+	memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if (memory == MAP_FAILED)
+		return NULL;
+
+	uintptr_t start = (uintptr_t)memory;
+	uintptr_t aligned = (start + kHugePageSize - 1) & ~(uintptr_t)(kHugePageSize - 1);
+	if (aligned > start)
+		munmap(memory, aligned - start);
+	if (start + mappedSize > aligned + size)
+		munmap((void *)(aligned + size), start + mappedSize - (aligned + size));
+
+	if (madvise((void *)aligned, size, MADV_HUGEPAGE) != 0) {
+		munmap((void *)aligned, size);
+		return NULL;
+	}
+	return (uint8_t *)aligned;
+}
+
+#endif // __linux__
+
+namespace VideoSnake {
+
+void FrameBuffer::release()
+{
+	if (_referenceCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+		return;
+
+	FrameBufferPoolState *state = _pool;
+	bool recycled = false;
+	{
+		std::lock_guard<std::mutex> locked(state->lock);
+		state->stats.outstanding--;
+		if (state->poolAlive) {
+			state->freeBuffers.push_back(this);
+			recycled = true;
+		}
+	}
+
+	if (!recycled)
+		FrameBufferPool::destroyBuffer(this);
+}
+
+FrameBufferPool::FrameBufferPool(const FrameBufferPoolOptions& options)
+: _state(new FrameBufferPoolState)
+{
+	_state->referenceCount.store(1, std::memory_order_relaxed);
+	_state->options = options;
+	if (_state->options.alignment < sizeof(void *))
+		_state->options.alignment = sizeof(void *);
+
+	size_t alignment = _state->options.alignment;
+	_state->bytesPerRow = ((size_t)options.width * options.bytesPerPixel + alignment - 1) & ~(alignment - 1);
+	_state->dataSize = _state->bytesPerRow * options.height;
+	_state->poolAlive = true;
+	memset(&_state->stats, 0, sizeof(_state->stats));
+
+	uint32_t expected = options.allocationThreshold ? options.allocationThreshold : options.retainedBufferCountHint;
+	_state->freeBuffers.reserve(expected);
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+	std::vector<FrameBuffer *> freeBuffers;
+	{
+		std::lock_guard<std::mutex> locked(_state->lock);
+		_state->poolAlive = false;
+		freeBuffers.swap(_state->freeBuffers);
+	}
+
+	for (size_t i = 0; i < freeBuffers.size(); i++)
+		destroyBuffer(freeBuffers[i]);
+	releasePoolState(_state);
+}
+
+const FrameBufferPoolOptions& FrameBufferPool::options() const
+{
+	return _state->options;
+}
+
+size_t FrameBufferPool::bytesPerRow() const
+{
+	return _state->bytesPerRow;
+}
+
+// Allocates a buffer's memory and touches every page of it, so that a
+// preallocated buffer takes no page faults once the pipeline is running.
+// Counts the buffer as allocated; the caller has already reserved its place.
+FrameBuffer *FrameBufferPool::allocateBuffer(FrameBufferPoolState *state)
+{
+	FrameBuffer *buffer = new FrameBuffer;
+	buffer->_bytesPerRow = state->bytesPerRow;
+	buffer->_width = state->options.width;
+	buffer->_height = state->options.height;
+	buffer->_mappedSize = 0;
+	buffer->_hugePages = false;
+	buffer->_baseAddress = NULL;
+	buffer->_pool = state;
+
+#ifdef __linux__
+	if (state->options.hugePages) {
+		size_t mappedSize = (state->dataSize + kHugePageSize - 1) & ~(kHugePageSize - 1);
+		buffer->_baseAddress = mapHugePages(mappedSize);
+		if (buffer->_baseAddress) {
+			buffer->_mappedSize = mappedSize;
+			buffer->_hugePages = true;
+		}
+	}
+#endif
+
+	// Without huge pages, or if none could be had
+	if (!buffer->_baseAddress) {
+		void *memory = NULL;
+		if (posix_memalign(&memory, state->options.alignment, state->dataSize ? state->dataSize : 1) != 0) {
+			delete buffer;
+			return NULL;
+		}
+		buffer->_baseAddress = (uint8_t *)memory;
+	}
+	memset(buffer->_baseAddress, 0, state->dataSize);
+
+	state->referenceCount.fetch_add(1, std::memory_order_relaxed);
+
+	std::lock_guard<std::mutex> locked(state->lock);
+	state->stats.bytesAllocated += buffer->_mappedSize ? buffer->_mappedSize : state->dataSize;
+	if (buffer->_hugePages)
+		state->stats.hugePageBuffers++;
+	if (state->stats.allocated > state->stats.allocatedHighWater)
+		state->stats.allocatedHighWater = state->stats.allocated;
+	if (state->freeBuffers.capacity() < state->stats.allocated)
+		state->freeBuffers.reserve(state->stats.allocated);
+	return buffer;
+}
+
+void FrameBufferPool::destroyBuffer(FrameBuffer *buffer)
+{
+	FrameBufferPoolState *state = buffer->_pool;
+	{
+		std::lock_guard<std::mutex> locked(state->lock);
+		state->stats.allocated--;
+		state->stats.bytesAllocated -= buffer->_mappedSize ? buffer->_mappedSize : state->dataSize;
+		if (buffer->_hugePages)
+			state->stats.hugePageBuffers--;
+	}
+
+#ifdef __linux__
+	if (buffer->_mappedSize)
+		munmap(buffer->_baseAddress, buffer->_mappedSize);
+	else
+#endif
+		free(buffer->_baseAddress);
+	delete buffer;
+
+	releasePoolState(state);
+}
+
+FrameBuffer *FrameBufferPool::createBuffer(FrameBufferPoolResult *result)
+{
+	{
+		std::lock_guard<std::mutex> locked(_state->lock);
+		FrameBufferPoolStats& stats = _state->stats;
+		stats.requests++;
+
+		if (!_state->freeBuffers.empty()) {
+			FrameBuffer *buffer = _state->freeBuffers.back();
+			_state->freeBuffers.pop_back();
+			buffer->_referenceCount.store(1, std::memory_order_relaxed);
+			stats.hits++;
+			if (++stats.outstanding > stats.outstandingHighWater)
+				stats.outstandingHighWater = stats.outstanding;
+			if (result)
+				*result = FrameBufferPoolSuccess;
+			return buffer;
+		}
+
+		uint32_t threshold = _state->options.allocationThreshold;
+		if (threshold && stats.outstanding >= threshold) {
+			stats.exhaustions++;
+			if (result)
+				*result = FrameBufferPoolWouldExceedAllocationThreshold;
+			return NULL;
+		}
+
+		// Hold the buffer's place against the threshold while it is allocated without the lock
+		stats.misses++;
+		stats.allocated++;
+		if (++stats.outstanding > stats.outstandingHighWater)
+			stats.outstandingHighWater = stats.outstanding;
+	}
+
+	FrameBuffer *buffer = allocateBuffer(_state);
+	if (!buffer) {
+		std::lock_guard<std::mutex> locked(_state->lock);
+		_state->stats.allocated--;
+		_state->stats.outstanding--;
+		if (result)
+			*result = FrameBufferPoolAllocationFailed;
+		return NULL;
+	}
+
+	if (result)
+		*result = FrameBufferPoolSuccess;
+	return buffer;
+}
+
+uint32_t FrameBufferPool::preallocate()
+{
+	uint32_t target = _state->options.allocationThreshold ? _state->options.allocationThreshold : _state->options.retainedBufferCountHint;
+	uint32_t count = 0;
+
+	for (;;) {
+		{
+			std::lock_guard<std::mutex> locked(_state->lock);
+			if (_state->stats.allocated >= target)
+				break;
+			_state->stats.allocated++;
+		}
+
+		FrameBuffer *buffer = allocateBuffer(_state);
+		std::lock_guard<std::mutex> locked(_state->lock);
+		if (!buffer) {
+			_state->stats.allocated--;
+			break;
+		}
+		_state->freeBuffers.push_back(buffer);
+		count++;
+	}
+	return count;
+}
+
+void FrameBufferPool::flushExcessBuffers()
+{
+	std::vector<FrameBuffer *> excess;
+	{
+		std::lock_guard<std::mutex> locked(_state->lock);
+		uint32_t allocated = _state->stats.allocated;
+		while (!_state->freeBuffers.empty() && allocated > _state->options.retainedBufferCountHint) {
+			excess.push_back(_state->freeBuffers.back());
+			_state->freeBuffers.pop_back();
+			allocated--;
+		}
+	}
+
+	for (size_t i = 0; i < excess.size(); i++)
+		destroyBuffer(excess[i]);
+}
+
+void FrameBufferPool::getStats(FrameBufferPoolStats& stats) const
+{
+	std::lock_guard<std::mutex> locked(_state->lock);
+	stats = _state->stats;
+}
+
+} // namespace VideoSnake
@@ -0,0 +1,153 @@
+/*
+ <codex>
+ <abstract>A portable pool of reference counted frame buffers, recycled rather than freed, with the buffer count hint, allocation threshold and preallocation of a CVPixelBufferPool, and counters for how well it recycles</abstract>
+ </codex>
+ */
+
+#ifndef FRAME_BUFFER_POOL_H
+#define FRAME_BUFFER_POOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct FrameBufferPoolStats {
+	uint64_t requests;				// calls to createBuffer
+	uint64_t hits;					// requests met with a recycled buffer
+	uint64_t misses;				// requests that allocated a new buffer
+	uint64_t exhaustions;			// requests refused at the allocation threshold
+	uint32_t outstanding;			// buffers vended and not yet released
+	uint32_t outstandingHighWater;
+	uint32_t allocated;				// buffers in memory, outstanding or free
+	uint32_t allocatedHighWater;
+	uint32_t hugePageBuffers;		// allocated buffers mapped for huge pages, reserved or transparent
+	uint64_t bytesAllocated;
+} FrameBufferPoolStats;
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+namespace VideoSnake {
+
+struct FrameBufferPoolOptions {
+	uint32_t width;
+	uint32_t height;
+	uint32_t bytesPerPixel;			// 4 for BGRA
+
+	// Of the base address and of every row; a power of two
+	size_t alignment;
+
+	// Buffers kept when flushing excess buffers, as kCVPixelBufferPoolMinimumBufferCountKey.
+	// Pass the number of buffers the pipeline expects to hold on to.
+	uint32_t retainedBufferCountHint;
+
+	// Most buffers outstanding at once, as kCVPixelBufferPoolAllocationThresholdKey; 0 for no limit
+	uint32_t allocationThreshold;
+
+	// On Linux, back buffers with 2 MB pages, reserved ones if there are any and transparent
+	// huge pages otherwise, so that large frames take fewer TLB entries. Ignored elsewhere.
+	bool hugePages;
+
+	FrameBufferPoolOptions(uint32_t width = 0, uint32_t height = 0, uint32_t bytesPerPixel = 4)
+	: width(width), height(height), bytesPerPixel(bytesPerPixel), alignment(64),
+	  retainedBufferCountHint(0), allocationThreshold(0), hugePages(false)
+	{
+	}
+};
+
+enum FrameBufferPoolResult {
+	FrameBufferPoolSuccess,
+	FrameBufferPoolWouldExceedAllocationThreshold,
+	FrameBufferPoolAllocationFailed,
+};
+
+class FrameBufferPool;
+struct FrameBufferPoolState;
+
+/*
+ A frame in memory from a FrameBufferPool. Created with a reference count of
+ one; when the last reference is released the buffer goes back to its pool,
+ or is freed if the pool has since been destroyed. Buffers come back holding
+ whatever was last written to them.
+ */
+class FrameBuffer
+{
+public:
+	uint8_t *baseAddress() const { return _baseAddress; }
+	size_t bytesPerRow() const { return _bytesPerRow; }
+	uint32_t width() const { return _width; }
+	uint32_t height() const { return _height; }
+	size_t dataSize() const { return _bytesPerRow * _height; }
+
+	FrameBuffer *retain()
+	{
+		_referenceCount.fetch_add(1, std::memory_order_relaxed);
+		return this;
+	}
+
+	void release();
+
+private:
+	friend class FrameBufferPool;
+
+	FrameBuffer() : _referenceCount(1) {}
+	~FrameBuffer() {}
+
+	std::atomic<uint32_t> _referenceCount;
+	uint8_t *_baseAddress;
+	size_t _bytesPerRow;
+	uint32_t _width;
+	uint32_t _height;
+	size_t _mappedSize;		// non-zero if the memory was mapped rather than allocated
+	bool _hugePages;
+	FrameBufferPoolState *_pool;
+};
+
+/*
+ Buffers are recycled through a free list under a lock held only to push or
+ pop one pointer; once the pool has grown to what the pipeline holds, vending
+ and releasing buffers allocates nothing.
+ */
+class FrameBufferPool
+{
+public:
+	explicit FrameBufferPool(const FrameBufferPoolOptions& options);
+
+	// Buffers still outstanding stay valid and are freed when released
+	~FrameBufferPool();
+
+	const FrameBufferPoolOptions& options() const;
+	size_t bytesPerRow() const;
+
+	// Returns a buffer with a reference count of one, or NULL with the reason in result
+	FrameBuffer *createBuffer(FrameBufferPoolResult *result = NULL);
+
+	// Allocates buffers until the allocation threshold, or the buffer count hint
+	// if there is no threshold, is reached, so that a real-time pipeline does
+	// not allocate once it is running. Returns the number of buffers allocated.
+	uint32_t preallocate();
+
+	// Frees the free buffers beyond the buffer count hint
+	void flushExcessBuffers();
+
+	void getStats(FrameBufferPoolStats& stats) const;
+
+private:
+	friend class FrameBuffer;
+
+	FrameBufferPool(const FrameBufferPool&);
+	FrameBufferPool& operator=(const FrameBufferPool&);
+
+	static FrameBuffer *allocateBuffer(FrameBufferPoolState *state);
+	static void destroyBuffer(FrameBuffer *buffer);
+
+	FrameBufferPoolState *_state;
+};
+
+} // namespace VideoSnake
+
+#endif // __cplusplus
+
+#endif /* FRAME_BUFFER_POOL_H */
@@ -0,0 +1,168 @@
+/*
+ <codex>
+ <abstract>Frame rate and frame pacing over a sliding window of timestamps</abstract>
+ </codex>
+ */
+
+#include <algorithm>
+#include <string.h>
+#include "FrameTiming.h"
+
+// Index of the nearest-rank percentile of count sorted values
+static size_t percentileIndex(double percentile, size_t count)
+{
+	size_t rank = (size_t)ceil(percentile * count);
+	return rank ? rank - 1 : 0;
+}
+
+namespace VideoSnake {
+
+FrameTimingWindow::FrameTimingWindow(double windowDuration, double nominalFrameDuration, size_t capacity)
+: _windowDuration(windowDuration), _nominalFrameDuration(nominalFrameDuration), _frames(capacity)
+{
+	_intervals.resize(_frames.capacity());
+	_frameCount = _dropped = _discontinuities = 0;
+	memset(_jitter, 0, sizeof(_jitter));
+}
+
+void FrameTimingWindow::setNominalFrameDuration(double nominalFrameDuration)
+{
+	std::lock_guard<std::mutex> locked(_lock);
+	_nominalFrameDuration = nominalFrameDuration;
+}
+
+void FrameTimingWindow::addFrame(double timestamp)
+{
+	std::lock_guard<std::mutex> locked(_lock);
+	Frame frame = {timestamp, 0.0};
+	_frameCount++;
+
+	if (!_frames.empty()) {
+		double interval = timestamp - _frames.back().timestamp;
+
+		if (interval <= 0.0 || interval >= _windowDuration) {
+			_discontinuities++;
+			_frames.clear();
+		}
+		else {
+			double frameDuration = _nominalFrameDuration;
+			if (frameDuration <= 0.0 && _frames.size() > 1)
+				frameDuration = (_frames.back().timestamp - _frames.front().timestamp) / (_frames.size() - 1);
+
+			if (frameDuration > 0.0) {
+				double periods = std::max(floor(interval / frameDuration + 0.5), 1.0);
+				_dropped += (uint64_t)periods - 1;
+
+				double jitter = fabs(interval - periods * frameDuration);
+				unsigned bucket = 0;
+				while (jitter >= FrameTimingJitterBucketLimit(bucket))
+					bucket++;
+				_jitter[bucket]++;
+			}
+			frame.interval = interval;
+		}
+	}
+
+	// Keep the frames of the last windowDuration seconds, as many as fit
+	while (!_frames.empty() && _frames.front().timestamp < timestamp - _windowDuration)
+		_frames.pop();
+	if (_frames.full())
+		_frames.pop();
+	_frames.push(frame);
+}
+
+double FrameTimingWindow::frameRateLocked() const
+{
+	if (_frames.size() < 2)
+		return 0.0;
+	return (_frames.size() - 1) / (_frames.back().timestamp - _frames.front().timestamp);
+}
+
+double FrameTimingWindow::frameRate() const
+{
+	std::lock_guard<std::mutex> locked(_lock);
+	return frameRateLocked();
+}
+
+void FrameTimingWindow::getStats(FrameTimingStats& stats) const
+{
+	std::lock_guard<std::mutex> locked(_lock);
+	memset(&stats, 0, sizeof(stats));
+	stats.frames = _frameCount;
+	stats.dropped = _dropped;
+	stats.discontinuities = _discontinuities;
+	memcpy(stats.jitter, _jitter, sizeof(stats.jitter));
+
+	stats.framesInWindow = (uint32_t)_frames.size();
+	stats.frameRate = frameRateLocked();
+	if (_frames.size() < 2)
+		return;
+	stats.meanInterval = 1.0 / stats.frameRate;
+
+	// The oldest frame's interval reaches back out of the window
+	size_t count = _frames.size() - 1;
+	for (size_t i = 0; i < count; i++)
+		_intervals[i] = _frames[i + 1].interval;
+
+	std::vector<double>::iterator begin = _intervals.begin(), end = begin + count;
+	size_t p50 = percentileIndex(0.50, count), p95 = percentileIndex(0.95, count), p99 = percentileIndex(0.99, count);
+
+	// Each selection leaves everything after it no smaller, so the next can start from there
+	std::nth_element(begin, begin + p50, end);
+	stats.p50Interval = begin[p50];
+	std::nth_element(begin + p50, begin + p95, end);
+	stats.p95Interval = begin[p95];
+	std::nth_element(begin + p95, begin + p99, end);
+	stats.p99Interval = begin[p99];
+	stats.maxInterval = *std::max_element(begin + p99, end);
+}
+
+void FrameTimingWindow::reset()
+{
+	std::lock_guard<std::mutex> locked(_lock);
+	_frames.clear();
+	_frameCount = _dropped = _discontinuities = 0;
+	memset(_jitter, 0, sizeof(_jitter));
+}
+
+} // namespace VideoSnake
+
+static VideoSnake::FrameTimingWindow *frameTimingWindow(FrameTimingWindowRef window)
+{
+	return reinterpret_cast<VideoSnake::FrameTimingWindow *>(window);
+}
+
+FrameTimingWindowRef FrameTimingWindowCreate(double windowDuration, double nominalFrameDuration, size_t capacity)
+{
+	return reinterpret_cast<FrameTimingWindowRef>(new VideoSnake::FrameTimingWindow(windowDuration, nominalFrameDuration, capacity));
+}
+
+void FrameTimingWindowRelease(FrameTimingWindowRef window)
+{
+	delete frameTimingWindow(window);
+}
+
+void FrameTimingWindowSetNominalFrameDuration(FrameTimingWindowRef window, double nominalFrameDuration)
+{
+	frameTimingWindow(window)->setNominalFrameDuration(nominalFrameDuration);
+}
+
+void FrameTimingWindowAddFrame(FrameTimingWindowRef window, double timestamp)
+{
+	frameTimingWindow(window)->addFrame(timestamp);
+}
+
+double FrameTimingWindowGetFrameRate(FrameTimingWindowRef window)
+{
+	return frameTimingWindow(window)->frameRate();
+}
+
+void FrameTimingWindowGetStats(FrameTimingWindowRef window, FrameTimingStats *stats)
+{
+	frameTimingWindow(window)->getStats(*stats);
+}
+
+void FrameTimingWindowReset(FrameTimingWindowRef window)
+{
+	frameTimingWindow(window)->reset();
+}
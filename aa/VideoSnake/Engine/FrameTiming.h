@@ -0,0 +1,134 @@
+/*
+ <codex>
+ <abstract>Frame rate and frame pacing over a sliding window of timestamps, for any stage of the pipeline: the frame rate, percentiles of the interval between frames, frames dropped from gaps in the timestamps, and a histogram of how far each interval strays from the frame duration</abstract>
+ </codex>
+ */
+
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+	FrameTimingJitterBucketCount = 10,
+};
+
+typedef struct FrameTimingStats {
+	// Since the window was created or reset
+	uint64_t frames;			// frames added
+	uint64_t dropped;			// frames missing from gaps of one and a half frame durations or more
+	uint64_t discontinuities;	// timestamps going backwards or jumping by the whole window, after which the window starts over
+
+	// Over the window, in seconds
+	uint32_t framesInWindow;
+	double frameRate;			// frames per second
+	double meanInterval;
+	double p50Interval;
+	double p95Interval;
+	double p99Interval;
+	double maxInterval;
+
+	// Intervals by how far they were from a whole number of frame durations, since the window was created or reset
+	uint64_t jitter[FrameTimingJitterBucketCount];
+} FrameTimingStats;
+
+// The upper bound, in seconds, of a jitter bucket: 0.125 ms for the first, doubling for each after; the last has none
+static inline double FrameTimingJitterBucketLimit(unsigned bucket)
+{
+	return bucket + 1 < FrameTimingJitterBucketCount ? ldexp(0.000125, (int)bucket) : INFINITY;
+}
+
+/*
+ For Objective-C callers. Frames are added from one thread or serial queue at
+ a time; the frame rate and stats can be read from any.
+ */
+typedef struct OpaqueFrameTimingWindow *FrameTimingWindowRef;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// As FrameTimingWindow's constructor; release with FrameTimingWindowRelease
+FrameTimingWindowRef FrameTimingWindowCreate(double windowDuration, double nominalFrameDuration, size_t capacity);
+void FrameTimingWindowRelease(FrameTimingWindowRef window);
+
+void FrameTimingWindowSetNominalFrameDuration(FrameTimingWindowRef window, double nominalFrameDuration);
+void FrameTimingWindowAddFrame(FrameTimingWindowRef window, double timestamp);
+double FrameTimingWindowGetFrameRate(FrameTimingWindowRef window);
+void FrameTimingWindowGetStats(FrameTimingWindowRef window, FrameTimingStats *stats);
+void FrameTimingWindowReset(FrameTimingWindowRef window);
+
+#ifdef __cplusplus
+}
+#endif
+
+#ifdef __cplusplus
+
+#include <mutex>
+#include <vector>
+#include "MotionSyncCore.h"
+
+namespace VideoSnake {
+
+/*
+ The timestamps of the frames of the last windowDuration seconds, in seconds
+ on any clock, kept in a fixed-size ring so that adding a frame allocates
+ nothing and, since frames leave the window in the order they came, costs a
+ constant amount of time on average. The frame rate is read off the ends of
+ the ring; the percentiles are selected from the window's intervals when the
+ stats are taken.
+
+ Gaps are measured against the nominal frame duration, or if there is none
+ against the mean interval over the window. A frame that comes late by a
+ whole number of frame durations counts those frames as dropped, and its
+ jitter is how far it was from the nearest whole number of frame durations.
+ */
+class FrameTimingWindow
+{
+public:
+	// Enough capacity for the fastest frame rate expected over the window; at
+	// a faster rate the window holds fewer frames than its duration
+	FrameTimingWindow(double windowDuration = 1.0, double nominalFrameDuration = 0.0, size_t capacity = 256);
+
+	void setNominalFrameDuration(double nominalFrameDuration);
+
+	void addFrame(double timestamp);
+
+	// Frames per second over the window, as calculateFramerateAtTimestamp: did; 0 until there are two frames
+	double frameRate() const;
+
+	void getStats(FrameTimingStats& stats) const;
+
+	void reset();
+
+private:
+	struct Frame {
+		double timestamp;
+		double interval;	// since the frame before; 0 for the first after a reset or discontinuity
+	};
+
+	FrameTimingWindow(const FrameTimingWindow&);
+	FrameTimingWindow& operator=(const FrameTimingWindow&);
+
+	double frameRateLocked() const;
+
+	double _windowDuration;
+	double _nominalFrameDuration;
+
+	mutable std::mutex _lock;
+	TimestampRing<Frame> _frames;
+	mutable std::vector<double> _intervals;	// scratch for selecting percentiles, as big as the ring
+
+	uint64_t _frameCount;
+	uint64_t _dropped;
+	uint64_t _discontinuities;
+	uint64_t _jitter[FrameTimingJitterBucketCount];
+};
+
+} // namespace VideoSnake
+
+#endif // __cplusplus
+
+#endif /* FRAME_TIMING_H */
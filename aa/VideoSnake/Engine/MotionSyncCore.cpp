@@ -0,0 +1,136 @@
+/*
+ <codex>
+ <abstract>Portable core of the motion synchronizer: fixed-capacity rings of media and motion samples in timestamp order, matched by binary search, with the motion interpolated to each media timestamp</abstract>
+ </codex>
+ */
+
+#include <math.h>
+#include "MotionSyncCore.h"
+
+// Above this cosine (attitudes nearly aligned), fall back to linear interpolation,
+// which is as accurate as slerp there and avoids dividing by a vanishing sine
+static const double kSlerpLinearThreshold = 0.9995;
+
+void VideoSnake::MotionSampleInterpolate(const MotionSample& a, const MotionSample& b, double t, MotionSample& result)
+{
+	double qb[4] = {b.attitude[0], b.attitude[1], b.attitude[2], b.attitude[3]};
+	double cosine = a.attitude[0] * qb[0] + a.attitude[1] * qb[1] + a.attitude[2] * qb[2] + a.attitude[3] * qb[3];
+
+	// q and -q are the same attitude; take the one nearer a to go the short way round
+	if (cosine < 0.0) {
+		for (int i = 0; i < 4; i++)
+			qb[i] = -qb[i];
+		cosine = -cosine;
+	}
+
+	double wa = 1.0 - t, wb = t;
+	if (cosine < kSlerpLinearThreshold) {
+		double angle = acos(cosine);
+		double sine = sin(angle);
+		wa = sin((1.0 - t) * angle) / sine;
+		wb = sin(t * angle) / sine;
+	}
+
+	double length = 0.0;
+	for (int i = 0; i < 4; i++) {
+		result.attitude[i] = wa * a.attitude[i] + wb * qb[i];
+		length += result.attitude[i] * result.attitude[i];
+	}
+	length = sqrt(length);
+	for (int i = 0; i < 4; i++)
+		result.attitude[i] /= length;
+
+	for (int i = 0; i < 3; i++) {
+		result.rotationRate[i] = a.rotationRate[i] + (b.rotationRate[i] - a.rotationRate[i]) * t;
+		result.gravity[i] = a.gravity[i] + (b.gravity[i] - a.gravity[i]) * t;
+		result.userAcceleration[i] = a.userAcceleration[i] + (b.userAcceleration[i] - a.userAcceleration[i]) * t;
+	}
+
+	result.timestamp = a.timestamp + (b.timestamp - a.timestamp) * t;
+}
+
+VideoSnake::MotionSyncCore::MotionSyncCore(size_t mediaLatency, size_t motionCapacity)
+: _mediaLatency(mediaLatency),
+  _media(mediaLatency + 1),
+  _motion(motionCapacity < 2 ? 2 : motionCapacity)
+{
+}
+
+bool VideoSnake::MotionSyncCore::appendMotion(const MotionSample& motion)
+{
+	if (!_motion.empty() && !(motion.timestamp > _motion.back().timestamp))
+		return false;
+
+	if (_motion.full())
+		_motion.pop();
+	_motion.push(motion);
+	return true;
+}
+
+bool VideoSnake::MotionSyncCore::appendMedia(double timestamp, void *context)
+{
+	// Media arriving out of order is treated as arriving at the latest time seen,
+	// which keeps the ring sorted for the binary search
+	if (!_media.empty() && timestamp < _media.back().timestamp)
+		timestamp = _media.back().timestamp;
+
+	if (_media.size() > _mediaLatency)
+		return false;
+
+	PendingMedia media = {timestamp, context};
+	return _media.push(media);
+}
+
+bool VideoSnake::MotionSyncCore::nextSynced(SyncedMedia& synced)
+{
+	if (_media.empty())
+		return false;
+
+	const PendingMedia& media = _media.front();
+	size_t next = _motion.lowerBound(media.timestamp);
+	bool bracketed = next < _motion.size();
+
+	if (!bracketed && _media.size() <= _mediaLatency)
+		return false;
+
+	synced.timestamp = media.timestamp;
+	synced.context = media.context;
+	synced.hasMotion = !_motion.empty();
+	if (synced.hasMotion)
+		interpolateMotion(media.timestamp, next, synced.motion);
+	_media.pop();
+
+	// Later media samples are no earlier than this one, so every motion sample
+	// before the one at or just before it is no longer needed
+	if (next > 1)
+		_motion.pop(next - 1);
+
+	return true;
+}
+
+bool VideoSnake::MotionSyncCore::takePendingMedia(void *&context)
+{
+	if (_media.empty())
+		return false;
+
+	context = _media.front().context;
+	_media.pop();
+	return true;
+}
+
+void VideoSnake::MotionSyncCore::interpolateMotion(double timestamp, size_t next, MotionSample& motion) const
+{
+	// Before the first motion sample or after the last, hold the nearest
+	if (next == 0) {
+		motion = _motion.front();
+	}
+	else if (next == _motion.size()) {
+		motion = _motion.back();
+	}
+	else {
+		const MotionSample& a = _motion[next - 1];
+		const MotionSample& b = _motion[next];
+		MotionSampleInterpolate(a, b, (timestamp - a.timestamp) / (b.timestamp - a.timestamp), motion);
+	}
+	motion.timestamp = timestamp;
+}
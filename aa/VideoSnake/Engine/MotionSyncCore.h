@@ -0,0 +1,162 @@
+/*
+ <codex>
+ <abstract>Portable core of the motion synchronizer: fixed-capacity rings of media and motion samples in timestamp order, matched by binary search, with the motion interpolated to each media timestamp</abstract>
+ </codex>
+ */
+
+#ifndef MOTION_SYNC_CORE_H
+#define MOTION_SYNC_CORE_H
+
+#include <stddef.h>
+
+/*
+ The parts of a CMDeviceMotion the effect uses, as plain data so that samples
+ can be stored, interpolated and passed between threads without allocating.
+ */
+typedef struct MotionSample {
+	double timestamp;			// seconds on the host time clock, as CMDeviceMotion.timestamp
+	double attitude[4];			// unit quaternion x, y, z, w, as CMAttitude.quaternion
+	double rotationRate[3];		// radians per second
+	double gravity[3];			// g
+	double userAcceleration[3];	// g
+} MotionSample;
+
+#ifdef __cplusplus
+
+#include <vector>
+
+namespace VideoSnake {
+
+/*
+ A fixed-capacity ring of samples whose timestamps increase from the oldest,
+ at index 0, to the newest. Nothing is allocated after construction.
+ */
+template <typename Sample>
+class TimestampRing
+{
+public:
+	// The capacity is rounded up to a power of two
+	explicit TimestampRing(size_t capacity)
+	: _head(0), _count(0)
+	{
+		size_t slots = 1;
+		while (slots < capacity)
+			slots <<= 1;
+		_samples.resize(slots);
+		_mask = slots - 1;
+	}
+
+	size_t capacity() const { return _samples.size(); }
+	size_t size() const { return _count; }
+	bool empty() const { return _count == 0; }
+	bool full() const { return _count == _samples.size(); }
+
+	const Sample& operator[](size_t index) const { return _samples[(_head + index) & _mask]; }
+	const Sample& front() const { return (*this)[0]; }
+	const Sample& back() const { return (*this)[_count - 1]; }
+
+	// Returns false without storing the sample if the ring is full
+	bool push(const Sample& sample)
+	{
+		if (full())
+			return false;
+		_samples[(_head + _count) & _mask] = sample;
+		_count++;
+		return true;
+	}
+
+	void pop(size_t count = 1)
+	{
+		if (count > _count)
+			count = _count;
+		_head = (_head + count) & _mask;
+		_count -= count;
+	}
+
+	void clear() { _head = _count = 0; }
+
+	// Index of the oldest sample at or after timestamp, or size() if there is none
+	size_t lowerBound(double timestamp) const
+	{
+		size_t low = 0, high = _count;
+		while (low < high) {
+			size_t middle = low + (high - low) / 2;
+			if ((*this)[middle].timestamp < timestamp)
+				low = middle + 1;
+			else
+				high = middle;
+		}
+		return low;
+	}
+
+private:
+	std::vector<Sample> _samples;
+	size_t _mask;
+	size_t _head;
+	size_t _count;
+};
+
+struct SyncedMedia {
+	double timestamp;
+	void *context;			// as passed to appendMedia, such as a retained CMSampleBufferRef
+	bool hasMotion;
+	MotionSample motion;	// interpolated to the media timestamp
+};
+
+/*
+ Matches media samples with motion samples. A media sample is ready once a
+ motion sample at or after its timestamp has arrived; its motion is then
+ interpolated between the two motion samples that bracket it, the attitude by
+ spherical linear interpolation. If more than mediaLatency media samples are
+ waiting, the oldest is output with the newest motion at hand instead.
+
+ Not thread safe: used from one thread or serial queue, which samples from
+ others reach through pipeline stages (PipelineStage.h).
+ */
+class MotionSyncCore
+{
+public:
+	MotionSyncCore(size_t mediaLatency = 5, size_t motionCapacity = 64);
+
+	// Motion timestamps must increase; returns false and ignores a sample that
+	// is not later than the last. When the ring is full the oldest is dropped.
+	bool appendMotion(const MotionSample& motion);
+
+	// Returns false if the media sample cannot be queued because nextSynced has
+	// not been called to drain the samples already ready
+	bool appendMedia(double timestamp, void *context);
+
+	// Takes the oldest media sample if it is ready, oldest first
+	bool nextSynced(SyncedMedia& synced);
+
+	// Takes the oldest waiting media sample, ready or not, without motion, so
+	// the caller can release its context when stopping
+	bool takePendingMedia(void *&context);
+
+	void clearMotion() { _motion.clear(); }
+
+	size_t pendingMediaCount() const { return _media.size(); }
+	size_t motionCount() const { return _motion.size(); }
+
+private:
+	struct PendingMedia {
+		double timestamp;
+		void *context;
+	};
+
+	void interpolateMotion(double timestamp, size_t next, MotionSample& motion) const;
+
+	size_t _mediaLatency;
+	TimestampRing<PendingMedia> _media;
+	TimestampRing<MotionSample> _motion;
+};
+
+// Interpolates every field of two motion samples, the attitude along the
+// shorter great circle arc between them; t = 0 gives a and t = 1 gives b
+void MotionSampleInterpolate(const MotionSample& a, const MotionSample& b, double t, MotionSample& result);
+
+} // namespace VideoSnake
+
+#endif // __cplusplus
+
+#endif /* MOTION_SYNC_CORE_H */
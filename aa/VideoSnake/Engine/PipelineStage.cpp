@@ -0,0 +1,126 @@
+/*
+ <codex>
+ <abstract>Latency histograms and counters for the stages of the capture pipeline</abstract>
+ </codex>
+ */
+
+#include "PipelineStage.h"
+
+// Microseconds below this have a bucket each; above it, each octave has four
+static const uint64_t kLinearLimit = 4;
+
+static size_t bucketForMicroseconds(uint64_t microseconds)
+{
+	if (microseconds < kLinearLimit)
+		return (size_t)microseconds;
+
+	int octave = 63 - __builtin_clzll(microseconds);
+	size_t quarter = (size_t)(microseconds >> (octave - 2)) & 3;
+	size_t bucket = 4 * (octave - 1) + quarter;
+	return bucket < VideoSnake::PipelineLatencyHistogram::kBucketCount ? bucket : VideoSnake::PipelineLatencyHistogram::kBucketCount - 1;
+}
+
+// The largest latency in the bucket, in seconds
+static double bucketLimit(size_t bucket)
+{
+	if (bucket < kLinearLimit)
+		return bucket * 1e-6;
+
+	int octave = (int)(bucket / 4) + 1;
+	uint64_t quarter = bucket & 3;
+	return (double)(((4 + quarter + 1) << (octave - 2)) - 1) * 1e-6;
+}
+
+VideoSnake::PipelineLatencyHistogram::PipelineLatencyHistogram()
+: _count(0), _totalMicroseconds(0), _maxMicroseconds(0)
+{
+	for (size_t i = 0; i < kBucketCount; i++)
+		_buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void VideoSnake::PipelineLatencyHistogram::record(double seconds)
+{
+	// Clocks can step back a little between threads; count that as no wait
+	uint64_t microseconds = seconds > 0.0 ? (uint64_t)(seconds * 1e6 + 0.5) : 0;
+
+	_buckets[bucketForMicroseconds(microseconds)].fetch_add(1, std::memory_order_relaxed);
+	_totalMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+	if (microseconds > _maxMicroseconds.load(std::memory_order_relaxed))
+		_maxMicroseconds.store(microseconds, std::memory_order_relaxed);
+	_count.fetch_add(1, std::memory_order_release);
+}
+
+void VideoSnake::PipelineLatencyHistogram::summarize(PipelineLatencySummary& summary) const
+{
+	uint64_t buckets[kBucketCount];
+	uint64_t count = 0;
+
+	// Counted from the buckets rather than _count, so the percentiles agree
+	// with each other while samples are being recorded
+	for (size_t i = 0; i < kBucketCount; i++) {
+		buckets[i] = _buckets[i].load(std::memory_order_relaxed);
+		count += buckets[i];
+	}
+
+	summary.mean = summary.p50 = summary.p99 = summary.max = 0.0;
+	if (count == 0)
+		return;
+
+	summary.mean = _totalMicroseconds.load(std::memory_order_relaxed) * 1e-6 / count;
+	summary.max = _maxMicroseconds.load(std::memory_order_relaxed) * 1e-6;
+
+	uint64_t p50Rank = (count + 1) / 2;
+	uint64_t p99Rank = count - count / 100;
+	uint64_t seen = 0;
+	for (size_t i = 0; i < kBucketCount; i++) {
+		if (!buckets[i])
+			continue;
+		seen += buckets[i];
+		if (seen >= p50Rank && summary.p50 == 0.0)
+			summary.p50 = bucketLimit(i);
+		if (seen >= p99Rank) {
+			summary.p99 = bucketLimit(i);
+			break;
+		}
+	}
+
+	// The top bucket is open ended, and the bucket limits overestimate
+	if (summary.p50 > summary.max)
+		summary.p50 = summary.max;
+	if (summary.p99 > summary.max)
+		summary.p99 = summary.max;
+}
+
+VideoSnake::PipelineStageCounters::PipelineStageCounters()
+: _queued(0), _refused(0), _evicted(0), _stale(0), _completed(0), _highWater(0)
+{
+}
+
+void VideoSnake::PipelineStageCounters::countQueued(size_t depth)
+{
+	_queued.fetch_add(1, std::memory_order_relaxed);
+	if (depth > _highWater.load(std::memory_order_relaxed))
+		_highWater.store((uint32_t)depth, std::memory_order_relaxed);
+}
+
+void VideoSnake::PipelineStageCounters::recordCompletion(double captureTime, double startTime, double now)
+{
+	_service.record(now - startTime);
+	_latency.record(now - captureTime);
+	_completed.fetch_add(1, std::memory_order_relaxed);
+}
+
+void VideoSnake::PipelineStageCounters::getStats(PipelineStageStats& stats, size_t depth) const
+{
+	stats.queued = _queued.load(std::memory_order_relaxed);
+	stats.refused = _refused.load(std::memory_order_relaxed);
+	stats.evicted = _evicted.load(std::memory_order_relaxed);
+	stats.stale = _stale.load(std::memory_order_relaxed);
+	stats.completed = _completed.load(std::memory_order_relaxed);
+	stats.depth = (uint32_t)depth;
+	stats.highWater = _highWater.load(std::memory_order_relaxed);
+
+	_wait.summarize(stats.wait);
+	_service.summarize(stats.service);
+	_latency.summarize(stats.latency);
+}
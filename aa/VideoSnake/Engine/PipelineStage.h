@@ -0,0 +1,308 @@
+/*
+ <codex>
+ <abstract>Stages of the capture pipeline: bounded lock-free queues that hand samples from one thread or serial queue to the next, with a drop policy for when the consumer falls behind and latency counters for every stage</abstract>
+ </codex>
+ */
+
+#ifndef PIPELINE_STAGE_H
+#define PIPELINE_STAGE_H
+
+#include <stdint.h>
+
+/*
+ What a stage does when its queue is full and the producer has another sample.
+ Back-pressure leaves the sample with the producer, which can hold it and try
+ again, making the stage before it wait in turn; the two drop policies keep
+ latency bounded instead, by giving up either the new sample or the oldest.
+ */
+typedef enum PipelineDropPolicy {
+	PipelineBackPressure,
+	PipelineDropNewest,
+	PipelineDropOldest,
+} PipelineDropPolicy;
+
+// Latencies are summarized from a histogram with four buckets per octave, so
+// the percentiles are upper bounds at most 25% above the true value
+typedef struct PipelineLatencySummary {
+	double mean;	// seconds
+	double p50;
+	double p99;
+	double max;
+} PipelineLatencySummary;
+
+typedef struct PipelineStageStats {
+	uint64_t queued;		// samples the stage accepted
+	uint64_t refused;		// pushes refused because the stage was full, under back-pressure or drop-newest
+	uint64_t evicted;		// samples dropped to make room under drop-oldest
+	uint64_t stale;			// samples dropped when dequeued past the latency budget
+	uint64_t completed;		// samples the stage finished with
+	uint32_t depth;			// samples waiting when the stats were taken
+	uint32_t highWater;		// most samples ever waiting at once
+
+	PipelineLatencySummary wait;	// from being queued to the stage starting on the sample
+	PipelineLatencySummary service;	// from the stage starting on the sample to finishing with it
+	PipelineLatencySummary latency;	// from capture to the stage finishing with the sample, glass to here
+} PipelineStageStats;
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <stddef.h>
+#include <vector>
+
+namespace VideoSnake {
+
+enum PipelinePushResult {
+	PipelineQueued,
+	PipelineQueuedEvictingOldest,	// queued, and the oldest sample handed back to be released
+	PipelineRefused,				// not queued; the sample stays with the producer
+};
+
+/*
+ A bounded queue for one producer and one consumer, neither of which ever
+ takes a lock. Each slot carries a sequence number saying whether it is free
+ for the producer or full for the consumer, so that under drop-oldest the
+ producer can also take the oldest sample off the head to make room; the head
+ is claimed with a compare-and-swap for this reason, and the consumer never
+ sees a sample the producer evicted.
+ */
+template <typename Item>
+class PipelineQueue
+{
+public:
+	// The capacity is rounded up to a power of two
+	PipelineQueue(size_t capacity, PipelineDropPolicy policy)
+	: _policy(policy), _head(0), _tail(0)
+	{
+		size_t slots = 1;
+		while (slots < capacity)
+			slots <<= 1;
+		_slots = std::vector<Slot>(slots);
+		for (size_t i = 0; i < slots; i++)
+			_slots[i].sequence.store(i, std::memory_order_relaxed);
+		_mask = slots - 1;
+	}
+
+	size_t capacity() const { return _slots.size(); }
+	PipelineDropPolicy policy() const { return _policy; }
+
+	// Approximate unless called from the producer or consumer with the other idle
+	size_t size() const
+	{
+		size_t head = _head.load(std::memory_order_acquire);
+		size_t tail = _tail.load(std::memory_order_acquire);
+		return tail - head > _slots.size() ? 0 : tail - head;
+	}
+
+	// Exact from the producer, which under back-pressure can wait for this to
+	// clear rather than push and be refused
+	bool full() const { return size() >= _slots.size(); }
+
+	// Producer only. When the result is PipelineQueuedEvictingOldest the
+	// evicted sample is stored in evicted.
+	PipelinePushResult push(const Item& item, Item& evicted)
+	{
+		PipelinePushResult result = PipelineQueued;
+		size_t tail = _tail.load(std::memory_order_relaxed);
+
+		for (;;) {
+			Slot& slot = _slots[tail & _mask];
+			if (slot.sequence.load(std::memory_order_acquire) == tail)
+				break;
+
+			// The slot still holds the sample from a lap ago. If the head has
+			// moved past it the consumer is just finishing reading it.
+			if (tail - _head.load(std::memory_order_acquire) < _slots.size())
+				continue;
+			if (_policy != PipelineDropOldest)
+				return PipelineRefused;
+			if (take(evicted))
+				result = PipelineQueuedEvictingOldest;
+		}
+
+		Slot& slot = _slots[tail & _mask];
+		slot.item = item;
+		slot.sequence.store(tail + 1, std::memory_order_release);
+		_tail.store(tail + 1, std::memory_order_release);
+		return result;
+	}
+
+	// Consumer only. Returns false if the queue is empty.
+	bool pop(Item& item) { return take(item); }
+
+private:
+	struct Slot {
+		std::atomic<size_t> sequence;
+		Item item;
+
+		Slot() : sequence(0), item() {}
+		Slot(const Slot&) : sequence(0), item() {}
+	};
+
+	bool take(Item& item)
+	{
+		size_t head = _head.load(std::memory_order_relaxed);
+
+		for (;;) {
+			Slot& slot = _slots[head & _mask];
+			size_t sequence = slot.sequence.load(std::memory_order_acquire);
+
+			if (sequence == head + 1) {
+				if (_head.compare_exchange_weak(head, head + 1, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+					item = slot.item;
+					slot.sequence.store(head + _slots.size(), std::memory_order_release);
+					return true;
+				}
+			}
+			else if (sequence == head) {
+				return false;
+			}
+			else {
+				head = _head.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	std::vector<Slot> _slots;
+	size_t _mask;
+	PipelineDropPolicy _policy;
+
+	// The ends are written by different threads; keep them on their own cache lines
+	char _padding0[64];
+	std::atomic<size_t> _head;
+	char _padding1[64];
+	std::atomic<size_t> _tail;
+	char _padding2[64];
+};
+
+/*
+ A histogram of latencies. Each histogram is recorded to from one thread at a
+ time and can be summarized from any.
+ */
+class PipelineLatencyHistogram
+{
+public:
+	enum { kBucketCount = 96 };
+
+	PipelineLatencyHistogram();
+
+	void record(double seconds);
+	void summarize(PipelineLatencySummary& summary) const;
+
+private:
+	std::atomic<uint64_t> _buckets[kBucketCount];
+	std::atomic<uint64_t> _count;
+	std::atomic<uint64_t> _totalMicroseconds;
+	std::atomic<uint64_t> _maxMicroseconds;
+};
+
+// The counters of a stage, for stages that do their work without a queue of their own
+class PipelineStageCounters
+{
+public:
+	PipelineStageCounters();
+
+	void countQueued(size_t depth);
+	void countRefused() { _refused.fetch_add(1, std::memory_order_relaxed); }
+	void countEvicted() { _evicted.fetch_add(1, std::memory_order_relaxed); }
+	void countStale() { _stale.fetch_add(1, std::memory_order_relaxed); }
+
+	// Times are in seconds on the capture clock
+	void recordStart(double queuedTime, double startTime) { _wait.record(startTime - queuedTime); }
+	void recordCompletion(double captureTime, double startTime, double now);
+
+	void getStats(PipelineStageStats& stats, size_t depth) const;
+
+private:
+	std::atomic<uint64_t> _queued;
+	std::atomic<uint64_t> _refused;
+	std::atomic<uint64_t> _evicted;
+	std::atomic<uint64_t> _stale;
+	std::atomic<uint64_t> _completed;
+	std::atomic<uint32_t> _highWater;
+	PipelineLatencyHistogram _wait;
+	PipelineLatencyHistogram _service;
+	PipelineLatencyHistogram _latency;
+};
+
+/*
+ A queue between two threads or serial queues together with its counters.
+ Samples are stamped with their capture time and the time they were queued,
+ both in seconds on whatever clock the caller uses for the pipeline. With a
+ latency budget, a sample already older than the budget when it is dequeued
+ is handed back as stale rather than worked on.
+ */
+template <typename Item>
+class PipelineStage
+{
+public:
+	struct Entry {
+		Item item;
+		double captureTime;
+		double queuedTime;
+	};
+
+	enum PopResult {
+		Empty,
+		Ready,
+		Stale,	// the entry is past the latency budget; release it and pop again
+	};
+
+	PipelineStage(size_t capacity, PipelineDropPolicy policy, double latencyBudget = 0.0)
+	: _queue(capacity, policy), _latencyBudget(latencyBudget)
+	{
+	}
+
+	// Producer only. A refused item stays with the producer; an evicted one is
+	// stored in evicted for the producer to release.
+	PipelinePushResult push(const Item& item, double captureTime, double now, Item& evicted)
+	{
+		Entry entry = {item, captureTime, now};
+		Entry evictedEntry;
+		PipelinePushResult result = _queue.push(entry, evictedEntry);
+
+		if (result == PipelineRefused) {
+			_counters.countRefused();
+			return result;
+		}
+		if (result == PipelineQueuedEvictingOldest) {
+			_counters.countEvicted();
+			evicted = evictedEntry.item;
+		}
+		_counters.countQueued(_queue.size());
+		return result;
+	}
+
+	// Consumer only. Records the wait of every entry dequeued.
+	PopResult pop(Entry& entry, double now)
+	{
+		if (!_queue.pop(entry))
+			return Empty;
+
+		_counters.recordStart(entry.queuedTime, now);
+		if (_latencyBudget > 0.0 && now - entry.captureTime > _latencyBudget) {
+			_counters.countStale();
+			return Stale;
+		}
+		return Ready;
+	}
+
+	// Consumer only, once it has finished with an entry it popped at startTime
+	void complete(const Entry& entry, double startTime, double now) { _counters.recordCompletion(entry.captureTime, startTime, now); }
+
+	void getStats(PipelineStageStats& stats) const { _counters.getStats(stats, _queue.size()); }
+
+	size_t depth() const { return _queue.size(); }
+	bool full() const { return _queue.full(); }
+
+private:
+	PipelineQueue<Entry> _queue;
+	PipelineStageCounters _counters;
+	double _latencyBudget;
+};
+
+} // namespace VideoSnake
+
+#endif // __cplusplus
+
+#endif /* PIPELINE_STAGE_H */
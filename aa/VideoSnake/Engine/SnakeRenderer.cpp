@@ -0,0 +1,361 @@
+/*
+ <codex>
+ <abstract>The snake effect rendered on the CPU, in bands of rows across threads</abstract>
+ </codex>
+ */
+
+#include <math.h>
+#include <string.h>
+#include <stdexcept>
+#include "SnakeRenderer.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+// kBlackUniform in BGRA
+static const uint8_t kBackgroundColor[4] = {0, 0, 0, 255};
+
+// Rows handed to a thread at a time
+static const uint32_t kBandRows = 16;
+
+// As the OpenGL renderer's pool: the hint is also the most buffers out at once
+static VideoSnake::FrameBufferPoolOptions poolOptions(uint32_t width, uint32_t height, uint32_t retainedBufferCountHint)
+{
+	VideoSnake::FrameBufferPoolOptions options(width, height, 4);
+	options.retainedBufferCountHint = retainedBufferCountHint;
+	options.allocationThreshold = retainedBufferCountHint;
+	return options;
+}
+
+static void fillBackground(uint8_t *dst, int32_t begin, int32_t end)
+{
+	for (int32_t i = begin; i < end; i++)
+		memcpy(dst + i * 4, kBackgroundColor, 4);
+}
+
+/*
+ Bilinear filtering of count pixels, each from two adjacent texels in each of
+ two rows. The rows are blended first and then the columns, each step with
+ eight-bit weights and rounded back to eight bits, so that every path below
+ gives the same result. The SIMD paths work a pixel at a time, with the eight
+ channels of its two texels in the lanes; they do not vectorize across pixels.
+ */
+#if defined(__SSE2__)
+
+template <typename Taps>
+static void sampleSpan(uint8_t *dst, const uint8_t *row0, const uint8_t *row1, uint32_t rowWeight, const Taps *columns, int32_t count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16(128);
+	const __m128i weight0 = _mm_set1_epi16((short)(256 - rowWeight));
+	const __m128i weight1 = _mm_set1_epi16((short)rowWeight);
+
+	for (int32_t i = 0; i < count; i++) {
+		int32_t column = columns[i].first;
+		uint32_t weight = columns[i].weight;
+
+		// Two texels of four channels from each row, widened to sixteen bits
+		__m128i top = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row0 + column * 4)), zero);
+		__m128i bottom = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i *)(row1 + column * 4)), zero);
+		__m128i blended = _mm_add_epi16(_mm_mullo_epi16(top, weight0), _mm_mullo_epi16(bottom, weight1));
+		blended = _mm_srli_epi16(_mm_add_epi16(blended, round), 8);
+
+		__m128i weights = _mm_unpacklo_epi64(_mm_set1_epi16((short)(256 - weight)), _mm_set1_epi16((short)weight));
+		__m128i products = _mm_mullo_epi16(blended, weights);
+		__m128i sum = _mm_add_epi16(products, _mm_srli_si128(products, 8));
+		sum = _mm_srli_epi16(_mm_add_epi16(sum, round), 8);
+
+		uint32_t pixel = (uint32_t)_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+		memcpy(dst + i * 4, &pixel, 4);
+	}
+}
+
+#elif defined(__ARM_NEON)
+
+template <typename Taps>
+static void sampleSpan(uint8_t *dst, const uint8_t *row0, const uint8_t *row1, uint32_t rowWeight, const Taps *columns, int32_t count)
+{
+	const uint16x8_t weight0 = vdupq_n_u16((uint16_t)(256 - rowWeight));
+	const uint16x8_t weight1 = vdupq_n_u16((uint16_t)rowWeight);
+
+	for (int32_t i = 0; i < count; i++) {
+		int32_t column = columns[i].first;
+		uint32_t weight = columns[i].weight;
+
+		uint16x8_t top = vmovl_u8(vld1_u8(row0 + column * 4));
+		uint16x8_t bottom = vmovl_u8(vld1_u8(row1 + column * 4));
+		uint16x8_t blended = vrshrq_n_u16(vmlaq_u16(vmulq_u16(top, weight0), bottom, weight1), 8);
+
+		uint16x4_t sum = vmla_n_u16(vmul_n_u16(vget_low_u16(blended), (uint16_t)(256 - weight)), vget_high_u16(blended), (uint16_t)weight);
+		sum = vrshr_n_u16(sum, 8);
+
+		uint8x8_t pixel = vmovn_u16(vcombine_u16(sum, sum));
+		vst1_lane_u32((uint32_t *)(void *)(dst + i * 4), vreinterpret_u32_u8(pixel), 0);
+	}
+}
+
+#else
+
+template <typename Taps>
+static void sampleSpan(uint8_t *dst, const uint8_t *row0, const uint8_t *row1, uint32_t rowWeight, const Taps *columns, int32_t count)
+{
+	for (int32_t i = 0; i < count; i++) {
+		const uint8_t *top = row0 + columns[i].first * 4;
+		const uint8_t *bottom = row1 + columns[i].first * 4;
+		uint32_t weight = columns[i].weight;
+
+		for (int channel = 0; channel < 4; channel++) {
+			uint32_t left = (top[channel] * (256 - rowWeight) + bottom[channel] * rowWeight + 128) >> 8;
+			uint32_t right = (top[channel + 4] * (256 - rowWeight) + bottom[channel + 4] * rowWeight + 128) >> 8;
+			dst[i * 4 + channel] = (uint8_t)((left * (256 - weight) + right * weight + 128) >> 8);
+		}
+	}
+}
+
+#endif
+
+namespace VideoSnake {
+
+SnakeRenderer::SnakeRenderer(uint32_t width, uint32_t height, uint32_t retainedBufferCountHint, unsigned threadCount)
+: _width(width), _height(height), _mirrorMotion(false), _pool(poolOptions(width, height, retainedBufferCountHint)), _backFrame(NULL),
+  _hasBack(false), _output(NULL), _outputBytesPerRow(0), _nextBand(0), _generation(0), _busyWorkers(0), _quit(false)
+{
+	// Every pixel samples two adjacent texels in each direction
+	if (width < 2 || height < 2)
+		throw std::invalid_argument("SnakeRenderer: frames must be at least 2 by 2 pixels");
+
+	memset(&_motionState, 0, sizeof(_motionState));
+
+	// Real-time, so allocate every buffer up front
+	_pool.preallocate();
+
+	_back.columns.taps.resize(width);
+	_back.rows.taps.resize(height);
+	_back.texture = NULL;
+	_back.bytesPerRow = 0;
+
+	// The frame itself is always drawn in the same place
+	layOutAxis(_front.columns, width, kSnakeFrontScaleFactor, 0);
+	layOutAxis(_front.rows, height, kSnakeFrontScaleFactor, 0);
+	_front.texture = NULL;
+	_front.bytesPerRow = 0;
+
+	if (!threadCount)
+		threadCount = std::thread::hardware_concurrency();
+	for (unsigned i = 1; i < threadCount; i++)
+		_workers.push_back(std::thread(&SnakeRenderer::workerLoop, this));
+}
+
+SnakeRenderer::~SnakeRenderer()
+{
+	{
+		std::lock_guard<std::mutex> locked(_lock);
+		_quit = true;
+	}
+	_wake.notify_all();
+	for (size_t i = 0; i < _workers.size(); i++)
+		_workers[i].join();
+
+	if (_backFrame)
+		_backFrame->release();
+}
+
+void SnakeRenderer::reset()
+{
+	if (_backFrame) {
+		_backFrame->release();
+		_backFrame = NULL;
+	}
+	memset(&_motionState, 0, sizeof(_motionState));
+}
+
+/*
+ The quad's corners are at -1 and 1 scaled and translated in normalized device
+ coordinates, taken to pixels by the viewport. A pixel is drawn if its centre
+ is on or after the quad's first edge and before its last, and its texture
+ coordinate is interpolated from 0 at the first edge to 1 at the last.
+ */
+void SnakeRenderer::layOutAxis(QuadAxis& axis, uint32_t size, float scale, float translation)
+{
+	float low = (translation - scale + 1.0f) * size * 0.5f;
+	float high = (translation + scale + 1.0f) * size * 0.5f;
+
+	axis.taps.resize(size);
+	axis.coveredBegin = axis.coveredEnd = 0;
+	axis.interiorBegin = axis.interiorEnd = 0;
+	bool covered = false, interior = false;
+
+	for (uint32_t i = 0; i < size; i++) {
+		float centre = i + 0.5f;
+		if (centre < low || centre >= high)
+			continue;
+
+		if (!covered) {
+			axis.coveredBegin = i;
+			covered = true;
+		}
+		axis.coveredEnd = i + 1;
+
+		float coordinate = (centre - low) / (high - low);
+		if (coordinate >= kSnakeBorderHigh || coordinate <= kSnakeBorderLow)
+			continue;
+
+		if (!interior) {
+			axis.interiorBegin = i;
+			interior = true;
+		}
+		axis.interiorEnd = i + 1;
+
+		// Texel centres are at half texels; past the first and last the edge texel repeats
+		float texel = coordinate * size - 0.5f;
+		float first = floorf(texel);
+		Taps& taps = axis.taps[i];
+		taps.first = (int32_t)first;
+		taps.weight = (uint32_t)((texel - first) * 256.0f + 0.5f);
+		if (taps.weight == 256) {
+			taps.first++;
+			taps.weight = 0;
+		}
+		if (taps.first < 0) {
+			taps.first = 0;
+			taps.weight = 0;
+		}
+		else if (taps.first > (int32_t)size - 2) {
+			taps.first = (int32_t)size - 2;
+			taps.weight = 256;
+		}
+		taps.second = taps.first + 1;
+	}
+
+	// No texels sampled: the whole quad is border
+	if (!interior)
+		axis.interiorBegin = axis.interiorEnd = axis.coveredEnd;
+}
+
+FrameBuffer *SnakeRenderer::copyRenderedBuffer(const uint8_t *frame, size_t bytesPerRow, const MotionSample *motion)
+{
+	SnakeMotionStateUpdate(&_motionState, motion);
+
+	FrameBuffer *output = _pool.createBuffer();
+	if (!output)
+		return NULL;
+
+	_hasBack = _backFrame != NULL;
+	if (_hasBack) {
+		float translation[2];
+		SnakeMotionStateGetBackTranslation(&_motionState, (int32_t)_width, _mirrorMotion, translation);
+		layOutAxis(_back.columns, _width, kSnakeBackScaleFactor, translation[0]);
+		layOutAxis(_back.rows, _height, kSnakeBackScaleFactor, translation[1]);
+		_back.texture = _backFrame->baseAddress();
+		_back.bytesPerRow = _backFrame->bytesPerRow();
+	}
+	_front.texture = frame;
+	_front.bytesPerRow = bytesPerRow;
+	_output = output->baseAddress();
+	_outputBytesPerRow = output->bytesPerRow();
+	_nextBand.store(0, std::memory_order_relaxed);
+
+	if (_workers.empty()) {
+		renderBands();
+	}
+	else {
+		{
+			std::lock_guard<std::mutex> locked(_lock);
+			_busyWorkers = (unsigned)_workers.size();
+			_generation++;
+		}
+		_wake.notify_all();
+		renderBands();
+
+		std::unique_lock<std::mutex> locked(_lock);
+		while (_busyWorkers)
+			_finished.wait(locked);
+	}
+
+	if (_backFrame)
+		_backFrame->release();
+	_backFrame = output->retain();
+	return output;
+}
+
+void SnakeRenderer::workerLoop()
+{
+	uint64_t generation = 0;
+	std::unique_lock<std::mutex> locked(_lock);
+
+	for (;;) {
+		while (!_quit && _generation == generation)
+			_wake.wait(locked);
+		if (_quit)
+			return;
+		generation = _generation;
+
+		locked.unlock();
+		renderBands();
+		locked.lock();
+
+		if (--_busyWorkers == 0)
+			_finished.notify_one();
+	}
+}
+
+void SnakeRenderer::renderBands()
+{
+	uint32_t bandCount = (_height + kBandRows - 1) / kBandRows;
+
+	for (;;) {
+		uint32_t band = _nextBand.fetch_add(1, std::memory_order_relaxed);
+		if (band >= bandCount)
+			return;
+
+		uint32_t end = (band + 1) * kBandRows < _height ? (band + 1) * kBandRows : _height;
+		for (uint32_t row = band * kBandRows; row < end; row++)
+			renderRow(row, _output + row * _outputBytesPerRow);
+	}
+}
+
+// The back frame over the clear colour, then the frame over both
+void SnakeRenderer::renderRow(uint32_t row, uint8_t *dst) const
+{
+	const QuadAxis& backRows = _back.rows;
+	if (_hasBack && (int32_t)row >= backRows.coveredBegin && (int32_t)row < backRows.coveredEnd) {
+		fillBackground(dst, 0, _back.columns.coveredBegin);
+		fillBackground(dst, _back.columns.coveredEnd, (int32_t)_width);
+		drawQuadRow(_back, row, dst);
+	}
+	else {
+		fillBackground(dst, 0, (int32_t)_width);
+	}
+
+	drawQuadRow(_front, row, dst);
+}
+
+void SnakeRenderer::drawQuadRow(const Quad& quad, uint32_t row, uint8_t *dst) const
+{
+	const QuadAxis& rows = quad.rows;
+	const QuadAxis& columns = quad.columns;
+	int32_t y = (int32_t)row;
+
+	if (y < rows.coveredBegin || y >= rows.coveredEnd)
+		return;
+	if (y < rows.interiorBegin || y >= rows.interiorEnd) {
+		fillBackground(dst, columns.coveredBegin, columns.coveredEnd);
+		return;
+	}
+
+	fillBackground(dst, columns.coveredBegin, columns.interiorBegin);
+	fillBackground(dst, columns.interiorEnd, columns.coveredEnd);
+
+	const Taps& rowTaps = rows.taps[y];
+	sampleSpan(dst + columns.interiorBegin * 4,
+			   quad.texture + rowTaps.first * quad.bytesPerRow,
+			   quad.texture + rowTaps.second * quad.bytesPerRow,
+			   rowTaps.weight,
+			   &columns.taps[columns.interiorBegin],
+			   columns.interiorEnd - columns.interiorBegin);
+}
+
+} // namespace VideoSnake
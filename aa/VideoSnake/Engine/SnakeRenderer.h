@@ -0,0 +1,181 @@
+/*
+ <codex>
+ <abstract>The snake effect without a GPU: the motion model the OpenGL renderer shares, and a multithreaded SIMD renderer that composites BGRA frames over their trail the way videoSnake.vsh and videoSnake.fsh do</abstract>
+ </codex>
+ */
+
+#ifndef SNAKE_RENDERER_H
+#define SNAKE_RENDERER_H
+
+#include <stdint.h>
+#include "MotionSyncCore.h"
+
+static const float kSnakeMotionDampingFactor = 0.75;
+static const float kSnakeMotionScaleFactor = 0.01;
+static const float kSnakeFrontScaleFactor = 0.25;
+static const float kSnakeBackScaleFactor = 0.85;
+
+// Texture coordinates at or beyond these, in from each edge of a frame, are drawn in the background colour
+static const float kSnakeBorderLow = 0.01;
+static const float kSnakeBorderHigh = 0.99;
+
+// How fast the trail drifts, integrated from the user acceleration of each frame's motion
+typedef struct SnakeMotionState {
+	double velocityDeltaX;
+	double velocityDeltaY;
+	double lastMotionTime;	// 0 until the first motion sample, and after a frame without motion
+} SnakeMotionState;
+
+// Without motion the snake keeps drifting to rest
+static inline void SnakeMotionStateUpdate(SnakeMotionState *state, const MotionSample *motion)
+{
+	double timeDelta = 0;
+	double accelerationX = 0, accelerationY = 0;
+	if (motion) {
+		if (!state->lastMotionTime)
+			state->lastMotionTime = motion->timestamp;
+		timeDelta = motion->timestamp - state->lastMotionTime;
+		state->lastMotionTime = motion->timestamp;
+		accelerationX = motion->userAcceleration[0];
+		accelerationY = motion->userAcceleration[1];
+	}
+	else {
+		// The next motion sample starts the clock over
+		state->lastMotionTime = 0;
+	}
+
+	state->velocityDeltaX += accelerationX * timeDelta;
+	state->velocityDeltaX *= kSnakeMotionDampingFactor;
+	state->velocityDeltaY += accelerationY * timeDelta;
+	state->velocityDeltaY *= kSnakeMotionDampingFactor;
+}
+
+// Where the back frame is drawn, as a translation in normalized device coordinates of frames width pixels wide
+static inline void SnakeMotionStateGetBackTranslation(const SnakeMotionState *state, int32_t width, int mirrorMotion, float translation[2])
+{
+	float motionPixels = kSnakeMotionScaleFactor * width;
+	int motionMirroring = mirrorMotion ? -1 : 1;
+	translation[0] = -state->velocityDeltaY * motionPixels;
+	translation[1] = -state->velocityDeltaX * motionPixels * motionMirroring;
+}
+
+#ifdef __cplusplus
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "FrameBufferPool.h"
+
+namespace VideoSnake {
+
+/*
+ Renders the effect of VideoSnakeOpenGLRenderer into BGRA frame buffers from a
+ pool of its own: the previous output, scaled and moved by the motion, then
+ the frame itself scaled down in the middle, both with a border of background
+ colour, with bilinear sampling clamped to the edge as the texture units do.
+
+ Where each quad covers, and which texels each pixel samples, is worked out
+ once per frame for every column and row; the filtering uses eight bits of
+ sub-texel weight, as GPUs do, so the output is within one of what the
+ shaders would write. Bands of rows are shared between the calling thread and
+ a set of workers.
+
+ The OpenGL renderer leaves the very first frame's background transparent,
+ before it has set the clear colour; this one draws it opaque black throughout.
+ */
+class SnakeRenderer
+{
+public:
+	// Frames are width by height, each at least 2; smaller throws
+	// std::invalid_argument. threadCount includes the calling thread; 0 for
+	// one per processor.
+	SnakeRenderer(uint32_t width, uint32_t height, uint32_t retainedBufferCountHint, unsigned threadCount = 0);
+	~SnakeRenderer();
+
+	uint32_t width() const { return _width; }
+	uint32_t height() const { return _height; }
+	unsigned threadCount() const { return (unsigned)_workers.size() + 1; }
+
+	bool shouldMirrorMotion() const { return _mirrorMotion; }
+	void setShouldMirrorMotion(bool mirrorMotion) { _mirrorMotion = mirrorMotion; }
+
+	const SnakeMotionState& motionState() const { return _motionState; }
+
+	// As copyRenderedPixelBuffer:motion:, for a frame of the renderer's
+	// dimensions; motion may be NULL. Returns the output retained, or NULL if
+	// the pool is out of buffers, in which case the frame is dropped.
+	FrameBuffer *copyRenderedBuffer(const uint8_t *frame, size_t bytesPerRow, const MotionSample *motion);
+
+	// Forgets the trail, and the motion too
+	void reset();
+
+	void getPoolStats(FrameBufferPoolStats& stats) const { _pool.getStats(stats); }
+
+private:
+	SnakeRenderer(const SnakeRenderer&);
+	SnakeRenderer& operator=(const SnakeRenderer&);
+
+	// Which texels a column or row of a quad samples
+	struct Taps {
+		int32_t first;		// the column or row index of the first texel; for columns the second follows it
+		int32_t second;
+		uint32_t weight;	// of the second texel, out of 256
+	};
+
+	/*
+	 Where a quad drawn at a scale and translation covers the frame, per axis.
+	 Pixels in [coveredBegin, coveredEnd) are drawn; those in [interiorBegin,
+	 interiorEnd) sample the texture and the rest of them are border.
+	 */
+	struct QuadAxis {
+		int32_t coveredBegin, coveredEnd;
+		int32_t interiorBegin, interiorEnd;
+		std::vector<Taps> taps;	// indexed by pixel
+	};
+
+	struct Quad {
+		QuadAxis columns;
+		QuadAxis rows;
+		const uint8_t *texture;
+		size_t bytesPerRow;
+	};
+
+	static void layOutAxis(QuadAxis& axis, uint32_t size, float scale, float translation);
+
+	void renderBands();
+	void renderRow(uint32_t row, uint8_t *dst) const;
+	void drawQuadRow(const Quad& quad, uint32_t row, uint8_t *dst) const;
+	void workerLoop();
+
+	uint32_t _width;
+	uint32_t _height;
+	bool _mirrorMotion;
+	SnakeMotionState _motionState;
+
+	FrameBufferPool _pool;
+	FrameBuffer *_backFrame;
+
+	// The frame being rendered
+	Quad _back;
+	Quad _front;
+	bool _hasBack;
+	uint8_t *_output;
+	size_t _outputBytesPerRow;
+	std::atomic<uint32_t> _nextBand;
+
+	std::vector<std::thread> _workers;
+	std::mutex _lock;
+	std::condition_variable _wake;
+	std::condition_variable _finished;
+	uint64_t _generation;
+	unsigned _busyWorkers;
+	bool _quit;
+};
+
+} // namespace VideoSnake
+
+#endif // __cplusplus
+
+#endif /* SNAKE_RENDERER_H */
@@ -0,0 +1,267 @@
+/*
+ <codex>
+ <abstract>Headless run of the capture pipeline on threads of its own. Synthetic frames and motion are generated in real time and handed through the same pipeline stages and motion synchronizer core as the app, to a render thread that spends a set time on each frame; the latency and drops of every stage are reported, and every frame is checked to come out at most once, in order, with its own motion.</abstract>
+ </codex>
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "MotionSyncCore.h"
+#include "PipelineStage.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static Clock::time_point gStart;
+
+// Seconds since the run started, the pipeline's capture clock
+static double now()
+{
+	return std::chrono::duration<double>(Clock::now() - gStart).count();
+}
+
+static void sleepUntil(double time)
+{
+	std::this_thread::sleep_until(gStart + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(time)));
+}
+
+static MotionSample motionAt(double t)
+{
+	MotionSample sample;
+	memset(&sample, 0, sizeof(sample));
+	sample.timestamp = t;
+	sample.attitude[2] = sin(t / 2.0);
+	sample.attitude[3] = cos(t / 2.0);
+	sample.gravity[1] = -1.0;
+	sample.userAcceleration[0] = t;
+	return sample;
+}
+
+// Frames carry their index, plus one so that no frame is a null pointer
+typedef void *Frame;
+
+// When the synchronizer took a frame off the frame stage; frames leave the
+// synchronizer in the order they enter it
+struct HeldFrame {
+	double timestamp;
+	double startTime;
+};
+
+struct RenderItem {
+	Frame frame;
+	bool hasMotion;
+	double motionTimestamp;
+	double accelerationX;
+};
+
+static void printStage(const char *name, const PipelineStageStats& stats)
+{
+	printf("%-7s %9llu %7llu %7llu %7llu %9llu %5u  %8.2f %8.2f  %8.2f %8.2f  %8.2f %8.2f %8.2f\n", name,
+		   (unsigned long long)stats.queued, (unsigned long long)stats.refused, (unsigned long long)stats.evicted,
+		   (unsigned long long)stats.stale, (unsigned long long)stats.completed, stats.highWater,
+		   stats.wait.p50 * 1e3, stats.wait.p99 * 1e3, stats.service.p50 * 1e3, stats.service.p99 * 1e3,
+		   stats.latency.p50 * 1e3, stats.latency.p99 * 1e3, stats.latency.max * 1e3);
+}
+
+static void printUsage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [--seconds=N] [--fps=N] [--motion-rate=N] [--motion-delay=S] [--render-ms=N]\n"
+			"          [--budget=S] [--render-policy=backpressure|newest|oldest]\n"
+			"  --motion-delay   seconds motion samples reach the pipeline after their timestamp\n"
+			"  --render-ms      milliseconds the render thread spends on each frame\n"
+			"  --budget         frames older than this many seconds are dropped at each stage, 0 for none\n"
+			"  --render-policy  what the synchronizer does when the render queue is full\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 5.0;
+	double fps = 60.0;
+	double motionRate = 120.0;
+	double motionDelay = 0.005;
+	double renderMilliseconds = 4.0;
+	double budget = 0.1;
+	PipelineDropPolicy renderPolicy = PipelineBackPressure;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (!strncmp(arg, "--seconds=", 10)) seconds = atof(arg + 10);
+		else if (!strncmp(arg, "--fps=", 6)) fps = atof(arg + 6);
+		else if (!strncmp(arg, "--motion-rate=", 14)) motionRate = atof(arg + 14);
+		else if (!strncmp(arg, "--motion-delay=", 15)) motionDelay = atof(arg + 15);
+		else if (!strncmp(arg, "--render-ms=", 12)) renderMilliseconds = atof(arg + 12);
+		else if (!strncmp(arg, "--budget=", 9)) budget = atof(arg + 9);
+		else if (!strcmp(arg, "--render-policy=backpressure")) renderPolicy = PipelineBackPressure;
+		else if (!strcmp(arg, "--render-policy=newest")) renderPolicy = PipelineDropNewest;
+		else if (!strcmp(arg, "--render-policy=oldest")) renderPolicy = PipelineDropOldest;
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// Laid out as in the app: capture and motion each hand off to the
+	// synchronizer, which hands synchronized frames on to the renderer
+	VideoSnake::PipelineStage<Frame> frameStage(4, PipelineDropOldest, budget);
+	VideoSnake::PipelineStage<MotionSample> motionStage(64, PipelineDropOldest);
+	VideoSnake::PipelineStage<RenderItem> renderStage(2, renderPolicy, budget);
+	VideoSnake::MotionSyncCore core;
+
+	size_t frameCount = (size_t)(seconds * fps);
+	size_t motionSampleCount = (size_t)(seconds * motionRate);
+	std::atomic<bool> producing(true), synchronizing(true);
+	std::atomic<size_t> released(0);
+	size_t rendered = 0, outOfOrder = 0, wrongMotion = 0;
+
+	gStart = Clock::now();
+
+	std::thread capture([&] {
+		for (size_t i = 0; i < frameCount; i++) {
+			double timestamp = i / fps;
+			sleepUntil(timestamp);
+			Frame evicted;
+			if (frameStage.push((Frame)(i + 1), timestamp, now(), evicted) == VideoSnake::PipelineQueuedEvictingOldest)
+				released++;
+		}
+	});
+
+	std::thread motion([&] {
+		for (size_t i = 0; i < motionSampleCount; i++) {
+			double timestamp = i / motionRate;
+			sleepUntil(timestamp + motionDelay);
+			MotionSample evicted;
+			motionStage.push(motionAt(timestamp), timestamp, now(), evicted);
+		}
+	});
+
+	std::thread synchronizer([&] {
+		VideoSnake::PipelineStage<MotionSample>::Entry motionEntry;
+		VideoSnake::PipelineStage<Frame>::Entry frameEntry;
+		VideoSnake::SyncedMedia synced;
+		VideoSnake::TimestampRing<HeldFrame> held(8);
+		bool draining = false;
+
+		for (;;) {
+			bool idle = true;
+			draining = draining || !producing;
+
+			while (motionStage.pop(motionEntry, now()) == VideoSnake::PipelineStage<MotionSample>::Ready) {
+				core.appendMotion(motionEntry.item);
+				motionStage.complete(motionEntry, now(), now());
+				idle = false;
+			}
+
+			VideoSnake::PipelineStage<Frame>::PopResult popped = frameStage.pop(frameEntry, now());
+			if (popped == VideoSnake::PipelineStage<Frame>::Stale) {
+				released++;
+				idle = false;
+			}
+			else if (popped == VideoSnake::PipelineStage<Frame>::Ready) {
+				HeldFrame frame = {frameEntry.captureTime, now()};
+				core.appendMedia(frameEntry.captureTime, frameEntry.item);
+				held.push(frame);
+				idle = false;
+			}
+
+			while (core.nextSynced(synced)) {
+				RenderItem item = {synced.context, synced.hasMotion, synced.motion.timestamp, synced.motion.userAcceleration[0]};
+				RenderItem evicted;
+				VideoSnake::PipelinePushResult pushed;
+
+				// The frame stage's service time is the wait for motion
+				VideoSnake::PipelineStage<Frame>::Entry entry = {synced.context, synced.timestamp, 0.0};
+				frameStage.complete(entry, held.front().startTime, now());
+				held.pop();
+
+				// Under back-pressure the synchronizer waits for the renderer,
+				// and the frame stage before it fills and drops in turn
+				while (renderPolicy == PipelineBackPressure && renderStage.full())
+					std::this_thread::yield();
+				pushed = renderStage.push(item, synced.timestamp, now(), evicted);
+				if (pushed == VideoSnake::PipelineRefused || pushed == VideoSnake::PipelineQueuedEvictingOldest)
+					released++;
+				idle = false;
+			}
+
+			if (idle) {
+				if (draining) {
+					void *context;
+					while (core.takePendingMedia(context)) {
+						held.pop();
+						released++;
+					}
+					break;
+				}
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		}
+		synchronizing = false;
+	});
+
+	std::thread renderer([&] {
+		VideoSnake::PipelineStage<RenderItem>::Entry entry;
+		size_t lastFrame = 0;
+
+		for (;;) {
+			double startTime = now();
+			VideoSnake::PipelineStage<RenderItem>::PopResult popped = renderStage.pop(entry, startTime);
+			if (popped == VideoSnake::PipelineStage<RenderItem>::Empty) {
+				if (!synchronizing)
+					break;
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+				continue;
+			}
+			if (popped == VideoSnake::PipelineStage<RenderItem>::Stale) {
+				released++;
+				continue;
+			}
+
+			size_t frame = (size_t)entry.item.frame;
+			if (frame <= lastFrame)
+				outOfOrder++;
+			lastFrame = frame;
+
+			// Motion is interpolated to the frame's own capture time
+			double timestamp = (frame - 1) / fps;
+			if (entry.item.hasMotion && (entry.item.motionTimestamp != timestamp || entry.item.accelerationX > timestamp + 1e-9))
+				wrongMotion++;
+
+			while (now() - startTime < renderMilliseconds * 1e-3)
+				;
+			renderStage.complete(entry, startTime, now());
+			rendered++;
+			released++;
+		}
+	});
+
+	capture.join();
+	motion.join();
+	producing = false;
+	synchronizer.join();
+	renderer.join();
+
+	PipelineStageStats frameStats, motionStats, renderStats;
+	frameStage.getStats(frameStats);
+	motionStage.getStats(motionStats);
+	renderStage.getStats(renderStats);
+
+	printf("%zu frames at %.0f fps, %zu motion samples at %.0f Hz %.1f ms late, render %.1f ms, budget %.0f ms\n",
+		   frameCount, fps, motionSampleCount, motionRate, motionDelay * 1e3, renderMilliseconds, budget * 1e3);
+	printf("stage      queued refused evicted   stale completed  high  wait p50  wait p99  serv p50 serv p99   lat p50  lat p99  lat max (ms)\n");
+	printStage("frames", frameStats);
+	printStage("motion", motionStats);
+	printStage("render", renderStats);
+	printf("rendered %zu, dropped %zu, out of order %zu, wrong motion %zu\n", rendered, released - rendered, outOfOrder, wrongMotion);
+
+	// Every frame is released exactly once, rendered or dropped
+	bool ok = released == frameCount && !outOfOrder && !wrongMotion;
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
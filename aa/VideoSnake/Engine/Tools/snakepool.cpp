@@ -0,0 +1,207 @@
+/*
+ <codex>
+ <abstract>Headless soak of the frame buffer pool the way an ingest pipeline uses it. A capture thread fills frames from the pool and hands them to a consumer that holds the most recent few, as an encoder would, before releasing them. Checks that no buffer is recycled while it is still held and that a preallocated pool allocates nothing while running, and optionally compares the cost with allocating every frame.</abstract>
+ </codex>
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include "FrameBufferPool.h"
+#include "PipelineStage.h"
+
+static const size_t kPageSize = 4096;
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Writes the frame number into every page of the frame, as a capture would
+// touch all of it, and reads it back
+static void stampFrame(uint8_t *data, size_t size, uint32_t frame)
+{
+	for (size_t offset = 0; offset + sizeof(frame) <= size; offset += kPageSize)
+		memcpy(data + offset, &frame, sizeof(frame));
+}
+
+static bool checkFrame(const uint8_t *data, size_t size, uint32_t frame)
+{
+	for (size_t offset = 0; offset + sizeof(frame) <= size; offset += kPageSize) {
+		uint32_t stamped;
+		memcpy(&stamped, data + offset, sizeof(stamped));
+		if (stamped != frame)
+			return false;
+	}
+	return true;
+}
+
+static void printStats(const char *name, const FrameBufferPoolStats& stats)
+{
+	printf("%s: %llu requests, %llu hits, %llu misses, %llu exhaustions; outstanding high water %u, allocated %u (high water %u, %u on huge pages), %.1f MB\n",
+		   name, (unsigned long long)stats.requests, (unsigned long long)stats.hits, (unsigned long long)stats.misses,
+		   (unsigned long long)stats.exhaustions, stats.outstandingHighWater, stats.allocated, stats.allocatedHighWater,
+		   stats.hugePageBuffers, stats.bytesAllocated / (1024.0 * 1024.0));
+}
+
+static void printUsage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [--width=N] [--height=N] [--frames=N] [--hold=N] [--threshold=N] [--no-preallocate]\n"
+			"          [--huge-pages] [--compare]\n"
+			"  --hold        frames the consumer holds on to, as an encoder would\n"
+			"  --threshold   most buffers outstanding at once; by default what the pipeline can hold\n"
+			"  --huge-pages  back the buffers with 2 MB pages\n"
+			"  --compare     also time allocating and freeing every frame instead of pooling\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t width = 3840;
+	uint32_t height = 2160;
+	uint32_t frameCount = 600;
+	uint32_t hold = 5;
+	uint32_t threshold = 0;
+	bool preallocate = true;
+	bool hugePages = false;
+	bool compare = false;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (!strncmp(arg, "--width=", 8)) width = (uint32_t)strtoul(arg + 8, NULL, 10);
+		else if (!strncmp(arg, "--height=", 9)) height = (uint32_t)strtoul(arg + 9, NULL, 10);
+		else if (!strncmp(arg, "--frames=", 9)) frameCount = (uint32_t)strtoul(arg + 9, NULL, 10);
+		else if (!strncmp(arg, "--hold=", 7)) hold = (uint32_t)strtoul(arg + 7, NULL, 10);
+		else if (!strncmp(arg, "--threshold=", 12)) threshold = (uint32_t)strtoul(arg + 12, NULL, 10);
+		else if (!strcmp(arg, "--no-preallocate")) preallocate = false;
+		else if (!strcmp(arg, "--huge-pages")) hugePages = true;
+		else if (!strcmp(arg, "--compare")) compare = true;
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+
+	// Frames are handed to the consumer through a stage this deep, under back-pressure
+	const uint32_t kQueueDepth = 4;
+
+	// What the pipeline can hold at once: the consumer's frames, the queue,
+	// one being handed over and one being filled
+	VideoSnake::FrameBufferPoolOptions options(width, height, 4);
+	options.retainedBufferCountHint = hold + kQueueDepth + 2;
+	options.allocationThreshold = threshold ? threshold : options.retainedBufferCountHint;
+	options.hugePages = hugePages;
+
+	VideoSnake::FrameBufferPool pool(options);
+	size_t frameSize = pool.bytesPerRow() * height;
+
+	Clock::time_point start = Clock::now();
+	uint32_t preallocated = preallocate ? pool.preallocate() : 0;
+	double preallocateSeconds = secondsSince(start);
+
+	FrameBufferPoolStats warm;
+	pool.getStats(warm);
+
+	struct Frame {
+		VideoSnake::FrameBuffer *buffer;
+		uint32_t number;
+	};
+	VideoSnake::PipelineQueue<Frame> queue(kQueueDepth, PipelineBackPressure);
+	std::atomic<uint32_t> dropped(0);
+	uint32_t corrupted = 0, consumed = 0;
+
+	start = Clock::now();
+
+	std::thread consumer([&] {
+		std::vector<Frame> held;
+		Frame frame;
+
+		while (consumed + dropped < frameCount) {
+			if (!queue.pop(frame)) {
+				std::this_thread::yield();
+				continue;
+			}
+			held.push_back(frame);
+			consumed++;
+
+			if (held.size() > hold) {
+				if (!checkFrame(held.front().buffer->baseAddress(), frameSize, held.front().number))
+					corrupted++;
+				held.front().buffer->release();
+				held.erase(held.begin());
+			}
+		}
+
+		for (size_t i = 0; i < held.size(); i++) {
+			if (!checkFrame(held[i].buffer->baseAddress(), frameSize, held[i].number))
+				corrupted++;
+			held[i].buffer->release();
+		}
+	});
+
+	for (uint32_t number = 0; number < frameCount; number++) {
+		VideoSnake::FrameBufferPoolResult result;
+		VideoSnake::FrameBuffer *buffer = pool.createBuffer(&result);
+
+		// Out of buffers: the frame is dropped, as videoPipelineDidRunOutOfBuffers does
+		if (!buffer) {
+			dropped++;
+			std::this_thread::yield();
+			continue;
+		}
+
+		stampFrame(buffer->baseAddress(), frameSize, number);
+		Frame frame = {buffer, number}, unused;
+		while (queue.push(frame, unused) == VideoSnake::PipelineRefused)
+			std::this_thread::yield();
+	}
+	consumer.join();
+	double runSeconds = secondsSince(start);
+
+	FrameBufferPoolStats stats;
+	pool.getStats(stats);
+
+	printf("%u frames of %ux%u BGRA (%.1f MB, %zu bytes per row), consumer holds %u, threshold %u\n",
+		   frameCount, width, height, frameSize / (1024.0 * 1024.0), pool.bytesPerRow(), hold, options.allocationThreshold);
+	printf("preallocated %u buffers in %.1f ms\n", preallocated, preallocateSeconds * 1e3);
+	printStats("pool", stats);
+	printf("consumed %u, dropped %u, recycled while held %u, misses while running %llu; %.2f ms per frame\n",
+		   consumed, dropped.load(), corrupted, (unsigned long long)(stats.misses - warm.misses), runSeconds * 1e3 / frameCount);
+
+	if (compare) {
+		// The same frames allocated and freed one at a time, touching every page
+		start = Clock::now();
+		for (uint32_t number = 0; number < frameCount; number++) {
+			uint8_t *data = (uint8_t *)malloc(frameSize);
+			stampFrame(data, frameSize, number);
+			free(data);
+		}
+		double mallocSeconds = secondsSince(start);
+
+		start = Clock::now();
+		for (uint32_t number = 0; number < frameCount; number++) {
+			VideoSnake::FrameBuffer *buffer = pool.createBuffer();
+			stampFrame(buffer->baseAddress(), frameSize, number);
+			buffer->release();
+		}
+		double poolSeconds = secondsSince(start);
+
+		printf("allocating every frame %.3f ms per frame, pooled %.3f ms per frame\n",
+			   mallocSeconds * 1e3 / frameCount, poolSeconds * 1e3 / frameCount);
+	}
+
+	// A preallocated pool that is big enough never allocates while running
+	bool ok = !corrupted && consumed + dropped == frameCount && stats.outstanding == 0;
+	if (preallocate && !threshold)
+		ok = ok && stats.misses == warm.misses && !dropped;
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,367 @@
+/*
+ <codex>
+ <abstract>Headless check of the CPU snake renderer against the shaders. Renders synthetic frames with synthetic motion, and compares every output with a golden image made by running videoSnake.vsh and videoSnake.fsh as written, in floating point: the vertices through the model view and projection matrices and the viewport, the coordinate interpolated across each triangle of the strip, and the texture filtered bilinearly and clamped to the edge. Reports the largest difference in any channel and the cost per frame.</abstract>
+ </codex>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "SnakeRenderer.h"
+
+// The shaders' output may differ by this much in any channel: the renderer
+// filters with eight-bit weights, as texture units do, and the golden image
+// with exact ones
+static const int kTolerance = 1;
+
+// Pixels whose centre or coordinate is this close to the edge of a quad or of
+// its border are left out of the comparison; mediump GPUs differ there too
+static const float kEdgeMargin = 1e-3f;		// pixels
+static const float kBorderMargin = 1e-4f;	// texture coordinate
+
+// The synthetic device sways, enough to move the trail by tens of pixels
+static const double kSwayAcceleration = 0.05;	// g
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+static MotionSample motionAt(double t)
+{
+	MotionSample sample;
+	memset(&sample, 0, sizeof(sample));
+	sample.timestamp = t;
+	sample.attitude[3] = 1.0;
+	sample.gravity[1] = -1.0;
+	sample.userAcceleration[0] = kSwayAcceleration * sin(2.0 * M_PI * 0.7 * t);
+	sample.userAcceleration[1] = kSwayAcceleration * cos(2.0 * M_PI * 0.45 * t);
+	return sample;
+}
+
+// A moving checkerboard over gradients, with noise so that every texel differs from its neighbours
+static void fillFrame(uint8_t *data, size_t bytesPerRow, uint32_t width, uint32_t height, uint32_t frame)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		uint8_t *row = data + y * bytesPerRow;
+		for (uint32_t x = 0; x < width; x++) {
+			uint32_t noise = (x * 73856093u) ^ (y * 19349663u) ^ (frame * 83492791u);
+			bool check = (((x + frame * 3) / 37) ^ ((y + frame) / 29)) & 1;
+			row[x * 4 + 0] = (uint8_t)((x * 255 / width) ^ (noise & 15));
+			row[x * 4 + 1] = (uint8_t)(check ? 200 + (noise >> 4 & 31) : 40 + (noise >> 9 & 31));
+			row[x * 4 + 2] = (uint8_t)((y * 255 / height) ^ (noise >> 13 & 15));
+			row[x * 4 + 3] = 255;
+		}
+	}
+}
+
+// The matrices of matrix.c, column-major
+static void loadTranslation(const float v[3], float m[16])
+{
+	memset(m, 0, 16 * sizeof(float));
+	m[0] = m[5] = m[10] = m[15] = 1.0f;
+	m[12] = v[0];
+	m[13] = v[1];
+	m[14] = v[2];
+}
+
+static void loadScale(const float s[3], float m[16])
+{
+	memset(m, 0, 16 * sizeof(float));
+	m[0] = s[0];
+	m[5] = s[1];
+	m[10] = s[2];
+	m[15] = 1.0f;
+}
+
+static void multiply(const float a[16], const float b[16], float m[16])
+{
+	for (int column = 0; column < 4; column++)
+		for (int row = 0; row < 4; row++)
+			m[column * 4 + row] = a[row] * b[column * 4] + a[4 + row] * b[column * 4 + 1] + a[8 + row] * b[column * 4 + 2] + a[12 + row] * b[column * 4 + 3];
+}
+
+struct Texture {
+	const uint8_t *data;
+	size_t bytesPerRow;
+	uint32_t width;
+	uint32_t height;
+};
+
+// texture2D with GL_LINEAR and GL_CLAMP_TO_EDGE, converted to eight bits as the framebuffer does
+static void sample(const Texture& texture, float s, float t, uint8_t out[4])
+{
+	float x = s * texture.width - 0.5f;
+	float y = t * texture.height - 0.5f;
+	int x0 = (int)floorf(x), y0 = (int)floorf(y);
+	float fx = x - x0, fy = y - y0;
+	int x1 = std::min(std::max(x0 + 1, 0), (int)texture.width - 1);
+	int y1 = std::min(std::max(y0 + 1, 0), (int)texture.height - 1);
+	x0 = std::min(std::max(x0, 0), (int)texture.width - 1);
+	y0 = std::min(std::max(y0, 0), (int)texture.height - 1);
+
+	const uint8_t *row0 = texture.data + y0 * texture.bytesPerRow;
+	const uint8_t *row1 = texture.data + y1 * texture.bytesPerRow;
+	for (int channel = 0; channel < 4; channel++) {
+		float top = row0[x0 * 4 + channel] * (1.0f - fx) + row0[x1 * 4 + channel] * fx;
+		float bottom = row1[x0 * 4 + channel] * (1.0f - fx) + row1[x1 * 4 + channel] * fx;
+		out[channel] = (uint8_t)floorf(top * (1.0f - fy) + bottom * fy + 0.5f);
+	}
+}
+
+// squareVertices and textureVertices, drawn as a triangle strip
+static const float kSquareVertices[8] = {-1, -1, 1, -1, -1, 1, 1, 1};
+static const float kTextureVertices[8] = {0, 0, 1, 0, 0, 1, 1, 1};
+
+static float edge(const float a[2], const float b[2], const float p[2])
+{
+	return (b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]);
+}
+
+/*
+ One glDrawArrays of the quad with the program. Pixels too close to call are
+ marked in ambiguous, and are not drawn.
+ */
+static void drawQuad(uint8_t *target, uint32_t width, uint32_t height, const float modelview[16], const Texture& texture, std::vector<bool>& ambiguous)
+{
+	static const uint8_t kBackground[4] = {0, 0, 0, 255};
+	float projection[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+	float matrix[16];
+	multiply(projection, modelview, matrix);
+
+	// The vertex shader, then the viewport
+	float window[4][2];
+	for (int i = 0; i < 4; i++) {
+		float position[4] = {kSquareVertices[i * 2], kSquareVertices[i * 2 + 1], 0, 1};
+		float clip[4];
+		for (int row = 0; row < 4; row++)
+			clip[row] = matrix[row] * position[0] + matrix[4 + row] * position[1] + matrix[8 + row] * position[2] + matrix[12 + row] * position[3];
+		window[i][0] = (clip[0] / clip[3] + 1.0f) * width * 0.5f;
+		window[i][1] = (clip[1] / clip[3] + 1.0f) * height * 0.5f;
+	}
+
+	static const int kTriangles[2][3] = {{0, 1, 2}, {2, 1, 3}};
+	float left = std::min(window[0][0], window[3][0]), right = std::max(window[0][0], window[3][0]);
+	float bottom = std::min(window[0][1], window[3][1]), top = std::max(window[0][1], window[3][1]);
+
+	for (uint32_t y = 0; y < height; y++) {
+		for (uint32_t x = 0; x < width; x++) {
+			float p[2] = {x + 0.5f, y + 0.5f};
+			if (p[0] < left - kEdgeMargin || p[0] > right + kEdgeMargin || p[1] < bottom - kEdgeMargin || p[1] > top + kEdgeMargin)
+				continue;
+			if (fabsf(p[0] - left) < kEdgeMargin || fabsf(p[0] - right) < kEdgeMargin || fabsf(p[1] - bottom) < kEdgeMargin || fabsf(p[1] - top) < kEdgeMargin) {
+				ambiguous[y * width + x] = true;
+				continue;
+			}
+
+			for (int t = 0; t < 2; t++) {
+				const int *v = kTriangles[t];
+				float area = edge(window[v[0]], window[v[1]], window[v[2]]);
+				float b0 = edge(window[v[1]], window[v[2]], p) / area;
+				float b1 = edge(window[v[2]], window[v[0]], p) / area;
+				float b2 = edge(window[v[0]], window[v[1]], p) / area;
+				if (b0 < 0 || b1 < 0 || b2 < 0)
+					continue;
+
+				// The fragment shader
+				float s = b0 * kTextureVertices[v[0] * 2] + b1 * kTextureVertices[v[1] * 2] + b2 * kTextureVertices[v[2] * 2];
+				float c = b0 * kTextureVertices[v[0] * 2 + 1] + b1 * kTextureVertices[v[1] * 2 + 1] + b2 * kTextureVertices[v[2] * 2 + 1];
+				if (fabsf(s - kSnakeBorderLow) < kBorderMargin || fabsf(s - kSnakeBorderHigh) < kBorderMargin ||
+					fabsf(c - kSnakeBorderLow) < kBorderMargin || fabsf(c - kSnakeBorderHigh) < kBorderMargin) {
+					ambiguous[y * width + x] = true;
+					break;
+				}
+
+				uint8_t *pixel = target + (y * width + x) * 4;
+				if (s >= kSnakeBorderHigh || s <= kSnakeBorderLow || c >= kSnakeBorderHigh || c <= kSnakeBorderLow)
+					memcpy(pixel, kBackground, 4);
+				else
+					sample(texture, s, c, pixel);
+				ambiguous[y * width + x] = false;
+				break;
+			}
+		}
+	}
+}
+
+// copyRenderedPixelBuffer:motion: on the GPU, given the back frame it would read
+static void renderGolden(uint8_t *golden, uint32_t width, uint32_t height, const Texture& frame, const Texture *back,
+						 const float translation[2], std::vector<bool>& ambiguous)
+{
+	static const uint8_t kBackground[4] = {0, 0, 0, 255};
+	for (size_t i = 0; i < (size_t)width * height; i++)
+		memcpy(golden + i * 4, kBackground, 4);
+	std::fill(ambiguous.begin(), ambiguous.end(), false);
+
+	float modelview[16];
+	if (back) {
+		float transBack[3] = {translation[0], translation[1], 0};
+		float scaleBack[3] = {kSnakeBackScaleFactor, kSnakeBackScaleFactor, 0};
+		float translationMatrix[16], scaling[16];
+		loadTranslation(transBack, translationMatrix);
+		loadScale(scaleBack, scaling);
+		multiply(translationMatrix, scaling, modelview);
+		drawQuad(golden, width, height, modelview, *back, ambiguous);
+	}
+
+	float scaleFront[3] = {kSnakeFrontScaleFactor, kSnakeFrontScaleFactor, 0};
+	loadScale(scaleFront, modelview);
+	drawQuad(golden, width, height, modelview, frame, ambiguous);
+}
+
+static bool writePPM(const char *path, const uint8_t *data, size_t bytesPerRow, uint32_t width, uint32_t height)
+{
+	FILE *file = fopen(path, "wb");
+	if (!file)
+		return false;
+	fprintf(file, "P6\n%u %u\n255\n", width, height);
+	std::vector<uint8_t> row(width * 3);
+	for (uint32_t y = height; y-- > 0;) {
+		for (uint32_t x = 0; x < width; x++) {
+			row[x * 3 + 0] = data[y * bytesPerRow + x * 4 + 2];
+			row[x * 3 + 1] = data[y * bytesPerRow + x * 4 + 1];
+			row[x * 3 + 2] = data[y * bytesPerRow + x * 4 + 0];
+		}
+		fwrite(&row[0], 1, row.size(), file);
+	}
+	return fclose(file) == 0;
+}
+
+static void printUsage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [--width=N] [--height=N] [--frames=N] [--fps=N] [--threads=N] [--mirror] [--no-golden] [--dump=file.ppm]\n"
+			"  --threads    threads rendering each frame, counting the caller; by default one per processor\n"
+			"  --no-golden  only time the renderer\n"
+			"  --dump       write the last frame, as the OpenGL renderer would show it\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t width = 1920;
+	uint32_t height = 1080;
+	uint32_t frameCount = 60;
+	double fps = 30.0;
+	unsigned threads = 0;
+	bool mirror = false;
+	bool golden = true;
+	const char *dumpPath = NULL;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (!strncmp(arg, "--width=", 8)) width = (uint32_t)strtoul(arg + 8, NULL, 10);
+		else if (!strncmp(arg, "--height=", 9)) height = (uint32_t)strtoul(arg + 9, NULL, 10);
+		else if (!strncmp(arg, "--frames=", 9)) frameCount = (uint32_t)strtoul(arg + 9, NULL, 10);
+		else if (!strncmp(arg, "--fps=", 6)) fps = atof(arg + 6);
+		else if (!strncmp(arg, "--threads=", 10)) threads = (unsigned)strtoul(arg + 10, NULL, 10);
+		else if (!strcmp(arg, "--mirror")) mirror = true;
+		else if (!strcmp(arg, "--no-golden")) golden = false;
+		else if (!strncmp(arg, "--dump=", 7)) dumpPath = arg + 7;
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (width < 2 || height < 2 || fps <= 0) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	// As the session manager: the output, the back frame, and a few for the preview and recorder
+	VideoSnake::SnakeRenderer renderer(width, height, 6, threads);
+	renderer.setShouldMirrorMotion(mirror);
+
+	size_t bytesPerRow = (size_t)width * 4;
+	std::vector<uint8_t> frame(bytesPerRow * height);
+	std::vector<uint8_t> goldenImage(bytesPerRow * height);
+	std::vector<bool> ambiguous((size_t)width * height);
+	VideoSnake::FrameBuffer *back = NULL;
+
+	double renderSeconds = 0.0, goldenSeconds = 0.0;
+	uint64_t compared = 0, skipped = 0, mismatched = 0;
+	int worst = 0;
+	uint32_t dropped = 0;
+
+	for (uint32_t number = 0; number < frameCount; number++) {
+		fillFrame(&frame[0], bytesPerRow, width, height, number);
+		MotionSample motion = motionAt(number / fps);
+
+		Clock::time_point start = Clock::now();
+		VideoSnake::FrameBuffer *output = renderer.copyRenderedBuffer(&frame[0], bytesPerRow, &motion);
+		renderSeconds += secondsSince(start);
+		if (!output) {
+			dropped++;
+			continue;
+		}
+
+		if (golden) {
+			Texture frameTexture = {&frame[0], bytesPerRow, width, height};
+			Texture backTexture = {NULL, 0, width, height};
+			if (back) {
+				backTexture.data = back->baseAddress();
+				backTexture.bytesPerRow = back->bytesPerRow();
+			}
+			float translation[2];
+			SnakeMotionStateGetBackTranslation(&renderer.motionState(), (int32_t)width, mirror, translation);
+
+			start = Clock::now();
+			renderGolden(&goldenImage[0], width, height, frameTexture, back ? &backTexture : NULL, translation, ambiguous);
+			goldenSeconds += secondsSince(start);
+
+			for (uint32_t y = 0; y < height; y++) {
+				const uint8_t *rendered = output->baseAddress() + y * output->bytesPerRow();
+				const uint8_t *expected = &goldenImage[y * bytesPerRow];
+				for (uint32_t x = 0; x < width; x++) {
+					if (ambiguous[y * width + x]) {
+						skipped++;
+						continue;
+					}
+					int difference = 0;
+					for (int channel = 0; channel < 4; channel++)
+						difference = std::max(difference, abs(rendered[x * 4 + channel] - expected[x * 4 + channel]));
+					if (difference > kTolerance) {
+						if (!mismatched)
+							printf("frame %u: pixel %u,%u differs by %d\n", number, x, y, difference);
+						mismatched++;
+					}
+					worst = std::max(worst, difference);
+					compared++;
+				}
+			}
+		}
+
+		if (back)
+			back->release();
+		back = output;
+	}
+
+	if (back && dumpPath && !writePPM(dumpPath, back->baseAddress(), back->bytesPerRow(), width, height))
+		fprintf(stderr, "could not write %s\n", dumpPath);
+	if (back)
+		back->release();
+
+	FrameBufferPoolStats stats;
+	renderer.getPoolStats(stats);
+
+	printf("%u frames of %ux%u BGRA on %u threads: %.2f ms per frame, %u dropped; pool %llu misses after preallocating %u\n",
+		   frameCount, width, height, renderer.threadCount(), renderSeconds * 1e3 / frameCount, dropped,
+		   (unsigned long long)stats.misses, stats.allocatedHighWater);
+
+	bool ok = !dropped && stats.misses == 0;
+	if (golden) {
+		printf("golden images: %llu pixels compared, %llu on an edge skipped, %llu beyond %d, largest difference %d; %.1f ms per golden frame\n",
+			   (unsigned long long)compared, (unsigned long long)skipped, (unsigned long long)mismatched, kTolerance, worst,
+			   goldenSeconds * 1e3 / frameCount);
+		ok = ok && !mismatched;
+	}
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,185 @@
+/*
+ <codex>
+ <abstract>Headless check of the motion synchronizer core. Feeds it synthetic video frames and device motion the way the capture and motion queues would, arriving late and jittered, then checks that every frame comes out once, in order, with motion interpolated to its timestamp, and reports the cost per sample.</abstract>
+ </codex>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "MotionSyncCore.h"
+
+// The synthetic device turns about z at a constant rate while accelerating
+// linearly, so interpolating between any two samples is exact
+static const double kTurnRate = 3.0;			// radians per second
+static const double kAccelerationRate = 0.25;	// g per second
+
+static MotionSample motionAt(double t)
+{
+	MotionSample sample;
+	memset(&sample, 0, sizeof(sample));
+	sample.timestamp = t;
+	sample.attitude[2] = sin(kTurnRate * t / 2.0);
+	sample.attitude[3] = cos(kTurnRate * t / 2.0);
+	sample.rotationRate[2] = kTurnRate;
+	sample.gravity[1] = -1.0;
+	sample.userAcceleration[0] = kAccelerationRate * t;
+	sample.userAcceleration[1] = -kAccelerationRate * t;
+	return sample;
+}
+
+static double motionError(const MotionSample& motion, double t)
+{
+	MotionSample expected = motionAt(t);
+	double error = 0.0;
+	
+	// q and -q are the same attitude
+	double cosine = 0.0;
+	for (int i = 0; i < 4; i++)
+		cosine += motion.attitude[i] * expected.attitude[i];
+	error = std::max(error, 1.0 - fabs(cosine));
+	for (int i = 0; i < 3; i++) {
+		error = std::max(error, fabs(motion.rotationRate[i] - expected.rotationRate[i]));
+		error = std::max(error, fabs(motion.gravity[i] - expected.gravity[i]));
+		error = std::max(error, fabs(motion.userAcceleration[i] - expected.userAcceleration[i]));
+	}
+	return error;
+}
+
+struct Arrival {
+	double time;		// when the sample reaches the synchronizer
+	bool isMedia;
+	size_t index;
+	double timestamp;
+	
+	bool operator<(const Arrival& other) const { return time < other.time || (time == other.time && isMedia && !other.isMedia); }
+};
+
+static void printUsage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [--seconds=N] [--fps=N] [--motion-rate=N] [--motion-delay=S] [--jitter=S]\n"
+			"          [--latency=N] [--seed=N]\n"
+			"  --motion-delay  seconds motion samples reach the synchronizer after their timestamp\n"
+			"  --jitter        up to this many seconds more, at random, for each motion sample\n"
+			"  --latency       frames held waiting for motion before one goes out without it\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	double seconds = 60.0;
+	double fps = 240.0;
+	double motionRate = 200.0;
+	double motionDelay = 0.01;
+	double jitter = 0.004;
+	size_t latency = 5;
+	unsigned seed = 1;
+	
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		
+		if (!strncmp(arg, "--seconds=", 10)) seconds = atof(arg + 10);
+		else if (!strncmp(arg, "--fps=", 6)) fps = atof(arg + 6);
+		else if (!strncmp(arg, "--motion-rate=", 14)) motionRate = atof(arg + 14);
+		else if (!strncmp(arg, "--motion-delay=", 15)) motionDelay = atof(arg + 15);
+		else if (!strncmp(arg, "--jitter=", 9)) jitter = atof(arg + 9);
+		else if (!strncmp(arg, "--latency=", 10)) latency = (size_t)strtoul(arg + 10, NULL, 10);
+		else if (!strncmp(arg, "--seed=", 7)) seed = (unsigned)strtoul(arg + 7, NULL, 10);
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	
+	// Frames reach the synchronizer as soon as they are captured; motion
+	// arrives late and jittered, but in order, as CoreMotion delivers it
+	std::vector<Arrival> arrivals;
+	srand(seed);
+	size_t frameCount = (size_t)(seconds * fps);
+	for (size_t i = 0; i < frameCount; i++) {
+		Arrival arrival = {i / fps, true, i, i / fps};
+		arrivals.push_back(arrival);
+	}
+	double lastMotionArrival = 0.0;
+	size_t motionSampleCount = (size_t)(seconds * motionRate);
+	for (size_t i = 0; i < motionSampleCount; i++) {
+		double timestamp = i / motionRate;
+		double time = std::max(lastMotionArrival, timestamp + motionDelay + jitter * rand() / RAND_MAX);
+		Arrival arrival = {time, false, i, timestamp};
+		arrivals.push_back(arrival);
+		lastMotionArrival = time;
+	}
+	std::stable_sort(arrivals.begin(), arrivals.end());
+	
+	VideoSnake::MotionSyncCore core(latency);
+	std::vector<VideoSnake::SyncedMedia> output;
+	output.reserve(frameCount);
+	size_t rejected = 0;
+	
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < arrivals.size(); i++) {
+		const Arrival& arrival = arrivals[i];
+		if (arrival.isMedia) {
+			if (!core.appendMedia(arrival.timestamp, (void *)(arrival.index + 1)))
+				rejected++;
+		}
+		else {
+			core.appendMotion(motionAt(arrival.timestamp));
+		}
+		
+		VideoSnake::SyncedMedia synced;
+		while (core.nextSynced(synced))
+			output.push_back(synced);
+	}
+	double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	
+	void *context;
+	size_t pending = 0;
+	while (core.takePendingMedia(context))
+		pending++;
+	
+	// Every frame once, in capture order; a frame is exact if it was
+	// bracketed by motion, and otherwise holds the newest motion at hand
+	size_t outOfOrder = 0, withoutMotion = 0, heldMotion = 0, inexact = 0;
+	double maxError = 0.0;
+	for (size_t i = 0; i < output.size(); i++) {
+		const VideoSnake::SyncedMedia& synced = output[i];
+		if ((size_t)synced.context != i + 1)
+			outOfOrder++;
+		if (!synced.hasMotion) {
+			withoutMotion++;
+			continue;
+		}
+		if (synced.motion.timestamp != synced.timestamp)
+			outOfOrder++;
+		
+		double error = motionError(synced.motion, synced.timestamp);
+		if (synced.timestamp * motionRate > motionSampleCount - 1 || error > 1e-9) {
+			// Held motion must be an actual sample from before the frame
+			double t = synced.motion.userAcceleration[0] / kAccelerationRate;
+			if (t <= synced.timestamp + 1e-9 && motionError(synced.motion, t) < 1e-9)
+				heldMotion++;
+			else
+				inexact++;
+		}
+		else {
+			maxError = std::max(maxError, error);
+		}
+	}
+	
+	printf("%zu frames at %.0f fps, %zu motion samples at %.0f Hz, motion %.1f ms late +%.1f ms jitter\n",
+		   frameCount, fps, motionSampleCount, motionRate, motionDelay * 1000.0, jitter * 1000.0);
+	printf("output %zu, pending at end %zu, rejected %zu, out of order %zu\n", output.size(), pending, rejected, outOfOrder);
+	printf("interpolated %zu (max error %.2g), held %zu, without motion %zu, inexact %zu\n",
+		   output.size() - heldMotion - withoutMotion - inexact, maxError, heldMotion, withoutMotion, inexact);
+	printf("%.1f ns per sample\n", elapsed * 1e9 / arrivals.size());
+	
+	bool ok = (output.size() + pending == frameCount) && !rejected && !outOfOrder && !inexact;
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}
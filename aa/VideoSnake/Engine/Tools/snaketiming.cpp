@@ -0,0 +1,173 @@
+/*
+ <codex>
+ <abstract>Headless check of the frame timing window. Feeds it a synthetic stream of frames with jittered timestamps, frames dropped at random and a restart of the clock, and compares every frame rate with the NSMutableArray algorithm calculateFramerateAtTimestamp: used, the percentiles with a sort of the same window, and the dropped frames with those left out. Reports the cost per frame.</abstract>
+ </codex>
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <random>
+#include <vector>
+
+#include "FrameTiming.h"
+
+typedef std::chrono::steady_clock Clock;
+
+static double secondsSince(Clock::time_point start)
+{
+	return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// What the stats should say about the window, from a sort of its intervals
+static void expectedPercentiles(const std::deque<double>& window, double percentiles[4])
+{
+	std::vector<double> intervals;
+	for (size_t i = 1; i < window.size(); i++)
+		intervals.push_back(window[i] - window[i - 1]);
+	std::sort(intervals.begin(), intervals.end());
+
+	const double kPercentiles[3] = {0.50, 0.95, 0.99};
+	for (int i = 0; i < 3; i++) {
+		size_t rank = (size_t)ceil(kPercentiles[i] * intervals.size());
+		percentiles[i] = intervals[rank ? rank - 1 : 0];
+	}
+	percentiles[3] = intervals.back();
+}
+
+static void printStats(const FrameTimingStats& stats)
+{
+	printf("%llu frames, %llu dropped, %llu discontinuities; window of %u frames at %.2f fps, interval mean %.2f ms p50 %.2f ms p95 %.2f ms p99 %.2f ms max %.2f ms\n",
+		   (unsigned long long)stats.frames, (unsigned long long)stats.dropped, (unsigned long long)stats.discontinuities,
+		   stats.framesInWindow, stats.frameRate, stats.meanInterval * 1e3, stats.p50Interval * 1e3, stats.p95Interval * 1e3,
+		   stats.p99Interval * 1e3, stats.maxInterval * 1e3);
+	printf("jitter:");
+	for (unsigned i = 0; i < FrameTimingJitterBucketCount; i++) {
+		double limit = FrameTimingJitterBucketLimit(i);
+		if (isinf(limit))
+			printf(" more %llu", (unsigned long long)stats.jitter[i]);
+		else
+			printf(" <%g ms %llu,", limit * 1e3, (unsigned long long)stats.jitter[i]);
+	}
+	printf("\n");
+}
+
+static void printUsage(const char *name)
+{
+	fprintf(stderr,
+			"usage: %s [--fps=N] [--seconds=N] [--jitter-ms=N] [--drop-rate=N] [--no-nominal]\n"
+			"  --jitter-ms   timestamps stray up to this far either way from the frame clock\n"
+			"  --drop-rate   fraction of frames left out of the stream\n"
+			"  --no-nominal  measure gaps against the mean interval instead of the frame duration\n", name);
+}
+
+int main(int argc, char **argv)
+{
+	double fps = 30.0;
+	double seconds = 120.0;
+	double jitter = 0.002;
+	double dropRate = 0.01;
+	bool nominal = true;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+
+		if (!strncmp(arg, "--fps=", 6)) fps = atof(arg + 6);
+		else if (!strncmp(arg, "--seconds=", 10)) seconds = atof(arg + 10);
+		else if (!strncmp(arg, "--jitter-ms=", 12)) jitter = atof(arg + 12) / 1000.0;
+		else if (!strncmp(arg, "--drop-rate=", 12)) dropRate = atof(arg + 12);
+		else if (!strcmp(arg, "--no-nominal")) nominal = false;
+		else {
+			printUsage(argv[0]);
+			return 1;
+		}
+	}
+	if (fps <= 0 || seconds <= 0 || jitter < 0 || dropRate < 0 || dropRate >= 1) {
+		printUsage(argv[0]);
+		return 1;
+	}
+
+	const double frameDuration = 1.0 / fps;
+	VideoSnake::FrameTimingWindow window(1.0, nominal ? frameDuration : 0.0, (size_t)(fps * 2));
+
+	std::mt19937 random(7);
+	std::uniform_real_distribution<double> jitterDistribution(-jitter, jitter);
+	std::uniform_real_distribution<double> dropDistribution(0.0, 1.0);
+
+	// Halfway through, the clock starts over, as when capture restarts
+	const uint64_t frameCount = (uint64_t)(seconds * fps);
+	const uint64_t restart = frameCount / 2;
+
+	std::deque<double> previousSecond;
+	uint64_t added = 0, leftOut = 0, dropped = 0, rateMismatches = 0, percentileMismatches = 0;
+	uint64_t pending = 0;
+	double addSeconds = 0.0, statsSeconds = 0.0;
+
+	for (uint64_t frame = 0; frame < frameCount; frame++) {
+		uint64_t tick = frame < restart ? frame : frame - restart;
+		double timestamp = (frame < restart ? 1000.0 : 10.0) + tick * frameDuration + jitterDistribution(random);
+
+		// Frames left out count as dropped once the next frame shows the gap, unless
+		// that frame is across the restart. The first frame of each half is always kept.
+		if (frame && frame != restart && dropDistribution(random) < dropRate) {
+			leftOut++;
+			pending++;
+			continue;
+		}
+		if (frame == restart)
+			previousSecond.clear();
+		else
+			dropped += pending;
+		pending = 0;
+
+		Clock::time_point start = Clock::now();
+		window.addFrame(timestamp);
+		addSeconds += secondsSince(start);
+		added++;
+
+		// calculateFramerateAtTimestamp:
+		previousSecond.push_back(timestamp);
+		while (previousSecond.front() < timestamp - 1.0)
+			previousSecond.pop_front();
+		double expectedRate = previousSecond.size() > 1 ? (previousSecond.size() - 1) / (previousSecond.back() - previousSecond.front()) : 0.0;
+		if (fabs(window.frameRate() - expectedRate) > 1e-9 * expectedRate)
+			rateMismatches++;
+
+		if (frame % 97 == 0 && previousSecond.size() > 1) {
+			FrameTimingStats stats;
+			start = Clock::now();
+			window.getStats(stats);
+			statsSeconds += secondsSince(start);
+
+			double expected[4];
+			expectedPercentiles(previousSecond, expected);
+			if (stats.p50Interval != expected[0] || stats.p95Interval != expected[1] || stats.p99Interval != expected[2] || stats.maxInterval != expected[3])
+				percentileMismatches++;
+		}
+	}
+
+	FrameTimingStats stats;
+	window.getStats(stats);
+
+	printf("%llu frames at %.0f fps over %.0f s, timestamps within %.1f ms, %llu left out, clock restarted once; gaps against the %s\n",
+		   (unsigned long long)frameCount, fps, seconds, jitter * 1e3, (unsigned long long)leftOut, nominal ? "frame duration" : "mean interval");
+	printStats(stats);
+	printf("frame rate differs from calculateFramerateAtTimestamp: %llu times, percentiles from a sort %llu times; %.0f ns to add a frame, %.1f us to take the stats\n",
+		   (unsigned long long)rateMismatches, (unsigned long long)percentileMismatches,
+		   addSeconds * 1e9 / added, statsSeconds * 1e6 / (added / 97 + 1));
+
+	uint64_t jittered = 0;
+	for (unsigned i = 0; i < FrameTimingJitterBucketCount; i++)
+		jittered += stats.jitter[i];
+
+	// Every interval is measured once there is a frame duration to measure against
+	bool ok = !rateMismatches && !percentileMismatches && stats.frames == added && stats.dropped == dropped && stats.discontinuities == 1;
+	if (nominal)
+		ok = ok && jittered == added - 1 - stats.discontinuities;
+	printf("%s\n", ok ? "PASS" : "FAIL");
+	return ok ? 0 : 1;
+}